@@ -0,0 +1,19 @@
+// benchmarks/driver.c - time a compiled Mino `int poly(int)`
+//
+// Linked with the object minoc -c writes for poly_div.mino or
+// poly_mul.mino. Prints the checksum of 2e7 calls and their wall time.
+#include <stdio.h>
+#include <time.h>
+
+long poly(long x);
+
+int main(void) {
+    struct timespec start, end;
+    long sum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < 20000000; i++) sum += poly(i);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%ld %.3f s\n", sum, seconds);
+    return 0;
+}
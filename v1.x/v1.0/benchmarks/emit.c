@@ -0,0 +1,50 @@
+// benchmarks/emit.c - time how fast the backend prints assembly
+//
+// Linked with the compiler's build/mir.o and build/emit.o. Builds the
+// instructions minoc -S writes for a prints.awk function, four for each
+// PrintIntLn(n + i), and prints them 200 times with mirPrintFunction to the
+// file named on the command line. Prints the bytes written, their wall time
+// and the rate in MB/s, without the parsing and optimization around it.
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "mir.h"
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: emit <output>\n");
+        return 64;
+    }
+    MFunction* fn = mirCreateFunction("f0");
+    for (int i = 0; i < 5000; i++) {
+        mirEmit(fn, MOP_MOV, mReg(REG_RBX), mReg(REG_R10));
+        mirEmit(fn, MOP_ADD, mImm(i), mReg(REG_R10));
+        mirEmit(fn, MOP_MOV, mReg(REG_R10), mReg(REG_RDI));
+        mirEmit(fn, MOP_CALL, mSym("sys_IO_print_PrintIntLn"), mNone());
+    }
+    int fd = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Emitter out;
+    emitInit(&out, fd);
+    for (int i = 0; i < 200; i++) mirPrintFunction(fn, &out);
+    int failed = emitFinish(&out);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long bytes = (long)lseek(fd, 0, SEEK_END);
+    close(fd);
+    mirFreeFunction(fn);
+    if (failed) {
+        fprintf(stderr, "%s: write failed\n", argv[1]);
+        return 1;
+    }
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%ld bytes in %.3f ms, %.0f MB/s\n", bytes, seconds * 1e3, bytes / seconds / 1e6);
+    return 0;
+}
@@ -0,0 +1,13 @@
+# benchmarks/locals.awk - write a program whose one function has n locals
+# (awk -v n=10000), for timing how compile time grows with function size.
+# big is @noinline and called with a variable, so compile-time evaluation
+# cannot replace the call with its result and drop the function.
+BEGIN {
+    print "@noinline\nfunc int big(int a) {\n    var acc: int = a;"
+    for (i = 0; i < n; i++) {
+        printf "    let v%d: int = acc + %d;\n", i, i
+        printf "    acc = v%d - %d + 1;\n", i, i
+    }
+    print "    return acc;\n}\nfunc int main() {"
+    print "    var a: int = 5;\n    sys.IO.print.PrintIntLn(big(a));\n    return 0;\n}"
+}
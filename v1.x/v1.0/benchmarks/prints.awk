@@ -0,0 +1,12 @@
+# benchmarks/prints.awk - write a program of 10 functions with 500 prints
+# each, for timing how fast minoc -S writes assembly
+BEGIN {
+    for (f = 0; f < 10; f++) {
+        printf "func int f%d(int n) {\n", f
+        for (i = 0; i < 500; i++) printf "    sys.IO.print.PrintIntLn(n + %d);\n", i
+        print "    return n;\n}\n"
+    }
+    print "func int main() {\n    var n: int = 1;"
+    for (f = 0; f < 10; f++) printf "    n = f%d(n);\n", f
+    print "    return 0;\n}"
+}
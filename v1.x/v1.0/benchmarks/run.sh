@@ -0,0 +1,87 @@
+#!/bin/sh
+# benchmarks/run.sh - measure the code minoc generates
+#
+# Prints one line per measurement and compares nothing; run it before and
+# after a change. Instruction counts are the instruction lines of the
+# minoc -S output, without directives and labels.
+#
+# Run from the directory with the Makefile: make bench, or benchmarks/run.sh
+MINOC=${MINOC:-./bin/minoc}
+BUILD_DIR=${BUILD_DIR:-build}
+CC=${CC:-gcc}
+work=$(mktemp -d "${TMPDIR:-/tmp}/minobench.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+
+# instructions <source> [flags...]: number of instructions minoc emits for it
+instructions() {
+    file=$1
+    shift
+    "$MINOC" "$@" -S -o "$work/count.s" "$file" > /dev/null || exit 1
+    grep -c "^	[a-z]" "$work/count.s"
+}
+
+# median <runs> <command...>: median wall time of the runs, in ms
+median() {
+    runs=$1
+    shift
+    : > "$work/times"
+    i=0
+    while [ "$i" -lt "$runs" ]; do
+        start=$(date +%s%N)
+        "$@" > /dev/null || exit 1
+        echo $(($(date +%s%N) - start)) >> "$work/times"
+        i=$((i + 1))
+    done
+    ns=$(sort -n "$work/times" | sed -n "$(((runs + 1) / 2))p")
+    echo "$((ns / 1000000)).$(printf %03d $((ns / 1000 % 1000))) ms"
+}
+
+for source in benchmarks/poly_div.mino benchmarks/poly_mul.mino benchmarks/spill.mino \
+              examples/simple.mino; do
+    echo "$(basename "$source" .mino): $(instructions "$source") instructions," \
+         "$(instructions "$source" -fno-peephole) without the peephole pass"
+done
+
+# The poly functions linked with driver.c: checksum and time of 2e7 calls
+for name in poly_div poly_mul; do
+    "$MINOC" -c -o "$work/$name.o" "benchmarks/$name.mino" > /dev/null || exit 1
+    $CC -O2 -o "$work/$name" benchmarks/driver.c "$work/$name.o" || exit 1
+    echo "$name: $("$work/$name")"
+done
+
+# Assembly output: -S on 10 functions of 500 prints each, and the rate
+# mirPrintFunction alone writes their instructions at (emit.c)
+awk -f benchmarks/prints.awk > "$work/prints.mino"
+time=$(median 5 "$MINOC" -S -o "$work/prints.s" "$work/prints.mino")
+bytes=$(wc -c < "$work/prints.s")
+rate=$(echo "$time" | awk -v bytes="$bytes" '{ printf "%.1f", bytes / $1 / 1000 }')
+echo "prints -S: $time for $bytes bytes of assembly, $rate MB/s end to end"
+$CC -O2 -Isrc/codegen -Iinclude -o "$work/emit" benchmarks/emit.c \
+    "$BUILD_DIR/mir.o" "$BUILD_DIR/emit.o" || exit 1
+echo "prints emit: $("$work/emit" "$work/emit.s")"
+
+# Compile latency on examples/simple.mino, median of 60 runs
+echo "simple -c: $(median 60 "$MINOC" -c -o "$work/simple.o" examples/simple.mino)"
+echo "simple executable: $(median 60 "$MINOC" -o "$work/simple" examples/simple.mino)"
+echo "simple --via-asm: $(median 60 "$MINOC" --via-asm -o "$work/simple" examples/simple.mino)"
+
+# --run against building and then running the executable
+"$MINOC" -o "$work/simple" examples/simple.mino > /dev/null || exit 1
+echo "simple run executable: $(median 60 "$work/simple")"
+echo "simple --run: $(median 60 "$MINOC" --run examples/simple.mino)"
+
+# Compile time of one function with 10k, 20k and 40k locals. Every pass is
+# linear in the function's size, so each doubling should take about twice
+# as long; the ratio to the previous size is printed next to the time.
+previous=
+for n in 10000 20000 40000; do
+    awk -v n=$n -f benchmarks/locals.awk > "$work/locals.mino"
+    time=$(median 5 "$MINOC" -c -o "$work/locals.o" "$work/locals.mino")
+    if [ -n "$previous" ]; then
+        ratio=$(echo "$time $previous" | awk '{ printf "%.2f", $1 / $3 }')
+        echo "locals $n: $time, ${ratio}x the previous size (linear: 2x)"
+    else
+        echo "locals $n: $time"
+    fi
+    previous=$time
+done
@@ -21,7 +21,7 @@ typedef struct
     void (*PrintFloat)(float value);
     void (*PrintDouble)(double value);
     void (*PrintString)(const char* str);
-    void (*println)(const char* format, ...);
+    void (*println)(const char* str, ...);
     void (*PrintIntLn)(int value);
     void (*printObject)(void* obj, const char* type);
 
@@ -58,8 +58,29 @@ typedef struct {
 
 extern System sys;
 
+// Fills in `sys`; call it before using the table. Compiled Mino programs
+// call the flattened sys_* functions below and never need it.
 void initSystem();
 
+// Purity annotation for runtime exports: the result depends only on the
+// arguments and the call has no side effects. The compiler's runtime
+// registry (generated from this header) uses it to fold constant calls.
+#if defined(__GNUC__)
+#define MINO_PURE __attribute__((const))
+#else
+#define MINO_PURE
+#endif
+
+// Flattened exports for compiler-generated calls (sys.IO.print.PrintInt -> sys_IO_print_PrintInt)
+void sys_IO_print_PrintInt(int v);
+void sys_IO_print_PrintFloat(float v);
+void sys_IO_print_PrintDouble(double v);
+void sys_IO_print_PrintString(const char* s);
+void sys_IO_print_println(const char* s);
+void sys_IO_print_PrintIntLn(int v);
+void sys_IO_scanner_scanInt(int* p);
+int sys_IO_scanner_inputInt(const char* p);
+
     // Math module (basic functions)
     typedef struct {
         double (*sin)(double);
@@ -76,18 +97,18 @@ void initSystem();
     extern MathModule mathModule; /* optional global reference */
 
     // C-friendly math wrappers
-    double sys_sin(double v);
-    double sys_cos(double v);
-    double sys_tan(double v);
-    double sys_sqrt(double v);
-    double sys_pow(double a, double b);
-    double sys_floor(double v);
-    double sys_ceil(double v);
-    double sys_abs(double v);
+    MINO_PURE double sys_sin(double v);
+    MINO_PURE double sys_cos(double v);
+    MINO_PURE double sys_tan(double v);
+    MINO_PURE double sys_sqrt(double v);
+    MINO_PURE double sys_pow(double a, double b);
+    MINO_PURE double sys_floor(double v);
+    MINO_PURE double sys_ceil(double v);
+    MINO_PURE double sys_abs(double v);
 
     // Integer math helpers (callable from generated code using integer ABI)
-    int sys_Math_absInt(int v);
-    int sys_Math_powInt(int a, int b);
+    MINO_PURE int sys_Math_absInt(int v);
+    MINO_PURE int sys_Math_powInt(int a, int b);
 
 // Convenience C runtime API (simplified helpers used by generated code)
 // These functions are thin wrappers around the System struct above.
@@ -116,4 +137,18 @@ double sys_time_seconds(void);
 int sys_rand_int(void);
 void sys_srand_seed(unsigned int seed);
 
+// Arrays: `length` 8-byte elements after a 16-byte header whose second word
+// holds the length. Returns the 16-byte aligned first element. The compiler
+// frees the arrays it can prove unused with sys_array_free (a temporary once
+// its method has run, a local at the end of its block); the rest live until
+// the program exits.
+void* sys_array_new(size_t length);
+void sys_array_free(void* array);
+
+// Profiling (minoc --profile-generate): an instrumented main passes its
+// counter layout, one "name checksum blocks" line per function, and the
+// counts are written at exit to $MINO_PROFILE_FILE (default.minoprof by
+// default), added to those of earlier runs of the same code.
+void sys_profile_start(const char* layout);
+
 #endif
\ No newline at end of file
@@ -23,12 +23,35 @@ typedef enum {
     NODE_LITERAL,
     NODE_VARIABLE,
     NODE_ASSIGN,
-    NODE_INCLUDE
+    NODE_INCLUDE,
+    NODE_ARRAY_LITERAL,
+    NODE_LAMBDA
 } NodeType;
 
+// Inlining preference attached to a function declaration
+typedef enum {
+    INLINE_DEFAULT,     // left to the inliner's cost model
+    INLINE_ALWAYS,      // @inline
+    INLINE_NEVER        // @noinline
+} InlineHint;
+
+// Built-in method an array call resolves to, set by semantic analysis
+typedef enum {
+    ARRAY_METHOD_NONE,      // not a call on an array
+    ARRAY_METHOD_EACH,      // a.each((x) => ...)
+    ARRAY_METHOD_MAP,       // a.map((x) => ...)
+    ARRAY_METHOD_REDUCE,    // a.reduce(init, (acc, x) => ...)
+    ARRAY_METHOD_SUM        // a.sum()
+} ArrayMethod;
+
 // Basic AST structure
 typedef struct ASTNode ASTNode;
 
+// Resolution results cached on nodes (defined in namespace.h / semantic.h)
+struct NamespaceNode;
+struct Symbol;
+struct RuntimeFunc;
+
 struct ASTNode {
     NodeType type;
     int line;
@@ -46,31 +69,56 @@ struct ASTNode {
             int paramCount;
             ASTNode* returnType;
             ASTNode* body;
+            InlineHint inlineHint;  // from @inline / @noinline
+            int slotCount;          // frame slots of params and locals, set by semantic analysis
         } function;
         
         struct {
             char* name;
             ASTNode* type;
             ASTNode* initializer;
+            int isMutable;          // declared with 'var' rather than 'let'
+            int slot;               // frame slot of a param or local, -1 for globals
         } variable;
         
         struct {
             Token token;
+            // set by constant folding: the node holds an integer computed at
+            // compile time and the token carries no source text
+            int folded;
+            long long value;
+            int isArray;            // a type keyword followed by '[]'
         } literal;
         
         struct {
             char* name;
+            int slot;               // slot of the local it names, -1 otherwise
         } varRef;
 
             struct {
                 ASTNode* callee;
                 ASTNode** args;
                 int argCount;
+                // runtime registry entry when the callee is a sys_* export
+                const struct RuntimeFunc* runtime;
+                // the FUNCTION_DECL of a Mino callee, set by semantic analysis
+                ASTNode* function;
+                // a method on an array receiver (callee->get.object): its
+                // element type keyword and the first of the three hidden
+                // frame slots its loop keeps the index and accumulators in
+                ArrayMethod arrayMethod;
+                TokenType elementType;
+                int slot;
             } call;
 
             struct {
                 ASTNode* object;
                 char* name;
+                // cached by resolveQualifiedName / semantic analysis
+                struct NamespaceNode* ns;
+                struct Symbol* symbol;
+                const char* linkName;
+                int isLength;       // 'a.length' on an array
             } get;
         
         struct {
@@ -79,6 +127,12 @@ struct ASTNode {
             ASTNode* right;
         } binary;
         
+        // 'int(x)' / 'float(x)': op is the TOKEN_INT or TOKEN_FLOAT keyword
+        struct {
+            Token op;
+            ASTNode* operand;
+        } unary;
+
         struct {
             ASTNode* target;
             ASTNode* value;
@@ -87,10 +141,39 @@ struct ASTNode {
         struct {
             ASTNode* value;
         } returnStmt;
+
+        // '{ ... }' body of a loop; opens its own scope
+        struct {
+            ASTNode** statements;
+            int count;
+        } block;
+
+        // NODE_WHILE_STMT for both 'while (cond)' and 'for (init; cond; step)';
+        // init, condition and step may be NULL
+        struct {
+            ASTNode* init;
+            ASTNode* condition;
+            ASTNode* step;
+            ASTNode* body;
+        } loop;
         
         struct {
             char* filename;
         } include;
+
+        // '[a, b, c]': elements of one primitive type
+        struct {
+            ASTNode** elements;
+            int count;
+        } array;
+
+        // '(acc, x) => expr', only as an argument of an array method;
+        // params are NODE_VAR_DECLs whose types semantic analysis infers
+        struct {
+            ASTNode** params;
+            int paramCount;
+            ASTNode* body;
+        } lambda;
     };
 };
 
@@ -102,11 +185,16 @@ ASTNode* createVarNode(char* name, ASTNode* type, ASTNode* initializer);
 ASTNode* createLiteralNode(Token token);
 ASTNode* createVarRefNode(char* name);
 ASTNode* createBinaryNode(Token op, ASTNode* left, ASTNode* right);
+ASTNode* createUnaryNode(Token op, ASTNode* operand);
 ASTNode* createAssignmentNode(ASTNode* target, ASTNode* value);
 ASTNode* createReturnNode(ASTNode* value);
+ASTNode* createBlockNode(ASTNode** statements, int count);
+ASTNode* createLoopNode(ASTNode* init, ASTNode* condition, ASTNode* step, ASTNode* body);
 ASTNode* createIncludeNode(char* filename);
 ASTNode* createCallNode(ASTNode* callee, ASTNode** args, int argCount);
 ASTNode* createGetNode(ASTNode* object, char* name);
+ASTNode* createArrayNode(ASTNode** elements, int count);
+ASTNode* createLambdaNode(ASTNode** params, int paramCount, ASTNode* body);
 
 // AST free
 void freeAST(ASTNode* node);
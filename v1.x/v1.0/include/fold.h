@@ -0,0 +1,17 @@
+// include/fold.h - constant folding and propagation over the checked AST
+#ifndef MINO_FOLD_H
+#define MINO_FOLD_H
+
+#include "ast.h"
+
+// Evaluate constant integer arithmetic at compile time (64-bit two's
+// complement wraparound) and substitute `let` bindings whose initializers
+// fold to a constant into their uses. Rewrites nodes in place.
+// Calls with constant arguments to functions that only compute with
+// integers, and to pure integer runtime helpers, are evaluated and
+// replaced by their results, within step and call-depth limits.
+// Runs after typeCheck; returns 1 on success, 0 if a constant expression
+// is invalid (division by zero, INT64_MIN / -1).
+int foldConstants(ASTNode* program);
+
+#endif
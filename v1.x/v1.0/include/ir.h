@@ -0,0 +1,262 @@
+// include/ir.h - SSA intermediate representation between the AST and codegen
+//
+// A module holds functions; a function is a list of basic blocks; a block
+// is a list of three-address instructions ending in exactly one
+// terminator. Every instruction that produces a value is that value (%id),
+// so operands point straight at their defining instruction. Phis sit at
+// the start of a block and take one operand per predecessor, in the order
+// of block->preds.
+#ifndef MINO_IR_H
+#define MINO_IR_H
+
+#include <stdio.h>
+#include "ast.h"
+
+struct RuntimeFunc;
+
+typedef enum {
+    IRT_VOID,
+    IRT_I64,        // int, bool
+    IRT_F64,        // float (IEEE double)
+    IRT_PTR,        // string, array (pointer to its first element)
+    IRT_V2I64,      // two int lanes of an array, in one XMM register
+    IRT_V2F64       // two float lanes
+} IRType;
+
+typedef enum {
+    IR_CONST,       // imm: integer value or f64 bit pattern
+    IR_PARAM,       // imm: parameter index
+    IR_STRING,      // imm: index into module->strings
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_REM,         // remainder of the truncating division, sign of the dividend
+    IR_EQ,          // comparisons of two integers or two floats: 1 or 0
+    IR_NE,
+    IR_LT,
+    IR_LE,
+    IR_GT,
+    IR_GE,
+    IR_ITOF,        // int -> float
+    IR_FTOI,        // float -> int, truncating toward zero
+    IR_LENGTH,      // element count of array args[0]
+    IR_LOAD,        // element args[1] of array args[0]; a vector type loads it and the next
+    IR_STORE,       // element args[1] of array args[0] = args[2] (scalar or vector)
+    IR_SPLAT,       // vector with args[0] in every lane
+    IR_HADD,        // sum of the lanes of an int vector
+    IR_CALL,        // sym: link name, args: arguments
+    IR_COUNT,       // bump profile counter imm (--profile-generate)
+    IR_PHI,         // args[i] flows in from block->preds[i]
+    IR_JMP,         // terminator: -> targets[0]
+    IR_BR,          // terminator: args[0] != 0 ? targets[0] : targets[1]
+    IR_RET,         // terminator: optional args[0]
+    IR_OP_COUNT
+} IROpcode;
+
+typedef struct IRInst IRInst;
+typedef struct IRBlock IRBlock;
+typedef struct IRFunction IRFunction;
+
+struct IRInst {
+    IROpcode op;
+    IRType type;
+    int id;                         // value number, printed as %id
+    IRInst** args;
+    int argCount;
+    int argCapacity;
+    long long imm;
+    const char* sym;
+    const struct RuntimeFunc* runtime;  // registry entry for sys_* callees
+    IRBlock* targets[2];
+    IRBlock* block;                 // owning block, NULL once removed
+    IRInst* prev;
+    IRInst* next;
+    int line;                       // source line, 0 if unknown
+    int inlineDecided;              // call site already considered by the inliner
+};
+
+struct IRBlock {
+    int id;
+    IRInst* first;
+    IRInst* last;
+    IRBlock** preds;
+    int predCount;
+    int predCapacity;
+    IRFunction* func;
+    IRBlock* next;                  // layout order
+
+    // Filled in by irComputeDominators
+    IRBlock* idom;
+    int rpoIndex;                   // -1 when unreachable
+
+    long long count;                // profiled executions, -1 without a profile
+};
+
+struct IRFunction {
+    char* name;
+    IRType returnType;
+    int paramCount;
+    IRType* paramTypes;             // IRT_I64 unless declared otherwise
+    IRBlock* entry;
+    IRBlock* lastBlock;
+    int nextBlockId;
+    int nextValueId;
+    InlineHint inlineHint;          // @inline / @noinline on the declaration
+    int line;                       // declaration line, 0 if unknown
+    long long entryCount;           // profiled calls, -1 without a profile
+    int index;                      // position in the module, set by the call graph (inline.c)
+    int recursive;                  // on a call-graph cycle, set by irCallGraphOrder
+    IRFunction* prev;
+    IRFunction* next;
+};
+
+// A string literal with its escapes decoded. Literals that end another
+// literal share its bytes: `base` is the literal actually emitted and
+// `offset` where this one starts in it (see irMergeStrings).
+typedef struct {
+    char* bytes;                    // NUL-terminated; may also contain NULs
+    int length;                     // without the terminator
+    int base;
+    int offset;
+} IRString;
+
+typedef struct {
+    IRFunction* functions;
+    IRFunction* lastFunction;
+    int functionCount;
+    IRFunction** functionHash;      // open addressing by name, NULL until the next lookup
+    int functionHashCapacity;
+    IRString* strings;              // string literal pool (.LC<index>)
+    int stringCount;
+    int stringCapacity;
+    int* stringHash;                // open addressing over string indices, -1 = empty
+    int stringHashCapacity;
+    FILE* remarks;                  // optimization remarks (inlining decisions), NULL = silent
+    int counterCount;               // IR_COUNT counters of an instrumented module
+    long long hottestCount;         // highest block count of the applied profile, -1 without one
+} IRModule;
+
+// ============ Construction (ir.c) ============
+
+IRModule* irCreateModule(void);
+void irFreeModule(IRModule* module);
+// Intern a literal given as source text without its quotes (escapes as
+// in C: \n, \t, \", \\, octal, \x...); returns its pool index
+int irModuleString(IRModule* module, const char* chars, int length);
+// Point every literal that is a suffix of another at the longer one
+void irMergeStrings(IRModule* module);
+
+IRFunction* irCreateFunction(IRModule* module, const char* name, IRType returnType, int paramCount);
+IRFunction* irFindFunction(IRModule* module, const char* name);
+// Unlink a function from the module and free it
+void irRemoveFunction(IRModule* module, IRFunction* fn);
+IRBlock* irCreateBlock(IRFunction* fn);
+// New block placed right after `after` in layout order
+IRBlock* irCreateBlockAfter(IRFunction* fn, IRBlock* after);
+// Move the instructions following `at` into a new block placed after
+// `block`; successors of the moved terminator take the new block as pred
+IRBlock* irSplitBlock(IRBlock* block, IRInst* at);
+void irAddPred(IRBlock* block, IRBlock* pred);
+void irRemovePred(IRBlock* block, IRBlock* pred);
+
+IRInst* irNewInst(IRFunction* fn, IROpcode op, IRType type);
+void irAddArg(IRInst* inst, IRInst* arg);
+void irAppend(IRBlock* block, IRInst* inst);
+void irPrepend(IRBlock* block, IRInst* inst);
+void irInsertBefore(IRInst* pos, IRInst* inst);
+void irUnlink(IRInst* inst);
+void irFreeInst(IRInst* inst);
+
+IRInst* irTerminator(IRBlock* block);
+int irIsTerminator(const IRInst* inst);
+int irIsCompare(IROpcode op);
+int irSuccessors(IRBlock* block, IRBlock** out);
+// Whether removing the instruction could change behaviour
+int irHasSideEffects(const IRInst* inst);
+
+// Redirect every operand listed in replacements[id] (NULL = keep),
+// following chains
+void irApplyReplacements(IRFunction* fn, IRInst** replacements);
+
+// Dominator tree over blocks reachable from the entry; returns the blocks
+// in reverse postorder (caller frees) and their count through outCount
+IRBlock** irComputeDominators(IRFunction* fn, int* outCount);
+int irDominates(IRBlock* a, IRBlock* b);
+
+const char* irTypeName(IRType type);
+const char* irOpName(IROpcode op);
+void irDumpFunction(IRModule* module, IRFunction* fn, FILE* out);
+void irDumpModule(IRModule* module, FILE* out);
+
+// ============ Lowering from the AST (irbuild.c) ============
+
+// Build SSA for every function in a checked (and folded) program
+IRModule* irBuildModule(ASTNode* program);
+
+// ============ Verification (irverify.c) ============
+
+// Check structural and SSA invariants; reports problems on stderr and
+// returns 1 when the function is well formed
+int irVerifyFunction(IRFunction* fn);
+int irVerifyModule(IRModule* module);
+
+// ============ Profiles (profile.c) ============
+
+// The counter array an instrumented module defines; the runtime writes it
+// out at exit (sys_profile_start in System.c)
+#define IR_PROFILE_COUNTERS "__mino_profile_counters"
+
+// Count every block of every function and start the runtime's profile
+// writer at the top of main. Run on the IR as built, before any pass.
+void irInstrumentModule(IRModule* module);
+
+// Load the block counts written by an instrumented build of the same
+// program into a module as built, before any pass; functions whose code
+// changed since are left without counts. Returns 0 if the file cannot be
+// read.
+int irApplyProfile(IRModule* module, const char* path);
+
+// ============ Passes (passes.c) ============
+
+// A pass returns 1 when it changed the function
+typedef int (*IRPassFn)(IRModule* module, IRFunction* fn);
+
+#define IR_MAX_PASSES 32
+
+typedef struct {
+    const char* name;
+    IRPassFn run;
+} IRPass;
+
+typedef struct {
+    IRPass passes[IR_MAX_PASSES];
+    int count;
+    int verifyEach;                 // run the verifier after every pass
+} IRPassManager;
+
+void irInitPassManager(IRPassManager* pm);
+void irAddPass(IRPassManager* pm, const char* name, IRPassFn run);
+void irAddDefaultPasses(IRPassManager* pm);
+// Run the pipeline over every function, callees before their callers;
+// returns 0 if verification failed
+int irRunPasses(IRPassManager* pm, IRModule* module);
+
+// Functions in bottom-up call-graph order (callees first), also setting
+// IRFunction.recursive for irPassInline; caller frees
+IRFunction** irCallGraphOrder(IRModule* module, int* outCount);
+// Drop the functions main cannot reach through calls; nothing is dropped
+// from a module without main. Returns how many were removed.
+int irRemoveUnreachableFunctions(IRModule* module);
+
+int irPassInline(IRModule* module, IRFunction* fn);
+int irPassFold(IRModule* module, IRFunction* fn);
+int irPassCSE(IRModule* module, IRFunction* fn);
+int irPassDCE(IRModule* module, IRFunction* fn);
+
+// ============ Loop passes (loops.c) ============
+
+int irPassLICM(IRModule* module, IRFunction* fn);
+int irPassIndVars(IRModule* module, IRFunction* fn);
+
+#endif
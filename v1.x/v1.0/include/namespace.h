@@ -0,0 +1,37 @@
+// include/namespace.h
+#ifndef MINO_NAMESPACE_H
+#define MINO_NAMESPACE_H
+
+#include "ast.h"
+
+// Qualified-name trie for dotted member chains (e.g. sys.IO.print.PrintInt).
+// Every node is keyed by an interned segment, so children are matched by
+// pointer; the dotted and flattened names are built once when a node is created.
+typedef struct NamespaceNode NamespaceNode;
+
+struct NamespaceNode {
+    const char* segment;        // interned segment, e.g. "print"
+    const char* qualifiedName;  // interned dotted name, e.g. "sys.IO.print"
+    const char* linkName;       // interned linker name, e.g. "sys_IO_print"
+    NamespaceNode* parent;
+    NamespaceNode* children;    // first child
+    NamespaceNode* sibling;     // next child of the same parent
+};
+
+// Return the canonical copy of a string; equal strings share one pointer
+const char* internString(const char* chars, int length);
+
+// Root of the trie (its children are the top-level names such as "sys")
+NamespaceNode* namespaceRoot(void);
+
+// Find or create the child of parent for an interned segment
+NamespaceNode* namespaceChild(NamespaceNode* parent, const char* segment);
+
+// Resolve a VARIABLE or GET_EXPR chain to its trie node. GET_EXPR nodes cache
+// the result (and its linker name) so later lookups are a field read.
+NamespaceNode* resolveQualifiedName(ASTNode* node);
+
+// Release the trie and the intern table
+void freeNamespaces(void);
+
+#endif
@@ -0,0 +1,62 @@
+// include/runtime_abi.h
+#ifndef MINO_RUNTIME_ABI_H
+#define MINO_RUNTIME_ABI_H
+
+// Typed registry of the runtime's exported sys_* functions. The table is
+// generated from include/System.h by tools/genabi.c at build time and
+// indexed by a perfect hash of the linker name.
+
+#define RUNTIME_MAX_PARAMS 6
+
+// C-level types that appear in the runtime ABI
+typedef enum {
+    ABI_VOID,
+    ABI_INT,        // int / unsigned int (32-bit, integer register)
+    ABI_LONG,       // size_t (64-bit, integer register)
+    ABI_FLOAT,      // float (XMM register, single precision)
+    ABI_DOUBLE,     // double (XMM register)
+    ABI_STRING,     // const char* / char*
+    ABI_PTR         // any other pointer (FILE*, void*, int*, ...)
+} AbiType;
+
+typedef struct RuntimeFunc {
+    const char* name;                     // linker name, e.g. "sys_sqrt"
+    AbiType ret;
+    int paramCount;
+    AbiType params[RUNTIME_MAX_PARAMS];
+    int isVariadic;                       // trailing "..." in the prototype
+    int isPure;                           // declared MINO_PURE
+} RuntimeFunc;
+
+// Seeded FNV-1a; shared by the generator and the lookup
+static inline unsigned int runtimeAbiHash(const char* name, unsigned int seed) {
+    unsigned int hash = 2166136261u ^ seed;
+    while (*name) {
+        hash ^= (unsigned char)(*name);
+        hash *= 16777619;
+        name++;
+    }
+    return hash ^ (hash >> 15);
+}
+
+// Generated tables (build/runtime_abi_table.c)
+extern const RuntimeFunc runtimeAbiFuncs[];
+extern const int runtimeAbiCount;
+extern const short runtimeAbiSlots[];   // function index per hash slot, -1 if empty
+extern const unsigned int runtimeAbiSeed;
+extern const unsigned int runtimeAbiMask;
+
+// Entry point of each runtime export, in runtimeAbiFuncs order. Only
+// defined when the runtime itself is linked in (build/runtime_abi_addrs.c)
+extern void (*const runtimeAbiAddresses[])(void);
+
+// Look up a runtime export by linker name; NULL if the runtime has no such function
+const RuntimeFunc* lookupRuntimeFunc(const char* name);
+
+// Whether a value of this ABI type travels in an XMM register
+int abiIsFloating(AbiType type);
+
+// Mino type name for an ABI type ("int", "float", "string", "void", "ptr")
+const char* abiMinoTypeName(AbiType type);
+
+#endif
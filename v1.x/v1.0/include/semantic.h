@@ -1,6 +1,7 @@
 #ifndef MINO_SEMANTIC_H
 #define MINO_SEMANTIC_H
 
+#include <stddef.h>
 #include "ast.h"
 
 // Forward declarations
@@ -23,7 +24,10 @@ struct Symbol {
     ASTNode* typeNode;      // type information
     int scopeDepth;         // scope depth
     int definedLine;        // definition line
+    int isMutable;          // a 'var' local that assignments may change
+    int slot;               // frame slot of a param or local, -1 otherwise
     Symbol* next;           // next in linked list
+    Symbol* defined;        // previously defined symbol, for unwinding scopes
 };
 
 // Symbol table structure
@@ -31,7 +35,14 @@ struct SymbolTable {
     Symbol** buckets;       // hash buckets
     int capacity;           // capacity
     int count;              // number of symbols
+    Symbol* lastDefined;    // most recent definition; exitScope unwinds from here
     int scopeDepth;         // current scope depth
+    int slotCount;          // frame slots handed out (local tables only)
+    SymbolTable* parent;    // read-only enclosing layer (globals), or NULL
+    ASTNode* function;      // function whose body is being checked, or NULL
+    char* diagnostics;      // buffered error text, or NULL to print directly
+    size_t diagLength;
+    size_t diagCapacity;
 };
 
 // Type information
@@ -45,6 +56,8 @@ typedef struct TypeInfo {
 
 // Function declarations
 SymbolTable* createSymbolTable();
+// Local layer over a read-only parent; diagnostics are buffered in the table
+SymbolTable* createLocalSymbolTable(SymbolTable* parent);
 void freeSymbolTable(SymbolTable* table);
 int enterScope(SymbolTable* table);
 int exitScope(SymbolTable* table);
@@ -10,6 +10,7 @@ typedef enum {
     TOKEN_COMMA, TOKEN_DOT, TOKEN_SEMICOLON, // , . ;
     TOKEN_COLON, TOKEN_QUESTION, // : ?
     TOKEN_ARROW,            
+    TOKEN_FAT_ARROW,                        // => (lambdas)
     
     // Operators
     TOKEN_PLUS, TOKEN_MINUS,                // + -
@@ -37,6 +38,7 @@ typedef enum {
 
     TOKEN_HASH,           // #
     TOKEN_HASH_INCLUDE,   // #include
+    TOKEN_AT,             // @ (function attributes)
     
     // Special
     TOKEN_ERROR, TOKEN_EOF
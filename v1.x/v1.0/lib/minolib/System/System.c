@@ -5,38 +5,30 @@
 #include <math.h>
 #include <System.h>
 
-//============= print =================
-static void PrintIntImpl (int value)
-{
-    printf("%d", value);
-}
-
-static void PrintFloatImpl(float value)
-{
-    printf("%f", value);
-}
-
-static void PrintDoubleImpl(double value)
-{
-    printf("%lf", value);
-}
-
-static void PrintStringImpl(const char* str)
-{
-    printf("%s", str);
-}
-
-static void printlnImpl(const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    vprintf(format, args);
-    va_end(args);
-    printf("\n");
-}
+// Runtime entry points are defined directly: generated code calls the
+// flattened sys_* symbols, which do the work themselves instead of loading
+// a pointer from the `sys` table and calling through it. They have hidden
+// visibility so calls within a linked image bind locally (no PLT, and LTO
+// may inline them); the `sys` table below is only a compatibility view
+// for C code written against the struct API.
+#if defined(__GNUC__)
+#define MINO_RUNTIME __attribute__((visibility("hidden")))
+#else
+#define MINO_RUNTIME
+#endif
 
-static void PrintIntLnImpl(int value)
-{
-    printf("%d\n", value);
+//============= print =================
+MINO_RUNTIME void sys_IO_print_PrintInt(int v) { printf("%d", v); }
+MINO_RUNTIME void sys_IO_print_PrintFloat(float v) { printf("%f", v); }
+MINO_RUNTIME void sys_IO_print_PrintDouble(double v) { printf("%lf", v); }
+MINO_RUNTIME void sys_IO_print_PrintString(const char* s) { fputs(s, stdout); }
+MINO_RUNTIME void sys_IO_print_println(const char* s) { puts(s); }
+MINO_RUNTIME void sys_IO_print_PrintIntLn(int v) { printf("%d\n", v); }
+
+// The table's println is declared variadic; like the flattened entry point
+// it prints its argument verbatim, so a '%' in the text is not a format.
+static void printlnImpl(const char* s, ...) {
+    sys_IO_print_println(s);
 }
 
 static void printObjectImpl(void* obj, const char* type) {
@@ -44,8 +36,8 @@ static void printObjectImpl(void* obj, const char* type) {
 }
 
 //======================== scanner ============================
-static void scanIntImpl(int* target) {
-    scanf("%d", target);
+MINO_RUNTIME void sys_IO_scanner_scanInt(int* p) {
+    scanf("%d", p);
     while (getchar() != '\n');
 }
 
@@ -67,7 +59,7 @@ static void scanStringImpl(char* buffer, int maxLength) {
     }
 }
 
-static int inputIntImpl(const char* prompt) {
+MINO_RUNTIME int sys_IO_scanner_inputInt(const char* prompt) {
     int value;
     printf("%s", prompt);
     scanf("%d", &value);
@@ -94,25 +86,27 @@ static void readLineImpl(char* buffer, int size) {
 System sys;
 MathModule mathModule;
 
-// Initialize system modules
+// Initialize system modules. Only C code that calls through the `sys`
+// table needs this, and calls it itself: filling the table in from a
+// constructor would keep every function it points to in every program.
 void initSystem() 
 {
     //Initialize print mod
-    sys.IO.print.PrintInt = PrintIntImpl;
-    sys.IO.print.PrintFloat = PrintFloatImpl;
-    sys.IO.print.PrintDouble = PrintDoubleImpl;
-    sys.IO.print.PrintString = PrintStringImpl;
+    sys.IO.print.PrintInt = sys_IO_print_PrintInt;
+    sys.IO.print.PrintFloat = sys_IO_print_PrintFloat;
+    sys.IO.print.PrintDouble = sys_IO_print_PrintDouble;
+    sys.IO.print.PrintString = sys_IO_print_PrintString;
     sys.IO.print.println = printlnImpl;
-    sys.IO.print.PrintIntLn = PrintIntLnImpl;
+    sys.IO.print.PrintIntLn = sys_IO_print_PrintIntLn;
     sys.IO.print.printObject = printObjectImpl;
 
     //Initialize scanner mod
-    sys.IO.scanner.scanInt = scanIntImpl;        // void scanInt(int*)
-    sys.IO.scanner.scanFloat = scanDoubleImpl;    // void scanFloat(float*)
+    sys.IO.scanner.scanInt = sys_IO_scanner_scanInt;      // void scanInt(int*)
+    sys.IO.scanner.scanFloat = scanFloatImpl;    // void scanFloat(float*)
     sys.IO.scanner.scanDouble = scanDoubleImpl;  // void scanDouble(double*)
     sys.IO.scanner.scanString = scanStringImpl;  // void scanString(char*, int)
     
-    sys.IO.scanner.inputInt = inputIntImpl;      // int inputInt(const char*)
+    sys.IO.scanner.inputInt = sys_IO_scanner_inputInt;    // int inputInt(const char*)
     sys.IO.scanner.inputFloat = inputFloatImpl;  // float inputFloat(const char*)
     
     sys.IO.scanner.readLine = readLineImpl;      // void readLine(char*, int)
@@ -128,21 +122,10 @@ void initSystem()
     mathModule.abs = fabs;
 }
 
-// Export simple wrappers for assembly-level calls (flattened dotted names)
-void sys_IO_print_PrintInt(int v) { sys.IO.print.PrintInt(v); }
-void sys_IO_print_PrintFloat(float v) { sys.IO.print.PrintFloat(v); }
-void sys_IO_print_PrintDouble(double v) { sys.IO.print.PrintDouble(v); }
-void sys_IO_print_PrintString(const char* s) { sys.IO.print.PrintString(s); }
-void sys_IO_print_println(const char* s) { sys.IO.print.println(s); }
-void sys_IO_print_PrintIntLn(int v) { sys.IO.print.PrintIntLn(v); }
-
-void sys_IO_scanner_scanInt(int* p) { sys.IO.scanner.scanInt(p); }
-int sys_IO_scanner_inputInt(const char* p) { return sys.IO.scanner.inputInt(p); }
-
 // Simple C-friendly runtime wrappers
-void sys_print(const char* s) { if (!s) return; sys.IO.print.PrintString(s); }
-void sys_println(const char* s) { sys.IO.print.println(s ? s : ""); }
-void sys_printlnf(const char* fmt, ...) {
+MINO_RUNTIME void sys_print(const char* s) { if (!s) return; fputs(s, stdout); }
+MINO_RUNTIME void sys_println(const char* s) { puts(s ? s : ""); }
+MINO_RUNTIME void sys_printlnf(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
     vprintf(fmt, args);
@@ -150,9 +133,9 @@ void sys_printlnf(const char* fmt, ...) {
     printf("\n");
 }
 
-void sys_PrintStringLn(const char* s) { if (!s) return; printf("%s\n", s); }
+MINO_RUNTIME void sys_PrintStringLn(const char* s) { if (!s) return; puts(s); }
 
-char* sys_readline(void) {
+MINO_RUNTIME char* sys_readline(void) {
     char* line = NULL;
     size_t n = 0;
     ssize_t r = getline(&line, &n, stdin);
@@ -162,30 +145,30 @@ char* sys_readline(void) {
 }
 
 // File I/O helpers
-FILE* sys_fopen(const char* path, const char* mode) {
+MINO_RUNTIME FILE* sys_fopen(const char* path, const char* mode) {
     return fopen(path, mode);
 }
 
-int sys_fclose(FILE* f) {
+MINO_RUNTIME int sys_fclose(FILE* f) {
     return fclose(f);
 }
 
-size_t sys_fread(void* ptr, size_t size, size_t nmemb, FILE* f) {
+MINO_RUNTIME size_t sys_fread(void* ptr, size_t size, size_t nmemb, FILE* f) {
     return fread(ptr, size, nmemb, f);
 }
 
-size_t sys_fwrite(const void* ptr, size_t size, size_t nmemb, FILE* f) {
+MINO_RUNTIME size_t sys_fwrite(const void* ptr, size_t size, size_t nmemb, FILE* f) {
     return fwrite(ptr, size, nmemb, f);
 }
 
-char* sys_fgets(char* s, int size, FILE* f) {
+MINO_RUNTIME char* sys_fgets(char* s, int size, FILE* f) {
     return fgets(s, size, f);
 }
 
-int sys_remove(const char* path) { return remove(path); }
+MINO_RUNTIME int sys_remove(const char* path) { return remove(path); }
 
 // Time and random
-double sys_time_seconds(void) {
+MINO_RUNTIME double sys_time_seconds(void) {
     struct timespec ts;
     if (clock_gettime(CLOCK_REALTIME, &ts) == 0) {
         return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
@@ -193,15 +176,116 @@ double sys_time_seconds(void) {
     return (double)time(NULL);
 }
 
-int sys_rand_int(void) { return rand(); }
-void sys_srand_seed(unsigned int seed) { srand(seed); }
+MINO_RUNTIME int sys_rand_int(void) { return rand(); }
+MINO_RUNTIME void sys_srand_seed(unsigned int seed) { srand(seed); }
+
+MINO_RUNTIME void sys_exit(int code) { fflush(stdout); exit(code); }
+
+MINO_RUNTIME void* sys_array_new(size_t length) {
+    // header and elements, rounded up to the alignment for aligned_alloc
+    size_t bytes = (16 + length * 8 + 15) & ~(size_t)15;
+    long long* header = aligned_alloc(16, bytes);
+    if (!header) {
+        fprintf(stderr, "Out of memory allocating an array of %zu elements\n", length);
+        exit(1);
+    }
+    header[0] = 0;
+    header[1] = (long long)length;
+    return header + 2;
+}
+
+MINO_RUNTIME void sys_array_free(void* array) {
+    if (array) free((long long*)array - 2);
+}
+
+// Profiling. The counters are defined by the instrumented program only,
+// hence the weak reference.
+extern long long __mino_profile_counters[] __attribute__((weak));
+static const char* profileLayout;
+
+#define PROFILE_HEADER "# mino profile v1\n"
+
+static char* readProfileFile(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    size_t length = 0, capacity = 4096;
+    char* text = (char*)malloc(capacity);
+    size_t n;
+    while (text && (n = fread(text + length, 1, capacity - length - 1, f)) > 0) {
+        length += n;
+        if (length + 1 == capacity) {
+            capacity *= 2;
+            text = (char*)realloc(text, capacity);
+        }
+    }
+    fclose(f);
+    if (text) text[length] = '\0';
+    return text;
+}
+
+// The counts after "name checksum blocks" in an earlier profile, or NULL
+static const char* findProfileRecord(const char* text, const char* key, size_t keyLength) {
+    const char* line = text;
+    while (line) {
+        if (strncmp(line, key, keyLength) == 0 && line[keyLength] == ' ') return line + keyLength;
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+    return NULL;
+}
+
+static void writeProfile(void) {
+    const char* path = getenv("MINO_PROFILE_FILE");
+    if (!path || !*path) path = "default.minoprof";
+    char* previous = readProfileFile(path);
+    if (previous && strncmp(previous, PROFILE_HEADER, strlen(PROFILE_HEADER)) != 0) {
+        free(previous);
+        previous = NULL;
+    }
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot write profile %s\n", path);
+        free(previous);
+        return;
+    }
+    fputs(PROFILE_HEADER, out);
+    const long long* counter = __mino_profile_counters;
+    const char* line = profileLayout;
+    while (*line) {
+        size_t keyLength = strcspn(line, "\n");
+        const char* blocksText = line + keyLength;
+        while (blocksText > line && blocksText[-1] != ' ') blocksText--;
+        long blocks = strtol(blocksText, NULL, 10);
+        const char* old = previous ? findProfileRecord(previous, line, keyLength) : NULL;
+        fprintf(out, "%.*s", (int)keyLength, line);
+        for (long i = 0; i < blocks; i++) {
+            long long count = counter[i];
+            if (old) {
+                char* end;
+                count += strtoll(old, &end, 10);
+                old = end;
+            }
+            fprintf(out, " %lld", count);
+        }
+        fputc('\n', out);
+        counter += blocks;
+        line += keyLength;
+        if (*line) line++;
+    }
+    if (fclose(out) != 0) fprintf(stderr, "Cannot write profile %s\n", path);
+    free(previous);
+}
 
-void sys_exit(int code) { fflush(stdout); exit(code); }
+MINO_RUNTIME void sys_profile_start(const char* layout) {
+    if (!layout || !__mino_profile_counters || profileLayout) return;
+    profileLayout = layout;
+    atexit(writeProfile);
+}
 
-void* sys_malloc(size_t n) { return malloc(n); }
-void sys_free(void* p) { free(p); }
+MINO_RUNTIME void* sys_malloc(size_t n) { return malloc(n); }
+MINO_RUNTIME void sys_free(void* p) { free(p); }
 
-char* sys_strdup(const char* s) {
+MINO_RUNTIME char* sys_strdup(const char* s) {
     if (!s) return NULL;
     size_t l = strlen(s) + 1;
     char* r = (char*)malloc(l);
@@ -209,7 +293,7 @@ char* sys_strdup(const char* s) {
     return r;
 }
 
-char* sys_itoa(int v) {
+MINO_RUNTIME char* sys_itoa(int v) {
     char buf[32];
     int n = snprintf(buf, sizeof(buf), "%d", v);
     if (n < 0) return NULL;
@@ -220,28 +304,23 @@ char* sys_itoa(int v) {
 }
 
 // Math wrappers
-double sys_sin(double v) { return mathModule.sin(v); }
-double sys_cos(double v) { return mathModule.cos(v); }
-double sys_tan(double v) { return mathModule.tan(v); }
-double sys_sqrt(double v) { return mathModule.sqrt(v); }
-double sys_pow(double a, double b) { return mathModule.pow(a,b); }
-double sys_floor(double v) { return mathModule.floor(v); }
-double sys_ceil(double v) { return mathModule.ceil(v); }
-double sys_abs(double v) { return mathModule.abs(v); }
+MINO_RUNTIME double sys_sin(double v) { return sin(v); }
+MINO_RUNTIME double sys_cos(double v) { return cos(v); }
+MINO_RUNTIME double sys_tan(double v) { return tan(v); }
+MINO_RUNTIME double sys_sqrt(double v) { return sqrt(v); }
+MINO_RUNTIME double sys_pow(double a, double b) { return pow(a, b); }
+MINO_RUNTIME double sys_floor(double v) { return floor(v); }
+MINO_RUNTIME double sys_ceil(double v) { return ceil(v); }
+MINO_RUNTIME double sys_abs(double v) { return fabs(v); }
 
 // Integer math helpers (use integer ABI)
-int sys_Math_absInt(int v) {
+MINO_RUNTIME int sys_Math_absInt(int v) {
     return v < 0 ? -v : v;
 }
 
-int sys_Math_powInt(int a, int b) {
+MINO_RUNTIME int sys_Math_powInt(int a, int b) {
     if (b < 0) return 0; // no negative exponents for int pow
     int res = 1;
     for (int i = 0; i < b; i++) res *= a;
     return res;
 }
-
-// Ensure system is initialized early when library is loaded
-__attribute__((constructor)) static void __system_auto_init(void) {
-    initSystem();
-}
\ No newline at end of file
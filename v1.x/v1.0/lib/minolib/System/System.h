@@ -19,7 +19,7 @@ typedef struct
     void (*PrintFloat)(float value);
     void (*PrintDouble)(double value);
     void (*PrintString)(const char* str);
-    void (*println)(const char* format, ...);
+    void (*println)(const char* str, ...);
     void (*printObject)(void* obj, const char* type);
 
 }PrintModule;
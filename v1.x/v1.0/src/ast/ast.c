@@ -58,6 +58,8 @@ ASTNode* createFunctionNode(char* name, ASTNode** params, int paramCount,
     node->function.paramCount = paramCount;
     node->function.returnType = returnType;
     node->function.body = body;
+    node->function.inlineHint = INLINE_DEFAULT;
+    node->function.slotCount = 0;
     return node;
 }
 
@@ -67,6 +69,8 @@ ASTNode* createVarNode(char* name, ASTNode* type, ASTNode* initializer) {
     node->variable.name = copyString(name);
     node->variable.type = type;
     node->variable.initializer = initializer;
+    node->variable.isMutable = 0;
+    node->variable.slot = -1;
     return node;
 }
 
@@ -74,6 +78,9 @@ ASTNode* createVarNode(char* name, ASTNode* type, ASTNode* initializer) {
 ASTNode* createLiteralNode(Token token) {
     ASTNode* node = createNode(NODE_LITERAL, token.line);
     node->literal.token = token;
+    node->literal.folded = 0;
+    node->literal.value = 0;
+    node->literal.isArray = 0;
     return node;
 }
 
@@ -81,6 +88,7 @@ ASTNode* createLiteralNode(Token token) {
 ASTNode* createVarRefNode(char* name) {
     ASTNode* node = createNode(NODE_VARIABLE, 0);
     node->varRef.name = copyString(name);
+    node->varRef.slot = -1;
     return node;
 }
 
@@ -93,6 +101,14 @@ ASTNode* createBinaryNode(Token op, ASTNode* left, ASTNode* right) {
     return node;
 }
 
+// Create unary node (a conversion to the type named by op)
+ASTNode* createUnaryNode(Token op, ASTNode* operand) {
+    ASTNode* node = createNode(NODE_UNARY_EXPR, op.line);
+    node->unary.op = op;
+    node->unary.operand = operand;
+    return node;
+}
+
 // Create assignment node
 ASTNode* createAssignmentNode(ASTNode* target, ASTNode* value) {
     ASTNode* node = createNode(NODE_ASSIGN, 0);
@@ -114,12 +130,35 @@ ASTNode* createReturnNode(ASTNode* value) {
     return node;
 }
 
+// Create block node
+ASTNode* createBlockNode(ASTNode** statements, int count) {
+    ASTNode* node = createNode(NODE_BLOCK_STMT, 0);
+    node->block.statements = statements;
+    node->block.count = count;
+    return node;
+}
+
+// Create loop node (while and for)
+ASTNode* createLoopNode(ASTNode* init, ASTNode* condition, ASTNode* step, ASTNode* body) {
+    ASTNode* node = createNode(NODE_WHILE_STMT, 0);
+    node->loop.init = init;
+    node->loop.condition = condition;
+    node->loop.step = step;
+    node->loop.body = body;
+    return node;
+}
+
 // Create function call node
 ASTNode* createCallNode(ASTNode* callee, ASTNode** args, int argCount) {
     ASTNode* node = createNode(NODE_CALL_EXPR, 0);
     node->call.callee = callee;
     node->call.args = args;
     node->call.argCount = argCount;
+    node->call.runtime = NULL;
+    node->call.function = NULL;
+    node->call.arrayMethod = ARRAY_METHOD_NONE;
+    node->call.elementType = TOKEN_INT;
+    node->call.slot = -1;
     return node;
 }
 
@@ -128,6 +167,27 @@ ASTNode* createGetNode(ASTNode* object, char* name) {
     ASTNode* node = createNode(NODE_GET_EXPR, 0);
     node->get.object = object;
     node->get.name = copyString(name);
+    node->get.ns = NULL;
+    node->get.symbol = NULL;
+    node->get.linkName = NULL;
+    node->get.isLength = 0;
+    return node;
+}
+
+// Create array literal node
+ASTNode* createArrayNode(ASTNode** elements, int count) {
+    ASTNode* node = createNode(NODE_ARRAY_LITERAL, 0);
+    node->array.elements = elements;
+    node->array.count = count;
+    return node;
+}
+
+// Create lambda node
+ASTNode* createLambdaNode(ASTNode** params, int paramCount, ASTNode* body) {
+    ASTNode* node = createNode(NODE_LAMBDA, 0);
+    node->lambda.params = params;
+    node->lambda.paramCount = paramCount;
+    node->lambda.body = body;
     return node;
 }
 
@@ -176,6 +236,9 @@ void freeAST(ASTNode* node) {
             freeAST(node->binary.left);
             freeAST(node->binary.right);
             break;
+        case NODE_UNARY_EXPR:
+            freeAST(node->unary.operand);
+            break;
         case NODE_CALL_EXPR:
             if (node->call.callee) freeAST(node->call.callee);
             for (int i = 0; i < node->call.argCount; i++) {
@@ -197,6 +260,22 @@ void freeAST(ASTNode* node) {
         case NODE_RETURN_STMT:
             freeAST(node->returnStmt.value);
             break;
+
+        case NODE_BLOCK_STMT:
+            for (int i = 0; i < node->block.count; i++) {
+                freeAST(node->block.statements[i]);
+            }
+            if (node->block.statements != NULL) {
+                free(node->block.statements);
+            }
+            break;
+
+        case NODE_WHILE_STMT:
+            freeAST(node->loop.init);
+            freeAST(node->loop.condition);
+            freeAST(node->loop.step);
+            freeAST(node->loop.body);
+            break;
             
         case NODE_VARIABLE:
             free(node->varRef.name);
@@ -209,14 +288,30 @@ void freeAST(ASTNode* node) {
         case NODE_INCLUDE:
             free(node->include.filename);
             break;
+
+        case NODE_ARRAY_LITERAL:
+            for (int i = 0; i < node->array.count; i++) {
+                freeAST(node->array.elements[i]);
+            }
+            if (node->array.elements != NULL) {
+                free(node->array.elements);
+            }
+            break;
+
+        case NODE_LAMBDA:
+            for (int i = 0; i < node->lambda.paramCount; i++) {
+                freeAST(node->lambda.params[i]);
+            }
+            if (node->lambda.params != NULL) {
+                free(node->lambda.params);
+            }
+            freeAST(node->lambda.body);
+            break;
             
         // Other node types do not require special handling for now
         case NODE_CLASS_DECL:
         case NODE_EXPR_STMT:
         case NODE_IF_STMT:
-        case NODE_WHILE_STMT:
-        case NODE_BLOCK_STMT:
-        case NODE_UNARY_EXPR:
         case NODE_SET_EXPR:
             // Free logic for these node types may be added later
             fprintf(stderr, "Warning: freeAST not implemented for node type %d\n", node->type);
@@ -254,8 +349,10 @@ void printAST(ASTNode* node, int depth) {
             break;
             
         case NODE_FUNCTION_DECL:
-            printf("Function: %s (params: %d)\n", 
-                   node->function.name, node->function.paramCount);
+            printf("Function: %s (params: %d)%s\n", 
+                   node->function.name, node->function.paramCount,
+                   node->function.inlineHint == INLINE_ALWAYS ? " @inline" :
+                   node->function.inlineHint == INLINE_NEVER ? " @noinline" : "");
             if (node->function.returnType != NULL) {
                 printIndent(depth + 1);
                 printf("Return Type:\n");
@@ -289,7 +386,9 @@ void printAST(ASTNode* node, int depth) {
         case NODE_LITERAL: {
             Token token = node->literal.token;
             printf("Literal: ");
-            if (token.type == TOKEN_NUMBER) {
+            if (node->literal.folded) {
+                printf("Number %lld (folded)\n", node->literal.value);
+            } else if (token.type == TOKEN_NUMBER) {
                 printf("Number '%.*s'\n", token.length, token.start);
             } else if (token.type == TOKEN_STRING) {
                 printf("String '%.*s'\n", token.length, token.start);
@@ -312,6 +411,7 @@ void printAST(ASTNode* node, int depth) {
                 case TOKEN_MINUS: printf("-\n"); break;
                 case TOKEN_STAR: printf("*\n"); break;
                 case TOKEN_SLASH: printf("/\n"); break;
+                case TOKEN_PERCENT: printf("%%\n"); break;
                 case TOKEN_EQUAL_EQUAL: printf("==\n"); break;
                 case TOKEN_BANG_EQUAL: printf("!=\n"); break;
                 case TOKEN_GREATER: printf(">\n"); break;
@@ -328,6 +428,11 @@ void printAST(ASTNode* node, int depth) {
             printAST(node->binary.right, depth + 2);
             break;
 
+        case NODE_UNARY_EXPR:
+            printf("Convert: %s\n", node->unary.op.type == TOKEN_FLOAT ? "float" : "int");
+            printAST(node->unary.operand, depth + 1);
+            break;
+
             case NODE_CALL_EXPR:
                 printf("CallExpr:\n");
                 printIndent(depth + 1);
@@ -369,9 +474,52 @@ void printAST(ASTNode* node, int depth) {
             }
             break;
             
+        case NODE_BLOCK_STMT:
+            printf("Block (%d statements):\n", node->block.count);
+            for (int i = 0; i < node->block.count; i++) {
+                printAST(node->block.statements[i], depth + 1);
+            }
+            break;
+
+        case NODE_WHILE_STMT:
+            printf(node->loop.init || node->loop.step ? "For:\n" : "While:\n");
+            if (node->loop.init != NULL) {
+                printIndent(depth + 1);
+                printf("Init:\n");
+                printAST(node->loop.init, depth + 2);
+            }
+            printIndent(depth + 1);
+            printf("Condition:\n");
+            printAST(node->loop.condition, depth + 2);
+            if (node->loop.step != NULL) {
+                printIndent(depth + 1);
+                printf("Step:\n");
+                printAST(node->loop.step, depth + 2);
+            }
+            printIndent(depth + 1);
+            printf("Body:\n");
+            printAST(node->loop.body, depth + 2);
+            break;
+
         case NODE_INCLUDE:
             printf("Include: %s\n", node->include.filename);
             break;
+
+        case NODE_ARRAY_LITERAL:
+            printf("Array (%d elements):\n", node->array.count);
+            for (int i = 0; i < node->array.count; i++) {
+                printAST(node->array.elements[i], depth + 1);
+            }
+            break;
+
+        case NODE_LAMBDA:
+            printf("Lambda (");
+            for (int i = 0; i < node->lambda.paramCount; i++) {
+                printf("%s%s", i > 0 ? ", " : "", node->lambda.params[i]->variable.name);
+            }
+            printf("):\n");
+            printAST(node->lambda.body, depth + 1);
+            break;
             
         default:
             printf("Unknown node type: %d\n", node->type);
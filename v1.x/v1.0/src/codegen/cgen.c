@@ -0,0 +1,626 @@
+// src/codegen/cgen.c - C99 source backend
+//
+// Lowers the checked, folded AST to readable C that calls the System.h
+// runtime, then hands it to the host C compiler. The output mirrors the
+// semantics of the native backend (see irbuild.c): int and bool are
+// int64_t, float is double, string is const char*, binary operators are
+// evaluated exactly as parsed, comparisons yield 0 or 1, calls evaluate
+// their arguments left to right, void calls read as zero and unknown names
+// read as zero. Blocks and loops map onto C blocks and while loops.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "codegen.h"
+#include <namespace.h>
+#include <runtime_abi.h>
+
+typedef enum { CT_VOID, CT_INT, CT_DOUBLE, CT_STRING } CType;
+
+typedef struct {
+    const char* name;       // Mino name
+    char* cName;            // C identifier
+    CType type;
+} Local;
+
+typedef struct {
+    FILE* out;
+    ASTNode* program;
+    Local* locals;          // locals of the current function, newest last
+    int localCount;
+    int localCapacity;
+    int tempCount;          // hoisted call results in the current function
+    int failed;
+} CContext;
+
+// String builder for expressions
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static void bufAppend(Buffer* buf, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (buf->length + n + 1 > buf->capacity) {
+        buf->capacity = (buf->length + n + 1) * 2;
+        buf->data = realloc(buf->data, buf->capacity);
+    }
+    vsnprintf(buf->data + buf->length, n + 1, format, args);
+    buf->length += n;
+    va_end(args);
+}
+
+// ============ Types and names ============
+
+static const char* cTypeName(CType type) {
+    switch (type) {
+        case CT_VOID: return "void";
+        case CT_DOUBLE: return "double";
+        case CT_STRING: return "const char*";
+        default: return "int64_t";
+    }
+}
+
+static CType typeFromNode(ASTNode* typeNode) {
+    if (!typeNode || typeNode->type != NODE_LITERAL) return CT_INT;
+    switch (typeNode->literal.token.type) {
+        case TOKEN_FLOAT: return CT_DOUBLE;
+        case TOKEN_STRING_TYPE: return CT_STRING;
+        case TOKEN_VOID: return CT_VOID;
+        default: return CT_INT;
+    }
+}
+
+static CType typeFromAbi(AbiType type) {
+    switch (type) {
+        case ABI_VOID: return CT_VOID;
+        case ABI_FLOAT:
+        case ABI_DOUBLE: return CT_DOUBLE;
+        case ABI_STRING:
+        case ABI_PTR: return CT_STRING;
+        default: return CT_INT;
+    }
+}
+
+static CType returnTypeOf(ASTNode* func) {
+    return func->function.returnType ? typeFromNode(func->function.returnType) : CT_INT;
+}
+
+static ASTNode* findFunctionDecl(ASTNode* program, const char* name) {
+    for (int i = 0; i < program->program.count; i++) {
+        ASTNode* s = program->program.statements[i];
+        if (s && s->type == NODE_FUNCTION_DECL && strcmp(s->function.name, name) == 0) return s;
+    }
+    return NULL;
+}
+
+static const char* getCalleeSymbol(ASTNode* callee) {
+    if (!callee) return NULL;
+    if (callee->type == NODE_VARIABLE) return callee->varRef.name;
+    if (callee->type == NODE_GET_EXPR) {
+        if (callee->get.linkName) return callee->get.linkName;
+        NamespaceNode* ns = resolveQualifiedName(callee);
+        return ns ? ns->linkName : NULL;
+    }
+    return NULL;
+}
+
+static const RuntimeFunc* runtimeOf(ASTNode* call, const char* target) {
+    if (call->call.runtime) return call->call.runtime;
+    if (call->call.callee->type == NODE_GET_EXPR) return lookupRuntimeFunc(target);
+    return NULL;
+}
+
+static int isCKeyword(const char* name) {
+    static const char* keywords[] = {
+        "auto", "break", "case", "char", "const", "continue", "default", "do",
+        "double", "else", "enum", "extern", "float", "for", "goto", "if",
+        "inline", "int", "long", "register", "restrict", "return", "short",
+        "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+        "unsigned", "void", "volatile", "while", "main", NULL
+    };
+    for (int i = 0; keywords[i]; i++) {
+        if (strcmp(keywords[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static Local* findLocal(CContext* ctx, const char* name) {
+    for (int i = ctx->localCount - 1; i >= 0; i--) {
+        if (strcmp(ctx->locals[i].name, name) == 0) return &ctx->locals[i];
+    }
+    return NULL;
+}
+
+// Declare a local; a redeclared name gets a fresh C identifier
+static Local* declareLocal(CContext* ctx, const char* name, CType type) {
+    int uses = 0;
+    for (int i = 0; i < ctx->localCount; i++) {
+        if (strcmp(ctx->locals[i].name, name) == 0) uses++;
+    }
+    if (ctx->localCount == ctx->localCapacity) {
+        ctx->localCapacity = ctx->localCapacity ? ctx->localCapacity * 2 : 16;
+        ctx->locals = realloc(ctx->locals, sizeof(Local) * ctx->localCapacity);
+    }
+    Local* local = &ctx->locals[ctx->localCount++];
+    local->name = name;
+    local->type = type;
+    size_t size = strlen(name) + 16;
+    local->cName = malloc(size);
+    if (uses > 0) snprintf(local->cName, size, "%s_%d", name, uses + 1);
+    else if (isCKeyword(name)) snprintf(local->cName, size, "%s_", name);
+    else snprintf(local->cName, size, "%s", name);
+    return local;
+}
+
+// Forget the locals declared since `mark`, at the end of a block
+static void popLocals(CContext* ctx, int mark) {
+    for (int i = mark; i < ctx->localCount; i++) free(ctx->locals[i].cName);
+    ctx->localCount = mark;
+}
+
+static void clearLocals(CContext* ctx) {
+    popLocals(ctx, 0);
+    ctx->tempCount = 0;
+}
+
+static int isComparison(TokenType op) {
+    return op == TOKEN_EQUAL_EQUAL || op == TOKEN_BANG_EQUAL || op == TOKEN_LESS ||
+           op == TOKEN_LESS_EQUAL || op == TOKEN_GREATER || op == TOKEN_GREATER_EQUAL;
+}
+
+// ============ Expressions ============
+
+static CType exprType(CContext* ctx, ASTNode* node) {
+    if (!node) return CT_INT;
+    switch (node->type) {
+        case NODE_LITERAL: {
+            if (node->literal.folded) return CT_INT;
+            Token t = node->literal.token;
+            if (t.type == TOKEN_STRING) return CT_STRING;
+            if (t.type == TOKEN_NUMBER && memchr(t.start, '.', t.length)) return CT_DOUBLE;
+            return CT_INT;
+        }
+        case NODE_VARIABLE: {
+            Local* local = findLocal(ctx, node->varRef.name);
+            return local ? local->type : CT_INT;
+        }
+        case NODE_BINARY_EXPR:
+            if (isComparison(node->binary.op.type)) return CT_INT;
+            if (exprType(ctx, node->binary.left) == CT_DOUBLE ||
+                exprType(ctx, node->binary.right) == CT_DOUBLE) {
+                return CT_DOUBLE;
+            }
+            return CT_INT;
+        case NODE_UNARY_EXPR:
+            return node->unary.op.type == TOKEN_FLOAT ? CT_DOUBLE : CT_INT;
+        case NODE_CALL_EXPR: {
+            const char* target = getCalleeSymbol(node->call.callee);
+            if (!target) return CT_INT;
+            const RuntimeFunc* runtime = runtimeOf(node, target);
+            if (runtime) return typeFromAbi(runtime->ret);
+            ASTNode* decl = findFunctionDecl(ctx->program, target);
+            return decl ? returnTypeOf(decl) : CT_INT;
+        }
+        default:
+            return CT_INT;
+    }
+}
+
+static int countCalls(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case NODE_BINARY_EXPR:
+            return countCalls(node->binary.left) + countCalls(node->binary.right);
+        case NODE_UNARY_EXPR:
+            return countCalls(node->unary.operand);
+        case NODE_CALL_EXPR: {
+            int count = 1;
+            for (int i = 0; i < node->call.argCount; i++) count += countCalls(node->call.args[i]);
+            return count;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Integer literals are int64_t like every Mino int, so arithmetic on them
+// cannot overflow a C int and variadic callees read all 64 bits
+static void emitLiteral(Buffer* buf, ASTNode* node) {
+    Token t = node->literal.token;
+    if (node->literal.folded) {
+        long long value = node->literal.value;
+        if (value == (-9223372036854775807LL - 1)) bufAppend(buf, "INT64_MIN");
+        else bufAppend(buf, "INT64_C(%lld)", value);
+        return;
+    }
+    switch (t.type) {
+        case TOKEN_NUMBER:
+            if (memchr(t.start, '.', t.length)) bufAppend(buf, "%.*s", t.length, t.start);
+            else bufAppend(buf, "INT64_C(%.*s)", t.length, t.start);
+            break;
+        case TOKEN_STRING:
+            // token text includes the quotes; raw newlines need escaping in C
+            for (int i = 0; i < t.length; i++) {
+                if (t.start[i] == '\n') bufAppend(buf, "\\n");
+                else bufAppend(buf, "%c", t.start[i]);
+            }
+            break;
+        case TOKEN_TRUE:
+            bufAppend(buf, "INT64_C(1)");
+            break;
+        default:
+            bufAppend(buf, "INT64_C(0)");
+            break;
+    }
+}
+
+static void emitExpression(CContext* ctx, Buffer* buf, ASTNode* node, int hoist, int indent);
+
+static void unsupportedArray(CContext* ctx, ASTNode* node) {
+    fprintf(stderr, "[line %d] Error: arrays are not supported by the C backend\n", node->line);
+    ctx->failed = 1;
+}
+
+// The call itself, "callee(args)"; NULL if the callee cannot be resolved
+static char* callText(CContext* ctx, ASTNode* node, int hoist, int indent) {
+    if (node->call.arrayMethod != ARRAY_METHOD_NONE) {
+        unsupportedArray(ctx, node);
+        return NULL;
+    }
+    const char* target = getCalleeSymbol(node->call.callee);
+    if (!target) {
+        fprintf(stderr, "[line %d] Error: unsupported callee\n", node->line);
+        ctx->failed = 1;
+        return NULL;
+    }
+    Buffer call = {0};
+    const RuntimeFunc* runtime = runtimeOf(node, target);
+    if (runtime || !findFunctionDecl(ctx->program, target)) {
+        bufAppend(&call, "%s(", target);
+    } else {
+        bufAppend(&call, "mino_%s(", target);
+    }
+    for (int i = 0; i < node->call.argCount; i++) {
+        if (i > 0) bufAppend(&call, ", ");
+        // variadic arguments get no prototype conversion, and a
+        // comparison is a C int
+        ASTNode* arg = node->call.args[i];
+        int widen = runtime && runtime->isVariadic && i >= runtime->paramCount &&
+                    arg->type != NODE_LITERAL && exprType(ctx, arg) == CT_INT;
+        if (widen) bufAppend(&call, "(int64_t)(");
+        emitExpression(ctx, &call, arg, hoist, indent);
+        if (widen) bufAppend(&call, ")");
+    }
+    bufAppend(&call, ")");
+    return call.data;
+}
+
+// Calls are emitted inline, or, when `hoist` is set, into temporaries in
+// evaluation order so C's unspecified operand order cannot reorder them
+static void emitCall(CContext* ctx, Buffer* buf, ASTNode* node, int hoist, int indent) {
+    char* call = callText(ctx, node, hoist, indent);
+    if (!call) {
+        bufAppend(buf, "0");
+        return;
+    }
+    CType type = exprType(ctx, node);
+    if (hoist) {
+        if (type == CT_VOID) {
+            fprintf(ctx->out, "%*s%s;\n", indent, "", call);
+            bufAppend(buf, "0");
+        } else {
+            int temp = ctx->tempCount++;
+            fprintf(ctx->out, "%*s%s t%d_ = %s;\n", indent, "", cTypeName(type), temp, call);
+            bufAppend(buf, "t%d_", temp);
+        }
+    } else if (type == CT_VOID) {
+        bufAppend(buf, "(%s, 0)", call);
+    } else {
+        bufAppend(buf, "%s", call);
+    }
+    free(call);
+}
+
+static void emitExpression(CContext* ctx, Buffer* buf, ASTNode* node, int hoist, int indent) {
+    if (!node) {
+        bufAppend(buf, "0");
+        return;
+    }
+    switch (node->type) {
+        case NODE_LITERAL:
+            emitLiteral(buf, node);
+            break;
+        case NODE_VARIABLE: {
+            Local* local = findLocal(ctx, node->varRef.name);
+            // unknown names (e.g. non-constant globals) read as zero
+            if (local) bufAppend(buf, "%s", local->cName);
+            else bufAppend(buf, "0");
+            break;
+        }
+        case NODE_BINARY_EXPR: {
+            const char* op;
+            switch (node->binary.op.type) {
+                case TOKEN_PLUS: op = "+"; break;
+                case TOKEN_MINUS: op = "-"; break;
+                case TOKEN_STAR: op = "*"; break;
+                case TOKEN_SLASH: op = "/"; break;
+                case TOKEN_PERCENT: op = "%"; break;
+                case TOKEN_EQUAL_EQUAL: op = "=="; break;
+                case TOKEN_BANG_EQUAL: op = "!="; break;
+                case TOKEN_LESS: op = "<"; break;
+                case TOKEN_LESS_EQUAL: op = "<="; break;
+                case TOKEN_GREATER: op = ">"; break;
+                case TOKEN_GREATER_EQUAL: op = ">="; break;
+                default:
+                    fprintf(stderr, "[line %d] Error: unsupported binary operator\n", node->line);
+                    ctx->failed = 1;
+                    bufAppend(buf, "0");
+                    return;
+            }
+            // nested operators are parenthesized so C precedence cannot regroup them
+            int leftParen = node->binary.left && node->binary.left->type == NODE_BINARY_EXPR;
+            int rightParen = node->binary.right && node->binary.right->type == NODE_BINARY_EXPR;
+            if (leftParen) bufAppend(buf, "(");
+            emitExpression(ctx, buf, node->binary.left, hoist, indent);
+            bufAppend(buf, leftParen ? ") %s " : " %s ", op);
+            if (rightParen) bufAppend(buf, "(");
+            emitExpression(ctx, buf, node->binary.right, hoist, indent);
+            if (rightParen) bufAppend(buf, ")");
+            break;
+        }
+        case NODE_UNARY_EXPR:
+            bufAppend(buf, node->unary.op.type == TOKEN_FLOAT ? "(double)(" : "(int64_t)(");
+            emitExpression(ctx, buf, node->unary.operand, hoist, indent);
+            bufAppend(buf, ")");
+            break;
+        case NODE_CALL_EXPR:
+            emitCall(ctx, buf, node, hoist, indent);
+            break;
+        case NODE_ARRAY_LITERAL:
+            unsupportedArray(ctx, node);
+            bufAppend(buf, "0");
+            break;
+        case NODE_GET_EXPR:
+            if (node->get.isLength) unsupportedArray(ctx, node);
+            bufAppend(buf, "0");
+            break;
+        default:
+            // member access outside a call and other forms have no value yet
+            bufAppend(buf, "0");
+            break;
+    }
+}
+
+// Render an expression, hoisting its calls first when there is more than one
+static char* expressionText(CContext* ctx, ASTNode* node, int indent) {
+    Buffer buf = {0};
+    emitExpression(ctx, &buf, node, countCalls(node) > 1, indent);
+    return buf.data;
+}
+
+// ============ Statements and functions ============
+
+static void emitStatement(CContext* ctx, ASTNode* node, CType returnType, int indent);
+
+static void emitStatements(CContext* ctx, ASTNode* block, CType returnType, int indent) {
+    if (!block) return;
+    if (block->type != NODE_BLOCK_STMT) {
+        emitStatement(ctx, block, returnType, indent);
+        return;
+    }
+    for (int i = 0; i < block->block.count; i++) emitStatement(ctx, block->block.statements[i], returnType, indent);
+}
+
+// [{ init;] while (cond) { body step }[ }]. A condition with several calls
+// hoists them, which must happen on every iteration, so it becomes
+// for (;;) { calls; if (!(cond)) break; ... }
+static void emitLoop(CContext* ctx, ASTNode* node, CType returnType, int indent) {
+    int mark = ctx->localCount;
+    int outer = indent;
+    if (node->loop.init) {
+        fprintf(ctx->out, "%*s{\n", outer, "");
+        indent += 4;
+        emitStatement(ctx, node->loop.init, returnType, indent);
+    }
+
+    ASTNode* condition = node->loop.condition;
+    if (condition && countCalls(condition) > 1) {
+        fprintf(ctx->out, "%*sfor (;;) {\n", indent, "");
+        char* value = expressionText(ctx, condition, indent + 4);
+        fprintf(ctx->out, "%*sif (!(%s)) break;\n", indent + 4, "", value);
+        free(value);
+    } else {
+        char* value = condition ? expressionText(ctx, condition, indent) : NULL;
+        fprintf(ctx->out, "%*swhile (%s) {\n", indent, "", value ? value : "1");
+        free(value);
+    }
+    int bodyMark = ctx->localCount;
+    emitStatements(ctx, node->loop.body, returnType, indent + 4);
+    popLocals(ctx, bodyMark);
+    emitStatement(ctx, node->loop.step, returnType, indent + 4);
+    fprintf(ctx->out, "%*s}\n", indent, "");
+    if (node->loop.init) fprintf(ctx->out, "%*s}\n", outer, "");
+    popLocals(ctx, mark);
+}
+
+static void emitStatement(CContext* ctx, ASTNode* node, CType returnType, int indent) {
+    if (!node) return;
+    switch (node->type) {
+        case NODE_VAR_DECL: {
+            CType type = node->variable.type ? typeFromNode(node->variable.type)
+                                             : exprType(ctx, node->variable.initializer);
+            if (type == CT_VOID) type = CT_INT;
+            char* value = node->variable.initializer ? expressionText(ctx, node->variable.initializer, indent) : NULL;
+            Local* local = declareLocal(ctx, node->variable.name, type);
+            fprintf(ctx->out, "%*s%s%s %s = %s;\n", indent, "", node->variable.isMutable ? "" : "const ",
+                    cTypeName(type), local->cName, value ? value : "0");
+            free(value);
+            break;
+        }
+        case NODE_RETURN_STMT: {
+            if (!node->returnStmt.value) {
+                fprintf(ctx->out, "%*sreturn%s;\n", indent, "", returnType == CT_VOID ? "" : " 0");
+                break;
+            }
+            char* value = expressionText(ctx, node->returnStmt.value, indent);
+            // a void function evaluates the expression but returns nothing
+            if (returnType == CT_VOID) {
+                fprintf(ctx->out, "%*s(void)(%s);\n%*sreturn;\n", indent, "", value, indent, "");
+            } else {
+                fprintf(ctx->out, "%*sreturn %s;\n", indent, "", value);
+            }
+            free(value);
+            break;
+        }
+        case NODE_CALL_EXPR: {
+            // the statement is the call; hoist when its arguments hold several calls
+            int hoist = countCalls(node) - 1 > 1;
+            char* call = callText(ctx, node, hoist, indent);
+            if (call) fprintf(ctx->out, "%*s%s;\n", indent, "", call);
+            free(call);
+            break;
+        }
+        case NODE_BINARY_EXPR:
+        case NODE_UNARY_EXPR:
+        case NODE_VARIABLE:
+        case NODE_ARRAY_LITERAL:
+        case NODE_GET_EXPR: {
+            char* value = expressionText(ctx, node, indent);
+            if (strcmp(value, "0") != 0) fprintf(ctx->out, "%*s(void)(%s);\n", indent, "", value);
+            free(value);
+            break;
+        }
+        case NODE_ASSIGN: {
+            char* value = expressionText(ctx, node->assignment.value, indent);
+            Local* local = findLocal(ctx, node->assignment.target->varRef.name);
+            if (local) fprintf(ctx->out, "%*s%s = %s;\n", indent, "", local->cName, value);
+            free(value);
+            break;
+        }
+        case NODE_BLOCK_STMT: {
+            int mark = ctx->localCount;
+            fprintf(ctx->out, "%*s{\n", indent, "");
+            emitStatements(ctx, node, returnType, indent + 4);
+            fprintf(ctx->out, "%*s}\n", indent, "");
+            popLocals(ctx, mark);
+            break;
+        }
+        case NODE_WHILE_STMT:
+            emitLoop(ctx, node, returnType, indent);
+            break;
+        default:
+            break;
+    }
+}
+
+static void emitSignature(CContext* ctx, ASTNode* func) {
+    fprintf(ctx->out, "static %s mino_%s(", cTypeName(returnTypeOf(func)), func->function.name);
+    if (func->function.paramCount == 0) fprintf(ctx->out, "void");
+    for (int i = 0; i < func->function.paramCount; i++) {
+        ASTNode* param = func->function.params[i];
+        CType type = typeFromNode(param->variable.type);
+        if (type == CT_VOID) type = CT_INT;
+        Local* local = declareLocal(ctx, param->variable.name, type);
+        fprintf(ctx->out, "%s%s %s", i > 0 ? ", " : "", cTypeName(type), local->cName);
+    }
+    fprintf(ctx->out, ")");
+}
+
+static void emitFunction(CContext* ctx, ASTNode* func) {
+    CType returnType = returnTypeOf(func);
+    emitSignature(ctx, func);
+    fprintf(ctx->out, " {\n");
+
+    ASTNode* body = func->function.body;
+    int returned = 0;
+    for (int i = 0; body && i < body->program.count; i++) {
+        ASTNode* s = body->program.statements[i];
+        emitStatement(ctx, s, returnType, 4);
+        if (s && s->type == NODE_RETURN_STMT) {
+            returned = 1;
+            break;      // the rest of the body is unreachable
+        }
+    }
+    // Falling off the end returns 0
+    if (!returned && returnType != CT_VOID) fprintf(ctx->out, "    return 0;\n");
+    fprintf(ctx->out, "}\n");
+    clearLocals(ctx);
+}
+
+static int writeProgram(CContext* ctx) {
+    ASTNode* program = ctx->program;
+
+    fprintf(ctx->out, "// Generated by minoc --emit-c\n");
+    fprintf(ctx->out, "#include <stdint.h>\n");
+    fprintf(ctx->out, "#include <System.h>\n\n");
+
+    // Prototypes first so functions may call each other in any order
+    ASTNode* mainFunc = NULL;
+    for (int i = 0; i < program->program.count; i++) {
+        ASTNode* s = program->program.statements[i];
+        if (!s || s->type != NODE_FUNCTION_DECL) continue;
+        if (strcmp(s->function.name, "main") == 0) mainFunc = s;
+        emitSignature(ctx, s);
+        fprintf(ctx->out, ";\n");
+        clearLocals(ctx);
+    }
+
+    for (int i = 0; i < program->program.count; i++) {
+        ASTNode* s = program->program.statements[i];
+        if (!s || s->type != NODE_FUNCTION_DECL) continue;
+        fprintf(ctx->out, "\n");
+        emitFunction(ctx, s);
+    }
+
+    if (mainFunc) {
+        fprintf(ctx->out, "\nint main(void) {\n");
+        if (returnTypeOf(mainFunc) == CT_INT) {
+            fprintf(ctx->out, "    return (int)mino_main();\n");
+        } else {
+            fprintf(ctx->out, "    mino_main();\n    return 0;\n");
+        }
+        fprintf(ctx->out, "}\n");
+    }
+
+    return ctx->failed;
+}
+
+int codegen_generateC(ASTNode* program, const char* outPath, int sourceOnly) {
+    if (!program) return 1;
+    CContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.program = program;
+
+    // With sourceOnly the C goes to outPath; otherwise it is piped into the compiler
+    LinkJob job;
+    if (sourceOnly) {
+        ctx.out = fopen(outPath, "w");
+        if (!ctx.out) {
+            fprintf(stderr, "Cannot write %s\n", outPath);
+            return 1;
+        }
+    } else {
+        const char* cc = getenv("MINO_CC");
+        const char* cflags = getenv("MINO_CFLAGS");
+        char driver[1024];
+        snprintf(driver, sizeof(driver), "%s %s", cc && *cc ? cc : "gcc", cflags ? cflags : "-O2 -fwrapv");
+        ctx.out = codegen_startLink(&job, driver, "c", outPath);
+        if (!ctx.out) return codegen_finishLink(&job, NULL);
+    }
+
+    int failed = writeProgram(&ctx);
+    free(ctx.locals);
+    if (sourceOnly) return (fclose(ctx.out) != 0) || failed;
+    if (failed) {
+        // make the compiler fail rather than link a partial program
+        fprintf(ctx.out, "\n#error \"minoc: C generation failed\"\n");
+    }
+    return codegen_finishLink(&job, ctx.out) || failed;
+}
@@ -2,440 +2,1231 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "codegen.h"
+#include <runtime_abi.h>
+#include "mir.h"
+#include "obj.h"
 
-// Simple x86_64 assembly backend (AT&T syntax), generates position-dependent executables
+// x86_64 backend, generates position-dependent executables. Each IR function
+// is selected into MIR over virtual registers (one per SSA value), run
+// through the linear-scan allocator (regalloc.c), then encoded straight into
+// an ELF object (x86enc.c, elf.c) or printed as AT&T assembly.
+//
+// Loops get three things here. A comparison used only by branches becomes
+// cmp + jcc with no boolean in between. A loop header's phi copies for the
+// back edge are placed just in front of the header, so the latch jumps back
+// with a single jcc. And the variable a loop carries (i = phi(.., i + 1))
+// shares one virtual register with its next value, so the copy on the back
+// edge disappears.
+//
+// Multiplies and divisions by a constant avoid imul and idiv where they can:
+// shifts and lea for small multipliers, shifts with a rounding fix-up for
+// powers of two, and a multiply by a "magic" reciprocal for other divisors
+// (Granlund and Montgomery; Hacker's Delight 10-1).
+//
+// Floats are doubles computed with scalar SSE2 in XMM registers, which the
+// allocator treats as a second register class. Their constants live in a
+// module-wide pool in .rodata.cst8 and are read %rip-relative; compares use
+// ucomisd with conditions that come out false when either side is NaN.
+//
+// Arrays are a pointer to their first element with the length 8 bytes in
+// front of it. The vectorized array methods compute on two 64-bit lanes of
+// an XMM register (packed SSE2, a third register class for the allocator);
+// loads and stores use movdqu, which costs nothing extra on the 16-byte
+// aligned pairs the vector loops visit.
+//
+// With a profile (--profile-use), functions go into .text most called
+// first and never called last, and blocks that never ran move to the end
+// of their function, so the hot path falls through. An instrumented build
+// (--profile-generate) bumps its counters with an add to memory.
+//
+// A leaf function that the allocator fits into caller-saved registers
+// gets no frame: no push %rbp / mov %rsp, %rbp and no leave, only its ret
+// (-fno-omit-frame-pointer keeps the frame for frame-pointer unwinders).
+//
+// With -g every machine instruction carries the source line of the IR it
+// was selected from, and the output says where each line's code starts
+// and how the prologue and epilogues move the frame: .loc and .cfi_*
+// directives in assembly, .debug_line and .eh_frame in an encoded object
+// (dwarf.c). The code itself is the same with or without -g.
 
 typedef struct {
-    FILE* out;
+    Emitter out;            // buffered assembly output
+    ObjectFile* obj;        // machine-code output instead of assembly, or NULL
+    CodegenOptions options;
+    IRModule* module;
+    IRFunction* irFn;       // function being selected
+    MFunction* fn;
+    int* vregs;             // SSA value id -> virtual register, REG_NONE if unassigned
+    char** labels;          // label names owned by the current function
     int labelCount;
-    // current function parameter and local name maps
-    char** paramNames;
-    int paramCount;
-    char** localNames;
-    int localCount;
-    // string literal table
-    char** strLits;
-    int strCount;
+    int labelCapacity;
+    int edgeCount;          // split critical edges in the current function
+    char* fused;            // SSA value id -> compare selected at its branches
+    IRBlock** backEdgeFrom; // block id -> latch whose phi copies precede the block
+
+    long long* floats;      // float constant .LF<n> bits, shared by the module
+    int floatCount;
+    int floatCapacity;
+    int* floatHash;         // open addressing over floats, -1 = empty
+    int floatHashCapacity;
 } CGContext;
 
-// Flatten dotted names to underscore style for external symbols
-static char* flattenName(const char* name) {
-    size_t n = strlen(name);
-    char* res = malloc(n + 1);
-    for (size_t i = 0; i < n; i++) {
-        res[i] = (name[i] == '.') ? '_' : name[i];
+static const int argRegs[6] = {REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9};
+
+static int fitsImm32(long long value) {
+    return value >= -2147483648LL && value <= 2147483647LL;
+}
+
+static const char* addLabel(CGContext* ctx, const char* name) {
+    if (ctx->labelCount == ctx->labelCapacity) {
+        ctx->labelCapacity = ctx->labelCapacity ? ctx->labelCapacity * 2 : 16;
+        ctx->labels = realloc(ctx->labels, sizeof(char*) * ctx->labelCapacity);
     }
-    res[n] = '\0';
-    return res;
+    ctx->labels[ctx->labelCount] = strdup(name);
+    return ctx->labels[ctx->labelCount++];
 }
 
-// String literal table helpers
-static int findStringLiteral(CGContext* ctx, const char* s) {
-    if (!ctx->strLits) return -1;
-    for (int i = 0; i < ctx->strCount; i++) {
-        if (strcmp(ctx->strLits[i], s) == 0) return i;
+static const char* findLabel(CGContext* ctx, const char* format, int id) {
+    char name[160];
+    snprintf(name, sizeof(name), format, ctx->irFn->name, id);
+    for (int i = 0; i < ctx->labelCount; i++) {
+        if (strcmp(ctx->labels[i], name) == 0) return ctx->labels[i];
     }
-    return -1;
+    return addLabel(ctx, name);
 }
 
-static int addStringLiteral(CGContext* ctx, const char* s) {
-    int idx = findStringLiteral(ctx, s);
-    if (idx >= 0) return idx;
-    ctx->strLits = realloc(ctx->strLits, sizeof(char*) * (ctx->strCount + 1));
-    ctx->strLits[ctx->strCount] = strdup(s);
-    return ctx->strCount++;
-}
-
-// Walk AST and collect string literals
-static void collectStringLiterals(CGContext* ctx, ASTNode* node) {
-    if (!node) return;
-    switch (node->type) {
-        case NODE_LITERAL: {
-            Token t = node->literal.token;
-            if (t.type == TOKEN_STRING) {
-                // copy token contents
-                char* s = malloc(t.length + 1);
-                memcpy(s, t.start, t.length);
-                s[t.length] = '\0';
-                addStringLiteral(ctx, s);
-                free(s);
-            }
-            break;
-        }
-        case NODE_PROGRAM: {
-            for (int i = 0; i < node->program.count; i++) collectStringLiterals(ctx, node->program.statements[i]);
-            break;
-        }
-        case NODE_FUNCTION_DECL: {
-            collectStringLiterals(ctx, node->function.returnType);
-            for (int i = 0; i < node->function.paramCount; i++) collectStringLiterals(ctx, node->function.params[i]);
-            collectStringLiterals(ctx, node->function.body);
-            break;
+static const char* blockLabel(CGContext* ctx, IRBlock* block) {
+    return findLabel(ctx, ".L%s_%d", block->id);
+}
+
+// The back edge's phi copies in front of a loop header
+static const char* backEdgeLabel(CGContext* ctx, IRBlock* header) {
+    return findLabel(ctx, ".L%s_b%d", header->id);
+}
+
+// ============ Float constants ============
+
+static unsigned int hashBits(long long bits) {
+    unsigned long long v = (unsigned long long)bits;
+    return (unsigned int)(v ^ (v >> 32)) * 2654435761u;
+}
+
+static void growFloatHash(CGContext* ctx) {
+    free(ctx->floatHash);
+    ctx->floatHashCapacity = ctx->floatHashCapacity ? ctx->floatHashCapacity * 2 : 16;
+    ctx->floatHash = malloc(sizeof(int) * ctx->floatHashCapacity);
+    for (int i = 0; i < ctx->floatHashCapacity; i++) ctx->floatHash[i] = -1;
+    for (int i = 0; i < ctx->floatCount; i++) {
+        unsigned int slot = hashBits(ctx->floats[i]) & (ctx->floatHashCapacity - 1);
+        while (ctx->floatHash[slot] >= 0) slot = (slot + 1) & (ctx->floatHashCapacity - 1);
+        ctx->floatHash[slot] = i;
+    }
+}
+
+// The pool label of a double given by its bits; equal constants share one entry
+static const char* floatLabel(CGContext* ctx, long long bits) {
+    if (ctx->floatCount * 2 >= ctx->floatHashCapacity) growFloatHash(ctx);
+    unsigned int slot = hashBits(bits) & (ctx->floatHashCapacity - 1);
+    while (ctx->floatHash[slot] >= 0 && ctx->floats[ctx->floatHash[slot]] != bits) {
+        slot = (slot + 1) & (ctx->floatHashCapacity - 1);
+    }
+    int index = ctx->floatHash[slot];
+    if (index < 0) {
+        if (ctx->floatCount == ctx->floatCapacity) {
+            ctx->floatCapacity = ctx->floatCapacity ? ctx->floatCapacity * 2 : 16;
+            ctx->floats = realloc(ctx->floats, sizeof(long long) * ctx->floatCapacity);
         }
-        case NODE_VAR_DECL: {
-            collectStringLiterals(ctx, node->variable.type);
-            collectStringLiterals(ctx, node->variable.initializer);
-            break;
+        index = ctx->floatCount++;
+        ctx->floats[index] = bits;
+        ctx->floatHash[slot] = index;
+    }
+    char label[32];
+    snprintf(label, sizeof(label), ".LF%d", index);
+    return addLabel(ctx, label);
+}
+
+static void freeFloats(CGContext* ctx) {
+    free(ctx->floats);
+    free(ctx->floatHash);
+}
+
+// ============ Values ============
+
+static int isFloat(IRInst* value) {
+    return value->type == IRT_F64;
+}
+
+static int isVector(IRInst* value) {
+    return value->type == IRT_V2I64 || value->type == IRT_V2F64;
+}
+
+static int newVreg(CGContext* ctx, IRInst* value) {
+    if (isVector(value)) return mirNewVectorVreg(ctx->fn);
+    return isFloat(value) ? mirNewFloatVreg(ctx->fn) : mirNewVreg(ctx->fn);
+}
+
+static MOpcode moveFor(IRInst* value) {
+    if (isVector(value)) return MOP_MOVDQU;
+    return isFloat(value) ? MOP_MOVSD : MOP_MOV;
+}
+
+static int vregOf(CGContext* ctx, IRInst* value) {
+    if (ctx->vregs[value->id] == REG_NONE) ctx->vregs[value->id] = newVreg(ctx, value);
+    return ctx->vregs[value->id];
+}
+
+static MOperand stringAddr(CGContext* ctx, IRInst* value) {
+    char label[32];
+    snprintf(label, sizeof(label), ".LC%lld", value->imm);
+    return mSymAddr(addLabel(ctx, label));
+}
+
+// Constants and string addresses are rematerialized at each use instead of
+// occupying a register for their whole lifetime
+static int isRematerializable(IRInst* value) {
+    return value->op == IR_CONST || value->op == IR_STRING;
+}
+
+static void rematerialize(CGContext* ctx, IRInst* value, MOperand dst) {
+    if (value->op == IR_STRING) mirEmit(ctx->fn, MOP_MOV, stringAddr(ctx, value), dst);
+    else if (isFloat(value)) mirEmit(ctx->fn, MOP_MOVSD, mRip(floatLabel(ctx, value->imm)), dst);
+    else mirEmit(ctx->fn, MOP_MOV, mImm(value->imm), dst);
+}
+
+// A register holding the value
+static int valueReg(CGContext* ctx, IRInst* value) {
+    if (!isRematerializable(value)) return vregOf(ctx, value);
+    int reg = newVreg(ctx, value);
+    rematerialize(ctx, value, mReg(reg));
+    return reg;
+}
+
+// A source operand: small integer constants fold into the instruction,
+// float constants are read from the pool
+static MOperand valueOperand(CGContext* ctx, IRInst* value) {
+    if (value->op == IR_CONST && isFloat(value)) return mRip(floatLabel(ctx, value->imm));
+    if (value->op == IR_CONST && fitsImm32(value->imm)) return mImm(value->imm);
+    return mReg(valueReg(ctx, value));
+}
+
+static void copyValue(CGContext* ctx, IRInst* value, MOperand dst) {
+    if (isRematerializable(value)) rematerialize(ctx, value, dst);
+    else mirEmit(ctx->fn, moveFor(value), mReg(vregOf(ctx, value)), dst);
+}
+
+// ============ Calls ============
+
+// ABI type of argument i: the runtime's declared parameter, otherwise
+// (Mino functions, variadic tails) a double or a 64-bit integer
+static AbiType argumentType(IRInst* call, int i) {
+    const RuntimeFunc* runtime = call->runtime;
+    if (runtime && i < runtime->paramCount) return runtime->params[i];
+    return isFloat(call->args[i]) ? ABI_DOUBLE : ABI_LONG;
+}
+
+static void selectCall(CGContext* ctx, IRInst* call) {
+    MFunction* fn = ctx->fn;
+    const RuntimeFunc* runtime = call->runtime;
+
+    // Classify arguments (SysV): floating values go to xmm0-7, the rest to GP registers
+    int gpCount = 0, xmmCount = 0;
+    for (int i = 0; i < call->argCount; i++) {
+        AbiType type = argumentType(call, i);
+        if (abiIsFloating(type)) {
+            if (xmmCount < 8) {
+                MOperand xmm = mReg(REG_XMM0 + xmmCount);
+                if (type == ABI_FLOAT) mirEmit(fn, MOP_CVTSD2SS, valueOperand(ctx, call->args[i]), xmm);
+                else copyValue(ctx, call->args[i], xmm);
+            }
+            xmmCount++;
+        } else {
+            if (gpCount < 6) copyValue(ctx, call->args[i], mReg(argRegs[gpCount]));
+            gpCount++;
         }
-        case NODE_CALL_EXPR: {
-            collectStringLiterals(ctx, node->call.callee);
-            for (int i = 0; i < node->call.argCount; i++) collectStringLiterals(ctx, node->call.args[i]);
+    }
+    // Variadic callees read the number of vector registers from %al
+    if (runtime && runtime->isVariadic) {
+        mirEmit(fn, MOP_MOV, mImm(xmmCount), mReg(REG_RAX));
+    }
+
+    // Local functions are called by label; runtime chains by flattened name
+    mirEmit(fn, MOP_CALL, mSym(call->sym), mNone());
+    if (call->type == IRT_VOID) return;
+
+    // Normalize the return value into a 64-bit integer or a double
+    int result = vregOf(ctx, call);
+    AbiType ret = runtime ? runtime->ret : isFloat(call) ? ABI_DOUBLE : ABI_LONG;
+    switch (ret) {
+        case ABI_INT:
+            mirEmit(fn, MOP_MOVSLQ, mReg(REG_RAX), mReg(result));
             break;
-        }
-        case NODE_GET_EXPR: {
-            collectStringLiterals(ctx, node->get.object);
+        case ABI_FLOAT:
+            mirEmit(fn, MOP_CVTSS2SD, mReg(REG_XMM0), mReg(REG_XMM0));
+            mirEmit(fn, MOP_MOVSD, mReg(REG_XMM0), mReg(result));
             break;
-        }
-        case NODE_BINARY_EXPR: {
-            collectStringLiterals(ctx, node->binary.left);
-            collectStringLiterals(ctx, node->binary.right);
+        case ABI_DOUBLE:
+            mirEmit(fn, MOP_MOVSD, mReg(REG_XMM0), mReg(result));
             break;
-        }
-        case NODE_RETURN_STMT: {
-            collectStringLiterals(ctx, node->returnStmt.value);
+        default:
+            mirEmit(fn, MOP_MOV, mReg(REG_RAX), mReg(result));
             break;
-        }
-        default: break;
     }
 }
 
-// Get callee name for VARIABLE or GET_EXPR
-static char* getCalleeName(ASTNode* callee) {
-    if (!callee) return NULL;
-    if (callee->type == NODE_VARIABLE) return strdup(callee->varRef.name);
-    if (callee->type == NODE_GET_EXPR) {
-        // Recursively construct chained name
-        char* left = getCalleeName(callee->get.object);
-        if (!left) return NULL;
-        size_t len = strlen(left) + 1 + strlen(callee->get.name) + 1;
-        char* buf = malloc(len);
-        snprintf(buf, len, "%s.%s", left, callee->get.name);
-        free(left);
-        return buf;
+// ============ Control flow ============
+
+static int predIndex(IRBlock* block, IRBlock* pred) {
+    for (int i = 0; i < block->predCount; i++) {
+        if (block->preds[i] == pred) return i;
     }
-    return NULL;
+    return -1;
 }
 
-// Emit function prologue/epilogue
-static void emitPrologue(CGContext* ctx) {
-    fprintf(ctx->out, "\tpush %%rbp\n");
-    fprintf(ctx->out, "\tmov %%rsp, %%rbp\n");
+static int hasPhis(IRBlock* block) {
+    return block->first && block->first->op == IR_PHI;
 }
 
-static void emitEpilogue(CGContext* ctx) {
-    fprintf(ctx->out, "\tleave\n");
-    fprintf(ctx->out, "\tret\n");
+// Whether the phi's operand along pred `index` is not already in the phi's
+// register (see coalescePhis)
+static int needsCopy(CGContext* ctx, IRInst* phi, int index) {
+    int reg = ctx->vregs[phi->args[index]->id];
+    return reg == REG_NONE || reg != ctx->vregs[phi->id];
 }
 
-// Generate expression, result placed in rax
-static void genExpression(CGContext* ctx, ASTNode* node, const char* funcName);
+// Copies for the phis of `to` along the edge from `from`. All operands are
+// read into temporaries before any phi is written, so phis that feed each
+// other (swaps) see the old values.
+static void emitPhiCopies(CGContext* ctx, IRBlock* from, IRBlock* to) {
+    int index = predIndex(to, from);
+    if (index < 0 || !hasPhis(to)) return;
 
-// Generate simple stack frame and variable layout for a function, then emit code
-static void genFunction(CGContext* ctx, ASTNode* func) {
-    // func->function.name, params in func->function.params
-    fprintf(ctx->out, "\t.globl %s\n", func->function.name);
-    fprintf(ctx->out, "%s:\n", func->function.name);
-    emitPrologue(ctx);
+    int count = 0;
+    for (IRInst* phi = to->first; phi && phi->op == IR_PHI; phi = phi->next) count++;
+    int* temps = malloc(sizeof(int) * count);
 
-    // Collect local variables (var declarations) and record names
-    int localCount = 0;
-    for (int i = 0; i < func->function.body->program.count; i++) {
-        ASTNode* s = func->function.body->program.statements[i];
-        if (s && s->type == NODE_VAR_DECL) localCount++;
+    int i = 0;
+    for (IRInst* phi = to->first; phi && phi->op == IR_PHI; phi = phi->next, i++) {
+        temps[i] = REG_NONE;
+        if (!needsCopy(ctx, phi, index)) continue;
+        temps[i] = newVreg(ctx, phi);
+        copyValue(ctx, phi->args[index], mReg(temps[i]));
     }
+    i = 0;
+    for (IRInst* phi = to->first; phi && phi->op == IR_PHI; phi = phi->next, i++) {
+        if (temps[i] != REG_NONE) mirEmit(ctx->fn, moveFor(phi), mReg(temps[i]), mReg(vregOf(ctx, phi)));
+    }
+    free(temps);
+}
 
-    // store parameter and local name maps in context for genExpression access
-    ctx->paramCount = func->function.paramCount;
-    if (ctx->paramNames) { /* clear any previous */
-        for (int i = 0; i < ctx->paramCount; i++) if (ctx->paramNames[i]) free(ctx->paramNames[i]);
-        free(ctx->paramNames);
-        ctx->paramNames = NULL;
+// Condition codes of the comparisons in IR_EQ..IR_GE order, for
+// `cmp right, left` and for the operands swapped
+static const char* conditionCodes[] = {"e", "ne", "l", "le", "g", "ge"};
+static const char* swappedCodes[] = {"e", "ne", "g", "ge", "l", "le"};
+
+static const char* invertCondition(const char* cc) {
+    static const char* pairs[][2] = {{"e", "ne"}, {"l", "ge"}, {"le", "g"}, {"a", "be"}, {"ae", "b"}};
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(cc, pairs[i][0]) == 0) return pairs[i][1];
+        if (strcmp(cc, pairs[i][1]) == 0) return pairs[i][0];
     }
-    if (func->function.paramCount > 0) {
-        ctx->paramNames = malloc(sizeof(char*) * func->function.paramCount);
-        for (int i = 0; i < func->function.paramCount; i++) {
-            ctx->paramNames[i] = strdup(func->function.params[i]->variable.name);
-        }
+    return cc;
+}
+
+// ucomisd for a float comparison. < and <= swap their operands so every
+// ordering tests "above", which is false when the compare is unordered
+// (NaN); == and != also need the parity flag, see selectCompare.
+static const char* emitFloatCompare(CGContext* ctx, IRInst* cmp) {
+    static const char* codes[] = {"e", "ne", "a", "ae", "a", "ae"};
+    IRInst* left = cmp->args[0];
+    IRInst* right = cmp->args[1];
+    if (cmp->op == IR_LT || cmp->op == IR_LE) {
+        left = cmp->args[1];
+        right = cmp->args[0];
     }
+    MInst* m = mirEmit(ctx->fn, MOP_UCOMISD, valueOperand(ctx, right), mReg(valueReg(ctx, left)));
+    m->line = cmp->line;
+    return codes[cmp->op - IR_EQ];
+}
 
-    ctx->localCount = localCount;
-    if (ctx->localNames) {
-        for (int i = 0; i < ctx->localCount; i++) if (ctx->localNames[i]) free(ctx->localNames[i]);
-        free(ctx->localNames);
-        ctx->localNames = NULL;
+// cmp for a comparison; returns the condition code that holds when it is true
+static const char* emitCompare(CGContext* ctx, IRInst* cmp) {
+    if (isFloat(cmp->args[0])) return emitFloatCompare(ctx, cmp);
+    IRInst* left = cmp->args[0];
+    IRInst* right = cmp->args[1];
+    const char* cc = conditionCodes[cmp->op - IR_EQ];
+    // cmp takes its immediate on the right
+    if (left->op == IR_CONST && fitsImm32(left->imm)) {
+        IRInst* tmp = left;
+        left = right;
+        right = tmp;
+        cc = swappedCodes[cmp->op - IR_EQ];
     }
-    if (localCount > 0) {
-        ctx->localNames = malloc(sizeof(char*) * localCount);
-        int idx = 0;
-        for (int i = 0; i < func->function.body->program.count; i++) {
-            ASTNode* s = func->function.body->program.statements[i];
-            if (s && s->type == NODE_VAR_DECL) {
-                ctx->localNames[idx++] = strdup(s->variable.name);
-            }
+    MInst* m = mirEmit(ctx->fn, MOP_CMP, valueOperand(ctx, right), mReg(valueReg(ctx, left)));
+    m->line = cmp->line;
+    return cc;
+}
+
+// Set the flags for a branch on `cond`; returns the condition code to jump on
+static const char* emitCondition(CGContext* ctx, IRInst* cond) {
+    if (irIsCompare(cond->op) && ctx->fused[cond->id]) return emitCompare(ctx, cond);
+    mirEmit(ctx->fn, MOP_CMP, mImm(0), mReg(valueReg(ctx, cond)));
+    return "ne";
+}
+
+// Whether the edge needs phi copies at the branch (back edges have theirs
+// in front of the header)
+static int edgeHasCopies(CGContext* ctx, IRBlock* from, IRBlock* to) {
+    int index = predIndex(to, from);
+    if (index < 0 || ctx->backEdgeFrom[to->id] == from) return 0;
+    for (IRInst* phi = to->first; phi && phi->op == IR_PHI; phi = phi->next) {
+        if (needsCopy(ctx, phi, index)) return 1;
+    }
+    return 0;
+}
+
+static const char* edgeLabel(CGContext* ctx, IRBlock* from, IRBlock* to) {
+    return ctx->backEdgeFrom[to->id] == from ? backEdgeLabel(ctx, to) : blockLabel(ctx, to);
+}
+
+static void emitJump(CGContext* ctx, IRBlock* from, IRBlock* to) {
+    if (ctx->backEdgeFrom[to->id] == from) {
+        mirEmit(ctx->fn, MOP_JMP, mSym(backEdgeLabel(ctx, to)), mNone());
+        return;
+    }
+    emitPhiCopies(ctx, from, to);
+    // falling through to the next block in layout needs no jump, unless
+    // a back edge's copies sit in between
+    if (from->next == to && !ctx->backEdgeFrom[to->id]) return;
+    mirEmit(ctx->fn, MOP_JMP, mSym(blockLabel(ctx, to)), mNone());
+}
+
+static void selectBranch(CGContext* ctx, IRInst* br) {
+    MFunction* fn = ctx->fn;
+    IRBlock* block = br->block;
+    IRBlock* taken = br->targets[0];
+    IRBlock* other = br->targets[1];
+    const char* cc = emitCondition(ctx, br->args[0]);
+
+    // Jump on the edge without phi copies, so the copies run on the
+    // fall-through path; otherwise fall through to the next block
+    int takenCopies = edgeHasCopies(ctx, block, taken);
+    int otherCopies = edgeHasCopies(ctx, block, other);
+    if (takenCopies > otherCopies || (takenCopies == otherCopies && block->next == taken)) {
+        IRBlock* tmp = taken;
+        taken = other;
+        other = tmp;
+        cc = invertCondition(cc);
+    }
+
+    if (!edgeHasCopies(ctx, block, taken)) {
+        MInst* jcc = mirEmit(fn, MOP_JCC, mSym(edgeLabel(ctx, block, taken)), mNone());
+        jcc->text = strdup(cc);
+        jcc->line = br->line;
+        emitJump(ctx, block, other);
+        return;
+    }
+
+    // Both edges carry copies (critical edges): the taken one gets its own block
+    char name[160];
+    snprintf(name, sizeof(name), ".L%s_e%d", ctx->irFn->name, ctx->edgeCount++);
+    const char* edge = addLabel(ctx, name);
+    MInst* jcc = mirEmit(fn, MOP_JCC, mSym(edge), mNone());
+    jcc->text = strdup(cc);
+    jcc->line = br->line;
+    emitPhiCopies(ctx, block, other);
+    mirEmit(fn, MOP_JMP, mSym(blockLabel(ctx, other)), mNone());
+    mirEmitLabel(fn, edge);
+    emitJump(ctx, block, taken);
+}
+
+// ============ Profile-guided layout ============
+
+// Blocks that never ran go after the ones that did, in their order, so
+// the taken side of a branch is usually the fall-through
+static void sinkColdBlocks(IRFunction* irFn) {
+    if (irFn->entryCount <= 0) return;
+    IRBlock* hotLast = irFn->entry;
+    IRBlock* coldFirst = NULL;
+    IRBlock* coldLast = NULL;
+    IRBlock* block = irFn->entry->next;
+    while (block) {
+        IRBlock* next = block->next;
+        block->next = NULL;
+        if (block->count == 0) {
+            if (coldLast) coldLast->next = block;
+            else coldFirst = block;
+            coldLast = block;
+        } else {
+            hotLast->next = block;
+            hotLast = block;
         }
+        block = next;
     }
+    hotLast->next = coldFirst;
+    irFn->lastBlock = coldLast ? coldLast : hotLast;
+}
 
-    int totalSlots = func->function.paramCount + localCount;
-    int stackSize = ((totalSlots * 8) + 15) & ~15; // 16-byte align
-    if (stackSize > 0) fprintf(ctx->out, "\tsub $%d, %%rsp\n", stackSize);
+// 0: called, 1: no profile, 2: never called
+static int hotness(IRFunction* fn) {
+    return fn->entryCount > 0 ? 0 : fn->entryCount < 0 ? 1 : 2;
+}
 
-    // Store parameters into stack slots (in order), supports up to 6 parameters
-    const char* regs[6] = {"%rdi","%rsi","%rdx","%rcx","%r8","%r9"};
-    for (int i = 0; i < func->function.paramCount && i < 6; i++) {
-        int offset = 8 * (i + 1);
-        fprintf(ctx->out, "\tmov %s, -%d(%%rbp)\n", regs[i], offset);
+// The functions in .text order: by profile, most called first, otherwise
+// as declared; caller frees
+static IRFunction** textOrder(IRModule* module, int* outCount) {
+    int count = 0;
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) count++;
+    IRFunction** order = malloc(sizeof(IRFunction*) * (count > 0 ? count : 1));
+    int n = 0;
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) {
+        // insertion sort keeps ties in declaration order
+        int at = n++;
+        while (at > 0 && (hotness(order[at - 1]) > hotness(fn) ||
+                          (hotness(fn) == 0 && order[at - 1]->entryCount < fn->entryCount))) {
+            order[at] = order[at - 1];
+            at--;
+        }
+        order[at] = fn;
     }
+    *outCount = count;
+    return order;
+}
 
-    // If this is main, call initSystem to initialize runtime
-    if (strcmp(func->function.name, "main") == 0) {
-        fprintf(ctx->out, "\tcall initSystem\n");
+// ============ Loops ============
+
+// Compares whose every use is a branch are selected at the branches. Float
+// == and != need two flags, so they always produce a value.
+static void findFusedCompares(CGContext* ctx, IRFunction* irFn) {
+    char* otherUse = calloc(irFn->nextValueId > 0 ? irFn->nextValueId : 1, 1);
+    for (IRBlock* block = irFn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            for (int i = 0; i < inst->argCount; i++) {
+                if (inst->op != IR_BR) otherUse[inst->args[i]->id] = 1;
+                else ctx->fused[inst->args[i]->id] = 1;
+            }
+        }
+    }
+    for (IRBlock* block = irFn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            if (!irIsCompare(inst->op) || otherUse[inst->id]) ctx->fused[inst->id] = 0;
+            else if (isFloat(inst->args[0]) && (inst->op == IR_EQ || inst->op == IR_NE)) ctx->fused[inst->id] = 0;
+        }
     }
+    free(otherUse);
+}
 
-    // Generate code for each statement
-    for (int i = 0; i < func->function.body->program.count; i++) {
-        ASTNode* s = func->function.body->program.statements[i];
-        if (!s) continue;
-        switch (s->type) {
-            case NODE_VAR_DECL: {
-                // find local variable index and store initializer
-                int varIndex = -1;
-                for (int j = 0; j < ctx->localCount; j++) {
-                    if (strcmp(ctx->localNames[j], s->variable.name) == 0) { varIndex = j; break; }
-                }
-                if (varIndex < 0) varIndex = 0;
-                int slotIndex = func->function.paramCount + varIndex;
-                int offset = 8 * (slotIndex + 1);
-
-                if (s->variable.initializer) {
-                    genExpression(ctx, s->variable.initializer, func->function.name);
-                    fprintf(ctx->out, "\tmov %%rax, -%d(%%rbp)\n", offset);
-                } else {
-                    fprintf(ctx->out, "\tmov $0, -%d(%%rbp)\n", offset);
-                }
+// The first predecessor at or after a phi block in layout is a loop latch;
+// its copies, if any survive coalescing, go in front of the block. Blocks
+// sunk for never having run keep their copies, off the hot path.
+static void findBackEdges(CGContext* ctx, IRFunction* irFn) {
+    int* position = calloc(irFn->nextBlockId > 0 ? irFn->nextBlockId : 1, sizeof(int));
+    int pos = 0;
+    for (IRBlock* block = irFn->entry; block; block = block->next) position[block->id] = pos++;
+    for (IRBlock* block = irFn->entry; block; block = block->next) {
+        if (!hasPhis(block)) continue;
+        for (int p = 0; p < block->predCount; p++) {
+            if (block->preds[p]->count == 0 && block->count != 0) continue;
+            if (position[block->preds[p]->id] >= position[block->id]) {
+                if (!edgeHasCopies(ctx, block->preds[p], block)) break;
+                ctx->backEdgeFrom[block->id] = block->preds[p];
                 break;
             }
-            case NODE_RETURN_STMT: {
-                if (s->returnStmt.value) {
-                    genExpression(ctx, s->returnStmt.value, func->function.name);
-                }
-                emitEpilogue(ctx);
-                break;
+        }
+    }
+    free(position);
+}
+
+// Give a phi and one of its operands x the same virtual register when every
+// use of the phi comes before x in x's block: the phi is dead once x is
+// computed, so x can overwrite it and the copy between them vanishes. x must
+// not read the phi after writing its result, which only `sub` and float
+// division could do with the phi on the right (add and mul swap their
+// operands instead).
+static void coalescePhis(CGContext* ctx, IRFunction* irFn) {
+    int count = irFn->nextValueId > 0 ? irFn->nextValueId : 1;
+    int* useBlock = malloc(sizeof(int) * count);      // -1 unused, -2 several blocks or a phi
+    int* lastUse = malloc(sizeof(int) * count);
+    int* position = malloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) {
+        useBlock[i] = -1;
+        lastUse[i] = -1;
+    }
+    int pos = 0;
+    for (IRBlock* block = irFn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next, pos++) {
+            position[inst->id] = pos;
+            int where = inst->op == IR_PHI ? -2 : block->id;
+            for (int i = 0; i < inst->argCount; i++) {
+                int id = inst->args[i]->id;
+                if (useBlock[id] == -1) useBlock[id] = where;
+                else if (useBlock[id] != where) useBlock[id] = -2;
+                lastUse[id] = pos;
             }
-            default: {
-                if (s->type == NODE_CALL_EXPR || s->type == NODE_BINARY_EXPR || s->type == NODE_VARIABLE) {
-                        genExpression(ctx, s, func->function.name);
-                    }
+        }
+    }
+
+    for (IRBlock* block = irFn->entry; block; block = block->next) {
+        for (IRInst* phi = block->first; phi && phi->op == IR_PHI; phi = phi->next) {
+            for (int i = 0; i < phi->argCount; i++) {
+                IRInst* x = phi->args[i];
+                if (x->op == IR_PHI || x->op == IR_PARAM || isRematerializable(x)) continue;
+                if (ctx->vregs[x->id] != REG_NONE || !x->block) continue;
+                if (useBlock[phi->id] != x->block->id || lastUse[phi->id] > position[x->id]) continue;
+                if ((x->op == IR_SUB || (x->op == IR_DIV && (isFloat(x) || isVector(x)))) &&
+                    x->args[1] == phi && x->args[0] != phi) continue;
+                ctx->vregs[x->id] = vregOf(ctx, phi);
                 break;
             }
         }
     }
+    free(useBlock);
+    free(lastUse);
+    free(position);
+}
+
+// ============ Constant multipliers and divisors ============
+
+static void emitAt(CGContext* ctx, MOpcode op, MOperand src, MOperand dst, int line) {
+    mirEmit(ctx->fn, op, src, dst)->line = line;
+}
+
+static unsigned long long magnitude(long long value) {
+    return value < 0 ? 0 - (unsigned long long)value : (unsigned long long)value;
+}
+
+// k if v is 2^k, else -1
+static int exactLog2(unsigned long long v) {
+    if (v == 0 || (v & (v - 1)) != 0) return -1;
+    int k = 0;
+    while (v >>= 1) k++;
+    return k;
+}
+
+// 3, 5 and 9 are one lea (%r,%r,2/4/8)
+static int leaScale(unsigned long long v) {
+    return v == 3 ? 2 : v == 5 ? 4 : v == 9 ? 8 : 0;
+}
+
+static void emitLea(CGContext* ctx, int reg, int scale, int line) {
+    emitAt(ctx, MOP_LEA, mMemIndex(reg, reg, scale, 0), mReg(reg), line);
+}
+
+// reg *= c. A power of two is a shift (and a neg when negative), 3/5/9
+// times a power of two a lea and a shift, and a product of two of 3/5/9
+// two leas; anything longer stays an imul.
+static void multiplyConstant(CGContext* ctx, int reg, long long c, int line) {
+    unsigned long long odd = magnitude(c);
+    int shift = 0;
+    while (odd != 0 && (odd & 1) == 0) {
+        odd >>= 1;
+        shift++;
+    }
+
+    if (odd == 1) {
+        if (shift > 0) emitAt(ctx, MOP_SHL, mImm(shift), mReg(reg), line);
+        if (c < 0) emitAt(ctx, MOP_NEG, mNone(), mReg(reg), line);
+        return;
+    }
+    if (c > 0 && leaScale(odd)) {
+        emitLea(ctx, reg, leaScale(odd), line);
+        if (shift > 0) emitAt(ctx, MOP_SHL, mImm(shift), mReg(reg), line);
+        return;
+    }
+    if (c > 0 && shift == 0) {
+        for (unsigned long long factor = 3; factor <= 9; factor++) {
+            if (!leaScale(factor) || odd % factor != 0 || !leaScale(odd / factor)) continue;
+            emitLea(ctx, reg, leaScale(factor), line);
+            emitLea(ctx, reg, leaScale(odd / factor), line);
+            return;
+        }
+    }
+    if (fitsImm32(c)) {
+        emitAt(ctx, MOP_IMUL, mImm(c), mReg(reg), line);
+    } else {
+        int factor = mirNewVreg(ctx->fn);
+        emitAt(ctx, MOP_MOV, mImm(c), mReg(factor), line);
+        emitAt(ctx, MOP_IMUL, mReg(factor), mReg(reg), line);
+    }
+}
+
+// Multiplier m and shift s such that x / d is (mulhs(x, m) [+/- x]) >> s,
+// plus one when that is negative, for every 64-bit x (Hacker's Delight
+// 10-1). |d| >= 2 and not a power of two.
+static void divisionMagic(long long d, long long* multiplier, int* shift) {
+    const unsigned long long two63 = 1ULL << 63;
+    unsigned long long ad = magnitude(d);
+    unsigned long long t = two63 + ((unsigned long long)d >> 63);
+    unsigned long long anc = t - 1 - t % ad;
+    unsigned long long q1 = two63 / anc, r1 = two63 - q1 * anc;
+    unsigned long long q2 = two63 / ad, r2 = two63 - q2 * ad;
+    unsigned long long delta;
+    int p = 63;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    *multiplier = (long long)(d < 0 ? 0 - (q2 + 1) : q2 + 1);
+    *shift = p - 64;
+}
+
+// A new register holding dividend / d, truncated, for a constant d != 0.
+// The dividend is only read.
+static int divideConstant(CGContext* ctx, IRInst* dividend, long long d, int line) {
+    int x = valueReg(ctx, dividend);
+    int q = mirNewVreg(ctx->fn);
+    int k = exactLog2(magnitude(d));
 
-    // Default return 0
-    fprintf(ctx->out, "\tmov $0, %%rax\n");
-    emitEpilogue(ctx);
+    if (k >= 0) {
+        // a negative dividend is biased by 2^k - 1 so the shift rounds toward zero
+        emitAt(ctx, MOP_MOV, mReg(x), mReg(q), line);
+        if (k > 0) {
+            if (k > 1) emitAt(ctx, MOP_SAR, mImm(63), mReg(q), line);
+            emitAt(ctx, MOP_SHR, mImm(64 - k), mReg(q), line);
+            emitAt(ctx, MOP_ADD, mReg(x), mReg(q), line);
+            emitAt(ctx, MOP_SAR, mImm(k), mReg(q), line);
+        }
+        if (d < 0) emitAt(ctx, MOP_NEG, mNone(), mReg(q), line);
+        return q;
+    }
 
-    // param/local name maps are stored in ctx and freed when overwritten
+    long long m;
+    int s;
+    divisionMagic(d, &m, &s);
+    emitAt(ctx, MOP_MOV, mImm(m), mReg(REG_RAX), line);
+    emitAt(ctx, MOP_IMULWIDE, mReg(x), mNone(), line);
+    emitAt(ctx, MOP_MOV, mReg(REG_RDX), mReg(q), line);
+    if (d > 0 && m < 0) emitAt(ctx, MOP_ADD, mReg(x), mReg(q), line);
+    if (d < 0 && m > 0) emitAt(ctx, MOP_SUB, mReg(x), mReg(q), line);
+    if (s > 0) emitAt(ctx, MOP_SAR, mImm(s), mReg(q), line);
+    int sign = mirNewVreg(ctx->fn);
+    emitAt(ctx, MOP_MOV, mReg(q), mReg(sign), line);
+    emitAt(ctx, MOP_SHR, mImm(63), mReg(sign), line);
+    emitAt(ctx, MOP_ADD, mReg(sign), mReg(q), line);
+    return q;
 }
 
-// Generate call, result in rax
-static void genCall(CGContext* ctx, ASTNode* node, const char* funcName) {
-    // Set arguments into registers (up to 6)
-    int argc = node->call.argCount;
-    const char* regs[6] = {"%rdi","%rsi","%rdx","%rcx","%r8","%r9"};
-    for (int i = 0; i < argc && i < 6; i++) {
-        genExpression(ctx, node->call.args[i], funcName);
-        fprintf(ctx->out, "\tmov %%rax, %s\n", regs[i]);
+// ============ Instruction selection ============
+
+// result = left op right in an XMM register, on a double or on both lanes
+// of a vector (the verifier allows only + and - on integer lanes)
+static void selectFloatArithmetic(CGContext* ctx, IRInst* inst) {
+    static const MOpcode scalarOps[] = {MOP_ADDSD, MOP_SUBSD, MOP_MULSD, MOP_DIVSD};
+    static const MOpcode doubleOps[] = {MOP_ADDPD, MOP_SUBPD, MOP_MULPD, MOP_DIVPD};
+    static const MOpcode intOps[] = {MOP_PADDQ, MOP_PSUBQ};
+    int result = vregOf(ctx, inst);
+    IRInst* left = inst->args[0];
+    IRInst* right = inst->args[1];
+    const MOpcode* ops = inst->type == IRT_V2I64 ? intOps : inst->type == IRT_V2F64 ? doubleOps : scalarOps;
+    MOpcode op = ops[inst->op - IR_ADD];
+    // a coalesced phi can share the result's register; read it before the copy clobbers it
+    if ((inst->op == IR_ADD || inst->op == IR_MUL) && !isRematerializable(right) && ctx->vregs[right->id] == result) {
+        left = inst->args[1];
+        right = inst->args[0];
     }
+    copyValue(ctx, left, mReg(result));
+    emitAt(ctx, op, valueOperand(ctx, right), mReg(result), inst->line);
+}
 
-    char* name = getCalleeName(node->call.callee);
-    if (!name) {
-        fprintf(stderr, "Codegen error: unsupported callee\n");
+static void selectArithmetic(CGContext* ctx, IRInst* inst) {
+    if (isFloat(inst) || isVector(inst)) {
+        selectFloatArithmetic(ctx, inst);
         return;
     }
-    char* flat = flattenName(name);
-    free(name);
-
-    // If local function (label), call the name directly; otherwise call flattened name
-    fprintf(ctx->out, "\tcall %s\n", flat);
-    free(flat);
-}
-
-// Generate expression
-static void genExpression(CGContext* ctx, ASTNode* node, const char* funcName) {
-    if (!node) return;
-    switch (node->type) {
-        case NODE_LITERAL: {
-            Token t = node->literal.token;
-            if (t.type == TOKEN_NUMBER) {
-                // Direct immediate
-                char buf[64] = {0};
-                snprintf(buf, sizeof(buf), "%.*s", t.length, t.start);
-                fprintf(ctx->out, "\tmov $%s, %%rax\n", buf);
-            } else if (t.type == TOKEN_STRING) {
-                // find string label
-                char* s = malloc(t.length + 1);
-                memcpy(s, t.start, t.length);
-                s[t.length] = '\0';
-                int idx = findStringLiteral(ctx, s);
-                free(s);
-                if (idx >= 0) {
-                    fprintf(ctx->out, "\tmov $ .LC%d, %%rax\n", idx);
-                } else {
-                    fprintf(ctx->out, "\tmov $0, %%rax\n");
-                }
-            } else {
-                fprintf(ctx->out, "\tmov $0, %%rax\n");
-            }
-            break;
+    MFunction* fn = ctx->fn;
+    int result = vregOf(ctx, inst);
+    IRInst* left = inst->args[0];
+    IRInst* right = inst->args[1];
+
+    // Operands are read before result is written: a coalesced phi can share its register
+    if ((inst->op == IR_DIV || inst->op == IR_REM) && right->op == IR_CONST && right->imm != 0) {
+        int quotient = divideConstant(ctx, left, right->imm, inst->line);
+        if (inst->op == IR_DIV) {
+            mirEmit(fn, MOP_MOV, mReg(quotient), mReg(result));
+            return;
         }
-        case NODE_VARIABLE: {
-            // Resolve variable slot among parameters and locals
-            int slotIndex = -1;
-            // search parameters
-            for (int i = 0; i < ctx->paramCount; i++) {
-                if (ctx->paramNames && strcmp(ctx->paramNames[i], node->varRef.name) == 0) {
-                    slotIndex = i;
-                    break;
-                }
-            }
-            // search locals if not found
-            if (slotIndex == -1) {
-                for (int i = 0; i < ctx->localCount; i++) {
-                    if (ctx->localNames && strcmp(ctx->localNames[i], node->varRef.name) == 0) {
-                        slotIndex = ctx->paramCount + i;
-                        break;
-                    }
-                }
-            }
+        // x % d == x - (x / d) * d
+        multiplyConstant(ctx, quotient, right->imm, inst->line);
+        copyValue(ctx, left, mReg(result));
+        emitAt(ctx, MOP_SUB, mReg(quotient), mReg(result), inst->line);
+        return;
+    }
+    if (inst->op == IR_DIV || inst->op == IR_REM) {
+        // left / right: dividend in rdx:rax, quotient in rax, remainder in rdx
+        copyValue(ctx, left, mReg(REG_RAX));
+        mirEmit(fn, MOP_CQO, mNone(), mNone());
+        mirEmit(fn, MOP_IDIV, mReg(valueReg(ctx, right)), mNone());
+        mirEmit(fn, MOP_MOV, mReg(inst->op == IR_DIV ? REG_RAX : REG_RDX), mReg(result));
+        return;
+    }
+    if (inst->op == IR_MUL && (left->op == IR_CONST || right->op == IR_CONST)) {
+        IRInst* constant = right->op == IR_CONST ? right : left;
+        copyValue(ctx, constant == right ? left : right, mReg(result));
+        multiplyConstant(ctx, result, constant->imm, inst->line);
+        return;
+    }
 
-            if (slotIndex == -1) {
-                // fallback: external symbol or uninitialized variable
-                fprintf(ctx->out, "\t# variable %s not found in locals/params, default 0\n", node->varRef.name);
-                fprintf(ctx->out, "\tmov $0, %%rax\n");
-            } else {
-                int offset = 8 * (slotIndex + 1);
-                fprintf(ctx->out, "\tmov -%d(%%rbp), %%rax\n", offset);
-            }
+    MOpcode op = inst->op == IR_ADD ? MOP_ADD : inst->op == IR_SUB ? MOP_SUB : MOP_IMUL;
+    // a coalesced phi can share the result's register; read it before the copy clobbers it
+    if (op != MOP_SUB && !isRematerializable(right) && ctx->vregs[right->id] == result) {
+        left = inst->args[1];
+        right = inst->args[0];
+    }
+    copyValue(ctx, left, mReg(result));
+    MInst* m = mirEmit(fn, op, valueOperand(ctx, right), mReg(result));
+    m->line = inst->line;
+}
+
+// A comparison as a 0/1 value; one only branched on is selected at the branch
+static void selectCompare(CGContext* ctx, IRInst* inst) {
+    if (ctx->fused[inst->id]) return;
+    const char* cc = emitCompare(ctx, inst);
+    int result = vregOf(ctx, inst);
+    MInst* set = mirEmit(ctx->fn, MOP_SETCC, mNone(), mReg(result));
+    set->text = strdup(cc);
+    // unordered sets ZF and PF: == is "e and not p", != is "ne or p"
+    if (isFloat(inst->args[0]) && (inst->op == IR_EQ || inst->op == IR_NE)) {
+        int parity = mirNewVreg(ctx->fn);
+        set = mirEmit(ctx->fn, MOP_SETCC, mNone(), mReg(parity));
+        set->text = strdup(inst->op == IR_EQ ? "np" : "p");
+        mirEmit(ctx->fn, inst->op == IR_EQ ? MOP_AND : MOP_OR, mReg(parity), mReg(result));
+    }
+    mirEmit(ctx->fn, MOP_MOVZB, mReg(result), mReg(result));
+}
+
+// (array, index, 8), folding a constant index into the displacement
+static MOperand elementAddress(CGContext* ctx, IRInst* array, IRInst* index) {
+    int base = valueReg(ctx, array);
+    if (index->op == IR_CONST && fitsImm32(index->imm * 8)) return mMem(base, index->imm * 8);
+    return mMemIndex(base, valueReg(ctx, index), 8, 0);
+}
+
+static void selectStore(CGContext* ctx, IRInst* inst) {
+    MOperand address = elementAddress(ctx, inst->args[0], inst->args[1]);
+    IRInst* value = inst->args[2];
+    // SSE stores need the value in a register; integers may be an immediate
+    MOperand source = isFloat(value) || isVector(value) ? mReg(valueReg(ctx, value)) : valueOperand(ctx, value);
+    emitAt(ctx, moveFor(value), source, address, inst->line);
+}
+
+// Both lanes of a vector set to one scalar
+static void selectSplat(CGContext* ctx, IRInst* inst) {
+    int result = vregOf(ctx, inst);
+    IRInst* scalar = inst->args[0];
+    if (isFloat(scalar)) mirEmit(ctx->fn, MOP_MOVSD, valueOperand(ctx, scalar), mReg(result));
+    else mirEmit(ctx->fn, MOP_MOVQ, mReg(valueReg(ctx, scalar)), mReg(result));
+    emitAt(ctx, MOP_PUNPCKLQDQ, mReg(result), mReg(result), inst->line);
+}
+
+// The sum of both integer lanes: add the high lane onto the low one
+static void selectHorizontalAdd(CGContext* ctx, IRInst* inst) {
+    int vector = valueReg(ctx, inst->args[0]);
+    int high = mirNewVectorVreg(ctx->fn);
+    mirEmit(ctx->fn, MOP_MOVDQU, mReg(vector), mReg(high));
+    mirEmit(ctx->fn, MOP_PUNPCKHQDQ, mReg(high), mReg(high));
+    emitAt(ctx, MOP_PADDQ, mReg(vector), mReg(high), inst->line);
+    mirEmit(ctx->fn, MOP_MOVQ, mReg(high), mReg(vregOf(ctx, inst)));
+}
+
+static void selectInst(CGContext* ctx, IRInst* inst) {
+    MFunction* fn = ctx->fn;
+    switch (inst->op) {
+        case IR_CONST:
+        case IR_STRING:
+        case IR_PARAM:
+        case IR_PHI:
+            // materialized at their uses, in the prologue, or on incoming edges
             break;
-        }
-        case NODE_BINARY_EXPR: {
-            // Evaluate left and right
-            genExpression(ctx, node->binary.left, funcName);
-            fprintf(ctx->out, "\tpush %%rax\n");
-            genExpression(ctx, node->binary.right, funcName);
-            fprintf(ctx->out, "\tpop %%rbx\n");
-            switch (node->binary.op.type) {
-                case TOKEN_PLUS:
-                    fprintf(ctx->out, "\tadd %%rbx, %%rax\n");
-                    break;
-                case TOKEN_MINUS:
-                    // left - right => rbx - rax -> store in rax
-                    fprintf(ctx->out, "\tsub %%rax, %%rbx\n");
-                    fprintf(ctx->out, "\tmov %%rbx, %%rax\n");
-                    break;
-                case TOKEN_STAR:
-                    fprintf(ctx->out, "\timul %%rbx, %%rax\n");
-                    break;
-                case TOKEN_SLASH: {
-                    // left / right
-                    fprintf(ctx->out, "\tmov %%rax, %%rcx\n");
-                    fprintf(ctx->out, "\tmov %%rbx, %%rax\n");
-                    fprintf(ctx->out, "\tcqo\n");
-                    fprintf(ctx->out, "\tidiv %%rcx\n");
-                    break;
-                }
-                default:
-                    fprintf(ctx->out, "\t# unsupported binary op\n");
-            }
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_REM:
+            selectArithmetic(ctx, inst);
             break;
-        }
-        case NODE_CALL_EXPR: {
-            genCall(ctx, node, funcName);
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+            selectCompare(ctx, inst);
             break;
-        }
-        case NODE_GET_EXPR: {
-                // If this is a call to sys.* the CALL handling resolves the name.
-                // Do not generate separate code here; return placeholder.
-            fprintf(ctx->out, "\t# get expr (placeholder) %s\n", node->get.name);
-            fprintf(ctx->out, "\tmov $0, %%rax\n");
+        case IR_ITOF:
+        case IR_FTOI:
+            emitAt(ctx, inst->op == IR_ITOF ? MOP_CVTSI2SD : MOP_CVTTSD2SI,
+                   mReg(valueReg(ctx, inst->args[0])), mReg(vregOf(ctx, inst)), inst->line);
+            break;
+        case IR_LENGTH:
+            emitAt(ctx, MOP_MOV, mMem(valueReg(ctx, inst->args[0]), -8), mReg(vregOf(ctx, inst)), inst->line);
+            break;
+        case IR_LOAD:
+            emitAt(ctx, moveFor(inst), elementAddress(ctx, inst->args[0], inst->args[1]),
+                   mReg(vregOf(ctx, inst)), inst->line);
+            break;
+        case IR_STORE:
+            selectStore(ctx, inst);
+            break;
+        case IR_SPLAT:
+            selectSplat(ctx, inst);
+            break;
+        case IR_HADD:
+            selectHorizontalAdd(ctx, inst);
+            break;
+        case IR_CALL:
+            selectCall(ctx, inst);
+            break;
+        case IR_COUNT: {
+            MOperand counter = mRip(IR_PROFILE_COUNTERS);
+            counter.imm = 8 * inst->imm;
+            emitAt(ctx, MOP_ADD, mImm(1), counter, inst->line);
             break;
         }
+        case IR_JMP:
+            emitJump(ctx, inst->block, inst->targets[0]);
+            break;
+        case IR_BR:
+            selectBranch(ctx, inst);
+            break;
+        case IR_RET:
+            if (inst->argCount > 0) copyValue(ctx, inst->args[0], mReg(isFloat(inst->args[0]) ? REG_XMM0 : REG_RAX));
+            else mirEmit(fn, MOP_MOV, mImm(0), mReg(REG_RAX));
+            mirEmit(fn, MOP_EPILOGUE, mNone(), mNone());
+            break;
         default:
-            fprintf(ctx->out, "\t# expr type %d not implemented\n", node->type);
-            fprintf(ctx->out, "\tmov $0, %%rax\n");
+            break;
     }
 }
 
-int codegen_generateExecutable(ASTNode* ast, const char* outPath) {
-    if (!ast) return 1;
-    CGContext ctx;
-    ctx.paramNames = NULL;
-    ctx.paramCount = 0;
-    ctx.localNames = NULL;
-    ctx.localCount = 0;
-    char asmPath[512];
-    snprintf(asmPath, sizeof(asmPath), "build/out.s");
-    ctx.out = fopen(asmPath, "w");
-    if (!ctx.out) return 1;
-
-    // Collect and emit string literals in .rodata
-    ctx.strLits = NULL;
-    ctx.strCount = 0;
-    collectStringLiterals(&ctx, ast);
-    if (ctx.strCount > 0) {
-        fprintf(ctx.out, "\t.section .rodata\n");
-        for (int i = 0; i < ctx.strCount; i++) {
-            fprintf(ctx.out, ".LC%d:\n", i);
-            // emit C-style escaped string
-            fprintf(ctx.out, "\t.asciz \"%s\"\n", ctx.strLits[i]);
+// Argument register of parameter `index`; integers and doubles count their
+// registers separately. REG_NONE past the sixth or eighth.
+static int paramRegister(IRFunction* irFn, int index) {
+    int wantFloat = irFn->paramTypes[index] == IRT_F64;
+    int position = 0;
+    for (int i = 0; i < index; i++) {
+        if ((irFn->paramTypes[i] == IRT_F64) == wantFloat) position++;
+    }
+    if (wantFloat) return position < 8 ? REG_XMM0 + position : REG_NONE;
+    return position < 6 ? argRegs[position] : REG_NONE;
+}
+
+// Arguments are only passed in registers: a call or a function with more
+// than 6 integer or 8 floating arguments cannot be generated. Checked for
+// the whole module before any output so nothing half-written is linked.
+static int checkArgumentCounts(IRModule* module) {
+    int failed = 0;
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) {
+        int gpCount = 0, xmmCount = 0;
+        for (int i = 0; i < fn->paramCount; i++) {
+            if (fn->paramTypes[i] == IRT_F64) xmmCount++;
+            else gpCount++;
+        }
+        if (gpCount > 6 || xmmCount > 8) {
+            fprintf(stderr, "Codegen error: too many parameters in function %s\n", fn->name);
+            failed = 1;
+        }
+        for (IRBlock* block = fn->entry; block; block = block->next) {
+            for (IRInst* inst = block->first; inst; inst = inst->next) {
+                if (inst->op != IR_CALL) continue;
+                gpCount = xmmCount = 0;
+                for (int i = 0; i < inst->argCount; i++) {
+                    if (abiIsFloating(argumentType(inst, i))) xmmCount++;
+                    else gpCount++;
+                }
+                if (gpCount > 6 || xmmCount > 8) {
+                    fprintf(stderr, "Codegen error: too many arguments in call to %s in %s\n", inst->sym, fn->name);
+                    failed = 1;
+                }
+            }
         }
     }
+    return failed;
+}
+
+// Select a function into MIR over virtual registers, allocate registers,
+// then encode or print it
+static void genFunction(CGContext* ctx, IRFunction* irFn) {
+    MFunction* fn = mirCreateFunction(irFn->name);
+    ctx->fn = fn;
+    ctx->irFn = irFn;
+    ctx->edgeCount = 0;
+    ctx->vregs = malloc(sizeof(int) * (irFn->nextValueId > 0 ? irFn->nextValueId : 1));
+    for (int i = 0; i < irFn->nextValueId; i++) ctx->vregs[i] = REG_NONE;
+    ctx->fused = calloc(irFn->nextValueId > 0 ? irFn->nextValueId : 1, 1);
+    ctx->backEdgeFrom = calloc(irFn->nextBlockId > 0 ? irFn->nextBlockId : 1, sizeof(IRBlock*));
+    sinkColdBlocks(irFn);
+    findFusedCompares(ctx, irFn);
+
+    fn->debugInfo = ctx->options.debugSource != NULL;
+    fn->keepFramePointer = ctx->options.keepFramePointer;
+    mirEmit(fn, MOP_PROLOGUE, mNone(), mNone())->line = irFn->line;
+
+    // Parameters arrive in argument registers and move into their own
+    // virtual registers before anything can clobber them (up to 6 integers
+    // and 8 doubles, see checkArgumentCounts)
+    for (IRInst* inst = irFn->entry->first; inst; inst = inst->next) {
+        if (inst->op != IR_PARAM) continue;
+        int reg = vregOf(ctx, inst);
+        int arg = paramRegister(irFn, (int)inst->imm);
+        if (arg != REG_NONE) emitAt(ctx, moveFor(inst), mReg(arg), mReg(reg), irFn->line);
+        else if (isFloat(inst)) emitAt(ctx, MOP_MOVSD, mRip(floatLabel(ctx, 0)), mReg(reg), irFn->line);
+        else emitAt(ctx, MOP_MOV, mImm(0), mReg(reg), irFn->line);
+    }
 
-    fprintf(ctx.out, "\t.text\n");
-    fprintf(ctx.out, "\t.global main\n");
+    coalescePhis(ctx, irFn);
+    findBackEdges(ctx, irFn);
 
-    // Generate code for each top-level function
-    for (int i = 0; i < ast->program.count; i++) {
-        ASTNode* s = ast->program.statements[i];
-        if (!s) continue;
-        if (s->type == NODE_FUNCTION_DECL) {
-            genFunction(&ctx, s);
+    for (IRBlock* block = irFn->entry; block; block = block->next) {
+        IRBlock* latch = ctx->backEdgeFrom[block->id];
+        if (latch) {
+            mirEmitLabel(fn, backEdgeLabel(ctx, block));
+            emitPhiCopies(ctx, latch, block);
+        }
+        if (block->predCount > 0) mirEmitLabel(fn, blockLabel(ctx, block));
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            int first = fn->count;
+            selectInst(ctx, inst);
+            // what the instruction selected without a line of its own
+            // (argument moves, phi copies, the epilogue) is on its line
+            for (int i = first; i < fn->count; i++) {
+                if (fn->insts[i].line == 0) fn->insts[i].line = inst->line;
+            }
         }
     }
 
-    fclose(ctx.out);
+    allocateRegisters(fn);
+    if (!ctx->options.noPeephole) peepholeOptimize(fn);
 
-    // free string table
-    if (ctx.strLits) {
-        for (int i = 0; i < ctx.strCount; i++) free(ctx.strLits[i]);
-        free(ctx.strLits);
+    if (ctx->obj) {
+        x86EncodeFunction(ctx->obj, fn);
+    } else {
+        // Each function in its own section, as the encoder writes it,
+        // so the linker can drop the ones nothing calls
+        emitf(&ctx->out, "\t.section .text.%s,\"ax\",@progbits\n", irFn->name);
+        emitf(&ctx->out, "\t.globl %s\n", irFn->name);
+        // -g also sizes the symbol, as the encoder does, for profilers
+        if (fn->debugInfo) emitf(&ctx->out, "\t.type %s, @function\n", irFn->name);
+        emitf(&ctx->out, "%s:\n", irFn->name);
+        if (fn->debugInfo) emitStr(&ctx->out, "\t.cfi_startproc\n");
+        mirPrintFunction(fn, &ctx->out);
+        if (fn->debugInfo) emitf(&ctx->out, "\t.cfi_endproc\n\t.size %s, .-%s\n", irFn->name, irFn->name);
     }
 
-        // Invoke gcc to link the executable. If a precompiled runtime object exists, prefer it.
-        char cmd[1024];
-        const char* libArchive = "lib/minolib/libminosys.a";
-        const char* runtimeObj = "lib/minolib/System/System.o";
-        FILE* farchive = fopen(libArchive, "r");
-        if (farchive) {
-            fclose(farchive);
-            // link with the static archive
-            snprintf(cmd, sizeof(cmd), "gcc -no-pie -o %s %s -Llib/minolib -lminosys -I./include -lm", outPath, "build/out.s");
-        } else {
-            FILE* fobj = fopen(runtimeObj, "r");
-            if (fobj) {
-                fclose(fobj);
-                snprintf(cmd, sizeof(cmd), "gcc -no-pie -o %s %s %s -I./include -lm", outPath, "build/out.s", runtimeObj);
+    mirFreeFunction(fn);
+    for (int i = 0; i < ctx->labelCount; i++) free(ctx->labels[i]);
+    ctx->labelCount = 0;
+    free(ctx->vregs);
+    free(ctx->fused);
+    free(ctx->backEdgeFrom);
+    ctx->vregs = NULL;
+    ctx->fused = NULL;
+    ctx->backEdgeFrom = NULL;
+    ctx->fn = NULL;
+    ctx->irFn = NULL;
+}
+
+// The string literals, in a mergeable section so the linker can also
+// share them with other objects. A literal that ends another one is a
+// label inside it.
+static void emitStrings(Emitter* out, IRModule* module) {
+    if (module->stringCount == 0) return;
+    irMergeStrings(module);
+    emitStr(out, "\t.section .rodata.str1.1,\"aMS\",@progbits,1\n");
+    for (int i = 0; i < module->stringCount; i++) {
+        IRString* s = &module->strings[i];
+        if (s->base != i) continue;
+        emitf(out, ".LC%d:\n\t.string \"", i);
+        for (int c = 0; c < s->length; c++) {
+            unsigned char byte = (unsigned char)s->bytes[c];
+            if (byte == '"' || byte == '\\') {
+                emitChar(out, '\\');
+                emitChar(out, (char)byte);
+            } else if (byte >= 32 && byte < 127) {
+                emitChar(out, (char)byte);
             } else {
-                // fallback: compile and link the C source directly
-                snprintf(cmd, sizeof(cmd), "gcc -no-pie -o %s %s %s -I./include -lm", outPath, "build/out.s", "lib/minolib/System/System.c");
+                // three octal digits, so a following digit cannot extend the escape
+                char escape[5] = {'\\', (char)('0' + (byte >> 6)), (char)('0' + ((byte >> 3) & 7)), (char)('0' + (byte & 7)), 0};
+                emitStr(out, escape);
             }
         }
-        int rc = system(cmd);
-    if (rc != 0) {
-        fprintf(stderr, "Linking failed (rc=%d)\n", rc);
+        emitStr(out, "\"\n");
+    }
+    for (int i = 0; i < module->stringCount; i++) {
+        IRString* s = &module->strings[i];
+        if (s->base != i) emitf(out, "\t.set .LC%d, .LC%d+%d\n", i, s->base, s->offset);
+    }
+}
+
+// The float constants, in a mergeable section of 8-byte entries
+static void emitFloats(Emitter* out, CGContext* ctx) {
+    if (ctx->floatCount == 0) return;
+    emitStr(out, "\t.section .rodata.cst8,\"aM\",@progbits,8\n\t.align 8\n");
+    for (int i = 0; i < ctx->floatCount; i++) emitf(out, ".LF%d:\n\t.quad %l\n", i, ctx->floats[i]);
+}
+
+// Write the object to a private temporary file, which the linker needs
+// to be able to seek in, and link it with the runtime
+static int linkEncodedObject(ObjectFile* obj, const char* outPath) {
+    const char* dir = getenv("TMPDIR");
+    char objectPath[512];
+    snprintf(objectPath, sizeof(objectPath), "%s/minoXXXXXX.o", dir && *dir ? dir : "/tmp");
+    int fd = mkstemps(objectPath, 2);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot create a temporary object in %s\n", dir && *dir ? dir : "/tmp");
         return 1;
     }
+    int failed = objWriteElf(obj, fd) != 0;
+    failed |= close(fd) != 0;
+    if (failed) fprintf(stderr, "Writing the object failed\n");
+    else failed = codegen_linkObject("gcc -no-pie", objectPath, outPath);
+    unlink(objectPath);
+    return failed;
+}
 
-    return 0;
+// Encode every function into an in-memory object; returns 0 on success
+static int encodeModule(IRModule* module, ObjectFile* obj, const CodegenOptions* options) {
+    if (checkArgumentCounts(module)) return 1;
+    CGContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.module = module;
+    ctx.obj = obj;
+    if (options) ctx.options = *options;
+    obj->debugSource = ctx.options.debugSource;
+
+    // Literals that end another one point into it
+    irMergeStrings(module);
+    obj->stringCount = module->stringCount;
+    obj->stringOffsets = malloc(sizeof(size_t) * (module->stringCount > 0 ? module->stringCount : 1));
+    for (int i = 0; i < module->stringCount; i++) {
+        IRString* s = &module->strings[i];
+        if (s->base == i) obj->stringOffsets[i] = objAddString(obj, s->bytes, s->length);
+    }
+    for (int i = 0; i < module->stringCount; i++) {
+        IRString* s = &module->strings[i];
+        if (s->base != i) obj->stringOffsets[i] = obj->stringOffsets[s->base] + s->offset;
+    }
+    int count;
+    IRFunction** order = textOrder(module, &count);
+    for (int i = 0; i < count; i++) genFunction(&ctx, order[i]);
+    free(order);
+    if (module->counterCount > 0) {
+        objDefineSymbol(obj, IR_PROFILE_COUNTERS, OBJ_COMMON, 8, 8 * (size_t)module->counterCount);
+    }
+    for (int i = 0; i < ctx.floatCount; i++) {
+        unsigned long long bits = (unsigned long long)ctx.floats[i];
+        unsigned char bytes[8];
+        for (int b = 0; b < 8; b++) bytes[b] = (unsigned char)(bits >> (8 * b));
+        objAppend(&obj->literals, bytes, 8);
+    }
+    freeFloats(&ctx);
+    free(ctx.labels);
+    return obj->failed;
+}
+
+// Encode the module, then write the object to outPath or link it
+static int generateObject(IRModule* module, const char* outPath, int link, const CodegenOptions* options) {
+    ObjectFile obj;
+    objInit(&obj);
+    int failed = encodeModule(module, &obj, options);
+    if (!failed && link) {
+        failed = linkEncodedObject(&obj, outPath);
+    } else if (!failed) {
+        int fd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "Cannot write %s\n", outPath);
+            failed = 1;
+        } else {
+            failed = objWriteElf(&obj, fd) != 0;
+            failed |= close(fd) != 0;
+            if (failed) fprintf(stderr, "Writing the object failed\n");
+        }
+    }
+    objFree(&obj);
+    return failed;
+}
+
+int codegen_run(IRModule* module, int* exitCode) {
+    if (!module) return 1;
+    ObjectFile obj;
+    objInit(&obj);
+    long long result = 0;
+    int failed = encodeModule(module, &obj, NULL) || jitRunMain(&obj, &result);
+    objFree(&obj);
+    if (!failed) *exitCode = (int)(result & 0xff);
+    return failed;
+}
+
+int codegen_generateExecutable(IRModule* module, const char* outPath, CodegenOutput output,
+                               const CodegenOptions* options) {
+    if (!module) return 1;
+    if (output == CODEGEN_EXECUTABLE || output == CODEGEN_OBJECT) {
+        return generateObject(module, outPath, output == CODEGEN_EXECUTABLE, options);
+    }
+    if (checkArgumentCounts(module)) return 1;
+
+    CGContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.module = module;
+    if (options) ctx.options = *options;
+    const char* debugSource = ctx.options.debugSource;
+
+    // -S writes the assembly to outPath; --via-asm pipes it into the driver
+    int assemblyOnly = output == CODEGEN_ASSEMBLY;
+    LinkJob job;
+    FILE* file;
+    if (assemblyOnly) {
+        file = fopen(outPath, "w");
+        if (!file) {
+            fprintf(stderr, "Cannot write %s\n", outPath);
+            return 1;
+        }
+    } else {
+        file = codegen_startLink(&job, "gcc -no-pie", "assembler", outPath);
+        if (!file) return codegen_finishLink(&job, NULL);
+    }
+    emitInit(&ctx.out, fileno(file));
+
+    emitStrings(&ctx.out, module);
+
+    emitStr(&ctx.out, "\t.text\n\t.global main\n");
+    if (debugSource) {
+        emitStr(&ctx.out, "\t.file 1 \"");
+        for (const char* c = debugSource; *c; c++) {
+            if (*c == '"' || *c == '\\') emitChar(&ctx.out, '\\');
+            emitChar(&ctx.out, *c);
+        }
+        emitStr(&ctx.out, "\"\n");
+    }
+
+    int count;
+    IRFunction** order = textOrder(module, &count);
+    for (int i = 0; i < count; i++) genFunction(&ctx, order[i]);
+    free(order);
+    if (module->counterCount > 0) {
+        emitf(&ctx.out, "\t.comm %s,%d,8\n", IR_PROFILE_COUNTERS, 8 * module->counterCount);
+    }
+    emitFloats(&ctx.out, &ctx);
+    // No executable stack, like the objects the encoder writes
+    emitStr(&ctx.out, "\t.section .note.GNU-stack,\"\",@progbits\n");
+    freeFloats(&ctx);
+    free(ctx.labels);
+
+    int failed = emitFinish(&ctx.out) != 0;
+    if (failed) fprintf(stderr, "Writing the assembly failed\n");
+    if (assemblyOnly) return (fclose(file) != 0) || failed;
+    return codegen_finishLink(&job, file) || failed;
 }
@@ -1,9 +1,62 @@
 #ifndef MINO_CODEGEN_H
 #define MINO_CODEGEN_H
 
+#include <sys/types.h>
+#include <ir.h>
 #include <ast.h>
 
-// Generate an executable; returns 0 on success
-int codegen_generateExecutable(ASTNode* ast, const char* outPath);
+// What the native backend produces at outPath
+typedef enum {
+    CODEGEN_EXECUTABLE,     // encode an object in memory, run only the linker
+    CODEGEN_OBJECT,         // relocatable ELF64 object (-c)
+    CODEGEN_ASSEMBLY,       // AT&T assembly text (-S)
+    CODEGEN_VIA_ASSEMBLER   // executable through gcc's assembler (--via-asm)
+} CodegenOutput;
+
+// How the native backend generates code
+typedef struct {
+    const char* debugSource;    // -g: DWARF line tables and call frame information
+                                // for this source file, NULL for none
+    int keepFramePointer;       // -fno-omit-frame-pointer: leaf functions set up
+                                // %rbp too, for frame-pointer unwinding
+    int noPeephole;             // -fno-peephole: print the allocated code as is,
+                                // to measure what peepholeOptimize removes
+} CodegenOptions;
+
+// Generate code for an optimized IR module; options may be NULL for the
+// defaults. Returns 0 on success
+int codegen_generateExecutable(IRModule* module, const char* outPath, CodegenOutput output,
+                               const CodegenOptions* options);
+
+// Encode the module into executable memory and call its main in-process
+// (minoc --run); returns 0 and main's exit status in *exitCode on success
+int codegen_run(IRModule* module, int* exitCode);
+
+// Lower a checked, folded program to C99 and compile it with the host C
+// compiler ($MINO_CC, default gcc) and flags ($MINO_CFLAGS, default
+// -O2 -fwrapv), or with sourceOnly write the C to outPath; returns 0 on
+// success
+int codegen_generateC(ASTNode* program, const char* outPath, int sourceOnly);
+
+// A compiler driver reading generated code from a pipe (link.c)
+#define LINK_MAX_ARGS 64
+
+typedef struct {
+    pid_t pid;
+    char* words;            // the split driver command, owned
+    char* args[LINK_MAX_ARGS];
+    int argCount;
+} LinkJob;
+
+// Spawn `driver` (e.g. "gcc -no-pie") to compile `language` ("assembler",
+// "c") from its standard input and link it with the Mino runtime into
+// outPath; returns the stream to write the code to, NULL on failure
+FILE* codegen_startLink(LinkJob* job, const char* driver, const char* language, const char* outPath);
+
+// Close the stream and wait for the driver; returns 0 if it succeeded
+int codegen_finishLink(LinkJob* job, FILE* out);
+
+// Link an object file with the Mino runtime into outPath; returns 0 on success
+int codegen_linkObject(const char* driver, const char* objectPath, const char* outPath);
 
 #endif
@@ -0,0 +1,350 @@
+// src/codegen/dwarf.c - DWARF line table and call frame information (-g)
+//
+// The encoder records where each source line's code starts in .text and
+// where the prologue and the epilogues move the canonical frame address
+// (CFA). From those this builds what GAS makes of the same .loc and .cfi_*
+// directives: .eh_frame with one CIE and an FDE per function, so
+// profilers and debuggers can unwind through Mino frames, and a
+// .debug_line program with a sequence per function section, found through
+// the one compile unit in .debug_info, whose code .debug_ranges lists.
+// The debug sections are DWARF 4.
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "obj.h"
+
+enum {
+    DW_TAG_compile_unit = 0x11,
+    DW_AT_name = 0x03, DW_AT_stmt_list = 0x10, DW_AT_low_pc = 0x11, DW_AT_high_pc = 0x12,
+    DW_AT_language = 0x13, DW_AT_comp_dir = 0x1b, DW_AT_producer = 0x25, DW_AT_ranges = 0x55,
+    DW_FORM_addr = 0x01, DW_FORM_data2 = 0x05, DW_FORM_data8 = 0x07, DW_FORM_string = 0x08,
+    DW_FORM_sec_offset = 0x17,
+    DW_LANG_Mips_Assembler = 0x8001,    // what GAS records for assembly without a language
+
+    DW_LNS_copy = 1, DW_LNS_advance_pc = 2, DW_LNS_advance_line = 3,
+    DW_LNE_end_sequence = 1, DW_LNE_set_address = 2,
+
+    DW_CFA_advance_loc = 0x40, DW_CFA_offset = 0x80, DW_CFA_nop = 0x00,
+    DW_CFA_advance_loc1 = 0x02, DW_CFA_advance_loc2 = 0x03, DW_CFA_advance_loc4 = 0x04,
+    DW_CFA_remember_state = 0x0a, DW_CFA_restore_state = 0x0b, DW_CFA_def_cfa = 0x0c,
+    DW_CFA_def_cfa_register = 0x0d, DW_CFA_def_cfa_offset = 0x0e,
+    DW_EH_PE_sdata4 = 0x0b, DW_EH_PE_pcrel = 0x10
+};
+
+// DWARF numbers of the general-purpose registers (x86-64 psABI 3.6.2),
+// which orders them differently from the instruction encoding
+static const int dwarfRegs[16] = {0, 2, 1, 3, 7, 6, 4, 5, 8, 9, 10, 11, 12, 13, 14, 15};
+#define DWARF_RETURN_ADDRESS 16
+
+// ============ Recording ============
+
+void objAddLine(ObjectFile* obj, size_t offset, int line) {
+    if (obj->lineCount == obj->lineCapacity) {
+        obj->lineCapacity = obj->lineCapacity ? obj->lineCapacity * 2 : 256;
+        obj->lines = realloc(obj->lines, sizeof(ObjLine) * obj->lineCapacity);
+    }
+    obj->lines[obj->lineCount].offset = offset;
+    obj->lines[obj->lineCount].line = line;
+    obj->lineCount++;
+}
+
+void objAddCfi(ObjectFile* obj, size_t offset, ObjCfiKind kind, int reg, int cfaOffset) {
+    if (obj->cfiCount == obj->cfiCapacity) {
+        obj->cfiCapacity = obj->cfiCapacity ? obj->cfiCapacity * 2 : 64;
+        obj->cfi = realloc(obj->cfi, sizeof(ObjCfi) * obj->cfiCapacity);
+    }
+    ObjCfi* c = &obj->cfi[obj->cfiCount++];
+    c->offset = offset;
+    c->kind = kind;
+    c->reg = reg;
+    c->cfaOffset = cfaOffset;
+}
+
+void objAddFrame(ObjectFile* obj, size_t start, size_t size) {
+    if (obj->frameCount == obj->frameCapacity) {
+        obj->frameCapacity = obj->frameCapacity ? obj->frameCapacity * 2 : 32;
+        obj->frames = realloc(obj->frames, sizeof(ObjFrame) * obj->frameCapacity);
+    }
+    ObjFrame* previous = obj->frameCount > 0 ? &obj->frames[obj->frameCount - 1] : NULL;
+    ObjFrame* f = &obj->frames[obj->frameCount++];
+    f->start = start;
+    f->size = size;
+    f->firstCfi = previous ? previous->firstCfi + previous->cfiCount : 0;
+    f->cfiCount = obj->cfiCount - f->firstCfi;
+}
+
+// ============ Encoding helpers ============
+
+static void put8(ObjBuffer* b, unsigned value) {
+    unsigned char byte = (unsigned char)value;
+    objAppend(b, &byte, 1);
+}
+
+static void putLittle(ObjBuffer* b, unsigned long long value, int bytes) {
+    for (int i = 0; i < bytes; i++) put8(b, (unsigned)(value >> (8 * i)));
+}
+
+static void putUleb(ObjBuffer* b, unsigned long long value) {
+    do {
+        unsigned byte = value & 0x7f;
+        value >>= 7;
+        put8(b, value ? byte | 0x80 : byte);
+    } while (value);
+}
+
+static void putSleb(ObjBuffer* b, long long value) {
+    for (;;) {
+        unsigned byte = value & 0x7f;
+        value >>= 7;        // arithmetic: the sign stays
+        if ((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40))) {
+            put8(b, byte);
+            return;
+        }
+        put8(b, byte | 0x80);
+    }
+}
+
+static void putString(ObjBuffer* b, const char* s) {
+    objAppend(b, s, strlen(s) + 1);
+}
+
+static void patch32(ObjBuffer* b, size_t at, size_t value) {
+    for (int i = 0; i < 4; i++) b->data[at + i] = (unsigned char)(value >> (8 * i));
+}
+
+// A relocated field at the end of the section: `bytes` zeros, fixed up to
+// the target section's address plus addend. The target is a debug section
+// or DEBUG_TEXT + i, the code of function i.
+static void putReloc(DebugSection* sec, int bytes, int type, int target, long long addend) {
+    if (sec->relocCount == sec->relocCapacity) {
+        sec->relocCapacity = sec->relocCapacity ? sec->relocCapacity * 2 : 16;
+        sec->relocs = realloc(sec->relocs, sizeof(ObjReloc) * sec->relocCapacity);
+    }
+    ObjReloc* r = &sec->relocs[sec->relocCount++];
+    r->offset = sec->data.length;
+    r->type = type;
+    r->symbol = target;
+    r->addend = addend;
+    putLittle(&sec->data, 0, bytes);
+}
+
+// ============ .eh_frame ============
+
+// Pad a CIE or FDE started at `start` to `alignment` bytes and fill in
+// its length. As GAS does, entries end on a 4-byte boundary and the last
+// on an 8-byte one.
+static void finishEntry(ObjBuffer* b, size_t start, size_t alignment) {
+    while (b->length % alignment != 0) put8(b, DW_CFA_nop);
+    patch32(b, start, b->length - start - 4);
+}
+
+static void advanceTo(ObjBuffer* b, size_t* location, size_t offset) {
+    size_t delta = offset - *location;
+    if (delta == 0) return;
+    if (delta < 64) {
+        put8(b, DW_CFA_advance_loc | (unsigned)delta);
+    } else if (delta < 256) {
+        put8(b, DW_CFA_advance_loc1);
+        put8(b, (unsigned)delta);
+    } else if (delta < 65536) {
+        put8(b, DW_CFA_advance_loc2);
+        putLittle(b, delta, 2);
+    } else {
+        put8(b, DW_CFA_advance_loc4);
+        putLittle(b, delta, 4);
+    }
+    *location = offset;
+}
+
+static void buildEhFrame(ObjectFile* obj, DebugSection* sec) {
+    ObjBuffer* b = &sec->data;
+
+    // The CIE: on entry the CFA is %rsp + 8 and the return address below it
+    size_t cie = b->length;
+    putLittle(b, 0, 4);                 // length
+    putLittle(b, 0, 4);                 // CIE id
+    put8(b, 1);                         // version
+    putString(b, "zR");                 // augmentation: FDE pointers are encoded
+    putUleb(b, 1);                      // code alignment
+    putSleb(b, -8);                     // data alignment
+    putUleb(b, DWARF_RETURN_ADDRESS);
+    putUleb(b, 1);                      // augmentation data length
+    put8(b, DW_EH_PE_pcrel | DW_EH_PE_sdata4);
+    put8(b, DW_CFA_def_cfa);
+    putUleb(b, dwarfRegs[REG_RSP]);
+    putUleb(b, 8);
+    put8(b, DW_CFA_offset | DWARF_RETURN_ADDRESS);
+    putUleb(b, 1);
+    finishEntry(b, cie, obj->frameCount > 0 ? 4 : 8);
+
+    for (int i = 0; i < obj->frameCount; i++) {
+        ObjFrame* frame = &obj->frames[i];
+        size_t fde = b->length;
+        putLittle(b, 0, 4);                             // length
+        putLittle(b, b->length - cie, 4);               // back to the CIE
+        putReloc(sec, 4, R_X86_64_PC32, DEBUG_TEXT + i, 0);
+        putLittle(b, frame->size, 4);
+        putUleb(b, 0);                                  // augmentation data length
+
+        size_t location = frame->start;
+        for (int c = frame->firstCfi; c < frame->firstCfi + frame->cfiCount; c++) {
+            ObjCfi* cfi = &obj->cfi[c];
+            advanceTo(b, &location, cfi->offset);
+            switch (cfi->kind) {
+                case OBJ_CFI_PUSH_FP:
+                    put8(b, DW_CFA_def_cfa_offset);
+                    putUleb(b, 16);
+                    put8(b, DW_CFA_offset | dwarfRegs[REG_RBP]);
+                    putUleb(b, 2);
+                    break;
+                case OBJ_CFI_SET_FP:
+                    put8(b, DW_CFA_def_cfa_register);
+                    putUleb(b, dwarfRegs[REG_RBP]);
+                    break;
+                case OBJ_CFI_SAVE:
+                    put8(b, DW_CFA_offset | dwarfRegs[cfi->reg]);
+                    putUleb(b, (unsigned long long)(-cfi->cfaOffset / 8));
+                    break;
+                case OBJ_CFI_REMEMBER:
+                    put8(b, DW_CFA_remember_state);
+                    break;
+                case OBJ_CFI_LEAVE:
+                    put8(b, DW_CFA_def_cfa);
+                    putUleb(b, dwarfRegs[REG_RSP]);
+                    putUleb(b, 8);
+                    break;
+                case OBJ_CFI_RESTORE:
+                    put8(b, DW_CFA_restore_state);
+                    break;
+            }
+        }
+        finishEntry(b, fde, i + 1 < obj->frameCount ? 4 : 8);
+    }
+}
+
+// ============ .debug_line ============
+
+static void buildLineTable(ObjectFile* obj, DebugSection* sec) {
+    static const unsigned char opcodeLengths[12] = {0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+    ObjBuffer* b = &sec->data;
+
+    putLittle(b, 0, 4);                 // unit length
+    putLittle(b, 4, 2);                 // version
+    size_t headerLength = b->length;
+    putLittle(b, 0, 4);
+    put8(b, 1);                         // minimum instruction length
+    put8(b, 1);                         // operations per instruction
+    put8(b, 1);                         // default is_stmt
+    put8(b, (unsigned char)-5);         // line base
+    put8(b, 14);                        // line range
+    put8(b, 13);                        // opcode base
+    objAppend(b, opcodeLengths, sizeof(opcodeLengths));
+    put8(b, 0);                         // no include directories
+    putString(b, obj->debugSource);     // file 1, relative to the compilation directory
+    putUleb(b, 0);
+    putUleb(b, 0);
+    putUleb(b, 0);
+    put8(b, 0);
+    patch32(b, headerLength, b->length - headerLength - 4);
+
+    // A sequence per function, whose code is a section of its own, with a
+    // row wherever the line changes
+    int row = 0;
+    for (int f = 0; f < obj->frameCount; f++) {
+        ObjFrame* frame = &obj->frames[f];
+        put8(b, 0);
+        putUleb(b, 9);
+        put8(b, DW_LNE_set_address);
+        putReloc(sec, 8, R_X86_64_64, DEBUG_TEXT + f, 0);
+        size_t address = frame->start;
+        int line = 1;
+        for (; row < obj->lineCount && obj->lines[row].offset < frame->start + frame->size; row++) {
+            ObjLine* entry = &obj->lines[row];
+            if (entry->offset > address) {
+                put8(b, DW_LNS_advance_pc);
+                putUleb(b, entry->offset - address);
+                address = entry->offset;
+            }
+            if (entry->line != line) {
+                put8(b, DW_LNS_advance_line);
+                putSleb(b, entry->line - line);
+                line = entry->line;
+            }
+            put8(b, DW_LNS_copy);
+        }
+        if (frame->start + frame->size > address) {
+            put8(b, DW_LNS_advance_pc);
+            putUleb(b, frame->start + frame->size - address);
+        }
+        put8(b, 0);
+        putUleb(b, 1);
+        put8(b, DW_LNE_end_sequence);
+    }
+    patch32(b, 0, b->length - 4);
+}
+
+// ============ .debug_info and .debug_abbrev ============
+
+static void buildCompileUnit(ObjectFile* obj, DebugSection* info, DebugSection* abbrev) {
+    static const unsigned char attributes[] = {
+        DW_AT_producer, DW_FORM_string,
+        DW_AT_language, DW_FORM_data2,
+        DW_AT_name, DW_FORM_string,
+        DW_AT_comp_dir, DW_FORM_string,
+        DW_AT_stmt_list, DW_FORM_sec_offset,
+        DW_AT_ranges, DW_FORM_sec_offset,
+        0, 0
+    };
+    putUleb(&abbrev->data, 1);
+    putUleb(&abbrev->data, DW_TAG_compile_unit);
+    put8(&abbrev->data, 0);             // no children
+    objAppend(&abbrev->data, attributes, sizeof(attributes));
+    put8(&abbrev->data, 0);
+
+    char dir[4096];
+    if (!getcwd(dir, sizeof(dir))) strcpy(dir, ".");
+    ObjBuffer* b = &info->data;
+    putLittle(b, 0, 4);                 // unit length
+    putLittle(b, 4, 2);                 // version
+    putReloc(info, 4, R_X86_64_32, DEBUG_ABBREV, 0);
+    put8(b, 8);                         // address size
+    putUleb(b, 1);
+    putString(b, "minoc");
+    putLittle(b, DW_LANG_Mips_Assembler, 2);
+    putString(b, obj->debugSource);
+    putString(b, dir);
+    putReloc(info, 4, R_X86_64_32, DEBUG_LINE, 0);
+    putReloc(info, 4, R_X86_64_32, DEBUG_RANGES, 0);
+    patch32(b, 0, b->length - 4);
+}
+
+// ============ .debug_ranges ============
+
+// The compile unit's code: each function's section. The addresses are
+// relocated, so the list starts by selecting a base address of 0.
+static void buildRanges(ObjectFile* obj, DebugSection* sec) {
+    putLittle(&sec->data, ~0ULL, 8);
+    putLittle(&sec->data, 0, 8);
+    for (int i = 0; i < obj->frameCount; i++) {
+        putReloc(sec, 8, R_X86_64_64, DEBUG_TEXT + i, 0);
+        putReloc(sec, 8, R_X86_64_64, DEBUG_TEXT + i, (long long)obj->frames[i].size);
+    }
+    putLittle(&sec->data, 0, 8);        // end of list
+    putLittle(&sec->data, 0, 8);
+}
+
+void dwarfBuildSections(ObjectFile* obj, DebugSection sections[DEBUG_SECTION_COUNT]) {
+    memset(sections, 0, sizeof(DebugSection) * DEBUG_SECTION_COUNT);
+    buildEhFrame(obj, &sections[DEBUG_EH_FRAME]);
+    buildCompileUnit(obj, &sections[DEBUG_INFO], &sections[DEBUG_ABBREV]);
+    buildLineTable(obj, &sections[DEBUG_LINE]);
+    buildRanges(obj, &sections[DEBUG_RANGES]);
+}
+
+void dwarfFreeSections(DebugSection sections[DEBUG_SECTION_COUNT]) {
+    for (int i = 0; i < DEBUG_SECTION_COUNT; i++) {
+        free(sections[i].data.data);
+        free(sections[i].relocs);
+    }
+}
@@ -0,0 +1,447 @@
+// src/codegen/elf.c - relocatable ELF64 object writer
+//
+// Holds the sections, symbols and relocations produced by the x86-64
+// encoder and lays them out as an ET_REL object the system linker accepts
+// alongside libminosys.a. The layout follows what GAS produces for the
+// same assembly: each function is its own section .text.<name>, so
+// --gc-sections can drop what nothing calls, with its relocations in
+// .rela.text.<name>; string literals live in the mergeable .rodata.str1.1 and
+// are reached through its section symbol plus an addend, float constants
+// in .rodata.cst8 through a local .LF<n> symbol each, calls through PLT32
+// relocations on named symbols. The profile counters of an instrumented
+// build are a common symbol, so the object needs no .bss of its own.
+// With -g the DWARF sections of dwarf.c follow the ones above.
+#include <elf.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "obj.h"
+
+// ============ Buffers and tables ============
+
+static void reserve(ObjBuffer* buf, size_t n) {
+    if (buf->length + n <= buf->capacity) return;
+    size_t capacity = buf->capacity ? buf->capacity : 256;
+    while (capacity < buf->length + n) capacity *= 2;
+    buf->data = realloc(buf->data, capacity);
+    buf->capacity = capacity;
+}
+
+void objAppend(ObjBuffer* buf, const void* bytes, size_t n) {
+    if (n == 0) return;
+    reserve(buf, n);
+    memcpy(buf->data + buf->length, bytes, n);
+    buf->length += n;
+}
+
+static void appendByte(ObjBuffer* buf, unsigned char byte) {
+    reserve(buf, 1);
+    buf->data[buf->length++] = byte;
+}
+
+static void alignTo(ObjBuffer* buf, size_t alignment) {
+    while (buf->length % alignment != 0) appendByte(buf, 0);
+}
+
+void objInit(ObjectFile* obj) {
+    memset(obj, 0, sizeof(*obj));
+    obj->hashCapacity = 64;
+    obj->symbolHash = malloc(sizeof(int) * obj->hashCapacity);
+    for (int i = 0; i < obj->hashCapacity; i++) obj->symbolHash[i] = -1;
+}
+
+void objFree(ObjectFile* obj) {
+    free(obj->text.data);
+    free(obj->rodata.data);
+    free(obj->literals.data);
+    free(obj->stringOffsets);
+    for (int i = 0; i < obj->symbolCount; i++) free(obj->symbols[i].name);
+    free(obj->symbols);
+    free(obj->symbolHash);
+    free(obj->relocs);
+    free(obj->functions);
+    free(obj->lines);
+    free(obj->cfi);
+    free(obj->frames);
+    memset(obj, 0, sizeof(*obj));
+}
+
+size_t objAddString(ObjectFile* obj, const char* bytes, size_t length) {
+    size_t offset = obj->rodata.length;
+    objAppend(&obj->rodata, bytes, length);
+    appendByte(&obj->rodata, 0);
+    return offset;
+}
+
+// ============ Symbols and relocations ============
+
+static unsigned hashName(const char* name) {
+    unsigned hash = 2166136261u;
+    for (; *name; name++) hash = (hash ^ (unsigned char)*name) * 16777619u;
+    return hash;
+}
+
+static void rehash(ObjectFile* obj) {
+    free(obj->symbolHash);
+    obj->hashCapacity *= 2;
+    obj->symbolHash = malloc(sizeof(int) * obj->hashCapacity);
+    for (int i = 0; i < obj->hashCapacity; i++) obj->symbolHash[i] = -1;
+    for (int i = 0; i < obj->symbolCount; i++) {
+        unsigned slot = hashName(obj->symbols[i].name) & (obj->hashCapacity - 1);
+        while (obj->symbolHash[slot] >= 0) slot = (slot + 1) & (obj->hashCapacity - 1);
+        obj->symbolHash[slot] = i;
+    }
+}
+
+int objSymbol(ObjectFile* obj, const char* name) {
+    unsigned slot = hashName(name) & (obj->hashCapacity - 1);
+    while (obj->symbolHash[slot] >= 0) {
+        int index = obj->symbolHash[slot];
+        if (strcmp(obj->symbols[index].name, name) == 0) return index;
+        slot = (slot + 1) & (obj->hashCapacity - 1);
+    }
+
+    if (obj->symbolCount == obj->symbolCapacity) {
+        obj->symbolCapacity = obj->symbolCapacity ? obj->symbolCapacity * 2 : 16;
+        obj->symbols = realloc(obj->symbols, sizeof(ObjSymbol) * obj->symbolCapacity);
+    }
+    int index = obj->symbolCount++;
+    ObjSymbol* sym = &obj->symbols[index];
+    sym->name = strdup(name);
+    sym->section = OBJ_UNDEF;
+    sym->value = 0;
+    sym->size = 0;
+    obj->symbolHash[slot] = index;
+    // keep the table at most half full
+    if (obj->symbolCount * 2 > obj->hashCapacity) rehash(obj);
+    return index;
+}
+
+void objDefineSymbol(ObjectFile* obj, const char* name, ObjSection section, size_t value, size_t size) {
+    int index = objSymbol(obj, name);      // may grow the table
+    ObjSymbol* sym = &obj->symbols[index];
+    sym->section = section;
+    sym->value = value;
+    sym->size = size;
+}
+
+void objAddReloc(ObjectFile* obj, size_t offset, int type, int symbol, long long addend) {
+    if (obj->relocCount == obj->relocCapacity) {
+        obj->relocCapacity = obj->relocCapacity ? obj->relocCapacity * 2 : 64;
+        obj->relocs = realloc(obj->relocs, sizeof(ObjReloc) * obj->relocCapacity);
+    }
+    ObjReloc* r = &obj->relocs[obj->relocCount++];
+    r->offset = offset;
+    r->type = type;
+    r->symbol = symbol;
+    r->addend = addend;
+}
+
+void objAddFunction(ObjectFile* obj, const char* name, size_t start) {
+    objDefineSymbol(obj, name, OBJ_TEXT, start, obj->text.length - start);
+    if (obj->functionCount == obj->functionCapacity) {
+        obj->functionCapacity = obj->functionCapacity ? obj->functionCapacity * 2 : 16;
+        obj->functions = realloc(obj->functions, sizeof(int) * obj->functionCapacity);
+    }
+    obj->functions[obj->functionCount++] = objSymbol(obj, name);
+}
+
+// ============ ELF output ============
+
+// Section header indices. Each function's .text.<name> follows them, with
+// its .rela.text.<name> after it when the code has relocations.
+enum {
+    SEC_NULL, SEC_RODATA, SEC_LITERALS, SEC_NOTE_STACK,
+    SEC_SYMTAB, SEC_STRTAB, SEC_SHSTRTAB, SEC_COUNT,
+    // a -g object also has the debug sections
+    SEC_EH_FRAME = SEC_COUNT, SEC_RELA_EH_FRAME, SEC_DEBUG_INFO, SEC_RELA_DEBUG_INFO,
+    SEC_DEBUG_ABBREV, SEC_DEBUG_LINE, SEC_RELA_DEBUG_LINE, SEC_DEBUG_RANGES, SEC_RELA_DEBUG_RANGES,
+    SEC_DEBUG_COUNT
+};
+
+// .symtab starts with the null symbol, the section symbols of the strings
+// and of each function's code, the float constants' local symbols, then
+// with -g the debug sections' section symbols; the object's own symbols
+// (all global) follow
+enum { SYM_NULL, SYM_RODATA, FIRST_FUNCTION };
+
+// Section headers of the debug sections and their relocations (0 if none)
+static const struct {
+    int header;
+    int rela;
+    const char* name;
+    Elf64_Word type;
+    Elf64_Xword flags;
+    Elf64_Xword align;
+} debugLayout[DEBUG_SECTION_COUNT] = {
+    [DEBUG_EH_FRAME] = {SEC_EH_FRAME, SEC_RELA_EH_FRAME, ".eh_frame", SHT_X86_64_UNWIND, SHF_ALLOC, 8},
+    [DEBUG_INFO] = {SEC_DEBUG_INFO, SEC_RELA_DEBUG_INFO, ".debug_info", SHT_PROGBITS, 0, 1},
+    [DEBUG_ABBREV] = {SEC_DEBUG_ABBREV, 0, ".debug_abbrev", SHT_PROGBITS, 0, 1},
+    [DEBUG_LINE] = {SEC_DEBUG_LINE, SEC_RELA_DEBUG_LINE, ".debug_line", SHT_PROGBITS, 0, 1},
+    [DEBUG_RANGES] = {SEC_DEBUG_RANGES, SEC_RELA_DEBUG_RANGES, ".debug_ranges", SHT_PROGBITS, 0, 1}
+};
+
+static Elf64_Word addName(ObjBuffer* table, const char* name) {
+    Elf64_Word offset = (Elf64_Word)table->length;
+    objAppend(table, name, strlen(name) + 1);
+    return offset;
+}
+
+// A section name made of a prefix and a function name, e.g. .text.main
+static Elf64_Word addSectionName(ObjBuffer* table, const char* prefix, const char* name) {
+    Elf64_Word offset = (Elf64_Word)table->length;
+    objAppend(table, prefix, strlen(prefix));
+    objAppend(table, name, strlen(name) + 1);
+    return offset;
+}
+
+static void setSection(Elf64_Shdr* sh, Elf64_Word name, Elf64_Word type, Elf64_Xword flags,
+                       size_t offset, size_t size, Elf64_Xword align) {
+    sh->sh_name = name;
+    sh->sh_type = type;
+    sh->sh_flags = flags;
+    sh->sh_offset = offset;
+    sh->sh_size = size;
+    sh->sh_addralign = align;
+}
+
+static void setRelocations(Elf64_Shdr* sh, Elf64_Word name, size_t offset, size_t size, int target) {
+    setSection(sh, name, SHT_RELA, SHF_INFO_LINK, offset, size, 8);
+    sh->sh_link = SEC_SYMTAB;
+    sh->sh_info = target;
+    sh->sh_entsize = sizeof(Elf64_Rela);
+}
+
+int objWriteElf(ObjectFile* obj, int fd) {
+    ObjBuffer file = {0};
+    ObjBuffer shstrtab = {0};
+    ObjBuffer strtab = {0};
+    int debug = obj->debugSource != NULL;
+    int functionCount = obj->functionCount;
+    int sectionCount = debug ? SEC_DEBUG_COUNT : SEC_COUNT;
+    Elf64_Shdr* sections = calloc(sectionCount + 2 * (size_t)functionCount, sizeof(Elf64_Shdr));
+    int* textSection = malloc(sizeof(int) * (functionCount > 0 ? functionCount : 1));
+    int* firstReloc = malloc(sizeof(int) * (functionCount + 1));
+    DebugSection debugSections[DEBUG_SECTION_COUNT];
+    if (debug) dwarfBuildSections(obj, debugSections);
+
+    appendByte(&shstrtab, 0);
+    appendByte(&strtab, 0);
+
+    Elf64_Ehdr header;
+    memset(&header, 0, sizeof(header));
+    objAppend(&file, &header, sizeof(header));      // filled in last
+
+    // Each function's code in its own section. The relocations are in
+    // .text order, so a function's are the ones before the first past
+    // its end.
+    int reloc = 0;
+    for (int i = 0; i < functionCount; i++) {
+        ObjSymbol* fn = &obj->symbols[obj->functions[i]];
+        textSection[i] = sectionCount++;
+        setSection(&sections[textSection[i]], addSectionName(&shstrtab, ".text.", fn->name), SHT_PROGBITS,
+                   SHF_ALLOC | SHF_EXECINSTR, file.length, fn->size, 1);
+        objAppend(&file, obj->text.data + fn->value, fn->size);
+        firstReloc[i] = reloc;
+        while (reloc < obj->relocCount && obj->relocs[reloc].offset < fn->value + fn->size) reloc++;
+        if (reloc > firstReloc[i]) sectionCount++;  // for its .rela.text.<name>
+    }
+    firstReloc[functionCount] = reloc;
+    if (sectionCount >= SHN_LORESERVE) {
+        // more would need the extended section numbering
+        fprintf(stderr, "Too many functions for one object: %d\n", functionCount);
+        if (debug) dwarfFreeSections(debugSections);
+        free(sections);
+        free(textSection);
+        free(firstReloc);
+        free(file.data);
+        free(shstrtab.data);
+        free(strtab.data);
+        return -1;
+    }
+
+    size_t rodataOffset = file.length;
+    objAppend(&file, obj->rodata.data, obj->rodata.length);
+    // SHF_MERGE | SHF_STRINGS lets the linker fold equal strings across objects
+    setSection(&sections[SEC_RODATA], addName(&shstrtab, ".rodata.str1.1"), SHT_PROGBITS,
+               SHF_ALLOC | SHF_MERGE | SHF_STRINGS, rodataOffset, obj->rodata.length, 1);
+    sections[SEC_RODATA].sh_entsize = 1;
+
+    // 8-byte constants, merged like the strings
+    alignTo(&file, 8);
+    size_t literalsOffset = file.length;
+    objAppend(&file, obj->literals.data, obj->literals.length);
+    setSection(&sections[SEC_LITERALS], addName(&shstrtab, ".rodata.cst8"), SHT_PROGBITS,
+               SHF_ALLOC | SHF_MERGE, literalsOffset, obj->literals.length, 8);
+    sections[SEC_LITERALS].sh_entsize = 8;
+
+    // Marks the stack non-executable, which the linker otherwise warns about
+    setSection(&sections[SEC_NOTE_STACK], addName(&shstrtab, ".note.GNU-stack"), SHT_PROGBITS,
+               0, file.length, 0, 1);
+
+    for (int i = 0; debug && i < DEBUG_SECTION_COUNT; i++) {
+        alignTo(&file, debugLayout[i].align);
+        setSection(&sections[debugLayout[i].header], addName(&shstrtab, debugLayout[i].name),
+                   debugLayout[i].type, debugLayout[i].flags, file.length,
+                   debugSections[i].data.length, debugLayout[i].align);
+        objAppend(&file, debugSections[i].data.data, debugSections[i].data.length);
+    }
+
+    // Symbols: null, section symbols, then the globals in creation order
+    alignTo(&file, 8);
+    size_t symtabOffset = file.length;
+    Elf64_Sym sym;
+    memset(&sym, 0, sizeof(sym));
+    objAppend(&file, &sym, sizeof(sym));
+    sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+    sym.st_shndx = SEC_RODATA;
+    objAppend(&file, &sym, sizeof(sym));
+    for (int i = 0; i < functionCount; i++) {
+        sym.st_shndx = textSection[i];
+        objAppend(&file, &sym, sizeof(sym));
+    }
+    int firstLiteral = FIRST_FUNCTION + functionCount;
+    int literalCount = (int)(obj->literals.length / 8);
+    for (int i = 0; i < literalCount; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), ".LF%d", i);
+        memset(&sym, 0, sizeof(sym));
+        sym.st_name = addName(&strtab, name);
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_NOTYPE);
+        sym.st_shndx = SEC_LITERALS;
+        sym.st_value = 8 * (Elf64_Addr)i;
+        objAppend(&file, &sym, sizeof(sym));
+    }
+    int debugSymbols = firstLiteral + literalCount;
+    for (int i = 0; debug && i < DEBUG_SECTION_COUNT; i++) {
+        memset(&sym, 0, sizeof(sym));
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        sym.st_shndx = debugLayout[i].header;
+        objAppend(&file, &sym, sizeof(sym));
+    }
+    int firstGlobal = debugSymbols + (debug ? DEBUG_SECTION_COUNT : 0);
+    int* functionOf = malloc(sizeof(int) * (obj->symbolCount > 0 ? obj->symbolCount : 1));
+    for (int i = 0; i < obj->symbolCount; i++) functionOf[i] = -1;
+    for (int i = 0; i < functionCount; i++) functionOf[obj->functions[i]] = i;
+    for (int i = 0; i < obj->symbolCount; i++) {
+        ObjSymbol* s = &obj->symbols[i];
+        memset(&sym, 0, sizeof(sym));
+        sym.st_name = addName(&strtab, s->name);
+        if (s->section == OBJ_UNDEF) {
+            sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE);
+            sym.st_shndx = SHN_UNDEF;
+        } else if (s->section == OBJ_COMMON) {
+            sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT);
+            sym.st_shndx = SHN_COMMON;
+            sym.st_value = s->value;
+            sym.st_size = s->size;
+        } else if (s->section == OBJ_TEXT) {
+            // a function starts its own section
+            sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+            sym.st_shndx = textSection[functionOf[i]];
+            sym.st_size = s->size;
+        } else {
+            sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT);
+            sym.st_shndx = SEC_RODATA;
+            sym.st_value = s->value;
+            sym.st_size = s->size;
+        }
+        objAppend(&file, &sym, sizeof(sym));
+    }
+    free(functionOf);
+    setSection(&sections[SEC_SYMTAB], addName(&shstrtab, ".symtab"), SHT_SYMTAB,
+               0, symtabOffset, file.length - symtabOffset, 8);
+    sections[SEC_SYMTAB].sh_link = SEC_STRTAB;
+    sections[SEC_SYMTAB].sh_info = firstGlobal;
+    sections[SEC_SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+
+    for (int i = 0; i < functionCount; i++) {
+        if (firstReloc[i + 1] == firstReloc[i]) continue;
+        ObjSymbol* fn = &obj->symbols[obj->functions[i]];
+        size_t relaOffset = file.length;
+        for (int r = firstReloc[i]; r < firstReloc[i + 1]; r++) {
+            ObjReloc* reloc = &obj->relocs[r];
+            Elf64_Rela rela;
+            int symbol = reloc->symbol == OBJ_RODATA_SYMBOL ? SYM_RODATA
+                       : reloc->symbol < 0 ? firstLiteral + objLiteralIndex(reloc->symbol)
+                       : firstGlobal + reloc->symbol;
+            rela.r_offset = reloc->offset - fn->value;
+            rela.r_info = ELF64_R_INFO(symbol, reloc->type);
+            rela.r_addend = reloc->addend;
+            objAppend(&file, &rela, sizeof(rela));
+        }
+        setRelocations(&sections[textSection[i] + 1], addSectionName(&shstrtab, ".rela.text.", fn->name),
+                       relaOffset, file.length - relaOffset, textSection[i]);
+    }
+
+    for (int i = 0; debug && i < DEBUG_SECTION_COUNT; i++) {
+        if (!debugLayout[i].rela) continue;
+        size_t relaOffset = file.length;
+        for (int r = 0; r < debugSections[i].relocCount; r++) {
+            ObjReloc* reloc = &debugSections[i].relocs[r];
+            Elf64_Rela rela;
+            int symbol = reloc->symbol >= DEBUG_TEXT ? FIRST_FUNCTION + (reloc->symbol - DEBUG_TEXT)
+                       : debugSymbols + reloc->symbol;
+            rela.r_offset = reloc->offset;
+            rela.r_info = ELF64_R_INFO(symbol, reloc->type);
+            rela.r_addend = reloc->addend;
+            objAppend(&file, &rela, sizeof(rela));
+        }
+        setRelocations(&sections[debugLayout[i].rela], addSectionName(&shstrtab, ".rela", debugLayout[i].name),
+                       relaOffset, file.length - relaOffset, debugLayout[i].header);
+    }
+
+    size_t strtabOffset = file.length;
+    objAppend(&file, strtab.data, strtab.length);
+    setSection(&sections[SEC_STRTAB], addName(&shstrtab, ".strtab"), SHT_STRTAB,
+               0, strtabOffset, strtab.length, 1);
+
+    Elf64_Word shstrtabName = addName(&shstrtab, ".shstrtab");
+    size_t shstrtabOffset = file.length;
+    objAppend(&file, shstrtab.data, shstrtab.length);
+    setSection(&sections[SEC_SHSTRTAB], shstrtabName, SHT_STRTAB,
+               0, shstrtabOffset, shstrtab.length, 1);
+
+    alignTo(&file, 8);
+    size_t sectionsOffset = file.length;
+    objAppend(&file, sections, sizeof(Elf64_Shdr) * sectionCount);
+
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = sectionsOffset;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = sectionCount;
+    header.e_shstrndx = SEC_SHSTRTAB;
+    memcpy(file.data, &header, sizeof(header));
+
+    // The whole object goes out in one write() where the kernel allows it
+    int failed = 0;
+    size_t done = 0;
+    while (done < file.length) {
+        ssize_t n = write(fd, file.data + done, file.length - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            failed = 1;
+            break;
+        }
+        done += (size_t)n;
+    }
+
+    if (debug) dwarfFreeSections(debugSections);
+    free(sections);
+    free(textSection);
+    free(firstReloc);
+    free(file.data);
+    free(shstrtab.data);
+    free(strtab.data);
+    return failed ? -1 : 0;
+}
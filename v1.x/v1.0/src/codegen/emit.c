@@ -0,0 +1,104 @@
+// src/codegen/emit.c - buffered text emitter for the assembly backend
+//
+// Replaces per-line fprintf: text is appended to one buffer with memcpy,
+// integers are converted by hand, and the buffer is handed to the kernel
+// in one write() per megabyte instead of through stdio.
+#include <stdarg.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include "emit.h"
+
+void emitInit(Emitter* e, int fd) {
+    e->capacity = EMIT_FLUSH_SIZE + 4096;
+    e->data = malloc(e->capacity);
+    e->length = 0;
+    e->fd = fd;
+    e->failed = 0;
+}
+
+void emitFlush(Emitter* e) {
+    size_t done = 0;
+    while (done < e->length && !e->failed) {
+        ssize_t n = write(e->fd, e->data + done, e->length - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            e->failed = 1;
+            break;
+        }
+        done += (size_t)n;
+    }
+    e->length = 0;
+}
+
+int emitFinish(Emitter* e) {
+    emitFlush(e);
+    free(e->data);
+    e->data = NULL;
+    e->capacity = 0;
+    return e->failed ? -1 : 0;
+}
+
+void emitReserve(Emitter* e, size_t n) {
+    if (e->length + n <= e->capacity) return;
+    // normally the buffer is flushed long before it fills; a single huge
+    // piece of text grows it instead
+    if (e->length >= EMIT_FLUSH_SIZE) emitFlush(e);
+    if (e->length + n > e->capacity) {
+        e->capacity = (e->length + n) * 2;
+        e->data = realloc(e->data, e->capacity);
+    }
+}
+
+void emitInt(Emitter* e, long long value) {
+    char digits[24];
+    int count = 0;
+    // work in unsigned so LLONG_MIN negates cleanly
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (e->length + count + 1 > e->capacity) emitReserve(e, count + 1);
+    char* out = e->data + e->length;
+    if (value < 0) *out++ = '-';
+    while (count > 0) *out++ = digits[--count];
+    e->length = out - e->data;
+}
+
+void emitf(Emitter* e, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const char* run = format;       // start of the pending literal text
+    const char* p = format;
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        emitChars(e, run, p - run);
+        switch (p[1]) {
+            case 's':
+                emitStr(e, va_arg(args, const char*));
+                break;
+            case 'd':
+                emitInt(e, va_arg(args, int));
+                break;
+            case 'l':
+                emitInt(e, va_arg(args, long long));
+                break;
+            case '%':
+                emitChar(e, '%');
+                break;
+            default:
+                // unknown directive: copy it through
+                emitChars(e, p, p[1] ? 2 : 1);
+                break;
+        }
+        p += p[1] ? 2 : 1;
+        run = p;
+    }
+    emitChars(e, run, p - run);
+    va_end(args);
+}
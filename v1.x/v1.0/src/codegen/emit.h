@@ -0,0 +1,54 @@
+// src/codegen/emit.h - buffered text emitter for the assembly backend
+#ifndef MINO_EMIT_H
+#define MINO_EMIT_H
+
+#include <stddef.h>
+#include <string.h>
+
+// Output collects in one growable buffer and goes out with a single
+// write() each time EMIT_FLUSH_SIZE bytes have accumulated
+#define EMIT_FLUSH_SIZE (1 << 20)
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int fd;             // destination file descriptor
+    int failed;         // a write failed; later output is dropped
+} Emitter;
+
+void emitInit(Emitter* e, int fd);
+// Flush what is left and release the buffer; returns 0 if every write succeeded
+int emitFinish(Emitter* e);
+void emitFlush(Emitter* e);
+// Make room for `n` more bytes
+void emitReserve(Emitter* e, size_t n);
+
+static inline void emitChars(Emitter* e, const char* s, size_t n) {
+    if (e->length + n > e->capacity) emitReserve(e, n);
+    memcpy(e->data + e->length, s, n);
+    e->length += n;
+}
+
+static inline void emitStr(Emitter* e, const char* s) {
+    emitChars(e, s, strlen(s));
+}
+
+static inline void emitChar(Emitter* e, char c) {
+    if (e->length + 1 > e->capacity) emitReserve(e, 1);
+    e->data[e->length++] = c;
+}
+
+// Signed decimal, formatted by hand rather than through stdio
+void emitInt(Emitter* e, long long value);
+
+// Instruction template: literal text with %s (const char*), %d (int),
+// %l (long long) and %% substituted, e.g. emitf(e, "\tsub $%d, %%rsp\n", n)
+void emitf(Emitter* e, const char* format, ...);
+
+// Flush once the buffer holds EMIT_FLUSH_SIZE bytes; call between lines
+static inline void emitMaybeFlush(Emitter* e) {
+    if (e->length >= EMIT_FLUSH_SIZE) emitFlush(e);
+}
+
+#endif
@@ -0,0 +1,121 @@
+// src/codegen/jit.c - run an encoded object in-process (minoc --run)
+//
+// The object from the x86-64 encoder is copied into mmap'd memory and
+// relocated there instead of being written out and linked. The generated
+// code assumes the non-PIE small code model (string addresses are 32-bit
+// absolute immediates), so the image is mapped into the low 2 GB with
+// MAP_32BIT. The runtime is linked into minoc itself; since minoc lives
+// far from that mapping, every runtime function gets a 16-byte stub in the
+// image (jmp *addr(%rip) plus the absolute address) for rel32 calls to reach.
+// Float constants follow the strings on the read-only pages.
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <runtime_abi.h>
+#include "obj.h"
+
+#define STUB_SIZE 16
+
+static size_t pageAlign(size_t n, size_t page) {
+    return (n + page - 1) & ~(page - 1);
+}
+
+// Address of a symbol in the loaded image, or of its runtime stub
+static unsigned char* symbolAddress(ObjectFile* obj, int symbol, unsigned char* text,
+                                    unsigned char* stubs, unsigned char* rodata, unsigned char* literals) {
+    if (symbol == OBJ_RODATA_SYMBOL) return rodata;
+    if (symbol < 0) return literals + 8 * (size_t)objLiteralIndex(symbol);
+    ObjSymbol* sym = &obj->symbols[symbol];
+    if (sym->section == OBJ_TEXT) return text + sym->value;
+    if (sym->section == OBJ_RODATA) return rodata + sym->value;
+    return stubs + (size_t)symbol * STUB_SIZE;
+}
+
+int jitRunMain(ObjectFile* obj, long long* result) {
+    // Every undefined symbol must be a runtime export
+    int missing = 0;
+    for (int i = 0; i < obj->symbolCount; i++) {
+        ObjSymbol* sym = &obj->symbols[i];
+        if (sym->section == OBJ_UNDEF && !lookupRuntimeFunc(sym->name)) {
+            fprintf(stderr, "Run failed: undefined symbol %s\n", sym->name);
+            missing = 1;
+        }
+    }
+    int mainSymbol = objSymbol(obj, "main");
+    if (obj->symbols[mainSymbol].section != OBJ_TEXT) {
+        fprintf(stderr, "Run failed: no main function\n");
+        missing = 1;
+    }
+    if (missing) return 1;
+
+    // Layout: [.text][stubs] executable, then [.rodata][literals] read-only on their own pages
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t stubsOffset = (obj->text.length + STUB_SIZE - 1) & ~(size_t)(STUB_SIZE - 1);
+    size_t codeSize = pageAlign(stubsOffset + (size_t)obj->symbolCount * STUB_SIZE, page);
+    size_t literalsOffset = (obj->rodata.length + 7) & ~(size_t)7;
+    size_t dataLength = literalsOffset + obj->literals.length;
+    size_t dataSize = pageAlign(dataLength > 0 ? dataLength : 1, page);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_32BIT
+    flags |= MAP_32BIT;
+#endif
+    unsigned char* image = mmap(NULL, codeSize + dataSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (image == MAP_FAILED) {
+        perror("Run failed: mmap");
+        return 1;
+    }
+    unsigned char* text = image;
+    unsigned char* stubs = image + stubsOffset;
+    unsigned char* rodata = image + codeSize;
+    unsigned char* literals = rodata + literalsOffset;
+    if (obj->text.length > 0) memcpy(text, obj->text.data, obj->text.length);
+    if (obj->rodata.length > 0) memcpy(rodata, obj->rodata.data, obj->rodata.length);
+    if (obj->literals.length > 0) memcpy(literals, obj->literals.data, obj->literals.length);
+
+    for (int i = 0; i < obj->symbolCount; i++) {
+        const RuntimeFunc* func = obj->symbols[i].section == OBJ_UNDEF ? lookupRuntimeFunc(obj->symbols[i].name) : NULL;
+        if (!func) continue;
+        uint64_t target = (uint64_t)(uintptr_t)runtimeAbiAddresses[func - runtimeAbiFuncs];
+        unsigned char* stub = stubs + (size_t)i * STUB_SIZE;
+        static const unsigned char jmpIndirect[6] = {0xFF, 0x25, 0, 0, 0, 0};   // jmp *0(%rip)
+        memcpy(stub, jmpIndirect, sizeof(jmpIndirect));
+        memcpy(stub + 6, &target, sizeof(target));
+    }
+
+    int failed = 0;
+    for (int i = 0; i < obj->relocCount; i++) {
+        ObjReloc* r = &obj->relocs[i];
+        unsigned char* place = text + r->offset;
+        int64_t value = (int64_t)(uintptr_t)symbolAddress(obj, r->symbol, text, stubs, rodata, literals) + r->addend;
+        if (r->type == R_X86_64_PLT32 || r->type == R_X86_64_PC32) value -= (int64_t)(uintptr_t)place;
+
+        if (r->type == R_X86_64_64) {
+            memcpy(place, &value, 8);
+        } else if (value < INT32_MIN || value > INT32_MAX) {
+            fprintf(stderr, "Run failed: relocation at .text+%zu out of range\n", r->offset);
+            failed = 1;
+        } else {
+            int32_t value32 = (int32_t)value;
+            memcpy(place, &value32, 4);
+        }
+    }
+
+    if (!failed && (mprotect(text, codeSize, PROT_READ | PROT_EXEC) != 0 ||
+                    mprotect(rodata, dataSize, PROT_READ) != 0)) {
+        perror("Run failed: mprotect");
+        failed = 1;
+    }
+    if (!failed) {
+        long long (*entry)(void);
+        unsigned char* address = text + obj->symbols[mainSymbol].value;
+        memcpy(&entry, &address, sizeof(entry));
+        *result = entry();
+        // Mino output goes through our stdio; flush it before minoc writes anything else
+        fflush(stdout);
+    }
+    munmap(image, codeSize + dataSize);
+    return failed;
+}
@@ -0,0 +1,162 @@
+// src/codegen/link.c - run the system compiler driver on generated code
+//
+// Objects from the built-in encoder are handed to the driver for the final
+// link only. Generated assembly or C is streamed into the driver's standard
+// input ("gcc -x assembler -") through a pipe, so nothing is written to a
+// shared path and concurrent minoc runs in one directory cannot clobber
+// each other. The driver is started with posix_spawnp rather than system(), so
+// no shell parses the command line.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "codegen.h"
+
+extern char** environ;
+
+static void addArg(LinkJob* job, const char* arg) {
+    if (job->argCount < LINK_MAX_ARGS - 1) job->args[job->argCount++] = (char*)arg;
+}
+
+// Runtime to link against: the archive, else the object, else its source
+static void addRuntime(LinkJob* job) {
+    const char* libArchive = "lib/minolib/libminosys.a";
+    const char* runtimeObj = "lib/minolib/System/System.o";
+    if (access(libArchive, R_OK) == 0) {
+        addArg(job, "-Llib/minolib");
+        addArg(job, "-lminosys");
+    } else if (access(runtimeObj, R_OK) == 0) {
+        addArg(job, runtimeObj);
+    } else {
+        // fallback: compile and link the C source directly
+        addArg(job, "-O2");
+        addArg(job, "lib/minolib/System/System.c");
+    }
+}
+
+// Start the argument list with the driver command, split on whitespace
+// (e.g. "ccache gcc -O2"); returns 0 if it is empty
+static int addDriver(LinkJob* job, const char* driver) {
+    memset(job, 0, sizeof(*job));
+    job->pid = -1;
+    job->words = strdup(driver);
+    for (char* word = strtok(job->words, " \t"); word; word = strtok(NULL, " \t")) addArg(job, word);
+    if (job->argCount == 0) {
+        fprintf(stderr, "Linking failed: empty compiler command\n");
+        free(job->words);
+        job->words = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// -o outPath, the runtime and libm, and the terminating NULL. The
+// runtime is built with a section per function (make runtime), so
+// --gc-sections leaves out what the program does not call.
+static void addOutput(LinkJob* job, const char* outPath) {
+    addArg(job, "-Wl,--gc-sections");
+    addArg(job, "-o");
+    addArg(job, outPath);
+    addRuntime(job);
+    addArg(job, "-lm");
+    job->args[job->argCount] = NULL;
+}
+
+// Reap the driver; returns 0 if it exited successfully
+static int waitForDriver(LinkJob* job) {
+    int status = 0;
+    while (waitpid(job->pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            status = -1;
+            break;
+        }
+    }
+    free(job->words);
+    job->words = NULL;
+    job->pid = -1;
+
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Linking failed (rc=%d)\n", WIFEXITED(status) ? WEXITSTATUS(status) : status);
+        return 1;
+    }
+    return 0;
+}
+
+FILE* codegen_startLink(LinkJob* job, const char* driver, const char* language, const char* outPath) {
+    if (!addDriver(job, driver)) return NULL;
+    addArg(job, "-x");
+    addArg(job, language);
+    addArg(job, "-");
+    addArg(job, "-x");
+    addArg(job, "none");       // later inputs are typed by extension again
+    addArg(job, "-I./include");
+    addOutput(job, outPath);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Linking failed: pipe: %s\n", strerror(errno));
+        free(job->words);
+        job->words = NULL;
+        return NULL;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    int rc = posix_spawnp(&job->pid, job->args[0], &actions, NULL, job->args, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[0]);
+    if (rc != 0) {
+        fprintf(stderr, "Linking failed: cannot run %s: %s\n", job->args[0], strerror(rc));
+        close(fds[1]);
+        free(job->words);
+        job->words = NULL;
+        job->pid = -1;
+        return NULL;
+    }
+
+    // A driver that exits early must not kill us with SIGPIPE; the write
+    // error and its exit status are reported by codegen_finishLink
+    signal(SIGPIPE, SIG_IGN);
+    FILE* out = fdopen(fds[1], "w");
+    if (!out) close(fds[1]);
+    return out;
+}
+
+int codegen_finishLink(LinkJob* job, FILE* out) {
+    int writeFailed = 0;
+    if (out) writeFailed = (fclose(out) != 0);
+    if (job->pid < 0) {
+        free(job->words);
+        job->words = NULL;
+        return 1;
+    }
+
+    if (waitForDriver(job) != 0) return 1;
+    if (writeFailed) {
+        fprintf(stderr, "Linking failed: could not write to the compiler\n");
+        return 1;
+    }
+    return 0;
+}
+
+int codegen_linkObject(const char* driver, const char* objectPath, const char* outPath) {
+    LinkJob job;
+    if (!addDriver(&job, driver)) return 1;
+    addArg(&job, objectPath);
+    addOutput(&job, outPath);
+
+    int rc = posix_spawnp(&job.pid, job.args[0], NULL, NULL, job.args, environ);
+    if (rc != 0) {
+        fprintf(stderr, "Linking failed: cannot run %s: %s\n", job.args[0], strerror(rc));
+        free(job.words);
+        return 1;
+    }
+    return waitForDriver(&job);
+}
@@ -0,0 +1,412 @@
+// src/codegen/mir.c - machine IR construction and AT&T printing
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mir.h"
+
+static const char* regNames[REG_PHYS_COUNT] = {
+    "%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+    "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15",
+    "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5", "%xmm6", "%xmm7",
+    "%xmm8", "%xmm9", "%xmm10", "%xmm11", "%xmm12", "%xmm13", "%xmm14", "%xmm15"
+};
+
+static const char* regNames32[16] = {
+    "%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi", "%edi",
+    "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"
+};
+
+static const char* regNames8[16] = {
+    "%al", "%cl", "%dl", "%bl", "%spl", "%bpl", "%sil", "%dil",
+    "%r8b", "%r9b", "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b"
+};
+
+static const char* opNames[MOP_COUNT] = {
+    "mov", "movabs", "movslq", "movzbq", "movsd", "cvtsd2ss", "cvtss2sd", "cvtsi2sdq", "cvttsd2si",
+    "addsd", "subsd", "mulsd", "divsd", "ucomisd",
+    "movdqu", "movq", "paddq", "psubq", "addpd", "subpd", "mulpd", "divpd", "punpcklqdq", "punpckhqdq",
+    "add", "sub", "imul", "imul", "shl", "sar", "shr", "lea", "xor", "and", "or", "cqo", "idiv", "neg",
+    "push", "pop", "call", "jmp", "cmp", "j", "set", "", "", "", ""
+};
+
+// ============ Operands ============
+
+MOperand mReg(int reg) {
+    MOperand o = {OPD_REG, reg, 0, NULL, REG_NONE, 0};
+    return o;
+}
+
+MOperand mImm(long long value) {
+    MOperand o = {OPD_IMM, REG_NONE, value, NULL, REG_NONE, 0};
+    return o;
+}
+
+MOperand mMem(int base, long long disp) {
+    MOperand o = {OPD_MEM, base, disp, NULL, REG_NONE, 0};
+    return o;
+}
+
+MOperand mMemIndex(int base, int index, int scale, long long disp) {
+    MOperand o = {OPD_MEM, base, disp, NULL, index, scale};
+    return o;
+}
+
+MOperand mSym(const char* sym) {
+    MOperand o = {OPD_SYM, REG_NONE, 0, sym, REG_NONE, 0};
+    return o;
+}
+
+MOperand mSymAddr(const char* sym) {
+    MOperand o = {OPD_SYM_ADDR, REG_NONE, 0, sym, REG_NONE, 0};
+    return o;
+}
+
+MOperand mRip(const char* sym) {
+    MOperand o = {OPD_RIP, REG_NONE, 0, sym, REG_NONE, 0};
+    return o;
+}
+
+MOperand mNone(void) {
+    MOperand o = {OPD_NONE, REG_NONE, 0, NULL, REG_NONE, 0};
+    return o;
+}
+
+// ============ Functions ============
+
+MFunction* mirCreateFunction(const char* name) {
+    MFunction* fn = calloc(1, sizeof(MFunction));
+    fn->name = strdup(name);
+    fn->capacity = 64;
+    fn->insts = malloc(sizeof(MInst) * fn->capacity);
+    return fn;
+}
+
+void mirFreeFunction(MFunction* fn) {
+    if (!fn) return;
+    for (int i = 0; i < fn->count; i++) {
+        free((char*)fn->insts[i].text);
+    }
+    free(fn->insts);
+    free(fn->floatVregs);
+    free(fn->name);
+    free(fn);
+}
+
+int mirNewVreg(MFunction* fn) {
+    return VREG_BASE + fn->vregCount++;
+}
+
+static int newXmmVreg(MFunction* fn, char kind) {
+    int reg = mirNewVreg(fn);
+    if (fn->vregCount > fn->floatVregCapacity) {
+        int capacity = fn->floatVregCapacity ? fn->floatVregCapacity : 64;
+        while (capacity < fn->vregCount) capacity *= 2;
+        fn->floatVregs = realloc(fn->floatVregs, capacity);
+        memset(fn->floatVregs + fn->floatVregCapacity, 0, capacity - fn->floatVregCapacity);
+        fn->floatVregCapacity = capacity;
+    }
+    fn->floatVregs[reg - VREG_BASE] = kind;
+    return reg;
+}
+
+int mirNewFloatVreg(MFunction* fn) {
+    return newXmmVreg(fn, 1);
+}
+
+int mirNewVectorVreg(MFunction* fn) {
+    return newXmmVreg(fn, 2);
+}
+
+int mirIsFloatReg(const MFunction* fn, int reg) {
+    if (!isVirtualReg(reg)) return reg >= REG_XMM0 && reg < REG_PHYS_COUNT;
+    return reg - VREG_BASE < fn->floatVregCapacity && fn->floatVregs[reg - VREG_BASE];
+}
+
+int mirIsVectorReg(const MFunction* fn, int reg) {
+    return isVirtualReg(reg) && reg - VREG_BASE < fn->floatVregCapacity && fn->floatVregs[reg - VREG_BASE] == 2;
+}
+
+MInst* mirEmit(MFunction* fn, MOpcode op, MOperand src, MOperand dst) {
+    if (fn->count == fn->capacity) {
+        fn->capacity *= 2;
+        fn->insts = realloc(fn->insts, sizeof(MInst) * fn->capacity);
+    }
+    MInst* inst = &fn->insts[fn->count++];
+    inst->op = op;
+    inst->src = src;
+    inst->dst = dst;
+    inst->text = NULL;
+    inst->line = 0;
+    return inst;
+}
+
+void mirEmitLabel(MFunction* fn, const char* label) {
+    MInst* inst = mirEmit(fn, MOP_LABEL, mNone(), mNone());
+    inst->text = strdup(label);
+}
+
+void mirEmitComment(MFunction* fn, const char* text) {
+    MInst* inst = mirEmit(fn, MOP_COMMENT, mNone(), mNone());
+    inst->text = strdup(text);
+}
+
+int mirIsCall(const MInst* inst) {
+    return inst->op == MOP_CALL;
+}
+
+// ============ Def/use information ============
+
+static void addVreg(int* list, int* count, int reg) {
+    if (!isVirtualReg(reg)) return;
+    for (int i = 0; i < *count; i++) if (list[i] == reg) return;
+    list[(*count)++] = reg;
+}
+
+// Registers read by an operand used as a value
+static void operandUses(const MOperand* o, int* uses, int* useCount) {
+    if (o->kind == OPD_REG || o->kind == OPD_MEM) addVreg(uses, useCount, o->reg);
+    if (o->kind == OPD_MEM && o->scale) addVreg(uses, useCount, o->index);
+}
+
+void mirDefsUses(const MInst* inst, int* defs, int* defCount, int* uses, int* useCount) {
+    *defCount = 0;
+    *useCount = 0;
+    switch (inst->op) {
+        // dst = f(src)
+        case MOP_MOV:
+        case MOP_MOVABS:
+        case MOP_MOVSLQ:
+        case MOP_MOVZB:
+        case MOP_MOVSD:
+        case MOP_CVTSD2SS:
+        case MOP_CVTSS2SD:
+        case MOP_CVTSI2SD:
+        case MOP_CVTTSD2SI:
+        case MOP_LEA:
+        case MOP_MOVDQU:
+        case MOP_MOVQ:
+            operandUses(&inst->src, uses, useCount);
+            if (inst->dst.kind == OPD_REG) addVreg(defs, defCount, inst->dst.reg);
+            else operandUses(&inst->dst, uses, useCount);
+            break;
+        // dst = dst op src
+        case MOP_ADD:
+        case MOP_SUB:
+        case MOP_IMUL:
+        case MOP_SHL:
+        case MOP_SAR:
+        case MOP_SHR:
+        case MOP_XOR:
+        case MOP_AND:
+        case MOP_OR:
+        case MOP_ADDSD:
+        case MOP_SUBSD:
+        case MOP_MULSD:
+        case MOP_DIVSD:
+        case MOP_PADDQ:
+        case MOP_PSUBQ:
+        case MOP_ADDPD:
+        case MOP_SUBPD:
+        case MOP_MULPD:
+        case MOP_DIVPD:
+        case MOP_PUNPCKLQDQ:
+        case MOP_PUNPCKHQDQ:
+            operandUses(&inst->src, uses, useCount);
+            operandUses(&inst->dst, uses, useCount);
+            if (inst->dst.kind == OPD_REG) addVreg(defs, defCount, inst->dst.reg);
+            break;
+        case MOP_SETCC:
+            if (inst->dst.kind == OPD_REG) addVreg(defs, defCount, inst->dst.reg);
+            else operandUses(&inst->dst, uses, useCount);
+            break;
+        case MOP_NEG:
+            operandUses(&inst->dst, uses, useCount);
+            if (inst->dst.kind == OPD_REG) addVreg(defs, defCount, inst->dst.reg);
+            break;
+        case MOP_CMP:
+        case MOP_UCOMISD:
+            operandUses(&inst->src, uses, useCount);
+            operandUses(&inst->dst, uses, useCount);
+            break;
+        case MOP_IDIV:
+        case MOP_IMULWIDE:
+        case MOP_PUSH:
+        case MOP_CALL:
+        case MOP_JMP:
+            operandUses(&inst->src, uses, useCount);
+            break;
+        case MOP_POP:
+            if (inst->dst.kind == OPD_REG) addVreg(defs, defCount, inst->dst.reg);
+            else operandUses(&inst->dst, uses, useCount);
+            break;
+        default:
+            break;
+    }
+}
+
+// ============ Printing ============
+
+static void printReg(Emitter* out, int reg) {
+    if (isVirtualReg(reg)) {
+        emitChars(out, "%v", 2);
+        emitInt(out, reg - VREG_BASE);
+    } else {
+        emitStr(out, regNames[reg]);
+    }
+}
+
+static void printOperand(Emitter* out, const MOperand* o) {
+    switch (o->kind) {
+        case OPD_REG:
+            printReg(out, o->reg);
+            break;
+        case OPD_IMM:
+            emitChar(out, '$');
+            emitInt(out, o->imm);
+            break;
+        case OPD_MEM:
+            if (o->imm != 0) emitInt(out, o->imm);
+            emitChar(out, '(');
+            printReg(out, o->reg);
+            if (o->scale) {
+                emitChar(out, ',');
+                printReg(out, o->index);
+                emitChar(out, ',');
+                emitInt(out, o->scale);
+            }
+            emitChar(out, ')');
+            break;
+        case OPD_SYM:
+            emitStr(out, o->sym);
+            break;
+        case OPD_SYM_ADDR:
+            emitChar(out, '$');
+            emitStr(out, o->sym);
+            break;
+        case OPD_RIP:
+            emitStr(out, o->sym);
+            if (o->imm) {
+                emitChar(out, '+');
+                emitInt(out, o->imm);
+            }
+            emitStr(out, "(%rip)");
+            break;
+        case OPD_NONE:
+            break;
+    }
+}
+
+// Nothing in a frameless function
+static void printPrologue(MFunction* fn, Emitter* out) {
+    if (fn->frameless) return;
+    emitStr(out, "\tpush %rbp\n");
+    if (fn->debugInfo) emitStr(out, "\t.cfi_def_cfa_offset 16\n\t.cfi_offset %rbp, -16\n");
+    emitStr(out, "\tmov %rsp, %rbp\n");
+    if (fn->debugInfo) emitStr(out, "\t.cfi_def_cfa_register %rbp\n");
+    if (fn->frameSize > 0) emitf(out, "\tsub $%d, %%rsp\n", fn->frameSize);
+    for (int i = 0; i < fn->calleeSavedCount; i++) {
+        emitf(out, "\tmov %s, %d(%%rbp)\n",
+              regNames[fn->calleeSavedRegs[i]], fn->calleeSavedOffsets[i]);
+        // the CFA is 16 bytes above %rbp
+        if (fn->debugInfo) {
+            emitf(out, "\t.cfi_offset %s, %d\n",
+                  regNames[fn->calleeSavedRegs[i]], fn->calleeSavedOffsets[i] - 16);
+        }
+    }
+}
+
+// An epilogue that more code follows keeps the frame rules for that code
+static void printEpilogue(MFunction* fn, Emitter* out, int last) {
+    if (fn->frameless) {
+        emitStr(out, "\tret\n");
+        return;
+    }
+    if (fn->debugInfo && !last) emitStr(out, "\t.cfi_remember_state\n");
+    for (int i = 0; i < fn->calleeSavedCount; i++) {
+        emitf(out, "\tmov %d(%%rbp), %s\n",
+              fn->calleeSavedOffsets[i], regNames[fn->calleeSavedRegs[i]]);
+    }
+    emitStr(out, "\tleave\n");
+    if (fn->debugInfo) emitStr(out, "\t.cfi_def_cfa %rsp, 8\n");
+    emitStr(out, "\tret\n");
+    if (fn->debugInfo && !last) emitStr(out, "\t.cfi_restore_state\n");
+}
+
+// Whether the instruction prints as machine code, which a .loc can precede
+static int printsCode(const MFunction* fn, const MInst* inst) {
+    return inst->op != MOP_LABEL && inst->op != MOP_COMMENT && !(inst->op == MOP_PROLOGUE && fn->frameless);
+}
+
+void mirPrintFunction(MFunction* fn, Emitter* out) {
+    int lastCode = fn->count - 1;
+    while (lastCode >= 0 && !printsCode(fn, &fn->insts[lastCode])) lastCode--;
+    int line = 0;
+    for (int i = 0; i < fn->count; i++) {
+        MInst* inst = &fn->insts[i];
+        emitMaybeFlush(out);
+        if (fn->debugInfo && inst->line > 0 && inst->line != line && printsCode(fn, inst)) {
+            emitf(out, "\t.loc 1 %d\n", inst->line);
+            line = inst->line;
+        }
+        switch (inst->op) {
+            case MOP_LABEL:
+                emitf(out, "%s:\n", inst->text);
+                continue;
+            case MOP_COMMENT:
+                emitf(out, "\t# %s\n", inst->text);
+                continue;
+            case MOP_PROLOGUE:
+                printPrologue(fn, out);
+                continue;
+            case MOP_EPILOGUE:
+                printEpilogue(fn, out, i == lastCode);
+                continue;
+            case MOP_JCC:
+                emitf(out, "\tj%s %s\n", inst->text, inst->src.sym);
+                continue;
+            case MOP_SETCC:
+                emitf(out, "\tset%s ", inst->text);
+                if (inst->dst.kind == OPD_REG && inst->dst.reg < 16) emitStr(out, regNames8[inst->dst.reg]);
+                else printOperand(out, &inst->dst);
+                emitChar(out, '\n');
+                continue;
+            default:
+                break;
+        }
+
+        // Without a register operand the operand size must be spelled out
+        // (the SSE mnemonics carry theirs)
+        int sized = inst->src.kind == OPD_REG || inst->dst.kind == OPD_REG ||
+                    inst->op == MOP_MOVABS || inst->op == MOP_CALL || inst->op == MOP_JMP ||
+                    inst->op == MOP_CQO || inst->op == MOP_MOVZB ||
+                    (inst->op >= MOP_MOVSD && inst->op <= MOP_PUNPCKHQDQ);
+        emitChar(out, '\t');
+        // a register-to-register movsd would merge into the old value; movapd copies all of it
+        if (inst->op == MOP_MOVSD && inst->src.kind == OPD_REG && inst->dst.kind == OPD_REG) emitStr(out, "movapd");
+        else emitStr(out, opNames[inst->op]);
+        if (!sized) emitChar(out, 'q');
+        if (inst->src.kind != OPD_NONE) {
+            emitChar(out, ' ');
+            // movslq reads the low 32 bits of its source register, and the
+            // 32-bit zeroing xor also clears the upper half
+            if ((inst->op == MOP_MOVSLQ || inst->op == MOP_XOR) &&
+                inst->src.kind == OPD_REG && inst->src.reg < 16) {
+                emitStr(out, regNames32[inst->src.reg]);
+            } else if (inst->op == MOP_MOVZB && inst->src.kind == OPD_REG && inst->src.reg < 16) {
+                emitStr(out, regNames8[inst->src.reg]);
+            } else {
+                printOperand(out, &inst->src);
+            }
+            if (inst->dst.kind != OPD_NONE) emitChar(out, ',');
+        }
+        if (inst->dst.kind != OPD_NONE) {
+            emitChar(out, ' ');
+            if (inst->op == MOP_XOR && inst->dst.kind == OPD_REG && inst->dst.reg < 16) {
+                emitStr(out, regNames32[inst->dst.reg]);
+            } else {
+                printOperand(out, &inst->dst);
+            }
+        }
+        emitChar(out, '\n');
+    }
+}
@@ -0,0 +1,169 @@
+// src/codegen/mir.h - machine-level IR for the x86-64 backend
+#ifndef MINO_MIR_H
+#define MINO_MIR_H
+
+#include <stdio.h>
+#include "emit.h"
+
+// Physical registers, numbered in x86-64 encoding order
+enum {
+    REG_RAX, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+    REG_XMM0, REG_XMM1, REG_XMM2, REG_XMM3, REG_XMM4, REG_XMM5, REG_XMM6, REG_XMM7,
+    REG_XMM8, REG_XMM9, REG_XMM10, REG_XMM11, REG_XMM12, REG_XMM13, REG_XMM14, REG_XMM15,
+    REG_PHYS_COUNT
+};
+
+#define REG_NONE (-1)
+// Virtual registers are numbered from VREG_BASE upwards
+#define VREG_BASE 64
+#define isVirtualReg(r) ((r) >= VREG_BASE)
+
+// Scratch registers reserved for spill fix-ups (never allocated)
+#define REG_SCRATCH REG_R11
+#define REG_FLOAT_SCRATCH REG_XMM15
+
+typedef enum {
+    OPD_NONE,
+    OPD_REG,        // register (physical or virtual)
+    OPD_IMM,        // $imm
+    OPD_MEM,        // disp(%base), or disp(%base,%index,scale) when scale != 0
+    OPD_SYM,        // bare symbol (call / jump target)
+    OPD_SYM_ADDR,   // $symbol (address as immediate)
+    OPD_RIP         // symbol+imm(%rip): a float constant, or a profile counter
+} OperandKind;
+
+typedef struct {
+    OperandKind kind;
+    int reg;            // OPD_REG register, OPD_MEM base register
+    long long imm;      // OPD_IMM value, OPD_MEM / OPD_RIP displacement
+    const char* sym;    // OPD_SYM / OPD_SYM_ADDR / OPD_RIP name
+    int index;          // OPD_MEM index register, used when scale != 0
+    int scale;          // OPD_MEM index scale (1, 2, 4 or 8), 0 without an index
+} MOperand;
+
+typedef enum {
+    MOP_MOV,            // mov src, dst
+    MOP_MOVABS,         // movabs $imm64, dst
+    MOP_MOVSLQ,         // sign-extend 32-bit src into dst
+    MOP_MOVZB,          // zero-extend the low byte of src into dst
+    MOP_MOVSD,          // move a double (movapd between registers)
+    MOP_CVTSD2SS,
+    MOP_CVTSS2SD,
+    MOP_CVTSI2SD,       // 64-bit integer src to double dst
+    MOP_CVTTSD2SI,      // double src to 64-bit integer dst, truncating
+    MOP_ADDSD,          // dst = dst op src on doubles; dst is an XMM register
+    MOP_SUBSD,
+    MOP_MULSD,
+    MOP_DIVSD,
+    MOP_UCOMISD,        // flags = dst compared with src, unordered sets ZF, PF and CF
+    MOP_MOVDQU,         // move all 128 bits of a vector, unaligned in memory
+    MOP_MOVQ,           // move 64 bits between a general-purpose and an XMM register
+    MOP_PADDQ,          // dst = dst op src on two 64-bit integer lanes
+    MOP_PSUBQ,
+    MOP_ADDPD,          // dst = dst op src on two double lanes
+    MOP_SUBPD,
+    MOP_MULPD,
+    MOP_DIVPD,
+    MOP_PUNPCKLQDQ,     // dst = {dst.low, src.low}
+    MOP_PUNPCKHQDQ,     // dst = {dst.high, src.high}
+    MOP_ADD,
+    MOP_SUB,
+    MOP_IMUL,
+    MOP_IMULWIDE,       // imul src (rdx:rax = rax * src, signed)
+    MOP_SHL,            // shl $src, dst
+    MOP_SAR,            // sar $src, dst (arithmetic)
+    MOP_SHR,            // shr $src, dst (logical)
+    MOP_LEA,            // lea src (an address), dst
+    MOP_XOR,            // xor src, dst (zeroing idiom when src == dst)
+    MOP_AND,
+    MOP_OR,
+    MOP_CQO,            // sign-extend rax into rdx:rax
+    MOP_IDIV,           // idiv src (rdx:rax / src)
+    MOP_NEG,            // neg dst
+    MOP_PUSH,
+    MOP_POP,
+    MOP_CALL,           // call src (symbol); clobbers caller-saved registers
+    MOP_JMP,
+    MOP_CMP,            // cmp src, dst (flags = dst - src)
+    MOP_JCC,            // j<text> src (symbol); falls through otherwise
+    MOP_SETCC,          // set<text> dst: low byte of dst = condition ? 1 : 0
+    MOP_LABEL,          // text = label name
+    MOP_COMMENT,        // text = comment
+    MOP_PROLOGUE,       // frame setup, expanded once the frame is known
+    MOP_EPILOGUE,       // restore callee-saved registers, leave, ret
+    MOP_COUNT
+} MOpcode;
+
+typedef struct {
+    MOpcode op;
+    MOperand dst;       // destination (second AT&T operand)
+    MOperand src;       // source (first AT&T operand)
+    const char* text;   // label name / comment text / condition code
+    int line;           // source line, 0 if unknown
+} MInst;
+
+typedef struct {
+    char* name;
+    MInst* insts;
+    int count;
+    int capacity;
+    int debugInfo;              // print .loc and .cfi_* directives (-g)
+    int keepFramePointer;       // set up %rbp even where it is not needed
+    int vregCount;              // virtual registers handed out so far
+    char* floatVregs;           // vreg - VREG_BASE -> 1 holds a double, 2 a vector (XMM class)
+    int floatVregCapacity;
+
+    // Filled in by allocateRegisters
+    int frameless;              // a leaf with nothing in memory: no frame at all
+    int frameSize;              // bytes reserved below %rbp (16-byte aligned)
+    int calleeSavedCount;
+    int calleeSavedRegs[8];     // registers saved in the prologue
+    int calleeSavedOffsets[8];  // their save slots (negative rbp offsets)
+    int spillCount;             // virtual registers that ended up in memory
+} MFunction;
+
+// Operand constructors
+MOperand mNone(void);
+MOperand mReg(int reg);
+MOperand mImm(long long value);
+MOperand mMem(int base, long long disp);
+MOperand mMemIndex(int base, int index, int scale, long long disp);
+MOperand mSym(const char* sym);
+MOperand mSymAddr(const char* sym);
+MOperand mRip(const char* sym);
+
+// Function construction
+MFunction* mirCreateFunction(const char* name);
+void mirFreeFunction(MFunction* fn);
+int mirNewVreg(MFunction* fn);
+int mirNewFloatVreg(MFunction* fn);
+int mirNewVectorVreg(MFunction* fn);
+// Whether a register (virtual or physical) is an XMM register
+int mirIsFloatReg(const MFunction* fn, int reg);
+// Whether a virtual register holds a 128-bit vector rather than a double
+int mirIsVectorReg(const MFunction* fn, int reg);
+MInst* mirEmit(MFunction* fn, MOpcode op, MOperand src, MOperand dst);
+void mirEmitLabel(MFunction* fn, const char* label);
+void mirEmitComment(MFunction* fn, const char* text);
+
+// Whether the instruction clobbers caller-saved registers (calls)
+int mirIsCall(const MInst* inst);
+
+// Virtual registers read / written by an instruction; returns counts via out params
+void mirDefsUses(const MInst* inst, int* defs, int* defCount, int* uses, int* useCount);
+
+// Linear-scan register allocation: assigns every virtual register to a
+// physical register or a frame slot and rewrites the instruction stream
+void allocateRegisters(MFunction* fn);
+
+// Pattern-driven cleanup of the allocated instruction stream (peephole.c)
+void peepholeOptimize(MFunction* fn);
+
+// Print the function as AT&T assembly; with debugInfo also the source
+// lines of its instructions (.loc, file 1) and the frame changes of its
+// prologue and epilogues (.cfi_*), between .cfi_startproc and
+// .cfi_endproc the caller prints
+void mirPrintFunction(MFunction* fn, Emitter* out);
+
+#endif
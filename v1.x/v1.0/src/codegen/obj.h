@@ -0,0 +1,167 @@
+// src/codegen/obj.h - in-memory relocatable object and ELF64 writer
+#ifndef MINO_OBJ_H
+#define MINO_OBJ_H
+
+#include <stddef.h>
+#include "mir.h"
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+} ObjBuffer;
+
+// Sections a symbol can be defined in
+typedef enum {
+    OBJ_UNDEF,          // external, e.g. a sys_* runtime export
+    OBJ_TEXT,
+    OBJ_RODATA,
+    OBJ_COMMON          // zeroed storage the linker allocates (.comm)
+} ObjSection;
+
+typedef struct {
+    char* name;
+    ObjSection section;
+    size_t value;       // offset in its section, for OBJ_TEXT in all of .text; the alignment of OBJ_COMMON
+    size_t size;
+} ObjSymbol;
+
+// Relocation target that is not a named symbol: the .rodata section itself
+#define OBJ_RODATA_SYMBOL (-1)
+// Float constant n, a local .LF<n> symbol: GAS keeps those for the -4
+// addend of %rip-relative loads, which the section symbol cannot carry
+#define OBJ_LITERAL_SYMBOL(n) (-2 - (n))
+#define objLiteralIndex(symbol) (-2 - (symbol))
+
+typedef struct {
+    size_t offset;      // patched location in .text
+    int type;           // R_X86_64_*
+    int symbol;         // index into symbols, OBJ_RODATA_SYMBOL or OBJ_LITERAL_SYMBOL(n)
+    long long addend;
+} ObjReloc;
+
+// -g: the .text offset where each source line's code starts, and how each
+// function's frame changes, for .debug_line and .eh_frame (dwarf.c)
+typedef struct {
+    size_t offset;
+    int line;
+} ObjLine;
+
+typedef enum {
+    OBJ_CFI_PUSH_FP,    // after push %rbp: CFA = %rsp + 16, %rbp saved at CFA - 16
+    OBJ_CFI_SET_FP,     // after mov %rsp, %rbp: CFA = %rbp + 16
+    OBJ_CFI_SAVE,       // after a callee-saved register is stored at CFA + cfaOffset
+    OBJ_CFI_REMEMBER,   // before an epilogue that more code follows
+    OBJ_CFI_LEAVE,      // after its leave: CFA = %rsp + 8
+    OBJ_CFI_RESTORE     // after its ret: the state remembered before it
+} ObjCfiKind;
+
+typedef struct {
+    size_t offset;      // .text offset the rule applies from
+    ObjCfiKind kind;
+    int reg;            // OBJ_CFI_SAVE register
+    int cfaOffset;
+} ObjCfi;
+
+typedef struct {
+    size_t start;       // the function's range in .text; frames[i] is functions[i]
+    size_t size;
+    int firstCfi;       // its rules, cfi[firstCfi .. firstCfi + cfiCount)
+    int cfiCount;
+} ObjFrame;
+
+typedef struct {
+    ObjBuffer text;         // the functions one after another, each written as .text.<name>
+    int* functions;         // their symbols in .text order
+    int functionCount;
+    int functionCapacity;
+    ObjBuffer rodata;       // the string literals, written as .rodata.str1.1
+    size_t* stringOffsets;  // .rodata offset of string literal .LC<n>
+    int stringCount;
+    ObjBuffer literals;     // float constant .LF<n> at 8 * n, written as .rodata.cst8
+
+    ObjSymbol* symbols;
+    int symbolCount;
+    int symbolCapacity;
+    int* symbolHash;        // open addressing over symbol indices, -1 = empty
+    int hashCapacity;
+
+    ObjReloc* relocs;
+    int relocCount;
+    int relocCapacity;
+
+    const char* debugSource;    // source file the debug information describes, NULL without -g
+    ObjLine* lines;
+    int lineCount;
+    int lineCapacity;
+    ObjCfi* cfi;
+    int cfiCount;
+    int cfiCapacity;
+    ObjFrame* frames;
+    int frameCount;
+    int frameCapacity;
+
+    int failed;             // an instruction could not be encoded
+} ObjectFile;
+
+void objInit(ObjectFile* obj);
+void objFree(ObjectFile* obj);
+
+void objAppend(ObjBuffer* buf, const void* bytes, size_t n);
+
+// Append a decoded string literal and its terminator to .rodata; returns
+// its offset
+size_t objAddString(ObjectFile* obj, const char* bytes, size_t length);
+
+// The symbol named `name`, created undefined on first use
+int objSymbol(ObjectFile* obj, const char* name);
+void objDefineSymbol(ObjectFile* obj, const char* name, ObjSection section, size_t value, size_t size);
+void objAddReloc(ObjectFile* obj, size_t offset, int type, int symbol, long long addend);
+// Define `name` as the code from `start` to the end of .text, a function
+// in its own section so the linker can drop it when nothing calls it
+void objAddFunction(ObjectFile* obj, const char* name, size_t start);
+
+// Record debug information (dwarf.c); lines and rules in .text order
+void objAddLine(ObjectFile* obj, size_t offset, int line);
+void objAddCfi(ObjectFile* obj, size_t offset, ObjCfiKind kind, int reg, int cfaOffset);
+// A function whose rules are the ones added since the previous frame
+void objAddFrame(ObjectFile* obj, size_t start, size_t size);
+
+// The DWARF sections of a -g object. Their relocations name the section
+// they point into, a function's code or another debug section, rather
+// than a symbol.
+typedef enum {
+    DEBUG_EH_FRAME,
+    DEBUG_INFO,
+    DEBUG_ABBREV,
+    DEBUG_LINE,
+    DEBUG_RANGES,
+    DEBUG_SECTION_COUNT,
+    DEBUG_TEXT = DEBUG_SECTION_COUNT    // relocation target only: DEBUG_TEXT + i is functions[i]
+} DebugSectionId;
+
+typedef struct {
+    ObjBuffer data;
+    ObjReloc* relocs;       // symbol is the DebugSectionId of the target
+    int relocCount;
+    int relocCapacity;
+} DebugSection;
+
+// Build .eh_frame, .debug_info, .debug_abbrev, .debug_line and
+// .debug_ranges from the recorded lines and frames; free them with
+// dwarfFreeSections
+void dwarfBuildSections(ObjectFile* obj, DebugSection sections[DEBUG_SECTION_COUNT]);
+void dwarfFreeSections(DebugSection sections[DEBUG_SECTION_COUNT]);
+
+// Encode an allocated function into .text and define its symbol (x86enc.c)
+void x86EncodeFunction(ObjectFile* obj, MFunction* fn);
+
+// Serialize as an ELF64 relocatable object; returns 0 on success
+int objWriteElf(ObjectFile* obj, int fd);
+
+// Load the object into executable memory, bind its runtime calls to the
+// runtime linked into minoc and call main (jit.c); returns 0 and main's
+// return value in *result on success
+int jitRunMain(ObjectFile* obj, long long* result);
+
+#endif
@@ -0,0 +1,461 @@
+// src/codegen/peephole.c - pattern-driven cleanup of allocated MIR
+//
+// Runs after register allocation, on physical registers, right before the
+// function is printed. Each round applies:
+//
+//   - unreachable code after jmp/epilogue, jumps to the next label and
+//     labels nobody jumps to are dropped
+//   - stores to frame slots are forwarded to later loads of the same slot,
+//     and a copy back into a register that still holds the value is dropped
+//   - mov $imm / mov src into a register that dies at its only use is
+//     folded into that use, and moves into dead registers are dropped
+//
+// and finally `mov $0, %reg` becomes `xor %reg32, %reg32` where the flags
+// are not needed. Register liveness is tracked per block only; every
+// register is assumed live across labels and jumps. Only general-purpose
+// registers are tracked: XMM moves are left alone, and SSE instructions
+// count only for the GP registers they read or write.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mir.h"
+
+#define GP_COUNT 16
+#define ALL_REGS 0xFFFFu
+#define BIT(r) (1u << (r))
+#define FRAME_REGS (BIT(REG_RSP) | BIT(REG_RBP))
+
+static const int argRegs[] = {REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9};
+static const int callerSaved[] = {
+    REG_RAX, REG_RCX, REG_RDX, REG_RSI, REG_RDI, REG_R8, REG_R9, REG_R10, REG_R11
+};
+
+static int isGpReg(const MOperand* o) {
+    return o->kind == OPD_REG && o->reg < GP_COUNT;
+}
+
+// General-purpose registers an operand reads when used as a value
+static unsigned int operandUse(const MOperand* o) {
+    if (o->kind == OPD_MEM && o->scale) return BIT(o->reg) | BIT(o->index);
+    if (isGpReg(o) || o->kind == OPD_MEM) return BIT(o->reg);
+    return 0;
+}
+
+static int mentionsReg(const MOperand* o, int reg) {
+    if (o->kind == OPD_MEM && o->scale && o->index == reg) return 1;
+    return (o->kind == OPD_REG || o->kind == OPD_MEM) && o->reg == reg;
+}
+
+static int sameMem(const MOperand* a, const MOperand* b) {
+    return a->kind == OPD_MEM && b->kind == OPD_MEM && a->reg == b->reg && a->imm == b->imm &&
+           a->scale == b->scale && (!a->scale || a->index == b->index);
+}
+
+static void physDefsUses(const MInst* in, unsigned int* def, unsigned int* use) {
+    *def = 0;
+    *use = 0;
+    switch (in->op) {
+        case MOP_MOV:
+        case MOP_MOVABS:
+        case MOP_MOVSLQ:
+        case MOP_MOVZB:
+        case MOP_MOVSD:
+        case MOP_CVTSD2SS:
+        case MOP_CVTSS2SD:
+        case MOP_CVTSI2SD:
+        case MOP_CVTTSD2SI:
+        case MOP_LEA:
+        case MOP_MOVDQU:
+        case MOP_MOVQ:
+        case MOP_POP:
+            *use = operandUse(&in->src);
+            if (isGpReg(&in->dst)) *def = BIT(in->dst.reg);
+            else *use |= operandUse(&in->dst);
+            break;
+        case MOP_ADD:
+        case MOP_SUB:
+        case MOP_IMUL:
+        case MOP_SHL:
+        case MOP_SAR:
+        case MOP_SHR:
+        case MOP_XOR:
+        case MOP_AND:
+        case MOP_OR:
+        case MOP_NEG:
+        case MOP_ADDSD:
+        case MOP_SUBSD:
+        case MOP_MULSD:
+        case MOP_DIVSD:
+        case MOP_PADDQ:
+        case MOP_PSUBQ:
+        case MOP_ADDPD:
+        case MOP_SUBPD:
+        case MOP_MULPD:
+        case MOP_DIVPD:
+        case MOP_PUNPCKLQDQ:
+        case MOP_PUNPCKHQDQ:
+            *use = operandUse(&in->src) | operandUse(&in->dst);
+            if (isGpReg(&in->dst)) *def = BIT(in->dst.reg);
+            break;
+        case MOP_CMP:
+        case MOP_UCOMISD:
+        case MOP_PUSH:
+            *use = operandUse(&in->src) | operandUse(&in->dst);
+            break;
+        case MOP_SETCC:
+            if (isGpReg(&in->dst)) *def = BIT(in->dst.reg);
+            else *use = operandUse(&in->dst);
+            break;
+        case MOP_CQO:
+            *use = BIT(REG_RAX);
+            *def = BIT(REG_RDX);
+            break;
+        case MOP_IDIV:
+            *use = operandUse(&in->src) | BIT(REG_RAX) | BIT(REG_RDX);
+            *def = BIT(REG_RAX) | BIT(REG_RDX);
+            break;
+        case MOP_IMULWIDE:
+            *use = operandUse(&in->src) | BIT(REG_RAX);
+            *def = BIT(REG_RAX) | BIT(REG_RDX);
+            break;
+        case MOP_CALL:
+            for (int i = 0; i < 6; i++) *use |= BIT(argRegs[i]);
+            *use |= BIT(REG_RAX);   // %al for variadic callees
+            for (int i = 0; i < (int)(sizeof(callerSaved) / sizeof(callerSaved[0])); i++) {
+                *def |= BIT(callerSaved[i]);
+            }
+            break;
+        case MOP_EPILOGUE:
+            *use = BIT(REG_RAX);
+            break;
+        case MOP_PROLOGUE:
+            *use = ALL_REGS;
+            break;
+        default:
+            break;
+    }
+}
+
+typedef struct {
+    MFunction* fn;
+    char* removed;
+    unsigned int* liveAfter;
+    int changed;
+} Peephole;
+
+static void removeInst(Peephole* p, int i) {
+    p->removed[i] = 1;
+    p->changed = 1;
+}
+
+// Next instruction that will be printed, skipping comments; -1 at the end
+static int nextReal(Peephole* p, int i) {
+    for (int j = i + 1; j < p->fn->count; j++) {
+        if (p->removed[j] || p->fn->insts[j].op == MOP_COMMENT) continue;
+        return j;
+    }
+    return -1;
+}
+
+static void compact(Peephole* p) {
+    MFunction* fn = p->fn;
+    int count = 0;
+    for (int i = 0; i < fn->count; i++) {
+        if (p->removed[i]) {
+            free((char*)fn->insts[i].text);
+            continue;
+        }
+        fn->insts[count++] = fn->insts[i];
+    }
+    fn->count = count;
+    memset(p->removed, 0, fn->count);
+}
+
+// ============ Control flow ============
+
+// The slot of label `name` in a set of jump targets: where it is, or the
+// empty slot it would go in
+static const char** targetSlot(const char** targets, int capacity, const char* name) {
+    unsigned slot = 0;
+    for (const char* c = name; *c; c++) slot = slot * 31 + (unsigned char)*c;
+    slot &= capacity - 1;
+    while (targets[slot] && strcmp(targets[slot], name) != 0) slot = (slot + 1) & (capacity - 1);
+    return &targets[slot];
+}
+
+static void cleanControlFlow(Peephole* p) {
+    MFunction* fn = p->fn;
+    for (int i = 0; i < fn->count; i++) {
+        if (p->removed[i]) continue;
+        MInst* in = &fn->insts[i];
+
+        // nothing reaches code between a jmp/epilogue and the next label
+        if (in->op == MOP_JMP || in->op == MOP_EPILOGUE) {
+            for (int j = i + 1; j < fn->count && fn->insts[j].op != MOP_LABEL; j++) {
+                if (!p->removed[j]) removeInst(p, j);
+            }
+        }
+
+        // a jump to the label that follows anyway
+        if (in->op == MOP_JMP || in->op == MOP_JCC) {
+            int j = nextReal(p, i);
+            if (j >= 0 && fn->insts[j].op == MOP_LABEL && strcmp(fn->insts[j].text, in->src.sym) == 0) {
+                removeInst(p, i);
+            }
+        }
+    }
+
+    // Local labels nobody jumps to only split blocks. The targets of the
+    // remaining jumps go into a set first, open addressing at most half full.
+    int capacity = 16;
+    while (capacity < fn->count * 2) capacity *= 2;
+    const char** targets = calloc(capacity, sizeof(const char*));
+    for (int i = 0; i < fn->count; i++) {
+        MInst* br = &fn->insts[i];
+        if (p->removed[i] || (br->op != MOP_JMP && br->op != MOP_JCC)) continue;
+        *targetSlot(targets, capacity, br->src.sym) = br->src.sym;
+    }
+    for (int i = 0; i < fn->count; i++) {
+        MInst* in = &fn->insts[i];
+        if (p->removed[i] || in->op != MOP_LABEL || strncmp(in->text, ".L", 2) != 0) continue;
+        if (!*targetSlot(targets, capacity, in->text)) removeInst(p, i);
+    }
+    free(targets);
+}
+
+// ============ Store-to-load and copy forwarding ============
+
+#define MAX_SLOTS 64
+
+typedef struct {
+    MOperand slot;      // frame slot
+    int reg;            // register holding the same value
+} SlotValue;
+
+typedef struct {
+    SlotValue slots[MAX_SLOTS];
+    int slotCount;
+    int copyOf[GP_COUNT];   // copyOf[b] == a: %b holds the same value as %a
+} Available;
+
+static void forgetAll(Available* av) {
+    av->slotCount = 0;
+    for (int r = 0; r < GP_COUNT; r++) av->copyOf[r] = REG_NONE;
+}
+
+static void forgetReg(Available* av, int reg) {
+    int kept = 0;
+    for (int i = 0; i < av->slotCount; i++) {
+        if (av->slots[i].reg != reg) av->slots[kept++] = av->slots[i];
+    }
+    av->slotCount = kept;
+    av->copyOf[reg] = REG_NONE;
+    for (int r = 0; r < GP_COUNT; r++) {
+        if (av->copyOf[r] == reg) av->copyOf[r] = REG_NONE;
+    }
+}
+
+static void forgetSlot(Available* av, const MOperand* slot) {
+    int kept = 0;
+    for (int i = 0; i < av->slotCount; i++) {
+        if (!sameMem(&av->slots[i].slot, slot)) av->slots[kept++] = av->slots[i];
+    }
+    av->slotCount = kept;
+}
+
+static void rememberSlot(Available* av, const MOperand* slot, int reg) {
+    forgetSlot(av, slot);
+    if (av->slotCount == MAX_SLOTS) return;
+    av->slots[av->slotCount].slot = *slot;
+    av->slots[av->slotCount].reg = reg;
+    av->slotCount++;
+}
+
+static int slotReg(Available* av, const MOperand* slot) {
+    for (int i = 0; i < av->slotCount; i++) {
+        if (sameMem(&av->slots[i].slot, slot)) return av->slots[i].reg;
+    }
+    return REG_NONE;
+}
+
+static void forwardValues(Peephole* p) {
+    MFunction* fn = p->fn;
+    Available av;
+    forgetAll(&av);
+
+    for (int i = 0; i < fn->count; i++) {
+        if (p->removed[i]) continue;
+        MInst* in = &fn->insts[i];
+
+        if (in->op == MOP_MOV) {
+            // mov %r, slot ... mov slot, %s  =>  mov %r, %s
+            if (in->src.kind == OPD_MEM && in->src.reg == REG_RBP && isGpReg(&in->dst)) {
+                int reg = slotReg(&av, &in->src);
+                if (reg == in->dst.reg) {
+                    removeInst(p, i);
+                    continue;
+                }
+                if (reg != REG_NONE) {
+                    in->src = mReg(reg);
+                    p->changed = 1;
+                }
+            }
+            // mov %a, %b ... mov %b, %a  (neither changed in between)
+            if (isGpReg(&in->src) && isGpReg(&in->dst) &&
+                (av.copyOf[in->dst.reg] == in->src.reg || av.copyOf[in->src.reg] == in->dst.reg)) {
+                removeInst(p, i);
+                continue;
+            }
+        }
+
+        // Invalidate what this instruction overwrites
+        unsigned int def, use;
+        physDefsUses(in, &def, &use);
+        for (int r = 0; r < GP_COUNT; r++) {
+            if (def & BIT(r)) forgetReg(&av, r);
+        }
+        if (in->dst.kind == OPD_MEM && in->op != MOP_CMP && in->op != MOP_PUSH) forgetSlot(&av, &in->dst);
+
+        // Record what is known afterwards
+        if (in->op == MOP_MOV && isGpReg(&in->src) && in->dst.kind == OPD_MEM && in->dst.reg == REG_RBP) {
+            rememberSlot(&av, &in->dst, in->src.reg);
+        } else if (in->op == MOP_MOV && in->src.kind == OPD_MEM && in->src.reg == REG_RBP && isGpReg(&in->dst)) {
+            rememberSlot(&av, &in->src, in->dst.reg);
+        } else if (in->op == MOP_MOV && isGpReg(&in->src) && isGpReg(&in->dst)) {
+            av.copyOf[in->dst.reg] = in->src.reg;
+        }
+
+        // Block boundaries end what we know
+        if (in->op == MOP_LABEL || in->op == MOP_JMP || in->op == MOP_JCC || in->op == MOP_EPILOGUE) {
+            forgetAll(&av);
+        }
+    }
+}
+
+// ============ Liveness-driven folds ============
+
+static void computeLiveAfter(Peephole* p) {
+    MFunction* fn = p->fn;
+    unsigned int live = 0;
+    for (int i = fn->count - 1; i >= 0; i--) {
+        MInst* in = &fn->insts[i];
+        if (in->op == MOP_EPILOGUE) live = 0;
+        else if (in->op == MOP_JMP || in->op == MOP_JCC) live = ALL_REGS;
+        p->liveAfter[i] = live | FRAME_REGS;
+
+        unsigned int def, use;
+        physDefsUses(in, &def, &use);
+        live = (live & ~def) | use;
+        // whatever jumps to a label may need any register
+        if (in->op == MOP_LABEL) live = ALL_REGS;
+    }
+}
+
+// Instructions that accept an immediate or memory source in place of a
+// register, with the register destination unchanged
+static int acceptsImmediate(MOpcode op) {
+    return op == MOP_MOV || op == MOP_ADD || op == MOP_SUB || op == MOP_CMP ||
+           op == MOP_IMUL || op == MOP_PUSH;
+}
+
+static int isDead(Peephole* p, int reg, int after) {
+    return !(p->liveAfter[after] & BIT(reg));
+}
+
+static void foldIntoUses(Peephole* p) {
+    MFunction* fn = p->fn;
+    for (int i = 0; i < fn->count; i++) {
+        if (p->removed[i]) continue;
+        MInst* in = &fn->insts[i];
+        if (in->op != MOP_MOV || !isGpReg(&in->dst)) continue;
+        int reg = in->dst.reg;
+        if (reg == REG_RSP || reg == REG_RBP) continue;
+
+        // a value nobody reads
+        if (isDead(p, reg, i)) {
+            removeInst(p, i);
+            continue;
+        }
+
+        int j = nextReal(p, i);
+        if (j < 0) continue;
+        MInst* use = &fn->insts[j];
+        if (!acceptsImmediate(use->op) || !isGpReg(&use->src) || use->src.reg != reg) continue;
+        if (mentionsReg(&use->dst, reg) || !isDead(p, reg, j)) continue;
+
+        // mov $imm, %r; op %r, dst  =>  op $imm, dst
+        if (in->src.kind == OPD_IMM || in->src.kind == OPD_SYM_ADDR) {
+            if (use->op == MOP_IMUL && use->dst.kind != OPD_REG) continue;
+            use->src = in->src;
+            removeInst(p, i);
+            continue;
+        }
+        // mov %a, %r; op %r, dst  =>  op %a, dst
+        if (isGpReg(&in->src)) {
+            use->src = in->src;
+            removeInst(p, i);
+            continue;
+        }
+        // mov slot, %r; op %r, %dst  =>  op slot, %dst
+        if (in->src.kind == OPD_MEM && use->dst.kind == OPD_REG && use->op != MOP_PUSH) {
+            use->src = in->src;
+            removeInst(p, i);
+            continue;
+        }
+    }
+}
+
+// ============ Zeroing ============
+
+static int setsFlags(MOpcode op) {
+    return op == MOP_ADD || op == MOP_SUB || op == MOP_IMUL || op == MOP_IMULWIDE ||
+           op == MOP_SHL || op == MOP_SAR || op == MOP_SHR || op == MOP_XOR ||
+           op == MOP_AND || op == MOP_OR || op == MOP_NEG || op == MOP_CMP ||
+           op == MOP_UCOMISD || op == MOP_IDIV || op == MOP_CALL;
+}
+
+// xor clobbers the flags, so it must not sit between a compare and the
+// jump or set that reads them
+static int flagsNeededAfter(MFunction* fn, int i) {
+    for (int j = i + 1; j < fn->count; j++) {
+        MOpcode op = fn->insts[j].op;
+        if (op == MOP_JCC || op == MOP_SETCC) return 1;
+        if (setsFlags(op) || op == MOP_LABEL || op == MOP_JMP || op == MOP_EPILOGUE) return 0;
+    }
+    return 0;
+}
+
+static void useXorZeroing(MFunction* fn) {
+    for (int i = 0; i < fn->count; i++) {
+        MInst* in = &fn->insts[i];
+        if (in->op != MOP_MOV || in->src.kind != OPD_IMM || in->src.imm != 0 || !isGpReg(&in->dst)) continue;
+        if (flagsNeededAfter(fn, i)) continue;
+        in->op = MOP_XOR;
+        in->src = in->dst;
+    }
+}
+
+#define MAX_PEEPHOLE_ROUNDS 8
+
+void peepholeOptimize(MFunction* fn) {
+    Peephole p;
+    p.fn = fn;
+    p.removed = calloc(fn->count > 0 ? fn->count : 1, 1);
+    p.liveAfter = malloc(sizeof(unsigned int) * (fn->count > 0 ? fn->count : 1));
+
+    for (int round = 0; round < MAX_PEEPHOLE_ROUNDS; round++) {
+        p.changed = 0;
+        cleanControlFlow(&p);
+        compact(&p);
+        forwardValues(&p);
+        compact(&p);
+        computeLiveAfter(&p);
+        foldIntoUses(&p);
+        compact(&p);
+        if (!p.changed) break;
+    }
+    useXorZeroing(fn);
+
+    free(p.liveAfter);
+    free(p.removed);
+}
@@ -0,0 +1,795 @@
+// src/codegen/regalloc.c - linear-scan register allocation over MIR
+//
+// Every virtual register gets one live interval [start, end] (the hull of
+// the instruction positions where it is live, from block-level liveness).
+// Intervals are scanned in start order (Poletto & Sarkar): expired
+// intervals free their register, and when none is free the cheapest
+// interval is spilled to a frame slot: each use or def inside a loop weighs
+// 8 times more per nesting level, and among equally cheap intervals the one
+// that ends furthest away goes. Loop depth comes from the backward jumps in
+// the layout, which codegen emits only for loop back edges.
+//
+// Doubles and two-lane vectors live in XMM registers, a second register
+// class: an interval only takes registers, hints and spill victims of its
+// own class. A spilled vector gets a 16-byte aligned slot.
+//
+// Registers with ABI roles (argument registers, rax/rdx around idiv, and
+// everything a call clobbers) are handled with fixed intervals. A virtual
+// register may only take a physical register whose fixed intervals do not
+// overlap its own, so values live across a call end up in callee-saved
+// registers.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mir.h"
+
+typedef struct {
+    int vreg;
+    int start;
+    int end;
+    int reg;            // assigned physical register, REG_NONE when spilled
+    int spillOffset;    // rbp-relative slot when spilled
+    int hint;           // register (or vreg) this one is copied from/to
+    long long weight;   // spill cost: uses and defs, weighted by loop depth
+    int isFloat;        // XMM class
+} LiveInterval;
+
+typedef struct {
+    int start;
+    int end;
+} FixedRange;
+
+typedef struct {
+    FixedRange* ranges;
+    int count;
+    int capacity;
+} FixedIntervals;
+
+typedef struct {
+    int start;          // first instruction index
+    int end;            // last instruction index
+    int succ[2];
+    int succCount;
+    unsigned long long* use;
+    unsigned long long* def;
+    unsigned long long* liveIn;
+    unsigned long long* liveOut;
+} Block;
+
+// Allocation order: caller-saved first (no save/restore cost), then
+// callee-saved. rax stays out of the pool (results, returns, idiv), rsp/rbp
+// hold the frame and r11 is the spill scratch register.
+static const int allocatable[] = {
+    REG_R10, REG_R9, REG_R8, REG_RCX, REG_RDX, REG_RSI, REG_RDI,
+    REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15
+};
+#define ALLOCATABLE_COUNT ((int)(sizeof(allocatable) / sizeof(allocatable[0])))
+
+// Every XMM register is caller-saved; xmm15 is the float spill scratch
+static const int floatAllocatable[] = {
+    REG_XMM0, REG_XMM1, REG_XMM2, REG_XMM3, REG_XMM4, REG_XMM5, REG_XMM6, REG_XMM7,
+    REG_XMM8, REG_XMM9, REG_XMM10, REG_XMM11, REG_XMM12, REG_XMM13, REG_XMM14
+};
+#define FLOAT_ALLOCATABLE_COUNT ((int)(sizeof(floatAllocatable) / sizeof(floatAllocatable[0])))
+
+static const int callerSaved[] = {
+    REG_RAX, REG_RCX, REG_RDX, REG_RSI, REG_RDI, REG_R8, REG_R9, REG_R10, REG_R11
+};
+#define CALLER_SAVED_COUNT ((int)(sizeof(callerSaved) / sizeof(callerSaved[0])))
+
+static const int argRegs[] = {REG_RDI, REG_RSI, REG_RDX, REG_RCX, REG_R8, REG_R9};
+
+static int isAllocatable(int reg, int isFloat) {
+    const int* pool = isFloat ? floatAllocatable : allocatable;
+    int count = isFloat ? FLOAT_ALLOCATABLE_COUNT : ALLOCATABLE_COUNT;
+    for (int r = 0; r < count; r++) if (pool[r] == reg) return 1;
+    return 0;
+}
+
+static int isCalleeSaved(int reg) {
+    return reg == REG_RBX || reg == REG_R12 || reg == REG_R13 ||
+           reg == REG_R14 || reg == REG_R15;
+}
+
+// ============ Fixed (physical) intervals ============
+
+static void addFixed(FixedIntervals* fixed, int reg, int start, int end) {
+    FixedIntervals* f = &fixed[reg];
+    if (f->count == f->capacity) {
+        f->capacity = f->capacity ? f->capacity * 2 : 8;
+        f->ranges = realloc(f->ranges, sizeof(FixedRange) * f->capacity);
+    }
+    f->ranges[f->count].start = start;
+    f->ranges[f->count].end = end;
+    f->count++;
+}
+
+static void physUse(FixedIntervals* fixed, int* lastDef, int reg, int pos) {
+    if (reg < 0 || isVirtualReg(reg) || reg == REG_RSP || reg == REG_RBP) return;
+    if (lastDef[reg] < 0) return;   // value undefined since the last call
+    addFixed(fixed, reg, lastDef[reg], pos);
+}
+
+static void physDef(FixedIntervals* fixed, int* lastDef, int reg, int pos) {
+    if (reg < 0 || isVirtualReg(reg) || reg == REG_RSP || reg == REG_RBP) return;
+    addFixed(fixed, reg, pos, pos);
+    lastDef[reg] = pos;
+}
+
+static void operandPhysUses(FixedIntervals* fixed, int* lastDef, const MOperand* o, int pos) {
+    if (o->kind == OPD_REG || o->kind == OPD_MEM) physUse(fixed, lastDef, o->reg, pos);
+    if (o->kind == OPD_MEM && o->scale) physUse(fixed, lastDef, o->index, pos);
+}
+
+static void buildFixedIntervals(MFunction* fn, FixedIntervals* fixed) {
+    int lastDef[REG_PHYS_COUNT];
+    // Incoming argument registers are live from function entry
+    for (int r = 0; r < REG_PHYS_COUNT; r++) lastDef[r] = 0;
+
+    for (int i = 0; i < fn->count; i++) {
+        MInst* in = &fn->insts[i];
+        switch (in->op) {
+            case MOP_MOV:
+            case MOP_MOVABS:
+            case MOP_MOVSLQ:
+            case MOP_MOVZB:
+            case MOP_MOVSD:
+            case MOP_CVTSD2SS:
+            case MOP_CVTSS2SD:
+            case MOP_CVTSI2SD:
+            case MOP_CVTTSD2SI:
+            case MOP_LEA:
+            case MOP_MOVDQU:
+            case MOP_MOVQ:
+                operandPhysUses(fixed, lastDef, &in->src, i);
+                if (in->dst.kind == OPD_REG) physDef(fixed, lastDef, in->dst.reg, i);
+                else operandPhysUses(fixed, lastDef, &in->dst, i);
+                break;
+            case MOP_ADD:
+            case MOP_SUB:
+            case MOP_IMUL:
+            case MOP_SHL:
+            case MOP_SAR:
+            case MOP_SHR:
+            case MOP_XOR:
+            case MOP_AND:
+            case MOP_OR:
+            case MOP_NEG:
+            case MOP_ADDSD:
+            case MOP_SUBSD:
+            case MOP_MULSD:
+            case MOP_DIVSD:
+            case MOP_PADDQ:
+            case MOP_PSUBQ:
+            case MOP_ADDPD:
+            case MOP_SUBPD:
+            case MOP_MULPD:
+            case MOP_DIVPD:
+            case MOP_PUNPCKLQDQ:
+            case MOP_PUNPCKHQDQ:
+                operandPhysUses(fixed, lastDef, &in->src, i);
+                operandPhysUses(fixed, lastDef, &in->dst, i);
+                if (in->dst.kind == OPD_REG) physDef(fixed, lastDef, in->dst.reg, i);
+                break;
+            case MOP_CQO:
+                physUse(fixed, lastDef, REG_RAX, i);
+                physDef(fixed, lastDef, REG_RDX, i);
+                break;
+            case MOP_IDIV:
+                operandPhysUses(fixed, lastDef, &in->src, i);
+                physUse(fixed, lastDef, REG_RAX, i);
+                physUse(fixed, lastDef, REG_RDX, i);
+                physDef(fixed, lastDef, REG_RAX, i);
+                physDef(fixed, lastDef, REG_RDX, i);
+                break;
+            case MOP_IMULWIDE:
+                operandPhysUses(fixed, lastDef, &in->src, i);
+                physUse(fixed, lastDef, REG_RAX, i);
+                physDef(fixed, lastDef, REG_RAX, i);
+                physDef(fixed, lastDef, REG_RDX, i);
+                break;
+            case MOP_CMP:
+            case MOP_UCOMISD:
+                operandPhysUses(fixed, lastDef, &in->src, i);
+                operandPhysUses(fixed, lastDef, &in->dst, i);
+                break;
+            case MOP_SETCC:
+                if (in->dst.kind == OPD_REG) physDef(fixed, lastDef, in->dst.reg, i);
+                else operandPhysUses(fixed, lastDef, &in->dst, i);
+                break;
+            case MOP_PUSH:
+                operandPhysUses(fixed, lastDef, &in->src, i);
+                break;
+            case MOP_POP:
+                if (in->dst.kind == OPD_REG) physDef(fixed, lastDef, in->dst.reg, i);
+                break;
+            case MOP_CALL:
+                // Arguments (and %al for variadic callees) are read by the call
+                for (int a = 0; a < 6; a++) {
+                    if (lastDef[argRegs[a]] > 0) physUse(fixed, lastDef, argRegs[a], i);
+                }
+                for (int x = REG_XMM0; x <= REG_XMM7; x++) {
+                    if (lastDef[x] > 0) physUse(fixed, lastDef, x, i);
+                }
+                if (lastDef[REG_RAX] > 0) physUse(fixed, lastDef, REG_RAX, i);
+                for (int c = 0; c < CALLER_SAVED_COUNT; c++) physDef(fixed, lastDef, callerSaved[c], i);
+                for (int x = REG_XMM0; x <= REG_XMM15; x++) physDef(fixed, lastDef, x, i);
+                // only the return registers carry a value out of the call
+                for (int c = 0; c < CALLER_SAVED_COUNT; c++) {
+                    if (callerSaved[c] != REG_RAX) lastDef[callerSaved[c]] = -1;
+                }
+                for (int x = REG_XMM1; x <= REG_XMM15; x++) lastDef[x] = -1;
+                break;
+            case MOP_EPILOGUE:
+                physUse(fixed, lastDef, REG_RAX, i);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static int fixedConflict(FixedIntervals* fixed, int reg, int start, int end) {
+    FixedIntervals* f = &fixed[reg];
+    for (int i = 0; i < f->count; i++) {
+        // touching endpoints are fine: a copy into or out of the register
+        if (start < f->ranges[i].end && f->ranges[i].start < end) return 1;
+    }
+    return 0;
+}
+
+// ============ Liveness ============
+
+static int findLabelBlock(MFunction* fn, Block* blocks, int blockCount, const char* label) {
+    for (int b = 0; b < blockCount; b++) {
+        MInst* first = &fn->insts[blocks[b].start];
+        if (first->op == MOP_LABEL && strcmp(first->text, label) == 0) return b;
+    }
+    return -1;
+}
+
+static int endsBlock(const MInst* in) {
+    return in->op == MOP_JMP || in->op == MOP_JCC || in->op == MOP_EPILOGUE;
+}
+
+static int buildBlocks(MFunction* fn, Block** outBlocks) {
+    int capacity = 16, count = 0;
+    Block* blocks = malloc(sizeof(Block) * capacity);
+    int start = 0;
+    for (int i = 0; i < fn->count; i++) {
+        int last = (i + 1 == fn->count) ||
+                   fn->insts[i + 1].op == MOP_LABEL ||
+                   endsBlock(&fn->insts[i]);
+        if (!last) continue;
+        if (count == capacity) {
+            capacity *= 2;
+            blocks = realloc(blocks, sizeof(Block) * capacity);
+        }
+        memset(&blocks[count], 0, sizeof(Block));
+        blocks[count].start = start;
+        blocks[count].end = i;
+        count++;
+        start = i + 1;
+    }
+
+    for (int b = 0; b < count; b++) {
+        MInst* lastInst = &fn->insts[blocks[b].end];
+        if (lastInst->op == MOP_JMP) {
+            int target = findLabelBlock(fn, blocks, count, lastInst->src.sym);
+            if (target >= 0) blocks[b].succ[blocks[b].succCount++] = target;
+        } else if (lastInst->op == MOP_JCC) {
+            // taken edge, then the fall-through block
+            int target = findLabelBlock(fn, blocks, count, lastInst->src.sym);
+            if (target >= 0) blocks[b].succ[blocks[b].succCount++] = target;
+            if (b + 1 < count && b + 1 != target) blocks[b].succ[blocks[b].succCount++] = b + 1;
+        } else if (lastInst->op != MOP_EPILOGUE && b + 1 < count) {
+            blocks[b].succ[blocks[b].succCount++] = b + 1;
+        }
+    }
+
+    *outBlocks = blocks;
+    return count;
+}
+
+#define BIT_SET(set, i) ((set)[(i) >> 6] |= 1ULL << ((i) & 63))
+#define BIT_TEST(set, i) (((set)[(i) >> 6] >> ((i) & 63)) & 1ULL)
+
+static void computeLiveness(MFunction* fn, Block* blocks, int blockCount, int words) {
+    int defs[8], uses[8], defCount, useCount;
+    for (int b = 0; b < blockCount; b++) {
+        Block* blk = &blocks[b];
+        blk->use = calloc(words, sizeof(unsigned long long));
+        blk->def = calloc(words, sizeof(unsigned long long));
+        blk->liveIn = calloc(words, sizeof(unsigned long long));
+        blk->liveOut = calloc(words, sizeof(unsigned long long));
+        for (int i = blk->start; i <= blk->end; i++) {
+            mirDefsUses(&fn->insts[i], defs, &defCount, uses, &useCount);
+            for (int u = 0; u < useCount; u++) {
+                int v = uses[u] - VREG_BASE;
+                if (!BIT_TEST(blk->def, v)) BIT_SET(blk->use, v);
+            }
+            for (int d = 0; d < defCount; d++) BIT_SET(blk->def, defs[d] - VREG_BASE);
+        }
+    }
+
+    // Backward dataflow to a fixed point
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = blockCount - 1; b >= 0; b--) {
+            Block* blk = &blocks[b];
+            for (int w = 0; w < words; w++) {
+                unsigned long long out = 0;
+                for (int s = 0; s < blk->succCount; s++) out |= blocks[blk->succ[s]].liveIn[w];
+                unsigned long long in = blk->use[w] | (out & ~blk->def[w]);
+                if (out != blk->liveOut[w] || in != blk->liveIn[w]) {
+                    blk->liveOut[w] = out;
+                    blk->liveIn[w] = in;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+// Loop nesting depth of every instruction: each backward edge from block b
+// to block s covers the instructions from the start of s to the end of b
+static int* loopDepths(MFunction* fn, Block* blocks, int blockCount) {
+    int* depth = calloc(fn->count + 1, sizeof(int));
+    for (int b = 0; b < blockCount; b++) {
+        for (int s = 0; s < blocks[b].succCount; s++) {
+            int succ = blocks[b].succ[s];
+            if (succ > b) continue;
+            depth[blocks[succ].start]++;
+            depth[blocks[b].end + 1]--;
+        }
+    }
+    for (int i = 1; i <= fn->count; i++) depth[i] += depth[i - 1];
+    return depth;
+}
+
+static void extend(LiveInterval* intervals, int v, int pos) {
+    if (intervals[v].start < 0 || pos < intervals[v].start) intervals[v].start = pos;
+    if (pos > intervals[v].end) intervals[v].end = pos;
+}
+
+static void buildIntervals(MFunction* fn, LiveInterval* intervals) {
+    int vregs = fn->vregCount;
+    int words = (vregs + 63) / 64;
+    for (int v = 0; v < vregs; v++) {
+        intervals[v].vreg = VREG_BASE + v;
+        intervals[v].start = -1;
+        intervals[v].end = -1;
+        intervals[v].reg = REG_NONE;
+        intervals[v].spillOffset = 0;
+        intervals[v].hint = REG_NONE;
+        intervals[v].weight = 0;
+        intervals[v].isFloat = mirIsFloatReg(fn, VREG_BASE + v);
+    }
+    if (vregs == 0) return;
+
+    Block* blocks = NULL;
+    int blockCount = buildBlocks(fn, &blocks);
+    computeLiveness(fn, blocks, blockCount, words);
+    int* depth = loopDepths(fn, blocks, blockCount);
+
+    int defs[8], uses[8], defCount, useCount;
+    for (int i = 0; i < fn->count; i++) {
+        MInst* in = &fn->insts[i];
+        mirDefsUses(in, defs, &defCount, uses, &useCount);
+        long long cost = 1LL << (3 * (depth[i] < 8 ? depth[i] : 8));
+        for (int u = 0; u < useCount; u++) {
+            extend(intervals, uses[u] - VREG_BASE, i);
+            intervals[uses[u] - VREG_BASE].weight += cost;
+        }
+        for (int d = 0; d < defCount; d++) {
+            extend(intervals, defs[d] - VREG_BASE, i);
+            intervals[defs[d] - VREG_BASE].weight += cost;
+        }
+
+        // Register-to-register copies suggest sharing a register
+        if ((in->op == MOP_MOV || in->op == MOP_MOVSD || in->op == MOP_MOVDQU) && in->src.kind == OPD_REG && in->dst.kind == OPD_REG) {
+            if (isVirtualReg(in->dst.reg)) {
+                intervals[in->dst.reg - VREG_BASE].hint = in->src.reg;
+            } else if (isVirtualReg(in->src.reg) && intervals[in->src.reg - VREG_BASE].hint == REG_NONE) {
+                intervals[in->src.reg - VREG_BASE].hint = in->dst.reg;
+            }
+        }
+    }
+    for (int b = 0; b < blockCount; b++) {
+        for (int v = 0; v < vregs; v++) {
+            if (BIT_TEST(blocks[b].liveIn, v)) extend(intervals, v, blocks[b].start);
+            if (BIT_TEST(blocks[b].liveOut, v)) extend(intervals, v, blocks[b].end);
+        }
+        free(blocks[b].use);
+        free(blocks[b].def);
+        free(blocks[b].liveIn);
+        free(blocks[b].liveOut);
+    }
+    free(blocks);
+    free(depth);
+}
+
+// ============ Linear scan ============
+
+static int compareStart(const void* a, const void* b) {
+    const LiveInterval* x = *(const LiveInterval* const*)a;
+    const LiveInterval* y = *(const LiveInterval* const*)b;
+    if (x->start != y->start) return x->start - y->start;
+    return x->vreg - y->vreg;
+}
+
+// A frame slot for a spilled interval: 8 bytes, or 16 bytes aligned to 16
+// for a vector so packed instructions can read it in place
+static int spillSlot(MFunction* fn, LiveInterval* it, int* spillSlots) {
+    if (mirIsVectorReg(fn, it->vreg)) *spillSlots = ((*spillSlots + 1) & ~1) + 1;
+    return -8 * (++(*spillSlots));
+}
+
+static void linearScan(MFunction* fn, LiveInterval* intervals, FixedIntervals* fixed, int* spillSlots) {
+    int vregs = fn->vregCount;
+    LiveInterval** order = malloc(sizeof(LiveInterval*) * (vregs > 0 ? vregs : 1));
+    int n = 0;
+    for (int v = 0; v < vregs; v++) {
+        if (intervals[v].start >= 0) order[n++] = &intervals[v];
+    }
+    qsort(order, n, sizeof(LiveInterval*), compareStart);
+
+    // active intervals, kept in increasing end order
+    LiveInterval** active = malloc(sizeof(LiveInterval*) * (n > 0 ? n : 1));
+    int activeCount = 0;
+    int regBusy[REG_PHYS_COUNT] = {0};
+
+    for (int i = 0; i < n; i++) {
+        LiveInterval* cur = order[i];
+
+        // Expire intervals that ended before this one starts
+        int kept = 0;
+        for (int a = 0; a < activeCount; a++) {
+            if (active[a]->end <= cur->start) {
+                regBusy[active[a]->reg] = 0;
+            } else {
+                active[kept++] = active[a];
+            }
+        }
+        activeCount = kept;
+
+        int chosen = REG_NONE;
+        int hint = cur->hint;
+        if (hint != REG_NONE && isVirtualReg(hint)) hint = intervals[hint - VREG_BASE].reg;
+        if (hint != REG_NONE && isAllocatable(hint, cur->isFloat) && !regBusy[hint] &&
+            !fixedConflict(fixed, hint, cur->start, cur->end)) {
+            chosen = hint;
+        }
+        const int* pool = cur->isFloat ? floatAllocatable : allocatable;
+        int poolCount = cur->isFloat ? FLOAT_ALLOCATABLE_COUNT : ALLOCATABLE_COUNT;
+        for (int r = 0; r < poolCount && chosen == REG_NONE; r++) {
+            int reg = pool[r];
+            if (regBusy[reg]) continue;
+            if (fixedConflict(fixed, reg, cur->start, cur->end)) continue;
+            chosen = reg;
+            break;
+        }
+
+        if (chosen == REG_NONE) {
+            // Spill the cheapest usable interval, the one ending furthest
+            // away among equals
+            int victim = -1;
+            LiveInterval* best = cur;
+            for (int a = activeCount - 1; a >= 0; a--) {
+                if (active[a]->isFloat != cur->isFloat) continue;
+                if (fixedConflict(fixed, active[a]->reg, cur->start, cur->end)) continue;
+                if (active[a]->weight < best->weight ||
+                    (active[a]->weight == best->weight && active[a]->end > best->end)) {
+                    victim = a;
+                    best = active[a];
+                }
+            }
+            if (victim >= 0) {
+                LiveInterval* spilled = active[victim];
+                chosen = spilled->reg;
+                spilled->reg = REG_NONE;
+                spilled->spillOffset = spillSlot(fn, spilled, spillSlots);
+                for (int a = victim; a + 1 < activeCount; a++) active[a] = active[a + 1];
+                activeCount--;
+            } else {
+                cur->spillOffset = spillSlot(fn, cur, spillSlots);
+                continue;
+            }
+        }
+
+        cur->reg = chosen;
+        regBusy[chosen] = 1;
+        // insert into active, sorted by end
+        int pos = activeCount;
+        while (pos > 0 && active[pos - 1]->end > cur->end) {
+            active[pos] = active[pos - 1];
+            pos--;
+        }
+        active[pos] = cur;
+        activeCount++;
+    }
+
+    free(active);
+    free(order);
+}
+
+// ============ Rewrite ============
+
+static MOperand rewriteOperand(MOperand o, LiveInterval* intervals) {
+    if (o.kind == OPD_REG && isVirtualReg(o.reg)) {
+        LiveInterval* it = &intervals[o.reg - VREG_BASE];
+        if (it->reg != REG_NONE) return mReg(it->reg);
+        return mMem(REG_RBP, it->spillOffset);
+    }
+    return o;
+}
+
+static int fitsImm32(long long v) {
+    return v >= -2147483648LL && v <= 2147483647LL;
+}
+
+// Append an instruction to the rewritten stream
+static void push(MInst** out, int* count, int* capacity, MInst inst) {
+    if (*count == *capacity) {
+        *capacity *= 2;
+        *out = realloc(*out, sizeof(MInst) * (*capacity));
+    }
+    (*out)[(*count)++] = inst;
+}
+
+static MInst makeInst(MOpcode op, MOperand src, MOperand dst, int line) {
+    MInst inst;
+    memset(&inst, 0, sizeof(inst));
+    inst.op = op;
+    inst.src = src;
+    inst.dst = dst;
+    inst.line = line;
+    return inst;
+}
+
+// Base and index of an address. A spilled register is loaded into the
+// scratch register first; when both are spilled the scratch register
+// receives the whole base + index * scale.
+static MOperand rewriteAddress(MOperand o, LiveInterval* intervals,
+                               MInst** out, int* count, int* capacity, int line) {
+    int spilled[2] = {0, 0};    // frame slots of a spilled base / index
+    int* regs[2] = {&o.reg, o.scale ? &o.index : NULL};
+    for (int i = 0; i < 2; i++) {
+        if (!regs[i] || !isVirtualReg(*regs[i])) continue;
+        LiveInterval* it = &intervals[*regs[i] - VREG_BASE];
+        if (it->reg != REG_NONE) *regs[i] = it->reg;
+        else spilled[i] = it->spillOffset;
+    }
+    MOperand scratch = mReg(REG_SCRATCH);
+    if (spilled[0] && spilled[1] && o.reg != o.index) {
+        push(out, count, capacity, makeInst(MOP_MOV, mMem(REG_RBP, spilled[1]), scratch, line));
+        int shift = o.scale == 8 ? 3 : o.scale == 4 ? 2 : o.scale == 2 ? 1 : 0;
+        if (shift) push(out, count, capacity, makeInst(MOP_SHL, mImm(shift), scratch, line));
+        push(out, count, capacity, makeInst(MOP_ADD, mMem(REG_RBP, spilled[0]), scratch, line));
+        return mMem(REG_SCRATCH, o.imm);
+    }
+    int slot = spilled[0] ? spilled[0] : spilled[1];
+    if (slot) push(out, count, capacity, makeInst(MOP_MOV, mMem(REG_RBP, slot), scratch, line));
+    if (spilled[0]) o.reg = REG_SCRATCH;
+    if (spilled[1]) o.index = REG_SCRATCH;
+    return o;
+}
+
+static int usesScratch(const MOperand* o) {
+    return o->kind == OPD_MEM && (o->reg == REG_SCRATCH || (o->scale && o->index == REG_SCRATCH));
+}
+
+static void rewriteFunction(MFunction* fn, LiveInterval* intervals) {
+    int capacity = fn->count + 16, count = 0;
+    MInst* out = malloc(sizeof(MInst) * capacity);
+    MOperand scratch = mReg(REG_SCRATCH);
+    MOperand floatScratch = mReg(REG_FLOAT_SCRATCH);
+
+    for (int i = 0; i < fn->count; i++) {
+        MInst in = fn->insts[i];
+        // direction of a movq, before spilling turns registers into slots
+        int toXmm = in.op == MOP_MOVQ && mirIsFloatReg(fn, in.dst.reg);
+        if (in.src.kind == OPD_MEM) in.src = rewriteAddress(in.src, intervals, &out, &count, &capacity, in.line);
+        if (in.dst.kind == OPD_MEM) in.dst = rewriteAddress(in.dst, intervals, &out, &count, &capacity, in.line);
+        in.src = rewriteOperand(in.src, intervals);
+        in.dst = rewriteOperand(in.dst, intervals);
+        int srcMem = in.src.kind == OPD_MEM;
+        int dstMem = in.dst.kind == OPD_MEM;
+
+        switch (in.op) {
+            case MOP_MOV:
+                // copies between the same register vanish
+                if (in.src.kind == OPD_REG && in.dst.kind == OPD_REG && in.src.reg == in.dst.reg) continue;
+                if (srcMem && dstMem) {
+                    if (in.src.reg == in.dst.reg && in.src.imm == in.dst.imm && !in.src.scale && !in.dst.scale) continue;
+                    if (usesScratch(&in.dst)) {
+                        // the store address occupies the scratch register:
+                        // carry the 64 bits through the XMM one instead
+                        push(&out, &count, &capacity, makeInst(MOP_MOVSD, in.src, floatScratch, in.line));
+                        in.op = MOP_MOVSD;
+                        in.src = floatScratch;
+                        break;
+                    }
+                    push(&out, &count, &capacity, makeInst(MOP_MOV, in.src, scratch, in.line));
+                    in.src = scratch;
+                }
+                if (in.src.kind == OPD_IMM && !fitsImm32(in.src.imm)) {
+                    in.op = MOP_MOVABS;
+                    if (dstMem) {
+                        MOperand slot = in.dst;
+                        in.dst = scratch;
+                        push(&out, &count, &capacity, in);
+                        push(&out, &count, &capacity, makeInst(MOP_MOV, scratch, slot, in.line));
+                        continue;
+                    }
+                }
+                break;
+            case MOP_MOVSD:
+                if (in.src.kind == OPD_REG && in.dst.kind == OPD_REG && in.src.reg == in.dst.reg) continue;
+                if ((srcMem || in.src.kind == OPD_RIP) && dstMem) {
+                    if (srcMem && in.src.reg == in.dst.reg && in.src.imm == in.dst.imm) continue;
+                    push(&out, &count, &capacity, makeInst(MOP_MOVSD, in.src, floatScratch, in.line));
+                    in.src = floatScratch;
+                }
+                break;
+            case MOP_ADDSD:
+            case MOP_SUBSD:
+            case MOP_MULSD:
+            case MOP_DIVSD:
+            case MOP_CVTSI2SD:
+                // SSE arithmetic needs an XMM register destination
+                if (dstMem) {
+                    MOperand slot = in.dst;
+                    if (in.op != MOP_CVTSI2SD) push(&out, &count, &capacity, makeInst(MOP_MOVSD, slot, floatScratch, in.line));
+                    in.dst = floatScratch;
+                    push(&out, &count, &capacity, in);
+                    push(&out, &count, &capacity, makeInst(MOP_MOVSD, floatScratch, slot, in.line));
+                    continue;
+                }
+                break;
+            case MOP_MOVDQU:
+                if (in.src.kind == OPD_REG && in.dst.kind == OPD_REG && in.src.reg == in.dst.reg) continue;
+                if (srcMem && dstMem) {
+                    if (in.src.reg == in.dst.reg && in.src.imm == in.dst.imm && !in.src.scale && !in.dst.scale) continue;
+                    push(&out, &count, &capacity, makeInst(MOP_MOVDQU, in.src, floatScratch, in.line));
+                    in.src = floatScratch;
+                }
+                break;
+            case MOP_MOVQ:
+                if (toXmm && dstMem) {
+                    // a spilled vector or double: build it in the XMM scratch
+                    MOperand slot = in.dst;
+                    in.dst = floatScratch;
+                    push(&out, &count, &capacity, in);
+                    push(&out, &count, &capacity, makeInst(mirIsVectorReg(fn, fn->insts[i].dst.reg) ? MOP_MOVDQU : MOP_MOVSD,
+                                                           floatScratch, slot, in.line));
+                    continue;
+                }
+                if (!toXmm && srcMem) {
+                    // the low lane of a spilled register is plain memory
+                    in.op = MOP_MOV;
+                    if (dstMem) {
+                        push(&out, &count, &capacity, makeInst(MOP_MOV, in.src, scratch, in.line));
+                        in.src = scratch;
+                    }
+                } else if (!toXmm && dstMem) {
+                    MOperand slot = in.dst;
+                    in.dst = scratch;
+                    push(&out, &count, &capacity, in);
+                    push(&out, &count, &capacity, makeInst(MOP_MOV, scratch, slot, in.line));
+                    continue;
+                }
+                break;
+            case MOP_PADDQ:
+            case MOP_PSUBQ:
+            case MOP_ADDPD:
+            case MOP_SUBPD:
+            case MOP_MULPD:
+            case MOP_DIVPD:
+            case MOP_PUNPCKLQDQ:
+            case MOP_PUNPCKHQDQ:
+                // packed arithmetic needs an XMM register destination
+                if (dstMem) {
+                    MOperand slot = in.dst;
+                    push(&out, &count, &capacity, makeInst(MOP_MOVDQU, slot, floatScratch, in.line));
+                    in.dst = floatScratch;
+                    push(&out, &count, &capacity, in);
+                    push(&out, &count, &capacity, makeInst(MOP_MOVDQU, floatScratch, slot, in.line));
+                    continue;
+                }
+                break;
+            case MOP_UCOMISD:
+                if (dstMem) {
+                    push(&out, &count, &capacity, makeInst(MOP_MOVSD, in.dst, floatScratch, in.line));
+                    in.dst = floatScratch;
+                }
+                break;
+            case MOP_ADD:
+            case MOP_SUB:
+            case MOP_XOR:
+            case MOP_AND:
+            case MOP_OR:
+            case MOP_CMP:
+                if (srcMem && dstMem) {
+                    push(&out, &count, &capacity, makeInst(MOP_MOV, in.src, scratch, in.line));
+                    in.src = scratch;
+                }
+                break;
+            case MOP_IMUL:
+                // imul needs a register destination
+                if (dstMem) {
+                    MOperand slot = in.dst;
+                    push(&out, &count, &capacity, makeInst(MOP_MOV, slot, scratch, in.line));
+                    in.dst = scratch;
+                    push(&out, &count, &capacity, in);
+                    push(&out, &count, &capacity, makeInst(MOP_MOV, scratch, slot, in.line));
+                    continue;
+                }
+                break;
+            case MOP_MOVABS:
+            case MOP_MOVSLQ:
+            case MOP_MOVZB:
+            case MOP_LEA:
+            case MOP_CVTTSD2SI:
+                // these need a register destination
+                if (dstMem) {
+                    MOperand slot = in.dst;
+                    in.dst = scratch;
+                    push(&out, &count, &capacity, in);
+                    push(&out, &count, &capacity, makeInst(MOP_MOV, scratch, slot, in.line));
+                    continue;
+                }
+                break;
+            default:
+                break;
+        }
+        push(&out, &count, &capacity, in);
+    }
+
+    free(fn->insts);
+    fn->insts = out;
+    fn->count = count;
+    fn->capacity = capacity;
+}
+
+void allocateRegisters(MFunction* fn) {
+    int vregs = fn->vregCount;
+    LiveInterval* intervals = malloc(sizeof(LiveInterval) * (vregs > 0 ? vregs : 1));
+    FixedIntervals fixed[REG_PHYS_COUNT];
+    memset(fixed, 0, sizeof(fixed));
+
+    buildIntervals(fn, intervals);
+    buildFixedIntervals(fn, fixed);
+
+    int spillSlots = 0;
+    linearScan(fn, intervals, fixed, &spillSlots);
+    fn->spillCount = spillSlots;
+
+    // Callee-saved registers in use get save slots below the spill area
+    int used[REG_PHYS_COUNT] = {0};
+    for (int v = 0; v < vregs; v++) {
+        if (intervals[v].reg != REG_NONE) used[intervals[v].reg] = 1;
+    }
+    int slots = spillSlots;
+    fn->calleeSavedCount = 0;
+    for (int r = 0; r < REG_PHYS_COUNT; r++) {
+        if (used[r] && isCalleeSaved(r)) {
+            fn->calleeSavedRegs[fn->calleeSavedCount] = r;
+            fn->calleeSavedOffsets[fn->calleeSavedCount] = -8 * (++slots);
+            fn->calleeSavedCount++;
+        }
+    }
+    fn->frameSize = ((slots * 8) + 15) & ~15;
+
+    // A leaf that keeps everything in caller-saved registers runs on its
+    // caller's stack as it finds it: no push %rbp, no leave, just the ret
+    int calls = 0;
+    for (int i = 0; i < fn->count && !calls; i++) calls = mirIsCall(&fn->insts[i]);
+    fn->frameless = slots == 0 && !calls && !fn->keepFramePointer;
+
+    rewriteFunction(fn, intervals);
+
+    for (int r = 0; r < REG_PHYS_COUNT; r++) free(fixed[r].ranges);
+    free(intervals);
+}
@@ -0,0 +1,681 @@
+// src/codegen/x86enc.c - x86-64 machine-code encoder for allocated MIR
+//
+// Encodes the instruction forms the backend selects, choosing the same
+// encodings GAS picks for the printed AT&T text (store-form register moves,
+// sign-extended imm8 where it fits, the short accumulator forms), so the
+// two paths produce identical executables. Jumps start in their 2-byte form
+// and are widened until every displacement fits, as an assembler relaxes
+// them; calls, string addresses and float constants become relocations.
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "obj.h"
+
+// Per-function encoding state. Everything but jumps is encoded once into
+// `code`; jumps are sized during relaxation and written in the final pass.
+typedef struct {
+    ObjectFile* obj;
+    MFunction* fn;
+    ObjBuffer code;
+    int* start;             // instruction index -> offset in code
+    int* length;            // encoded bytes (0 for jumps and labels)
+    int* target;            // jump -> instruction index of its label
+    int* isLong;            // jump needs the rel32 form
+    size_t* offset;         // instruction index -> offset in the function
+    int current;            // instruction being encoded
+    int saveEnd[8];         // -g: where each callee-saved store ends in the prologue
+
+    struct {
+        int inst;           // instruction the relocation belongs to
+        int at;             // byte offset within its encoding
+        int type;
+        int symbol;
+        long long addend;
+    }* relocs;
+    int relocCount;
+    int relocCapacity;
+} Encoder;
+
+static int fitsImm8(long long value) {
+    return value >= -128 && value <= 127;
+}
+
+static int fitsImm32(long long value) {
+    return value >= -2147483648LL && value <= 2147483647LL;
+}
+
+// Hardware register number (GP and XMM registers both count from 0)
+static int hw(int reg) {
+    return reg >= REG_XMM0 ? reg - REG_XMM0 : reg;
+}
+
+static void byte(Encoder* e, int value) {
+    unsigned char b = (unsigned char)value;
+    objAppend(&e->code, &b, 1);
+}
+
+static void imm32(Encoder* e, long long value) {
+    unsigned int v = (unsigned int)value;
+    unsigned char bytes[4] = {v, v >> 8, v >> 16, v >> 24};
+    objAppend(&e->code, bytes, 4);
+}
+
+static void imm64(Encoder* e, long long value) {
+    unsigned long long v = (unsigned long long)value;
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) bytes[i] = (unsigned char)(v >> (8 * i));
+    objAppend(&e->code, bytes, 8);
+}
+
+// Record a relocation for the next 4 (or 8) bytes of instruction `inst`
+static void reloc(Encoder* e, int inst, int type, int symbol, long long addend) {
+    if (e->relocCount == e->relocCapacity) {
+        e->relocCapacity = e->relocCapacity ? e->relocCapacity * 2 : 16;
+        e->relocs = realloc(e->relocs, sizeof(*e->relocs) * e->relocCapacity);
+    }
+    e->relocs[e->relocCount].inst = inst;
+    e->relocs[e->relocCount].at = (int)(e->code.length - e->start[inst]);
+    e->relocs[e->relocCount].type = type;
+    e->relocs[e->relocCount].symbol = symbol;
+    e->relocs[e->relocCount].addend = addend;
+    e->relocCount++;
+}
+
+// $symbol as a 32-bit immediate: string literals (.LC<n>) are addressed
+// through the .rodata section symbol, anything else by name
+static void symbolImm32(Encoder* e, int inst, const char* sym) {
+    if (strncmp(sym, ".LC", 3) == 0) {
+        int index = atoi(sym + 3);
+        long long offset = index < e->obj->stringCount ? (long long)e->obj->stringOffsets[index] : 0;
+        reloc(e, inst, R_X86_64_32S, OBJ_RODATA_SYMBOL, offset);
+    } else {
+        reloc(e, inst, R_X86_64_32S, objSymbol(e->obj, sym), 0);
+    }
+    imm32(e, 0);
+}
+
+// [prefix] [REX] opcode ModRM [SIB] [disp] for register field `reg` and
+// the register or memory operand `rm`
+static void encodeOp(Encoder* e, int prefix, int rexW, const char* opcode, int opcodeLength,
+                     int reg, const MOperand* rm) {
+    int base = rm->kind == OPD_RIP ? 0 : hw(rm->reg);
+    int indexed = rm->kind == OPD_MEM && rm->scale;
+    int index = indexed ? hw(rm->index) : 0;
+    int rex = (rexW ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((index & 8) ? 2 : 0) | ((base & 8) ? 1 : 0);
+    if (prefix) byte(e, prefix);
+    if (rex) byte(e, 0x40 | rex);
+    for (int i = 0; i < opcodeLength; i++) byte(e, (unsigned char)opcode[i]);
+
+    if (rm->kind == OPD_REG) {
+        byte(e, 0xC0 | ((reg & 7) << 3) | (base & 7));
+        return;
+    }
+    // .LF<n>(%rip) is float constant n, anything else a named symbol plus
+    // the displacement. The disp32 is relative to the end of the
+    // instruction, which is its own end unless an immediate follows
+    // (ripImmediate).
+    if (rm->kind == OPD_RIP) {
+        byte(e, ((reg & 7) << 3) | 5);
+        if (strncmp(rm->sym, ".LF", 3) == 0) {
+            reloc(e, e->current, R_X86_64_PC32, OBJ_LITERAL_SYMBOL(atoi(rm->sym + 3)), -4);
+        } else {
+            reloc(e, e->current, R_X86_64_PC32, objSymbol(e->obj, rm->sym), rm->imm - 4);
+        }
+        imm32(e, 0);
+        return;
+    }
+    // disp(%base): rbp/r13 need a displacement even when it is 0, and
+    // rsp/r12 need a SIB byte, as does an index
+    long long disp = rm->imm;
+    int mod = (disp == 0 && (base & 7) != REG_RBP) ? 0 : fitsImm8(disp) ? 1 : 2;
+    if (indexed) {
+        int scaleBits = rm->scale == 8 ? 3 : rm->scale == 4 ? 2 : rm->scale == 2 ? 1 : 0;
+        byte(e, (mod << 6) | ((reg & 7) << 3) | 4);
+        byte(e, (scaleBits << 6) | ((index & 7) << 3) | (base & 7));
+    } else {
+        byte(e, (mod << 6) | ((reg & 7) << 3) | (base & 7));
+        if ((base & 7) == REG_RSP) byte(e, 0x24);
+    }
+    if (mod == 1) byte(e, (int)disp);
+    else if (mod == 2) imm32(e, disp);
+}
+
+// An immediate of `bytes` bytes follows the %rip displacement of `rm`
+static void ripImmediate(Encoder* e, const MOperand* rm, int bytes) {
+    if (rm->kind == OPD_RIP) e->relocs[e->relocCount - 1].addend -= bytes;
+}
+
+// ============ Instruction forms ============
+
+static void encodeMov(Encoder* e, int index, const MInst* inst) {
+    const MOperand* src = &inst->src;
+    const MOperand* dst = &inst->dst;
+    if (src->kind == OPD_REG) {
+        encodeOp(e, 0, 1, "\x89", 1, hw(src->reg), dst);
+    } else if (src->kind == OPD_MEM) {
+        encodeOp(e, 0, 1, "\x8B", 1, hw(dst->reg), src);
+    } else if (src->kind == OPD_SYM_ADDR) {
+        encodeOp(e, 0, 1, "\xC7", 1, 0, dst);
+        symbolImm32(e, index, src->sym);
+    } else if (fitsImm32(src->imm) || dst->kind != OPD_REG) {
+        encodeOp(e, 0, 1, "\xC7", 1, 0, dst);
+        imm32(e, src->imm);
+    } else {
+        // GAS turns a mov of a wider constant into movabs
+        byte(e, 0x48 | ((hw(dst->reg) & 8) ? 1 : 0));
+        byte(e, 0xB8 + (hw(dst->reg) & 7));
+        imm64(e, src->imm);
+    }
+}
+
+static void encodeMovabs(Encoder* e, int index, const MInst* inst) {
+    int reg = hw(inst->dst.reg);
+    byte(e, 0x48 | ((reg & 8) ? 1 : 0));
+    byte(e, 0xB8 + (reg & 7));
+    if (inst->src.kind == OPD_SYM_ADDR) {
+        reloc(e, index, R_X86_64_64, objSymbol(e->obj, inst->src.sym), 0);
+        imm64(e, 0);
+    } else {
+        imm64(e, inst->src.imm);
+    }
+}
+
+// movsd load or store; movapd between registers
+static void encodeMovsd(Encoder* e, const MInst* inst) {
+    const MOperand* src = &inst->src;
+    const MOperand* dst = &inst->dst;
+    if (src->kind == OPD_REG && dst->kind == OPD_REG) {
+        encodeOp(e, 0x66, 0, "\x0F\x28", 2, hw(dst->reg), src);
+    } else if (dst->kind == OPD_REG) {
+        encodeOp(e, 0xF2, 0, "\x0F\x10", 2, hw(dst->reg), src);
+    } else {
+        encodeOp(e, 0xF2, 0, "\x0F\x11", 2, hw(src->reg), dst);
+    }
+}
+
+// movdqu load, store or copy
+static void encodeMovdqu(Encoder* e, const MInst* inst) {
+    if (inst->dst.kind == OPD_REG) encodeOp(e, 0xF3, 0, "\x0F\x6F", 2, hw(inst->dst.reg), &inst->src);
+    else encodeOp(e, 0xF3, 0, "\x0F\x7F", 2, hw(inst->src.reg), &inst->dst);
+}
+
+// movq between a general-purpose and an XMM register, or a load into XMM
+static void encodeMovq(Encoder* e, const MInst* inst) {
+    const MOperand* src = &inst->src;
+    const MOperand* dst = &inst->dst;
+    if (src->kind == OPD_MEM) encodeOp(e, 0xF3, 0, "\x0F\x7E", 2, hw(dst->reg), src);
+    else if (dst->reg >= REG_XMM0) encodeOp(e, 0x66, 1, "\x0F\x6E", 2, hw(dst->reg), src);
+    else encodeOp(e, 0x66, 1, "\x0F\x7E", 2, hw(src->reg), dst);
+}
+
+// add/sub/xor/and/or/cmp; `digit` is the group-1 opcode extension
+static void encodeAlu(Encoder* e, int index, const MInst* inst, int digit) {
+    const MOperand* src = &inst->src;
+    const MOperand* dst = &inst->dst;
+    // the printer writes xor with 32-bit register names (which also
+    // clear the upper half), so it is encoded without REX.W
+    int rexW = inst->op == MOP_XOR ? !(src->kind == OPD_REG || dst->kind == OPD_REG) : 1;
+    char opcode = (char)(digit << 3);
+    if (src->kind == OPD_REG) {
+        opcode |= 0x01;
+        encodeOp(e, 0, rexW, &opcode, 1, hw(src->reg), dst);
+    } else if (src->kind == OPD_MEM) {
+        opcode |= 0x03;
+        encodeOp(e, 0, rexW, &opcode, 1, hw(dst->reg), src);
+    } else if (src->kind == OPD_SYM_ADDR) {
+        encodeOp(e, 0, rexW, "\x81", 1, digit, dst);
+        symbolImm32(e, index, src->sym);
+    } else if (fitsImm8(src->imm)) {
+        encodeOp(e, 0, rexW, "\x83", 1, digit, dst);
+        ripImmediate(e, dst, 1);
+        byte(e, (int)src->imm);
+    } else if (dst->kind == OPD_REG && dst->reg == REG_RAX) {
+        if (rexW) byte(e, 0x48);
+        byte(e, (digit << 3) | 0x05);
+        imm32(e, src->imm);
+    } else {
+        encodeOp(e, 0, rexW, "\x81", 1, digit, dst);
+        ripImmediate(e, dst, 4);
+        imm32(e, src->imm);
+    }
+}
+
+static void encodeImul(Encoder* e, const MInst* inst) {
+    const MOperand* src = &inst->src;
+    int reg = hw(inst->dst.reg);
+    if (src->kind != OPD_IMM) {
+        encodeOp(e, 0, 1, "\x0F\xAF", 2, reg, src);
+    } else if (fitsImm8(src->imm)) {
+        encodeOp(e, 0, 1, "\x6B", 1, reg, &inst->dst);
+        byte(e, (int)src->imm);
+    } else {
+        encodeOp(e, 0, 1, "\x69", 1, reg, &inst->dst);
+        imm32(e, src->imm);
+    }
+}
+
+// shl/sar/shr by an immediate count; `digit` is the group-2 opcode extension
+static void encodeShift(Encoder* e, const MInst* inst, int digit) {
+    if (inst->src.imm == 1) {
+        encodeOp(e, 0, 1, "\xD1", 1, digit, &inst->dst);
+    } else {
+        encodeOp(e, 0, 1, "\xC1", 1, digit, &inst->dst);
+        byte(e, (int)inst->src.imm);
+    }
+}
+
+static void encodePushPop(Encoder* e, const MInst* inst) {
+    int push = inst->op == MOP_PUSH;
+    const MOperand* o = push ? &inst->src : &inst->dst;
+    if (o->kind == OPD_REG) {
+        if (hw(o->reg) & 8) byte(e, 0x41);
+        byte(e, (push ? 0x50 : 0x58) + (hw(o->reg) & 7));
+    } else if (o->kind == OPD_IMM) {
+        if (fitsImm8(o->imm)) {
+            byte(e, 0x6A);
+            byte(e, (int)o->imm);
+        } else {
+            byte(e, 0x68);
+            imm32(e, o->imm);
+        }
+    } else if (push) {
+        encodeOp(e, 0, 0, "\xFF", 1, 6, o);
+    } else {
+        encodeOp(e, 0, 0, "\x8F", 1, 0, o);
+    }
+}
+
+static void encodePrologue(Encoder* e, int index, MFunction* fn) {
+    if (fn->frameless) return;
+    byte(e, 0x55);                                  // push %rbp
+    byte(e, 0x48); byte(e, 0x89); byte(e, 0xE5);    // mov %rsp, %rbp
+    if (fn->frameSize > 0) {
+        MInst sub = {MOP_SUB, mReg(REG_RSP), mImm(fn->frameSize), NULL, 0};
+        encodeAlu(e, index, &sub, 5);
+    }
+    for (int i = 0; i < fn->calleeSavedCount; i++) {
+        MOperand slot = mMem(REG_RBP, fn->calleeSavedOffsets[i]);
+        encodeOp(e, 0, 1, "\x89", 1, hw(fn->calleeSavedRegs[i]), &slot);
+        e->saveEnd[i] = (int)e->code.length - e->start[index];
+    }
+}
+
+static void encodeEpilogue(Encoder* e, MFunction* fn) {
+    for (int i = 0; i < fn->calleeSavedCount; i++) {
+        MOperand slot = mMem(REG_RBP, fn->calleeSavedOffsets[i]);
+        encodeOp(e, 0, 1, "\x8B", 1, hw(fn->calleeSavedRegs[i]), &slot);
+    }
+    if (!fn->frameless) byte(e, 0xC9);     // leave
+    byte(e, 0xC3);                          // ret
+}
+
+// Condition code of a j<cc> mnemonic suffix
+static int conditionCode(const char* cc) {
+    static const struct { const char* name; int code; } codes[] = {
+        {"o", 0x0}, {"no", 0x1}, {"b", 0x2}, {"c", 0x2}, {"nae", 0x2},
+        {"ae", 0x3}, {"nb", 0x3}, {"nc", 0x3}, {"e", 0x4}, {"z", 0x4},
+        {"ne", 0x5}, {"nz", 0x5}, {"be", 0x6}, {"na", 0x6}, {"a", 0x7},
+        {"nbe", 0x7}, {"s", 0x8}, {"ns", 0x9}, {"p", 0xA}, {"pe", 0xA},
+        {"np", 0xB}, {"po", 0xB}, {"l", 0xC}, {"nge", 0xC}, {"ge", 0xD},
+        {"nl", 0xD}, {"le", 0xE}, {"ng", 0xE}, {"g", 0xF}, {"nle", 0xF},
+    };
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+        if (strcmp(codes[i].name, cc) == 0) return codes[i].code;
+    }
+    return -1;
+}
+
+static int usesVirtualReg(const MOperand* o) {
+    if (o->kind == OPD_MEM && o->scale && isVirtualReg(o->index)) return 1;
+    return (o->kind == OPD_REG || o->kind == OPD_MEM) && isVirtualReg(o->reg);
+}
+
+// Encode one non-jump instruction into e->code; returns 0 if the form is unsupported
+static int encodeInst(Encoder* e, int index, const MInst* inst) {
+    if (usesVirtualReg(&inst->src) || usesVirtualReg(&inst->dst)) return 0;
+    switch (inst->op) {
+        case MOP_LABEL:
+        case MOP_COMMENT:
+            return 1;
+        case MOP_PROLOGUE:
+            encodePrologue(e, index, e->fn);
+            return 1;
+        case MOP_EPILOGUE:
+            encodeEpilogue(e, e->fn);
+            return 1;
+        case MOP_MOV:
+            encodeMov(e, index, inst);
+            return 1;
+        case MOP_MOVABS:
+            encodeMovabs(e, index, inst);
+            return 1;
+        case MOP_MOVSLQ:
+            encodeOp(e, 0, 1, "\x63", 1, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_MOVZB:
+            // REX.W is always present, so sil/dil etc. need no extra prefix
+            encodeOp(e, 0, 1, "\x0F\xB6", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_MOVSD:
+            encodeMovsd(e, inst);
+            return 1;
+        case MOP_CVTSD2SS:
+            encodeOp(e, 0xF2, 0, "\x0F\x5A", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_CVTSS2SD:
+            encodeOp(e, 0xF3, 0, "\x0F\x5A", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_CVTSI2SD:
+            encodeOp(e, 0xF2, 1, "\x0F\x2A", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_CVTTSD2SI:
+            encodeOp(e, 0xF2, 1, "\x0F\x2C", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_ADDSD:
+            encodeOp(e, 0xF2, 0, "\x0F\x58", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_MULSD:
+            encodeOp(e, 0xF2, 0, "\x0F\x59", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_SUBSD:
+            encodeOp(e, 0xF2, 0, "\x0F\x5C", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_DIVSD:
+            encodeOp(e, 0xF2, 0, "\x0F\x5E", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_UCOMISD:
+            encodeOp(e, 0x66, 0, "\x0F\x2E", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_MOVDQU:
+            encodeMovdqu(e, inst);
+            return 1;
+        case MOP_MOVQ:
+            encodeMovq(e, inst);
+            return 1;
+        case MOP_PADDQ:
+            encodeOp(e, 0x66, 0, "\x0F\xD4", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_PSUBQ:
+            encodeOp(e, 0x66, 0, "\x0F\xFB", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_ADDPD:
+            encodeOp(e, 0x66, 0, "\x0F\x58", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_MULPD:
+            encodeOp(e, 0x66, 0, "\x0F\x59", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_SUBPD:
+            encodeOp(e, 0x66, 0, "\x0F\x5C", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_DIVPD:
+            encodeOp(e, 0x66, 0, "\x0F\x5E", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_PUNPCKLQDQ:
+            encodeOp(e, 0x66, 0, "\x0F\x6C", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_PUNPCKHQDQ:
+            encodeOp(e, 0x66, 0, "\x0F\x6D", 2, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_ADD:
+            encodeAlu(e, index, inst, 0);
+            return 1;
+        case MOP_SUB:
+            encodeAlu(e, index, inst, 5);
+            return 1;
+        case MOP_XOR:
+            encodeAlu(e, index, inst, 6);
+            return 1;
+        case MOP_AND:
+            encodeAlu(e, index, inst, 4);
+            return 1;
+        case MOP_OR:
+            encodeAlu(e, index, inst, 1);
+            return 1;
+        case MOP_CMP:
+            encodeAlu(e, index, inst, 7);
+            return 1;
+        case MOP_SETCC: {
+            int cc = conditionCode(inst->text);
+            if (cc < 0) return 0;
+            char opcode[2] = {0x0F, (char)(0x90 + cc)};
+            // spl..dil need an empty REX prefix to be addressed as bytes
+            if (inst->dst.kind == OPD_REG && hw(inst->dst.reg) >= 4 && hw(inst->dst.reg) < 8) byte(e, 0x40);
+            encodeOp(e, 0, 0, opcode, 2, 0, &inst->dst);
+            return 1;
+        }
+        case MOP_IMUL:
+            encodeImul(e, inst);
+            return 1;
+        case MOP_CQO:
+            byte(e, 0x48);
+            byte(e, 0x99);
+            return 1;
+        case MOP_IDIV:
+            encodeOp(e, 0, 1, "\xF7", 1, 7, &inst->src);
+            return 1;
+        case MOP_IMULWIDE:
+            encodeOp(e, 0, 1, "\xF7", 1, 5, &inst->src);
+            return 1;
+        case MOP_SHL:
+            encodeShift(e, inst, 4);
+            return 1;
+        case MOP_SHR:
+            encodeShift(e, inst, 5);
+            return 1;
+        case MOP_SAR:
+            encodeShift(e, inst, 7);
+            return 1;
+        case MOP_LEA:
+            encodeOp(e, 0, 1, "\x8D", 1, hw(inst->dst.reg), &inst->src);
+            return 1;
+        case MOP_NEG:
+            encodeOp(e, 0, 1, "\xF7", 1, 3, &inst->dst);
+            return 1;
+        case MOP_PUSH:
+        case MOP_POP:
+            encodePushPop(e, inst);
+            return 1;
+        case MOP_CALL:
+            if (inst->src.kind != OPD_SYM) return 0;
+            byte(e, 0xE8);
+            reloc(e, index, R_X86_64_PLT32, objSymbol(e->obj, inst->src.sym), -4);
+            imm32(e, 0);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// ============ Jumps ============
+
+static int isJump(const MInst* inst) {
+    return inst->op == MOP_JMP || inst->op == MOP_JCC;
+}
+
+static int jumpSize(const MInst* inst, int isLong) {
+    if (!isLong) return 2;
+    return inst->op == MOP_JMP ? 5 : 6;
+}
+
+// Match every jump with the label it targets
+static int resolveTargets(Encoder* e) {
+    MFunction* fn = e->fn;
+    int capacity = 16;
+    while (capacity < fn->count * 2) capacity *= 2;
+    int* table = malloc(sizeof(int) * capacity);
+    for (int i = 0; i < capacity; i++) table[i] = -1;
+
+    for (int i = 0; i < fn->count; i++) {
+        if (fn->insts[i].op != MOP_LABEL) continue;
+        unsigned slot = 0;
+        for (const char* p = fn->insts[i].text; *p; p++) slot = slot * 31 + (unsigned char)*p;
+        slot &= capacity - 1;
+        while (table[slot] >= 0) slot = (slot + 1) & (capacity - 1);
+        table[slot] = i;
+    }
+
+    int ok = 1;
+    for (int i = 0; i < fn->count; i++) {
+        if (!isJump(&fn->insts[i])) continue;
+        const char* name = fn->insts[i].src.sym;
+        unsigned slot = 0;
+        for (const char* p = name; *p; p++) slot = slot * 31 + (unsigned char)*p;
+        slot &= capacity - 1;
+        e->target[i] = -1;
+        while (table[slot] >= 0) {
+            if (strcmp(fn->insts[table[slot]].text, name) == 0) {
+                e->target[i] = table[slot];
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (e->target[i] < 0) {
+            fprintf(stderr, "Codegen error: undefined label %s in %s\n", name, fn->name);
+            ok = 0;
+        }
+    }
+    free(table);
+    return ok;
+}
+
+// Lay the function out, widening jumps whose target is out of rel8 range.
+// Jumps only ever grow, so this terminates.
+static void relaxJumps(Encoder* e) {
+    MFunction* fn = e->fn;
+    for (int changed = 1; changed; ) {
+        changed = 0;
+        size_t at = 0;
+        for (int i = 0; i < fn->count; i++) {
+            e->offset[i] = at;
+            at += (size_t)(isJump(&fn->insts[i]) ? jumpSize(&fn->insts[i], e->isLong[i]) : e->length[i]);
+        }
+        e->offset[fn->count] = at;
+        for (int i = 0; i < fn->count; i++) {
+            if (!isJump(&fn->insts[i]) || e->isLong[i]) continue;
+            long long disp = (long long)e->offset[e->target[i]] - (long long)(e->offset[i] + 2);
+            if (!fitsImm8(disp)) {
+                e->isLong[i] = 1;
+                changed = 1;
+            }
+        }
+    }
+}
+
+// ============ Debug information ============
+
+// -g: where the function's source lines start and where its frame
+// changes, the rows and rules GAS derives from the .loc and .cfi_*
+// directives mirPrintFunction prints
+static void describeFunction(Encoder* e, size_t base) {
+    ObjectFile* obj = e->obj;
+    MFunction* fn = e->fn;
+    size_t end = e->offset[fn->count];
+    int line = 0;
+    for (int i = 0; i < fn->count; i++) {
+        MInst* inst = &fn->insts[i];
+        // labels, comments and a frameless prologue have no code
+        if (!isJump(inst) && e->length[i] == 0) continue;
+        size_t at = base + e->offset[i];
+        if (inst->line > 0 && inst->line != line) {
+            objAddLine(obj, at, inst->line);
+            line = inst->line;
+        }
+        if (fn->frameless) {
+            // the CFA stays %rsp + 8 throughout
+        } else if (inst->op == MOP_PROLOGUE) {
+            objAddCfi(obj, at + 1, OBJ_CFI_PUSH_FP, 0, 0);
+            objAddCfi(obj, at + 4, OBJ_CFI_SET_FP, 0, 0);
+            for (int k = 0; k < fn->calleeSavedCount; k++) {
+                // the CFA is 16 bytes above %rbp
+                objAddCfi(obj, at + e->saveEnd[k], OBJ_CFI_SAVE, fn->calleeSavedRegs[k],
+                          fn->calleeSavedOffsets[k] - 16);
+            }
+        } else if (inst->op == MOP_EPILOGUE) {
+            // ends in leave; ret
+            size_t after = e->offset[i] + e->length[i];
+            if (after < end) objAddCfi(obj, at, OBJ_CFI_REMEMBER, 0, 0);
+            objAddCfi(obj, base + after - 1, OBJ_CFI_LEAVE, 0, 0);
+            if (after < end) objAddCfi(obj, base + after, OBJ_CFI_RESTORE, 0, 0);
+        }
+    }
+    objAddFrame(obj, base, end);
+}
+
+void x86EncodeFunction(ObjectFile* obj, MFunction* fn) {
+    Encoder e;
+    memset(&e, 0, sizeof(e));
+    e.obj = obj;
+    e.fn = fn;
+    int n = fn->count;
+    e.start = calloc(n + 1, sizeof(int));
+    e.length = calloc(n + 1, sizeof(int));
+    e.target = calloc(n + 1, sizeof(int));
+    e.isLong = calloc(n + 1, sizeof(int));
+    e.offset = calloc(n + 1, sizeof(size_t));
+
+    for (int i = 0; i < n; i++) {
+        MInst* inst = &fn->insts[i];
+        e.start[i] = (int)e.code.length;
+        e.current = i;
+        if (isJump(inst)) continue;
+        if (!encodeInst(&e, i, inst)) {
+            fprintf(stderr, "Codegen error: cannot encode instruction %d in %s\n", i, fn->name);
+            obj->failed = 1;
+        }
+        e.length[i] = (int)(e.code.length - e.start[i]);
+    }
+    if (!resolveTargets(&e)) obj->failed = 1;
+
+    if (!obj->failed) {
+        relaxJumps(&e);
+
+        size_t base = obj->text.length;
+        for (int i = 0; i < n; i++) {
+            MInst* inst = &fn->insts[i];
+            if (!isJump(inst)) {
+                objAppend(&obj->text, e.code.data + e.start[i], e.length[i]);
+                continue;
+            }
+            int size = jumpSize(inst, e.isLong[i]);
+            long long disp = (long long)e.offset[e.target[i]] - (long long)(e.offset[i] + size);
+            unsigned char bytes[6];
+            int count = 0;
+            int cc = inst->op == MOP_JCC ? conditionCode(inst->text) : 0;
+            if (cc < 0) {
+                fprintf(stderr, "Codegen error: unknown condition j%s in %s\n", inst->text, fn->name);
+                obj->failed = 1;
+                cc = 0;
+            }
+            if (!e.isLong[i]) {
+                bytes[count++] = inst->op == MOP_JMP ? 0xEB : (unsigned char)(0x70 + cc);
+                bytes[count++] = (unsigned char)disp;
+            } else {
+                if (inst->op == MOP_JMP) {
+                    bytes[count++] = 0xE9;
+                } else {
+                    bytes[count++] = 0x0F;
+                    bytes[count++] = (unsigned char)(0x80 + cc);
+                }
+                unsigned int v = (unsigned int)disp;
+                for (int k = 0; k < 4; k++) bytes[count++] = (unsigned char)(v >> (8 * k));
+            }
+            objAppend(&obj->text, bytes, count);
+        }
+
+        for (int i = 0; i < e.relocCount; i++) {
+            size_t at = base + e.offset[e.relocs[i].inst] + e.relocs[i].at;
+            objAddReloc(obj, at, e.relocs[i].type, e.relocs[i].symbol, e.relocs[i].addend);
+        }
+        objAddFunction(obj, fn->name, base);
+        if (obj->debugSource) describeFunction(&e, base);
+    }
+
+    free(e.code.data);
+    free(e.relocs);
+    free(e.start);
+    free(e.length);
+    free(e.target);
+    free(e.isLong);
+    free(e.offset);
+}
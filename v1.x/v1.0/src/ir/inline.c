@@ -0,0 +1,436 @@
+// src/ir/inline.c - call graph ordering and the cost-model inliner
+//
+// A call to a Mino function is replaced by a copy of the callee's blocks
+// when the callee is small enough for the call to be worth removing:
+//
+//   callee cost <= call overhead + constant-argument bonus + INLINE_THRESHOLD
+//
+// The cost counts the instructions the body will expand to; the overhead
+// is what the call itself costs (call, frame setup and teardown, argument
+// and result moves). @inline forces inlining and @noinline forbids it.
+// Functions on a call-graph cycle are never inlined, so recursion cannot
+// unroll, and a caller stops growing once it reaches INLINE_CALLER_LIMIT.
+//
+// Functions are processed callees first (irCallGraphOrder), so the body
+// copied into a caller has already been inlined into and optimized. The
+// same walk finds the call-graph cycles (Tarjan's SCCs) and sets
+// IRFunction.recursive, which is all the inliner checks. Inlining only
+// gives a caller calls to functions it already reached, so it creates no
+// new cycle.
+// Functions main cannot reach are dropped before and after the pipeline
+// (irRemoveUnreachableFunctions), so a function inlined at all of its
+// call sites is not compiled on its own.
+//
+// With a profile (--profile-use), a call site that never ran is left
+// alone unless the callee is @inline, one whose block runs at least
+// 1/INLINE_HOT_FRACTION as often as the hottest block of the program
+// gets INLINE_HOT_THRESHOLD instead of INLINE_THRESHOLD, and the copied
+// blocks take the callee's counts scaled to the call site.
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ir.h>
+
+#define INLINE_THRESHOLD 6          // extra instructions a call may grow by
+#define INLINE_CONST_ARG_BONUS 2    // per constant argument (folds after inlining)
+#define INLINE_CALLER_LIMIT 2000    // stop growing a caller past this cost
+#define INLINE_HOT_THRESHOLD 24     // INLINE_THRESHOLD at a hot call site
+#define INLINE_HOT_FRACTION 100     // hot: run at least 1/100 as often as the hottest block
+
+// ============ Call graph ============
+
+// The module functions by index (IRFunction.index) with, for each, the
+// indices of the module functions it calls; built in one pass over the
+// calls, with names resolved through the module's function table
+typedef struct {
+    IRFunction** functions;
+    int** callees;
+    int* calleeCount;
+    int count;
+} CallGraph;
+
+// The module function a call targets, NULL for runtime calls
+static IRFunction* callTarget(IRModule* module, IRInst* call) {
+    if (call->op != IR_CALL || !call->sym || call->runtime) return NULL;
+    return irFindFunction(module, call->sym);
+}
+
+static void buildCallGraph(IRModule* module, CallGraph* graph) {
+    int count = module->functionCount;
+    graph->count = count;
+    graph->functions = malloc(sizeof(IRFunction*) * (count > 0 ? count : 1));
+    graph->callees = calloc(count > 0 ? count : 1, sizeof(int*));
+    graph->calleeCount = calloc(count > 0 ? count : 1, sizeof(int));
+    int index = 0;
+    for (IRFunction* fn = module->functions; fn; fn = fn->next, index++) {
+        fn->index = index;
+        graph->functions[index] = fn;
+    }
+    for (int i = 0; i < count; i++) {
+        int capacity = 0;
+        for (IRBlock* block = graph->functions[i]->entry; block; block = block->next) {
+            for (IRInst* inst = block->first; inst; inst = inst->next) {
+                IRFunction* callee = callTarget(module, inst);
+                if (!callee) continue;
+                if (graph->calleeCount[i] == capacity) {
+                    capacity = capacity ? capacity * 2 : 4;
+                    graph->callees[i] = realloc(graph->callees[i], sizeof(int) * capacity);
+                }
+                graph->callees[i][graph->calleeCount[i]++] = callee->index;
+            }
+        }
+    }
+}
+
+static void freeCallGraph(CallGraph* graph) {
+    for (int i = 0; i < graph->count; i++) free(graph->callees[i]);
+    free(graph->callees);
+    free(graph->calleeCount);
+    free(graph->functions);
+}
+
+// Tarjan's strongly connected components. A component is complete only
+// after every component it calls, so appending them as they complete
+// lists callees first.
+typedef struct {
+    CallGraph* graph;
+    int* number;        // DFS number + 1, 0 = not visited yet
+    int* low;
+    int* stack;
+    char* onStack;
+    int depth;
+    int counter;
+    IRFunction** order;
+    int count;
+} SCCState;
+
+static void strongConnect(SCCState* st, int v) {
+    CallGraph* graph = st->graph;
+    st->number[v] = st->low[v] = ++st->counter;
+    st->stack[st->depth++] = v;
+    st->onStack[v] = 1;
+    int selfCall = 0;
+    for (int i = 0; i < graph->calleeCount[v]; i++) {
+        int w = graph->callees[v][i];
+        if (w == v) selfCall = 1;
+        if (!st->number[w]) {
+            strongConnect(st, w);
+            if (st->low[w] < st->low[v]) st->low[v] = st->low[w];
+        } else if (st->onStack[w] && st->number[w] < st->low[v]) {
+            st->low[v] = st->number[w];
+        }
+    }
+    if (st->low[v] != st->number[v]) return;
+
+    // v is the root of a component: everything above it on the stack
+    int first = st->count;
+    int w;
+    do {
+        w = st->stack[--st->depth];
+        st->onStack[w] = 0;
+        st->order[st->count++] = graph->functions[w];
+    } while (w != v);
+    int recursive = st->count - first > 1 || selfCall;
+    for (int i = first; i < st->count; i++) st->order[i]->recursive = recursive;
+}
+
+IRFunction** irCallGraphOrder(IRModule* module, int* outCount) {
+    CallGraph graph;
+    buildCallGraph(module, &graph);
+    int total = graph.count > 0 ? graph.count : 1;
+    SCCState st = {&graph, calloc(total, sizeof(int)), malloc(sizeof(int) * total), malloc(sizeof(int) * total),
+                   calloc(total, 1), 0, 0, malloc(sizeof(IRFunction*) * total), 0};
+    for (int v = 0; v < graph.count; v++) {
+        if (!st.number[v]) strongConnect(&st, v);
+    }
+    free(st.number);
+    free(st.low);
+    free(st.stack);
+    free(st.onStack);
+    freeCallGraph(&graph);
+    *outCount = st.count;
+    return st.order;
+}
+
+// A worklist from main over the call graph, then one pass that unlinks
+// the rest: linear in functions plus calls
+int irRemoveUnreachableFunctions(IRModule* module) {
+    IRFunction* mainFn = irFindFunction(module, "main");
+    if (!mainFn) return 0;
+    CallGraph graph;
+    buildCallGraph(module, &graph);
+    char* live = calloc(graph.count, 1);
+    int* work = malloc(sizeof(int) * graph.count);
+    int pending = 0;
+    live[mainFn->index] = 1;
+    work[pending++] = mainFn->index;
+    while (pending > 0) {
+        int v = work[--pending];
+        for (int i = 0; i < graph.calleeCount[v]; i++) {
+            int w = graph.callees[v][i];
+            if (live[w]) continue;
+            live[w] = 1;
+            work[pending++] = w;
+        }
+    }
+
+    int removed = 0;
+    for (int i = 0; i < graph.count; i++) {
+        if (live[i]) continue;
+        IRFunction* fn = graph.functions[i];
+        if (module->remarks) {
+            fprintf(module->remarks, "[line %d] removed: %s (not reachable from main)\n", fn->line, fn->name);
+        }
+        irRemoveFunction(module, fn);
+        removed++;
+    }
+    free(work);
+    free(live);
+    freeCallGraph(&graph);
+    return removed;
+}
+
+// ============ Cost model ============
+
+static int instCost(IRInst* inst) {
+    switch (inst->op) {
+        case IR_CONST:
+        case IR_PARAM:
+        case IR_STRING:
+        case IR_PHI:
+        case IR_COUNT:          // so instrumenting leaves the decisions alone
+        case IR_JMP:
+        case IR_RET:
+            return 0;
+        case IR_DIV:
+        case IR_REM:
+            return 4;       // rax/rdx setup, cqo, idiv
+        case IR_CALL:
+            return 1 + inst->argCount;
+        case IR_BR:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+static int functionCost(IRFunction* fn) {
+    int cost = 0;
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) cost += instCost(inst);
+    }
+    return cost;
+}
+
+// call, prologue and epilogue, argument moves and the result move
+static int callOverhead(IRInst* call) {
+    return 3 + call->argCount + (call->type != IRT_VOID ? 1 : 0);
+}
+
+static void remark(IRModule* module, IRInst* call, const char* format, ...) {
+    if (!module->remarks) return;
+    va_list args;
+    va_start(args, format);
+    fprintf(module->remarks, "[line %d] ", call->line);
+    vfprintf(module->remarks, format, args);
+    fprintf(module->remarks, "\n");
+    va_end(args);
+}
+
+// Decide whether to inline; returns 1 to inline and reports either way
+static int shouldInline(IRModule* module, IRFunction* caller, IRInst* call, IRFunction* callee, int callerCost) {
+    if (callee == caller || callee->recursive) {
+        remark(module, call, "not inlined: %s into %s (recursive)", callee->name, caller->name);
+        return 0;
+    }
+    if (call->argCount != callee->paramCount) {
+        remark(module, call, "not inlined: %s into %s (argument count mismatch)", callee->name, caller->name);
+        return 0;
+    }
+    if (callee->entry && callee->entry->predCount > 0) {
+        remark(module, call, "not inlined: %s into %s (entry block is a loop header)", callee->name, caller->name);
+        return 0;
+    }
+    if (callee->inlineHint == INLINE_NEVER) {
+        remark(module, call, "not inlined: %s into %s (@noinline)", callee->name, caller->name);
+        return 0;
+    }
+
+    int cost = functionCost(callee);
+    if (callee->inlineHint == INLINE_ALWAYS) {
+        remark(module, call, "inlined %s into %s (@inline, cost %d)", callee->name, caller->name, cost);
+        return 1;
+    }
+
+    long long calls = call->block->count;
+    if (calls == 0) {
+        remark(module, call, "not inlined: %s into %s (call site never ran)", callee->name, caller->name);
+        return 0;
+    }
+    int hot = calls > 0 && calls * INLINE_HOT_FRACTION >= module->hottestCount;
+
+    int bonus = 0;
+    for (int i = 0; i < call->argCount; i++) {
+        if (call->args[i]->op == IR_CONST) bonus += INLINE_CONST_ARG_BONUS;
+    }
+    int limit = callOverhead(call) + bonus + (hot ? INLINE_HOT_THRESHOLD : INLINE_THRESHOLD);
+    const char* site = hot ? "hot call site, " : "";
+    if (cost > limit) {
+        remark(module, call, "not inlined: %s into %s (%scost %d > limit %d)", callee->name, caller->name, site, cost, limit);
+        return 0;
+    }
+    if (callerCost + cost > INLINE_CALLER_LIMIT) {
+        remark(module, call, "not inlined: %s into %s (caller too large)", callee->name, caller->name);
+        return 0;
+    }
+    remark(module, call, "inlined %s into %s (%scost %d, limit %d)", callee->name, caller->name, site, cost, limit);
+    return 1;
+}
+
+// ============ Body substitution ============
+
+// A callee block's count for the copy at a call site that ran `calls`
+// times, the callee having been entered `entries` times in all
+static long long scaledCount(long long count, long long calls, long long entries) {
+    if (count < 0 || calls < 0 || entries < 0) return -1;
+    if (entries == 0) return 0;
+    return (long long)((double)count * (double)calls / (double)entries);
+}
+
+// Replace `call` with a copy of the callee; returns the block holding the
+// instructions that followed the call
+static IRBlock* inlineCall(IRFunction* caller, IRInst* call, IRFunction* callee) {
+    IRBlock* block = call->block;
+    IRBlock* cont = irSplitBlock(block, call);
+    irUnlink(call);
+
+    // Copy every block and instruction; parameters become the call's arguments
+    IRBlock** blockMap = calloc(callee->nextBlockId > 0 ? callee->nextBlockId : 1, sizeof(IRBlock*));
+    IRInst** valueMap = calloc(callee->nextValueId > 0 ? callee->nextValueId : 1, sizeof(IRInst*));
+    IRBlock* after = block;
+    for (IRBlock* b = callee->entry; b; b = b->next) {
+        blockMap[b->id] = irCreateBlockAfter(caller, after);
+        after = blockMap[b->id];
+        blockMap[b->id]->count = scaledCount(b->count, block->count, callee->entryCount);
+    }
+
+    IRInst** returns = NULL;        // returned value per return site (NULL if none)
+    IRBlock** returnBlocks = NULL;
+    int returnCount = 0;
+
+    for (IRBlock* b = callee->entry; b; b = b->next) {
+        IRBlock* copy = blockMap[b->id];
+        for (int p = 0; p < b->predCount; p++) irAddPred(copy, blockMap[b->preds[p]->id]);
+        for (IRInst* inst = b->first; inst; inst = inst->next) {
+            if (inst->op == IR_PARAM) {
+                valueMap[inst->id] = call->args[inst->imm];
+                continue;
+            }
+            if (inst->op == IR_RET) {
+                // returns become jumps to the code after the call
+                IRInst* jump = irNewInst(caller, IR_JMP, IRT_VOID);
+                jump->targets[0] = cont;
+                jump->line = inst->line;
+                irAppend(copy, jump);
+                returns = realloc(returns, sizeof(IRInst*) * (returnCount + 1));
+                returnBlocks = realloc(returnBlocks, sizeof(IRBlock*) * (returnCount + 1));
+                returns[returnCount] = inst->argCount > 0 ? inst->args[0] : NULL;
+                returnBlocks[returnCount] = copy;
+                returnCount++;
+                continue;
+            }
+            IRInst* clone = irNewInst(caller, inst->op, inst->type);
+            clone->imm = inst->imm;
+            clone->sym = inst->sym;
+            clone->runtime = inst->runtime;
+            clone->line = inst->line;
+            clone->inlineDecided = inst->inlineDecided;
+            for (int t = 0; t < 2; t++) clone->targets[t] = inst->targets[t] ? blockMap[inst->targets[t]->id] : NULL;
+            irAppend(copy, clone);
+            valueMap[inst->id] = clone;
+        }
+    }
+
+    // Operands may refer forward (phis), so they are filled in afterwards
+    for (IRBlock* b = callee->entry; b; b = b->next) {
+        for (IRInst* inst = b->first; inst; inst = inst->next) {
+            if (inst->op == IR_PARAM || inst->op == IR_RET) continue;
+            IRInst* clone = valueMap[inst->id];
+            for (int i = 0; i < inst->argCount; i++) irAddArg(clone, valueMap[inst->args[i]->id]);
+        }
+    }
+
+    IRInst* jump = irNewInst(caller, IR_JMP, IRT_VOID);
+    jump->targets[0] = blockMap[callee->entry->id];
+    jump->line = call->line;
+    irAppend(block, jump);
+    irAddPred(blockMap[callee->entry->id], block);
+
+    // The call's value: the single returned value, or a phi over all of them
+    IRInst* result = NULL;
+    for (int r = 0; r < returnCount; r++) {
+        irAddPred(cont, returnBlocks[r]);
+        if (call->type == IRT_VOID) continue;
+        if (returns[r]) {
+            returns[r] = valueMap[returns[r]->id];
+        } else {
+            IRInst* zero = irNewInst(caller, IR_CONST, call->type);
+            irInsertBefore(returnBlocks[r]->last, zero);
+            returns[r] = zero;
+        }
+    }
+    if (call->type != IRT_VOID && returnCount > 0) {
+        if (returnCount == 1) {
+            result = returns[0];
+        } else {
+            result = irNewInst(caller, IR_PHI, call->type);
+            for (int r = 0; r < returnCount; r++) irAddArg(result, returns[r]);
+            irPrepend(cont, result);
+        }
+    }
+    if (call->type != IRT_VOID && !result) {
+        // the callee never returns; the value is never observed
+        result = irNewInst(caller, IR_CONST, call->type);
+        irPrepend(cont, result);
+    }
+
+    if (result) {
+        IRInst** replacements = calloc(caller->nextValueId, sizeof(IRInst*));
+        replacements[call->id] = result;
+        irApplyReplacements(caller, replacements);
+        free(replacements);
+    }
+
+    irFreeInst(call);
+    free(returns);
+    free(returnBlocks);
+    free(valueMap);
+    free(blockMap);
+    return cont;
+}
+
+int irPassInline(IRModule* module, IRFunction* fn) {
+    int changed = 0;
+    int callerCost = functionCost(fn);
+
+    IRBlock* block = fn->entry;
+    while (block) {
+        IRBlock* resume = NULL;
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            if (inst->op != IR_CALL || inst->inlineDecided) continue;
+            IRFunction* callee = callTarget(module, inst);
+            if (!callee) continue;
+            inst->inlineDecided = 1;
+            if (!shouldInline(module, fn, inst, callee, callerCost)) continue;
+
+            callerCost += functionCost(callee);
+            // the copied body was already processed with the callee; carry on after it
+            resume = inlineCall(fn, inst, callee);
+            changed = 1;
+            break;
+        }
+        block = resume ? resume : block->next;
+    }
+    return changed;
+}
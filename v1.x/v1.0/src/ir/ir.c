@@ -0,0 +1,636 @@
+// src/ir/ir.c - SSA IR construction helpers, dominators and textual dump
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ir.h>
+#include <runtime_abi.h>
+
+// ============ Module ============
+
+IRModule* irCreateModule(void) {
+    IRModule* module = calloc(1, sizeof(IRModule));
+    module->hottestCount = -1;
+    return module;
+}
+
+static void freeFunction(IRFunction* fn) {
+    IRBlock* block = fn->entry;
+    while (block) {
+        IRBlock* nextBlock = block->next;
+        IRInst* inst = block->first;
+        while (inst) {
+            IRInst* nextInst = inst->next;
+            irFreeInst(inst);
+            inst = nextInst;
+        }
+        free(block->preds);
+        free(block);
+        block = nextBlock;
+    }
+    free(fn->paramTypes);
+    free(fn->name);
+    free(fn);
+}
+
+void irFreeModule(IRModule* module) {
+    if (!module) return;
+    IRFunction* fn = module->functions;
+    while (fn) {
+        IRFunction* next = fn->next;
+        freeFunction(fn);
+        fn = next;
+    }
+    for (int i = 0; i < module->stringCount; i++) free(module->strings[i].bytes);
+    free(module->strings);
+    free(module->stringHash);
+    free(module->functionHash);
+    free(module);
+}
+
+// ============ String literals ============
+
+static int isOctal(char c) {
+    return c >= '0' && c <= '7';
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Decode the escapes GAS accepts in .asciz into `out` (at least length + 1
+// bytes); returns the decoded length
+static int decodeString(const char* p, int length, char* out) {
+    const char* end = p + length;
+    int n = 0;
+    while (p < end) {
+        if (*p != '\\' || p + 1 == end) {
+            out[n++] = *p++;
+            continue;
+        }
+        p++;
+        if (isOctal(*p)) {
+            int value = 0;
+            for (int digits = 0; digits < 3 && p < end && isOctal(*p); digits++) value = value * 8 + (*p++ - '0');
+            out[n++] = (char)value;
+            continue;
+        }
+        if ((*p == 'x' || *p == 'X') && p + 1 < end && hexValue(p[1]) >= 0) {
+            // like GAS, every following hex digit belongs to the escape
+            int value = 0;
+            for (p++; p < end && hexValue(*p) >= 0; p++) value = value * 16 + hexValue(*p);
+            out[n++] = (char)value;
+            continue;
+        }
+        switch (*p) {
+            case 'b': out[n++] = '\b'; break;
+            case 'f': out[n++] = '\f'; break;
+            case 'n': out[n++] = '\n'; break;
+            case 'r': out[n++] = '\r'; break;
+            case 't': out[n++] = '\t'; break;
+            default: out[n++] = *p; break;
+        }
+        p++;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+static unsigned hashBytes(const char* bytes, int length) {
+    unsigned hash = 2166136261u;
+    for (int i = 0; i < length; i++) hash = (hash ^ (unsigned char)bytes[i]) * 16777619u;
+    return hash;
+}
+
+static void rehashStrings(IRModule* module) {
+    free(module->stringHash);
+    module->stringHashCapacity = module->stringHashCapacity ? module->stringHashCapacity * 2 : 64;
+    module->stringHash = malloc(sizeof(int) * module->stringHashCapacity);
+    int mask = module->stringHashCapacity - 1;
+    for (int i = 0; i < module->stringHashCapacity; i++) module->stringHash[i] = -1;
+    for (int i = 0; i < module->stringCount; i++) {
+        unsigned slot = hashBytes(module->strings[i].bytes, module->strings[i].length) & mask;
+        while (module->stringHash[slot] >= 0) slot = (slot + 1) & mask;
+        module->stringHash[slot] = i;
+    }
+}
+
+int irModuleString(IRModule* module, const char* chars, int length) {
+    char* bytes = malloc(length + 1);
+    int decoded = decodeString(chars, length, bytes);
+    // keep the table at most half full
+    if ((module->stringCount + 1) * 2 > module->stringHashCapacity) rehashStrings(module);
+
+    int mask = module->stringHashCapacity - 1;
+    unsigned slot = hashBytes(bytes, decoded) & mask;
+    while (module->stringHash[slot] >= 0) {
+        IRString* s = &module->strings[module->stringHash[slot]];
+        if (s->length == decoded && memcmp(s->bytes, bytes, decoded) == 0) {
+            free(bytes);
+            return module->stringHash[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (module->stringCount == module->stringCapacity) {
+        module->stringCapacity = module->stringCapacity ? module->stringCapacity * 2 : 16;
+        module->strings = realloc(module->strings, sizeof(IRString) * module->stringCapacity);
+    }
+    int index = module->stringCount++;
+    IRString* s = &module->strings[index];
+    s->bytes = bytes;
+    s->length = decoded;
+    s->base = index;
+    s->offset = 0;
+    module->stringHash[slot] = index;
+    return index;
+}
+
+// Order by the bytes read backwards, so a suffix sorts right before the
+// strings that end with it
+static const IRString* sortStrings;
+
+static int compareReversed(const void* a, const void* b) {
+    const IRString* x = &sortStrings[*(const int*)a];
+    const IRString* y = &sortStrings[*(const int*)b];
+    for (int i = 1; i <= x->length && i <= y->length; i++) {
+        unsigned char cx = (unsigned char)x->bytes[x->length - i];
+        unsigned char cy = (unsigned char)y->bytes[y->length - i];
+        if (cx != cy) return cx - cy;
+    }
+    return x->length - y->length;
+}
+
+void irMergeStrings(IRModule* module) {
+    int count = module->stringCount;
+    if (count == 0) return;
+    int* order = malloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) order[i] = i;
+    sortStrings = module->strings;
+    qsort(order, count, sizeof(int), compareReversed);
+
+    // Walking down the order, a string either ends the current base or
+    // starts a new one
+    IRString* base = NULL;
+    for (int i = count - 1; i >= 0; i--) {
+        IRString* s = &module->strings[order[i]];
+        if (base && s->length <= base->length &&
+            memcmp(s->bytes, base->bytes + base->length - s->length, s->length) == 0) {
+            s->base = base->base;
+            s->offset = base->length - s->length;
+        } else {
+            s->base = order[i];
+            s->offset = 0;
+            base = s;
+        }
+    }
+    free(order);
+}
+
+// ============ Functions and blocks ============
+
+static void hashFunction(IRModule* module, IRFunction* fn) {
+    int mask = module->functionHashCapacity - 1;
+    unsigned slot = hashBytes(fn->name, (int)strlen(fn->name)) & mask;
+    while (module->functionHash[slot]) slot = (slot + 1) & mask;
+    module->functionHash[slot] = fn;
+}
+
+// Rebuild the name table at most half full; functions go in in module
+// order, so a lookup finds the first of two with the same name
+static void rehashFunctions(IRModule* module) {
+    free(module->functionHash);
+    module->functionHashCapacity = 64;
+    while (module->functionHashCapacity < module->functionCount * 2) module->functionHashCapacity *= 2;
+    module->functionHash = calloc(module->functionHashCapacity, sizeof(IRFunction*));
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) hashFunction(module, fn);
+}
+
+IRFunction* irCreateFunction(IRModule* module, const char* name, IRType returnType, int paramCount) {
+    IRFunction* fn = calloc(1, sizeof(IRFunction));
+    fn->name = strdup(name);
+    fn->returnType = returnType;
+    fn->paramCount = paramCount;
+    fn->paramTypes = malloc(sizeof(IRType) * (paramCount > 0 ? paramCount : 1));
+    for (int i = 0; i < paramCount; i++) fn->paramTypes[i] = IRT_I64;
+    fn->entryCount = -1;
+    fn->prev = module->lastFunction;
+    if (module->lastFunction) module->lastFunction->next = fn;
+    else module->functions = fn;
+    module->lastFunction = fn;
+    module->functionCount++;
+    if (module->functionHash) {
+        if (module->functionCount * 2 > module->functionHashCapacity) rehashFunctions(module);
+        else hashFunction(module, fn);
+    }
+    return fn;
+}
+
+void irRemoveFunction(IRModule* module, IRFunction* fn) {
+    if (fn->prev) fn->prev->next = fn->next;
+    else module->functions = fn->next;
+    if (fn->next) fn->next->prev = fn->prev;
+    else module->lastFunction = fn->prev;
+    module->functionCount--;
+    // removals come in batches; the next lookup rebuilds the table once
+    free(module->functionHash);
+    module->functionHash = NULL;
+    freeFunction(fn);
+}
+
+IRFunction* irFindFunction(IRModule* module, const char* name) {
+    if (!module->functionHash) rehashFunctions(module);
+    int mask = module->functionHashCapacity - 1;
+    unsigned slot = hashBytes(name, (int)strlen(name)) & mask;
+    for (IRFunction* fn; (fn = module->functionHash[slot]); slot = (slot + 1) & mask) {
+        if (strcmp(fn->name, name) == 0) return fn;
+    }
+    return NULL;
+}
+
+IRBlock* irCreateBlock(IRFunction* fn) {
+    IRBlock* block = calloc(1, sizeof(IRBlock));
+    block->id = fn->nextBlockId++;
+    block->func = fn;
+    block->rpoIndex = -1;
+    block->count = -1;
+    if (fn->lastBlock) fn->lastBlock->next = block;
+    else fn->entry = block;
+    fn->lastBlock = block;
+    return block;
+}
+
+IRBlock* irCreateBlockAfter(IRFunction* fn, IRBlock* after) {
+    IRBlock* block = calloc(1, sizeof(IRBlock));
+    block->id = fn->nextBlockId++;
+    block->func = fn;
+    block->rpoIndex = -1;
+    block->count = -1;
+    block->next = after->next;
+    after->next = block;
+    if (fn->lastBlock == after) fn->lastBlock = block;
+    return block;
+}
+
+IRBlock* irSplitBlock(IRBlock* block, IRInst* at) {
+    IRBlock* tail = irCreateBlockAfter(block->func, block);
+    tail->count = block->count;
+    IRInst* inst = at->next;
+    if (inst) {
+        tail->first = inst;
+        tail->last = block->last;
+        inst->prev = NULL;
+        for (; inst; inst = inst->next) inst->block = tail;
+    }
+    at->next = NULL;
+    block->last = at;
+
+    IRBlock* succs[2];
+    int n = irSuccessors(tail, succs);
+    for (int s = 0; s < n; s++) {
+        for (int i = 0; i < succs[s]->predCount; i++) {
+            if (succs[s]->preds[i] == block) succs[s]->preds[i] = tail;
+        }
+    }
+    return tail;
+}
+
+void irAddPred(IRBlock* block, IRBlock* pred) {
+    if (block->predCount == block->predCapacity) {
+        block->predCapacity = block->predCapacity ? block->predCapacity * 2 : 4;
+        block->preds = realloc(block->preds, sizeof(IRBlock*) * block->predCapacity);
+    }
+    block->preds[block->predCount++] = pred;
+}
+
+// Drop one predecessor edge together with the matching phi operands
+void irRemovePred(IRBlock* block, IRBlock* pred) {
+    int index = -1;
+    for (int i = 0; i < block->predCount; i++) {
+        if (block->preds[i] == pred) { index = i; break; }
+    }
+    if (index < 0) return;
+    for (int i = index; i + 1 < block->predCount; i++) block->preds[i] = block->preds[i + 1];
+    block->predCount--;
+
+    for (IRInst* inst = block->first; inst && inst->op == IR_PHI; inst = inst->next) {
+        for (int i = index; i + 1 < inst->argCount; i++) inst->args[i] = inst->args[i + 1];
+        inst->argCount--;
+    }
+}
+
+// ============ Instructions ============
+
+IRInst* irNewInst(IRFunction* fn, IROpcode op, IRType type) {
+    IRInst* inst = calloc(1, sizeof(IRInst));
+    inst->op = op;
+    inst->type = type;
+    inst->id = fn->nextValueId++;
+    return inst;
+}
+
+void irAddArg(IRInst* inst, IRInst* arg) {
+    if (inst->argCount == inst->argCapacity) {
+        inst->argCapacity = inst->argCapacity ? inst->argCapacity * 2 : 2;
+        inst->args = realloc(inst->args, sizeof(IRInst*) * inst->argCapacity);
+    }
+    inst->args[inst->argCount++] = arg;
+}
+
+void irAppend(IRBlock* block, IRInst* inst) {
+    inst->block = block;
+    inst->next = NULL;
+    inst->prev = block->last;
+    if (block->last) block->last->next = inst;
+    else block->first = inst;
+    block->last = inst;
+}
+
+void irPrepend(IRBlock* block, IRInst* inst) {
+    inst->block = block;
+    inst->prev = NULL;
+    inst->next = block->first;
+    if (block->first) block->first->prev = inst;
+    else block->last = inst;
+    block->first = inst;
+}
+
+void irInsertBefore(IRInst* pos, IRInst* inst) {
+    IRBlock* block = pos->block;
+    inst->block = block;
+    inst->next = pos;
+    inst->prev = pos->prev;
+    if (pos->prev) pos->prev->next = inst;
+    else block->first = inst;
+    pos->prev = inst;
+}
+
+void irUnlink(IRInst* inst) {
+    IRBlock* block = inst->block;
+    if (!block) return;
+    if (inst->prev) inst->prev->next = inst->next;
+    else block->first = inst->next;
+    if (inst->next) inst->next->prev = inst->prev;
+    else block->last = inst->prev;
+    inst->prev = NULL;
+    inst->next = NULL;
+    inst->block = NULL;
+}
+
+void irFreeInst(IRInst* inst) {
+    if (!inst) return;
+    free(inst->args);
+    free(inst);
+}
+
+int irIsTerminator(const IRInst* inst) {
+    return inst->op == IR_JMP || inst->op == IR_BR || inst->op == IR_RET;
+}
+
+int irIsCompare(IROpcode op) {
+    return op >= IR_EQ && op <= IR_GE;
+}
+
+IRInst* irTerminator(IRBlock* block) {
+    if (block->last && irIsTerminator(block->last)) return block->last;
+    return NULL;
+}
+
+int irSuccessors(IRBlock* block, IRBlock** out) {
+    IRInst* term = irTerminator(block);
+    if (!term) return 0;
+    switch (term->op) {
+        case IR_JMP:
+            out[0] = term->targets[0];
+            return 1;
+        case IR_BR:
+            out[0] = term->targets[0];
+            out[1] = term->targets[1];
+            return out[0] == out[1] ? 1 : 2;
+        default:
+            return 0;
+    }
+}
+
+int irHasSideEffects(const IRInst* inst) {
+    if (irIsTerminator(inst) || inst->op == IR_STORE || inst->op == IR_COUNT) return 1;
+    if (inst->op == IR_CALL) {
+        // pure runtime functions (MINO_PURE) may be dropped when unused
+        return !(inst->runtime && inst->runtime->isPure);
+    }
+    return 0;
+}
+
+static IRInst* resolveReplacement(IRInst** replacements, IRInst* value) {
+    while (replacements[value->id] && replacements[value->id] != value) {
+        value = replacements[value->id];
+    }
+    return value;
+}
+
+void irApplyReplacements(IRFunction* fn, IRInst** replacements) {
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            for (int i = 0; i < inst->argCount; i++) {
+                inst->args[i] = resolveReplacement(replacements, inst->args[i]);
+            }
+        }
+    }
+}
+
+// ============ Dominators ============
+
+static void postorder(IRBlock* block, char* visited, IRBlock** order, int* count) {
+    visited[block->id] = 1;
+    IRBlock* succs[2];
+    int n = irSuccessors(block, succs);
+    for (int i = 0; i < n; i++) {
+        if (!visited[succs[i]->id]) postorder(succs[i], visited, order, count);
+    }
+    order[(*count)++] = block;
+}
+
+static IRBlock* intersect(IRBlock* a, IRBlock* b) {
+    while (a != b) {
+        while (a->rpoIndex > b->rpoIndex) a = a->idom;
+        while (b->rpoIndex > a->rpoIndex) b = b->idom;
+    }
+    return a;
+}
+
+// Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm"
+IRBlock** irComputeDominators(IRFunction* fn, int* outCount) {
+    int total = fn->nextBlockId;
+    char* visited = calloc(total > 0 ? total : 1, 1);
+    IRBlock** post = malloc(sizeof(IRBlock*) * (total > 0 ? total : 1));
+    int count = 0;
+
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        block->idom = NULL;
+        block->rpoIndex = -1;
+    }
+    if (fn->entry) postorder(fn->entry, visited, post, &count);
+
+    IRBlock** rpo = malloc(sizeof(IRBlock*) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) {
+        rpo[i] = post[count - 1 - i];
+        rpo[i]->rpoIndex = i;
+    }
+
+    if (count > 0) {
+        rpo[0]->idom = rpo[0];
+        int changed = 1;
+        while (changed) {
+            changed = 0;
+            for (int i = 1; i < count; i++) {
+                IRBlock* block = rpo[i];
+                IRBlock* newIdom = NULL;
+                for (int p = 0; p < block->predCount; p++) {
+                    IRBlock* pred = block->preds[p];
+                    if (pred->rpoIndex < 0 || !pred->idom) continue;
+                    newIdom = newIdom ? intersect(pred, newIdom) : pred;
+                }
+                if (newIdom && block->idom != newIdom) {
+                    block->idom = newIdom;
+                    changed = 1;
+                }
+            }
+        }
+    }
+
+    free(visited);
+    free(post);
+    *outCount = count;
+    return rpo;
+}
+
+int irDominates(IRBlock* a, IRBlock* b) {
+    if (a->rpoIndex < 0 || b->rpoIndex < 0) return 0;
+    while (b != a) {
+        if (b->idom == b || !b->idom) return 0;
+        b = b->idom;
+    }
+    return 1;
+}
+
+// ============ Dump ============
+
+static const char* opNames[IR_OP_COUNT] = {
+    "const", "param", "string", "add", "sub", "mul", "div", "rem",
+    "eq", "ne", "lt", "le", "gt", "ge", "itof", "ftoi",
+    "length", "load", "store", "splat", "hadd",
+    "call", "count", "phi", "jmp", "br", "ret"
+};
+
+const char* irOpName(IROpcode op) {
+    return opNames[op];
+}
+
+const char* irTypeName(IRType type) {
+    switch (type) {
+        case IRT_VOID: return "void";
+        case IRT_I64: return "i64";
+        case IRT_F64: return "f64";
+        case IRT_PTR: return "ptr";
+        case IRT_V2I64: return "v2i64";
+        case IRT_V2F64: return "v2f64";
+    }
+    return "?";
+}
+
+static void dumpEscaped(FILE* out, const IRString* s) {
+    fputc('"', out);
+    for (int i = 0; i < s->length; i++) {
+        unsigned char c = (unsigned char)s->bytes[i];
+        if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+        else if (c == '\n') fprintf(out, "\\n");
+        else if (c < 32 || c >= 127) fprintf(out, "\\%03o", c);
+        else fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void dumpInst(IRModule* module, IRInst* inst, FILE* out) {
+    fprintf(out, "    ");
+    if (inst->type != IRT_VOID && !irIsTerminator(inst)) fprintf(out, "%%%d = ", inst->id);
+    fprintf(out, "%s", opNames[inst->op]);
+
+    switch (inst->op) {
+        case IR_CONST:
+            if (inst->type == IRT_F64) {
+                double d;
+                memcpy(&d, &inst->imm, sizeof(d));
+                fprintf(out, " f64 %g", d);
+            } else {
+                fprintf(out, " %s %lld", irTypeName(inst->type), inst->imm);
+            }
+            break;
+        case IR_PARAM:
+            fprintf(out, " %s %lld", irTypeName(inst->type), inst->imm);
+            break;
+        case IR_STRING:
+            fprintf(out, " .LC%lld ", inst->imm);
+            if (module && inst->imm < module->stringCount) dumpEscaped(out, &module->strings[inst->imm]);
+            break;
+        case IR_CALL:
+            fprintf(out, " %s @%s(", irTypeName(inst->type), inst->sym);
+            for (int i = 0; i < inst->argCount; i++) {
+                fprintf(out, "%s%%%d", i ? ", " : "", inst->args[i]->id);
+            }
+            fprintf(out, ")");
+            break;
+        case IR_PHI:
+            fprintf(out, " %s", irTypeName(inst->type));
+            for (int i = 0; i < inst->argCount; i++) {
+                fprintf(out, "%s [%%%d, bb%d]", i ? "," : "", inst->args[i]->id,
+                        i < inst->block->predCount ? inst->block->preds[i]->id : -1);
+            }
+            break;
+        case IR_COUNT:
+            fprintf(out, " #%lld", inst->imm);
+            break;
+        case IR_JMP:
+            fprintf(out, " bb%d", inst->targets[0]->id);
+            break;
+        case IR_BR:
+            fprintf(out, " %%%d, bb%d, bb%d", inst->args[0]->id,
+                    inst->targets[0]->id, inst->targets[1]->id);
+            break;
+        case IR_RET:
+            if (inst->argCount > 0) fprintf(out, " %s %%%d", irTypeName(inst->args[0]->type), inst->args[0]->id);
+            else fprintf(out, " void");
+            break;
+        default:
+            fprintf(out, " %s", irTypeName(inst->type));
+            for (int i = 0; i < inst->argCount; i++) {
+                fprintf(out, "%s %%%d", i ? "," : "", inst->args[i]->id);
+            }
+            break;
+    }
+    if (inst->line > 0) fprintf(out, "    ; line %d", inst->line);
+    fprintf(out, "\n");
+}
+
+void irDumpFunction(IRModule* module, IRFunction* fn, FILE* out) {
+    fprintf(out, "func %s(%d) -> %s {\n", fn->name, fn->paramCount, irTypeName(fn->returnType));
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        fprintf(out, "bb%d:", block->id);
+        if (block->predCount > 0) {
+            fprintf(out, "    ; preds");
+            for (int i = 0; i < block->predCount; i++) fprintf(out, " bb%d", block->preds[i]->id);
+        }
+        if (block->count >= 0) fprintf(out, "    ; count %lld", block->count);
+        fprintf(out, "\n");
+        for (IRInst* inst = block->first; inst; inst = inst->next) dumpInst(module, inst, out);
+    }
+    fprintf(out, "}\n");
+}
+
+void irDumpModule(IRModule* module, FILE* out) {
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) {
+        irDumpFunction(module, fn, out);
+        if (fn->next) fprintf(out, "\n");
+    }
+}
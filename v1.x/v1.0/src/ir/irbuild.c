@@ -0,0 +1,975 @@
+// src/ir/irbuild.c - lower the checked AST to SSA IR
+//
+// SSA is built directly while walking the AST, following Braun et al.,
+// "Simple and Efficient Construction of Static Single Assignment Form":
+// each block records the current value of every source variable, reads in
+// a block without a local definition look through the predecessors, and
+// phis are only created where control flow actually merges. Blocks whose
+// predecessors are not all known yet stay unsealed and collect incomplete
+// phis until sealBlock.
+//
+// Loops are lowered inverted: a guard tests the condition once, and the
+// test is repeated at the bottom of the body, so each iteration takes one
+// conditional branch. The guard jumps through a preheader block that
+// gives loop passes a place to hoist code to.
+//
+// Array methods are lowered inline to counted loops over the elements,
+// with the lambda's body expanded in the loop body. When map's lambda, or
+// the addend of an int reduce ('(acc, x) => acc + e') or sum, only does
+// lane-wise arithmetic, a first loop handles two elements per iteration
+// in vector values and a scalar loop finishes the odd element.
+//
+// An array literal or map result is fresh: nothing else refers to it yet.
+// A fresh array that is the receiver of a method or .length is freed as
+// soon as that has run. One bound by a declaration is freed at the end of its
+// block, and before a return, when the variable is only ever a receiver;
+// arrays passed to calls, returned or stored elsewhere live until exit.
+//
+// Source variables are the frame slots semantic analysis assigned to each
+// param and local, so a reference indexes the block tables directly.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ir.h>
+#include <namespace.h>
+#include <runtime_abi.h>
+
+typedef struct {
+    IRInst** defs;              // current definition per variable
+    IRInst** incompletePhis;    // per variable, while the block is unsealed
+    int sealed;
+} BlockState;
+
+typedef struct {
+    IRModule* module;
+    IRFunction* fn;
+    IRBlock* current;
+
+    // source variables of the current function, indexed by frame slot
+    IRType* varTypes;
+    int varCount;
+    int varCapacity;
+
+    BlockState* blocks;         // indexed by block id
+    int blockCapacity;
+
+    IRInst** removedPhis;       // trivial phis, freed when the function is done
+    int removedCount;
+    int removedCapacity;
+
+    // per frame slot: the variable is read other than as an array receiver
+    char* escapes;
+    // arrays bound by declarations of the enclosing blocks, freed when they end
+    IRInst** owned;
+    int ownedCount;
+    int ownedCapacity;
+} Builder;
+
+// ============ Types ============
+
+static IRType typeFromToken(TokenType type) {
+    switch (type) {
+        case TOKEN_FLOAT: return IRT_F64;
+        case TOKEN_STRING_TYPE: return IRT_PTR;
+        case TOKEN_VOID: return IRT_VOID;
+        default: return IRT_I64;
+    }
+}
+
+static IRType typeFromNode(ASTNode* typeNode) {
+    if (!typeNode || typeNode->type != NODE_LITERAL) return IRT_I64;
+    if (typeNode->literal.isArray) return IRT_PTR;
+    return typeFromToken(typeNode->literal.token.type);
+}
+
+static IRType vectorOf(IRType lane) {
+    return lane == IRT_F64 ? IRT_V2F64 : IRT_V2I64;
+}
+
+static IRType typeFromAbi(AbiType type) {
+    switch (type) {
+        case ABI_VOID: return IRT_VOID;
+        case ABI_FLOAT:
+        case ABI_DOUBLE: return IRT_F64;
+        case ABI_STRING:
+        case ABI_PTR: return IRT_PTR;
+        default: return IRT_I64;
+    }
+}
+
+// ============ Blocks and variables ============
+
+static IRBlock* newBlock(Builder* b) {
+    IRBlock* block = irCreateBlock(b->fn);
+    if (block->id >= b->blockCapacity) {
+        int old = b->blockCapacity;
+        b->blockCapacity = b->blockCapacity ? b->blockCapacity * 2 : 8;
+        while (b->blockCapacity <= block->id) b->blockCapacity *= 2;
+        b->blocks = realloc(b->blocks, sizeof(BlockState) * b->blockCapacity);
+        memset(&b->blocks[old], 0, sizeof(BlockState) * (b->blockCapacity - old));
+    }
+    BlockState* state = &b->blocks[block->id];
+    state->defs = calloc(b->varCount > 0 ? b->varCount : 1, sizeof(IRInst*));
+    state->incompletePhis = calloc(b->varCount > 0 ? b->varCount : 1, sizeof(IRInst*));
+    state->sealed = 0;
+    return block;
+}
+
+static int declareVariable(Builder* b, int slot, IRType type) {
+    b->varTypes[slot] = type;
+    return slot;
+}
+
+static IRInst* emit(Builder* b, IROpcode op, IRType type, int line) {
+    IRInst* inst = irNewInst(b->fn, op, type);
+    inst->line = line;
+    irAppend(b->current, inst);
+    return inst;
+}
+
+static IRInst* emitConst(Builder* b, IRType type, long long value, int line) {
+    IRInst* inst = emit(b, IR_CONST, type, line);
+    inst->imm = value;
+    return inst;
+}
+
+// ============ SSA construction ============
+
+// Undefined values become zero constants at the top of the entry block,
+// which dominates every use
+static IRInst* undefinedValue(Builder* b, IRType type) {
+    IRInst* value = irNewInst(b->fn, IR_CONST, type);
+    IRBlock* entry = b->fn->entry;
+    if (entry->first) irInsertBefore(entry->first, value);
+    else irAppend(entry, value);
+    return value;
+}
+
+static IRInst* readVariable(Builder* b, int var, IRBlock* block);
+
+static void writeVariable(Builder* b, int var, IRBlock* block, IRInst* value) {
+    b->blocks[block->id].defs[var] = value;
+}
+
+// Replace every use of a removed phi, including the builder's own tables
+static void replacePhiUses(Builder* b, IRInst* phi, IRInst* value) {
+    for (IRBlock* block = b->fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            for (int i = 0; i < inst->argCount; i++) {
+                if (inst->args[i] == phi) inst->args[i] = value;
+            }
+        }
+        BlockState* state = &b->blocks[block->id];
+        for (int v = 0; v < b->varCount; v++) {
+            if (state->defs[v] == phi) state->defs[v] = value;
+        }
+    }
+}
+
+static IRInst* tryRemoveTrivialPhi(Builder* b, IRInst* phi) {
+    IRInst* same = NULL;
+    for (int i = 0; i < phi->argCount; i++) {
+        IRInst* op = phi->args[i];
+        if (op == same || op == phi) continue;
+        if (same) return phi;   // merges at least two values
+        same = op;
+    }
+    // unreachable or undefined: the value is never observed
+    if (!same) same = undefinedValue(b, phi->type);
+
+    // Phis that used this one may become trivial in turn
+    IRInst** users = NULL;
+    int userCount = 0;
+    for (IRBlock* block = b->fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst && inst->op == IR_PHI; inst = inst->next) {
+            if (inst == phi) continue;
+            for (int i = 0; i < inst->argCount; i++) {
+                if (inst->args[i] == phi) {
+                    users = realloc(users, sizeof(IRInst*) * (userCount + 1));
+                    users[userCount++] = inst;
+                    break;
+                }
+            }
+        }
+    }
+
+    replacePhiUses(b, phi, same);
+    irUnlink(phi);
+    if (b->removedCount == b->removedCapacity) {
+        b->removedCapacity = b->removedCapacity ? b->removedCapacity * 2 : 8;
+        b->removedPhis = realloc(b->removedPhis, sizeof(IRInst*) * b->removedCapacity);
+    }
+    b->removedPhis[b->removedCount++] = phi;
+
+    for (int i = 0; i < userCount; i++) {
+        if (users[i]->block) tryRemoveTrivialPhi(b, users[i]);
+    }
+    free(users);
+    return same;
+}
+
+static IRInst* addPhiOperands(Builder* b, int var, IRInst* phi) {
+    IRBlock* block = phi->block;
+    for (int i = 0; i < block->predCount; i++) {
+        irAddArg(phi, readVariable(b, var, block->preds[i]));
+    }
+    return tryRemoveTrivialPhi(b, phi);
+}
+
+static IRInst* newPhi(Builder* b, IRBlock* block, IRType type) {
+    IRInst* phi = irNewInst(b->fn, IR_PHI, type);
+    irPrepend(block, phi);
+    return phi;
+}
+
+static IRInst* readVariableRecursive(Builder* b, int var, IRBlock* block, IRType type) {
+    IRInst* value;
+    BlockState* state = &b->blocks[block->id];
+    if (!state->sealed) {
+        value = newPhi(b, block, type);
+        state->incompletePhis[var] = value;
+    } else if (block->predCount == 1) {
+        value = readVariable(b, var, block->preds[0]);
+    } else if (block->predCount == 0) {
+        // read before any definition: behaves as zero
+        value = undefinedValue(b, type);
+    } else {
+        IRInst* phi = newPhi(b, block, type);
+        writeVariable(b, var, block, phi);
+        addPhiOperands(b, var, phi);
+        // Removing the phi can make phis that use it trivial in turn,
+        // including the one it was replaced by; the block's table follows
+        // every replacement
+        value = b->blocks[block->id].defs[var];
+    }
+    writeVariable(b, var, block, value);
+    return value;
+}
+
+static IRInst* readVariable(Builder* b, int var, IRBlock* block) {
+    IRInst* value = b->blocks[block->id].defs[var];
+    if (value) return value;
+    return readVariableRecursive(b, var, block, b->varTypes[var]);
+}
+
+static void sealBlock(Builder* b, IRBlock* block) {
+    BlockState* state = &b->blocks[block->id];
+    for (int v = 0; v < b->varCount; v++) {
+        IRInst* phi = state->incompletePhis[v];
+        if (phi) {
+            state->incompletePhis[v] = NULL;
+            addPhiOperands(b, v, phi);
+        }
+    }
+    state->sealed = 1;
+}
+
+// ============ Array lifetimes ============
+
+static void emitArrayFree(Builder* b, IRInst* array, int line) {
+    IRInst* call = emit(b, IR_CALL, IRT_VOID, line);
+    call->sym = "sys_array_free";
+    call->runtime = lookupRuntimeFunc(call->sym);
+    irAddArg(call, array);
+}
+
+static int isFreshArray(ASTNode* node) {
+    return node && (node->type == NODE_ARRAY_LITERAL ||
+                    (node->type == NODE_CALL_EXPR && node->call.arrayMethod == ARRAY_METHOD_MAP));
+}
+
+// The array an array method or .length reads, NULL for other nodes
+static ASTNode* arrayReceiver(ASTNode* node) {
+    if (node->type == NODE_CALL_EXPR && node->call.arrayMethod != ARRAY_METHOD_NONE) {
+        return node->call.callee->get.object;
+    }
+    if (node->type == NODE_GET_EXPR && node->get.isLength) return node->get.object;
+    return NULL;
+}
+
+// Mark the slots of the variables `node` reads other than as a receiver
+static void findEscapes(ASTNode* node, char* escapes) {
+    if (!node) return;
+    ASTNode* receiver = arrayReceiver(node);
+    if (receiver && receiver->type != NODE_VARIABLE) findEscapes(receiver, escapes);
+    switch (node->type) {
+        case NODE_VARIABLE:
+            if (node->varRef.slot >= 0) escapes[node->varRef.slot] = 1;
+            break;
+        case NODE_CALL_EXPR:
+            if (!receiver) findEscapes(node->call.callee, escapes);
+            for (int i = 0; i < node->call.argCount; i++) findEscapes(node->call.args[i], escapes);
+            break;
+        case NODE_GET_EXPR:
+            if (!receiver) findEscapes(node->get.object, escapes);
+            break;
+        case NODE_VAR_DECL:
+            findEscapes(node->variable.initializer, escapes);
+            break;
+        case NODE_BINARY_EXPR:
+            findEscapes(node->binary.left, escapes);
+            findEscapes(node->binary.right, escapes);
+            break;
+        case NODE_UNARY_EXPR:
+            findEscapes(node->unary.operand, escapes);
+            break;
+        case NODE_ASSIGN:
+            findEscapes(node->assignment.target, escapes);
+            findEscapes(node->assignment.value, escapes);
+            break;
+        case NODE_RETURN_STMT:
+            findEscapes(node->returnStmt.value, escapes);
+            break;
+        case NODE_PROGRAM:
+            for (int i = 0; i < node->program.count; i++) findEscapes(node->program.statements[i], escapes);
+            break;
+        case NODE_BLOCK_STMT:
+            for (int i = 0; i < node->block.count; i++) findEscapes(node->block.statements[i], escapes);
+            break;
+        case NODE_WHILE_STMT:
+            findEscapes(node->loop.init, escapes);
+            findEscapes(node->loop.condition, escapes);
+            findEscapes(node->loop.step, escapes);
+            findEscapes(node->loop.body, escapes);
+            break;
+        case NODE_ARRAY_LITERAL:
+            for (int i = 0; i < node->array.count; i++) findEscapes(node->array.elements[i], escapes);
+            break;
+        case NODE_LAMBDA:
+            findEscapes(node->lambda.body, escapes);
+            break;
+        default:
+            break;
+    }
+}
+
+// Free the arrays owned since `mark`, newest first
+static void freeOwnedArrays(Builder* b, int mark, int line) {
+    for (int i = b->ownedCount - 1; i >= mark; i--) emitArrayFree(b, b->owned[i], line);
+}
+
+// ============ Expressions ============
+
+// Linker symbol for a callee: plain names are used as-is, dotted chains use
+// the flattened name cached on the GET node (e.g. sys_IO_print_PrintInt)
+static const char* getCalleeSymbol(ASTNode* callee) {
+    if (!callee) return NULL;
+    if (callee->type == NODE_VARIABLE) return callee->varRef.name;
+    if (callee->type == NODE_GET_EXPR) {
+        if (callee->get.linkName) return callee->get.linkName;
+        NamespaceNode* ns = resolveQualifiedName(callee);
+        return ns ? ns->linkName : NULL;
+    }
+    return NULL;
+}
+
+static IRInst* lowerExpression(Builder* b, ASTNode* node);
+static IRInst* lowerArrayLiteral(Builder* b, ASTNode* node);
+static IRInst* lowerArrayMethod(Builder* b, ASTNode* node);
+
+// Values used as operands must exist; void calls read as zero
+static IRInst* valueOf(Builder* b, IRInst* value, int line) {
+    if (value->type != IRT_VOID) return value;
+    return emitConst(b, IRT_I64, 0, line);
+}
+
+static IRInst* lowerCall(Builder* b, ASTNode* node) {
+    int line = node->line;
+    const char* target = getCalleeSymbol(node->call.callee);
+    if (!target) {
+        fprintf(stderr, "[line %d] Error: unsupported callee\n", line);
+        return emitConst(b, IRT_I64, 0, line);
+    }
+
+    // Runtime exports carry C types; Mino functions use their declared types
+    const RuntimeFunc* runtime = node->call.runtime;
+    if (!runtime && node->call.callee->type == NODE_GET_EXPR) runtime = lookupRuntimeFunc(target);
+    IRType type = IRT_I64;
+    if (runtime) {
+        type = typeFromAbi(runtime->ret);
+    } else {
+        ASTNode* decl = node->call.function;
+        if (decl && decl->function.returnType) type = typeFromNode(decl->function.returnType);
+    }
+
+    // Evaluate arguments left to right before the call
+    IRInst** args = malloc(sizeof(IRInst*) * (node->call.argCount > 0 ? node->call.argCount : 1));
+    for (int i = 0; i < node->call.argCount; i++) {
+        args[i] = valueOf(b, lowerExpression(b, node->call.args[i]), line);
+    }
+
+    IRInst* call = emit(b, IR_CALL, type, line);
+    call->sym = target;
+    call->runtime = runtime;
+    for (int i = 0; i < node->call.argCount; i++) irAddArg(call, args[i]);
+    free(args);
+    return call;
+}
+
+static IRInst* lowerLiteral(Builder* b, ASTNode* node) {
+    Token t = node->literal.token;
+    int line = node->line;
+    if (node->literal.folded) return emitConst(b, IRT_I64, node->literal.value, line);
+
+    switch (t.type) {
+        case TOKEN_NUMBER: {
+            char buf[64] = {0};
+            snprintf(buf, sizeof(buf), "%.*s", t.length, t.start);
+            if (strchr(buf, '.')) {
+                // float literal: the constant holds the IEEE double bit pattern
+                double d = strtod(buf, NULL);
+                long long bits;
+                memcpy(&bits, &d, sizeof(bits));
+                return emitConst(b, IRT_F64, bits, line);
+            }
+            return emitConst(b, IRT_I64, strtoll(buf, NULL, 10), line);
+        }
+        case TOKEN_STRING: {
+            // token text includes the surrounding quotes
+            IRInst* str = emit(b, IR_STRING, IRT_PTR, line);
+            str->imm = irModuleString(b->module, t.start + 1, t.length - 2);
+            return str;
+        }
+        case TOKEN_TRUE:
+            return emitConst(b, IRT_I64, 1, line);
+        default:
+            return emitConst(b, IRT_I64, 0, line);
+    }
+}
+
+static IRInst* lowerExpression(Builder* b, ASTNode* node) {
+    if (!node) return emitConst(b, IRT_I64, 0, 0);
+    switch (node->type) {
+        case NODE_LITERAL:
+            return lowerLiteral(b, node);
+        case NODE_VARIABLE: {
+            // names without a slot (e.g. non-constant globals) read as zero
+            if (node->varRef.slot < 0) return emitConst(b, IRT_I64, 0, node->line);
+            return readVariable(b, node->varRef.slot, b->current);
+        }
+        case NODE_BINARY_EXPR: {
+            IRInst* left = valueOf(b, lowerExpression(b, node->binary.left), node->line);
+            IRInst* right = valueOf(b, lowerExpression(b, node->binary.right), node->line);
+            IROpcode op;
+            switch (node->binary.op.type) {
+                case TOKEN_PLUS: op = IR_ADD; break;
+                case TOKEN_MINUS: op = IR_SUB; break;
+                case TOKEN_STAR: op = IR_MUL; break;
+                case TOKEN_SLASH: op = IR_DIV; break;
+                case TOKEN_PERCENT: op = IR_REM; break;
+                case TOKEN_EQUAL_EQUAL: op = IR_EQ; break;
+                case TOKEN_BANG_EQUAL: op = IR_NE; break;
+                case TOKEN_LESS: op = IR_LT; break;
+                case TOKEN_LESS_EQUAL: op = IR_LE; break;
+                case TOKEN_GREATER: op = IR_GT; break;
+                case TOKEN_GREATER_EQUAL: op = IR_GE; break;
+                default:
+                    fprintf(stderr, "[line %d] Error: unsupported binary operator\n", node->line);
+                    return emitConst(b, IRT_I64, 0, node->line);
+            }
+            IRType type = (left->type == IRT_F64 || right->type == IRT_F64) ? IRT_F64 : IRT_I64;
+            if (irIsCompare(op)) type = IRT_I64;
+            IRInst* inst = emit(b, op, type, node->binary.op.line);
+            irAddArg(inst, left);
+            irAddArg(inst, right);
+            return inst;
+        }
+        case NODE_UNARY_EXPR: {
+            IRInst* operand = valueOf(b, lowerExpression(b, node->unary.operand), node->line);
+            IRType type = node->unary.op.type == TOKEN_FLOAT ? IRT_F64 : IRT_I64;
+            if (operand->type == type) return operand;
+            IRInst* inst = emit(b, type == IRT_F64 ? IR_ITOF : IR_FTOI, type, node->line);
+            irAddArg(inst, operand);
+            return inst;
+        }
+        case NODE_CALL_EXPR:
+            if (node->call.arrayMethod != ARRAY_METHOD_NONE) return lowerArrayMethod(b, node);
+            return lowerCall(b, node);
+        case NODE_ARRAY_LITERAL:
+            return lowerArrayLiteral(b, node);
+        case NODE_GET_EXPR:
+            if (node->get.isLength) {
+                IRInst* array = valueOf(b, lowerExpression(b, node->get.object), node->line);
+                IRInst* length = emit(b, IR_LENGTH, IRT_I64, node->line);
+                irAddArg(length, array);
+                if (isFreshArray(node->get.object)) emitArrayFree(b, array, node->line);
+                return length;
+            }
+            return emitConst(b, IRT_I64, 0, node->line);
+        default:
+            // member access outside a call and other forms have no value yet
+            return emitConst(b, IRT_I64, 0, node->line);
+    }
+}
+
+// ============ Statements ============
+
+// Code after a return lands in a fresh block with no predecessors
+static void startUnreachableBlock(Builder* b) {
+    b->current = newBlock(b);
+    sealBlock(b, b->current);
+}
+
+static void lowerStatement(Builder* b, ASTNode* node);
+
+// A missing condition (for (;;)) is always true
+static IRInst* lowerCondition(Builder* b, ASTNode* condition, int line) {
+    if (!condition) return emitConst(b, IRT_I64, 1, line);
+    return valueOf(b, lowerExpression(b, condition), line);
+}
+
+static IRInst* emitBranch(Builder* b, IRInst* cond, IRBlock* ifTrue, int line) {
+    IRInst* br = emit(b, IR_BR, IRT_VOID, line);
+    irAddArg(br, cond);
+    br->targets[0] = ifTrue;
+    irAddPred(ifTrue, b->current);
+    return br;
+}
+
+//   guard:     init; br cond, preheader, exit
+//   preheader: jmp header
+//   header:    body...; step; br cond, header, exit
+//   exit:
+static void lowerLoop(Builder* b, ASTNode* node) {
+    int line = node->line;
+    lowerStatement(b, node->loop.init);
+
+    IRBlock* guard = b->current;
+    IRBlock* preheader = newBlock(b);
+    IRInst* skip = emitBranch(b, lowerCondition(b, node->loop.condition, line), preheader, line);
+    sealBlock(b, preheader);
+
+    // the header stays unsealed until the back edge exists
+    b->current = preheader;
+    IRBlock* header = newBlock(b);
+    IRInst* enter = emit(b, IR_JMP, IRT_VOID, line);
+    enter->targets[0] = header;
+    irAddPred(header, preheader);
+
+    b->current = header;
+    lowerStatement(b, node->loop.body);
+    lowerStatement(b, node->loop.step);
+    IRBlock* latch = b->current;
+    IRInst* again = emitBranch(b, lowerCondition(b, node->loop.condition, line), header, line);
+    sealBlock(b, header);
+
+    // created after the body so the loop is laid out contiguously
+    IRBlock* exit = newBlock(b);
+    skip->targets[1] = exit;
+    again->targets[1] = exit;
+    irAddPred(exit, guard);
+    irAddPred(exit, latch);
+    sealBlock(b, exit);
+    b->current = exit;
+}
+
+// ============ Arrays ============
+
+static IRInst* emitBinary(Builder* b, IROpcode op, IRType type, IRInst* left, IRInst* right, int line) {
+    IRInst* inst = emit(b, op, type, line);
+    irAddArg(inst, left);
+    irAddArg(inst, right);
+    return inst;
+}
+
+static IRInst* emitSplat(Builder* b, IRType vector, IRInst* scalar, int line) {
+    IRInst* splat = emit(b, IR_SPLAT, vector, line);
+    irAddArg(splat, scalar);
+    return splat;
+}
+
+static IRInst* emitArrayNew(Builder* b, IRInst* length, int line) {
+    IRInst* call = emit(b, IR_CALL, IRT_PTR, line);
+    call->sym = "sys_array_new";
+    call->runtime = lookupRuntimeFunc(call->sym);
+    irAddArg(call, length);
+    return call;
+}
+
+static IRInst* emitLoad(Builder* b, IRType type, IRInst* array, IRInst* index, int line) {
+    return emitBinary(b, IR_LOAD, type, array, index, line);
+}
+
+static void emitStore(Builder* b, IRInst* array, IRInst* index, IRInst* value, int line) {
+    IRInst* store = emitBinary(b, IR_STORE, IRT_VOID, array, index, line);
+    irAddArg(store, value);
+}
+
+static IRInst* lowerArrayLiteral(Builder* b, ASTNode* node) {
+    int line = node->line;
+    IRInst* array = emitArrayNew(b, emitConst(b, IRT_I64, node->array.count, line), line);
+    for (int i = 0; i < node->array.count; i++) {
+        IRInst* value = valueOf(b, lowerExpression(b, node->array.elements[i]), line);
+        emitStore(b, array, emitConst(b, IRT_I64, i, line), value, line);
+    }
+    return array;
+}
+
+// A counted loop 'for (i = start; i < limit; i += step)' over frame slot
+// `var`, shaped like lowerLoop's
+typedef struct {
+    int var;
+    IRInst* limit;
+    long long step;
+    IRBlock* guard;
+    IRBlock* header;
+    IRInst* skip;
+    int line;
+} CountedLoop;
+
+// Emit the guard and open the loop body; returns the index
+static IRInst* beginCountedLoop(Builder* b, CountedLoop* loop, int var, IRInst* start,
+                                IRInst* limit, long long step, int line) {
+    loop->var = declareVariable(b, var, IRT_I64);
+    loop->limit = limit;
+    loop->step = step;
+    loop->line = line;
+    writeVariable(b, var, b->current, start);
+
+    loop->guard = b->current;
+    IRBlock* preheader = newBlock(b);
+    loop->skip = emitBranch(b, emitBinary(b, IR_LT, IRT_I64, start, limit, line), preheader, line);
+    sealBlock(b, preheader);
+
+    b->current = preheader;
+    loop->header = newBlock(b);
+    IRInst* enter = emit(b, IR_JMP, IRT_VOID, line);
+    enter->targets[0] = loop->header;
+    irAddPred(loop->header, preheader);
+
+    b->current = loop->header;
+    return readVariable(b, var, loop->header);
+}
+
+// Step the index and close the loop; code continues after it
+static void endCountedLoop(Builder* b, CountedLoop* loop) {
+    int line = loop->line;
+    IRInst* index = readVariable(b, loop->var, b->current);
+    IRInst* next = emitBinary(b, IR_ADD, IRT_I64, index, emitConst(b, IRT_I64, loop->step, line), line);
+    writeVariable(b, loop->var, b->current, next);
+    IRBlock* latch = b->current;
+    IRInst* again = emitBranch(b, emitBinary(b, IR_LT, IRT_I64, next, loop->limit, line), loop->header, line);
+    sealBlock(b, loop->header);
+
+    IRBlock* exit = newBlock(b);
+    loop->skip->targets[1] = exit;
+    again->targets[1] = exit;
+    irAddPred(exit, loop->guard);
+    irAddPred(exit, latch);
+    sealBlock(b, exit);
+    b->current = exit;
+}
+
+// Expand a lambda on `args`: its params are frame slots like any local
+static IRInst* applyLambda(Builder* b, ASTNode* lambda, IRInst** args) {
+    for (int i = 0; i < lambda->lambda.paramCount; i++) {
+        int var = declareVariable(b, lambda->lambda.params[i]->variable.slot, args[i]->type);
+        writeVariable(b, var, b->current, args[i]);
+    }
+    return lowerExpression(b, lambda->lambda.body);
+}
+
+static int isFloatLiteral(Token token) {
+    for (int i = 0; i < token.length; i++) {
+        if (token.start[i] == '.') return 1;
+    }
+    return 0;
+}
+
+// Whether `node` can be evaluated on two lanes of type `lane` at once: it
+// combines the element (slot `element`), numeric literals and variables
+// other than `excluded` with + and - on ints, or + - * / on floats
+static int isVectorizable(Builder* b, ASTNode* node, IRType lane, int element, int excluded) {
+    if (!node) return 0;
+    switch (node->type) {
+        case NODE_LITERAL:
+            if (node->literal.folded) return lane == IRT_I64;
+            if (node->literal.token.type != TOKEN_NUMBER) return 0;
+            return (isFloatLiteral(node->literal.token) ? IRT_F64 : IRT_I64) == lane;
+        case NODE_VARIABLE: {
+            int slot = node->varRef.slot;
+            if (slot == element) return 1;
+            return slot >= 0 && slot != excluded && b->varTypes[slot] == lane;
+        }
+        case NODE_BINARY_EXPR: {
+            TokenType op = node->binary.op.type;
+            int ok = op == TOKEN_PLUS || op == TOKEN_MINUS ||
+                     (lane == IRT_F64 && (op == TOKEN_STAR || op == TOKEN_SLASH));
+            return ok && isVectorizable(b, node->binary.left, lane, element, excluded) &&
+                   isVectorizable(b, node->binary.right, lane, element, excluded);
+        }
+        default:
+            return 0;
+    }
+}
+
+// Lower a vectorizable expression with the element slot bound to the
+// vector `elements`; everything else is the same in both lanes
+static IRInst* lowerVector(Builder* b, ASTNode* node, IRType vector, int element, IRInst* elements) {
+    int line = node->line;
+    if (node->type == NODE_BINARY_EXPR) {
+        IRInst* left = lowerVector(b, node->binary.left, vector, element, elements);
+        IRInst* right = lowerVector(b, node->binary.right, vector, element, elements);
+        IROpcode op = node->binary.op.type == TOKEN_PLUS ? IR_ADD :
+                      node->binary.op.type == TOKEN_MINUS ? IR_SUB :
+                      node->binary.op.type == TOKEN_STAR ? IR_MUL : IR_DIV;
+        return emitBinary(b, op, vector, left, right, node->binary.op.line);
+    }
+    if (node->type == NODE_VARIABLE && node->varRef.slot == element) return elements;
+
+    return emitSplat(b, vector, valueOf(b, lowerExpression(b, node), line), line);
+}
+
+// '(acc, x) => acc + e' or '(acc, x) => e + acc' where e does not read acc
+// and is vectorizable: returns e, which can be summed two lanes at a time
+static ASTNode* reduceAddend(Builder* b, ASTNode* lambda, IRType lane) {
+    ASTNode* body = lambda->lambda.body;
+    int acc = lambda->lambda.params[0]->variable.slot;
+    int element = lambda->lambda.params[1]->variable.slot;
+    if (lane != IRT_I64 || body->type != NODE_BINARY_EXPR || body->binary.op.type != TOKEN_PLUS) return NULL;
+
+    ASTNode* left = body->binary.left;
+    ASTNode* right = body->binary.right;
+    if (left->type == NODE_VARIABLE && left->varRef.slot == acc &&
+        isVectorizable(b, right, lane, element, acc)) return right;
+    if (right->type == NODE_VARIABLE && right->varRef.slot == acc &&
+        isVectorizable(b, left, lane, element, acc)) return left;
+    return NULL;
+}
+
+static void lowerEach(Builder* b, ASTNode* node, IRInst* array, IRInst* length, IRType lane) {
+    int line = node->line;
+    CountedLoop loop;
+    IRInst* index = beginCountedLoop(b, &loop, node->call.slot, emitConst(b, IRT_I64, 0, line), length, 1, line);
+    IRInst* element = emitLoad(b, lane, array, index, line);
+    applyLambda(b, node->call.args[0], &element);
+    endCountedLoop(b, &loop);
+}
+
+static IRInst* lowerMap(Builder* b, ASTNode* node, IRInst* array, IRInst* length, IRType lane) {
+    int line = node->line;
+    ASTNode* lambda = node->call.args[0];
+    int element = lambda->lambda.params[0]->variable.slot;
+    IRInst* result = emitArrayNew(b, length, line);
+    IRInst* start = emitConst(b, IRT_I64, 0, line);
+    CountedLoop loop;
+
+    if ((lane == IRT_I64 || lane == IRT_F64) && isVectorizable(b, lambda->lambda.body, lane, element, -1)) {
+        // two elements per iteration while i + 1 < length
+        IRInst* limit = emitBinary(b, IR_SUB, IRT_I64, length, emitConst(b, IRT_I64, 1, line), line);
+        IRInst* index = beginCountedLoop(b, &loop, node->call.slot, start, limit, 2, line);
+        IRInst* elements = emitLoad(b, vectorOf(lane), array, index, line);
+        IRInst* value = lowerVector(b, lambda->lambda.body, vectorOf(lane), element, elements);
+        emitStore(b, result, index, value, line);
+        endCountedLoop(b, &loop);
+        start = readVariable(b, node->call.slot, b->current);
+    }
+
+    IRInst* index = beginCountedLoop(b, &loop, node->call.slot, start, length, 1, line);
+    IRInst* value = emitLoad(b, lane, array, index, line);
+    value = valueOf(b, applyLambda(b, lambda, &value), line);
+    emitStore(b, result, index, value, line);
+    endCountedLoop(b, &loop);
+    return result;
+}
+
+// reduce(init, lambda), or sum() when lambda is NULL
+static IRInst* lowerReduce(Builder* b, ASTNode* node, IRInst* array, IRInst* length,
+                           IRType lane, IRInst* init, ASTNode* lambda) {
+    int line = node->line;
+    int acc = declareVariable(b, node->call.slot + 1, init->type);
+    int vacc = declareVariable(b, node->call.slot + 2, IRT_V2I64);
+    writeVariable(b, acc, b->current, init);
+    IRInst* start = emitConst(b, IRT_I64, 0, line);
+    CountedLoop loop;
+
+    // int additions reassociate freely, so two partial sums run side by side
+    ASTNode* addend = lambda ? reduceAddend(b, lambda, lane) : NULL;
+    if (lane == IRT_I64 && init->type == IRT_I64 && (addend || !lambda)) {
+        int element = lambda ? lambda->lambda.params[1]->variable.slot : -1;
+        writeVariable(b, vacc, b->current, emitSplat(b, IRT_V2I64, emitConst(b, IRT_I64, 0, line), line));
+
+        IRInst* limit = emitBinary(b, IR_SUB, IRT_I64, length, emitConst(b, IRT_I64, 1, line), line);
+        IRInst* index = beginCountedLoop(b, &loop, node->call.slot, start, limit, 2, line);
+        IRInst* elements = emitLoad(b, IRT_V2I64, array, index, line);
+        IRInst* value = addend ? lowerVector(b, addend, IRT_V2I64, element, elements) : elements;
+        writeVariable(b, vacc, b->current,
+                      emitBinary(b, IR_ADD, IRT_V2I64, readVariable(b, vacc, b->current), value, line));
+        endCountedLoop(b, &loop);
+
+        IRInst* partial = readVariable(b, vacc, b->current);
+        IRInst* total = emit(b, IR_HADD, IRT_I64, line);
+        irAddArg(total, partial);
+        writeVariable(b, acc, b->current,
+                      emitBinary(b, IR_ADD, IRT_I64, readVariable(b, acc, b->current), total, line));
+        start = readVariable(b, node->call.slot, b->current);
+    }
+
+    // the rest in order, one element at a time
+    IRInst* index = beginCountedLoop(b, &loop, node->call.slot, start, length, 1, line);
+    IRInst* args[2] = {readVariable(b, acc, b->current), emitLoad(b, lane, array, index, line)};
+    IRInst* value = lambda ? valueOf(b, applyLambda(b, lambda, args), line)
+                           : emitBinary(b, IR_ADD, lane, args[0], args[1], line);
+    writeVariable(b, acc, b->current, value);
+    endCountedLoop(b, &loop);
+    return readVariable(b, acc, b->current);
+}
+
+static IRInst* lowerArrayMethod(Builder* b, ASTNode* node) {
+    int line = node->line;
+    IRInst* array = valueOf(b, lowerExpression(b, node->call.callee->get.object), line);
+    IRInst* length = emit(b, IR_LENGTH, IRT_I64, line);
+    irAddArg(length, array);
+    IRType lane = typeFromToken(node->call.elementType);
+
+    IRInst* result;
+    switch (node->call.arrayMethod) {
+        case ARRAY_METHOD_EACH:
+            lowerEach(b, node, array, length, lane);
+            result = emitConst(b, IRT_I64, 0, line);
+            break;
+        case ARRAY_METHOD_MAP:
+            result = lowerMap(b, node, array, length, lane);
+            break;
+        case ARRAY_METHOD_REDUCE: {
+            IRInst* init = valueOf(b, lowerExpression(b, node->call.args[0]), line);
+            result = lowerReduce(b, node, array, length, lane, init, node->call.args[1]);
+            break;
+        }
+        default:
+            result = lowerReduce(b, node, array, length, lane,
+                                 emitConst(b, lane, 0, line), NULL);
+            break;
+    }
+    if (isFreshArray(node->call.callee->get.object)) emitArrayFree(b, array, line);
+    return result;
+}
+
+static void lowerStatement(Builder* b, ASTNode* node) {
+    if (!node) return;
+    switch (node->type) {
+        case NODE_VAR_DECL: {
+            IRInst* value;
+            if (node->variable.initializer) {
+                value = valueOf(b, lowerExpression(b, node->variable.initializer), node->line);
+            } else {
+                value = emitConst(b, typeFromNode(node->variable.type), 0, node->line);
+            }
+            int var = declareVariable(b, node->variable.slot, value->type);
+            writeVariable(b, var, b->current, value);
+            if (isFreshArray(node->variable.initializer) && !b->escapes[var]) {
+                if (b->ownedCount == b->ownedCapacity) {
+                    b->ownedCapacity = b->ownedCapacity ? b->ownedCapacity * 2 : 16;
+                    b->owned = realloc(b->owned, sizeof(IRInst*) * b->ownedCapacity);
+                }
+                b->owned[b->ownedCount++] = value;
+            }
+            break;
+        }
+        case NODE_RETURN_STMT: {
+            IRInst* value = NULL;
+            if (node->returnStmt.value) {
+                value = valueOf(b, lowerExpression(b, node->returnStmt.value), node->line);
+            }
+            freeOwnedArrays(b, 0, node->line);
+            IRInst* ret = emit(b, IR_RET, IRT_VOID, node->line);
+            // a void function evaluates the expression but returns nothing
+            if (value && b->fn->returnType != IRT_VOID) irAddArg(ret, value);
+            startUnreachableBlock(b);
+            break;
+        }
+        case NODE_PROGRAM:
+            for (int i = 0; i < node->program.count; i++) lowerStatement(b, node->program.statements[i]);
+            break;
+        case NODE_BLOCK_STMT: {
+            int mark = b->ownedCount;
+            for (int i = 0; i < node->block.count; i++) lowerStatement(b, node->block.statements[i]);
+            freeOwnedArrays(b, mark, node->line);
+            b->ownedCount = mark;
+            break;
+        }
+        case NODE_WHILE_STMT:
+            lowerLoop(b, node);
+            break;
+        case NODE_ASSIGN: {
+            IRInst* value = valueOf(b, lowerExpression(b, node->assignment.value), node->line);
+            int var = node->assignment.target->varRef.slot;
+            if (var >= 0) writeVariable(b, var, b->current, value);
+            break;
+        }
+        case NODE_CALL_EXPR:
+        case NODE_BINARY_EXPR:
+        case NODE_UNARY_EXPR:
+        case NODE_VARIABLE:
+        case NODE_ARRAY_LITERAL:
+        case NODE_GET_EXPR:
+            lowerExpression(b, node);
+            break;
+        default:
+            break;
+    }
+}
+
+static void lowerFunction(Builder* b, ASTNode* func) {
+    IRType returnType = func->function.returnType ? typeFromNode(func->function.returnType) : IRT_I64;
+    b->fn = irCreateFunction(b->module, func->function.name, returnType, func->function.paramCount);
+    b->fn->inlineHint = func->function.inlineHint;
+    b->fn->line = func->line;
+    b->varCount = func->function.slotCount;
+    if (b->varCount > b->varCapacity) {
+        b->varCapacity = b->varCount;
+        b->varTypes = realloc(b->varTypes, sizeof(IRType) * b->varCapacity);
+    }
+    b->removedCount = 0;
+    b->escapes = calloc(b->varCount > 0 ? b->varCount : 1, 1);
+    findEscapes(func->function.body, b->escapes);
+    b->ownedCount = 0;
+
+    b->current = newBlock(b);
+    sealBlock(b, b->current);
+
+    for (int i = 0; i < func->function.paramCount; i++) {
+        ASTNode* param = func->function.params[i];
+        IRInst* value = emit(b, IR_PARAM, typeFromNode(param->variable.type), func->line);
+        value->imm = i;
+        b->fn->paramTypes[i] = value->type;
+        writeVariable(b, declareVariable(b, param->variable.slot, value->type), b->current, value);
+    }
+
+    lowerStatement(b, func->function.body);
+
+    // Falling off the end returns 0 (0.0 has the same bits)
+    if (!irTerminator(b->current)) {
+        IRInst* zero = emitConst(b, returnType == IRT_F64 ? IRT_F64 : IRT_I64, 0, 0);
+        IRInst* ret = emit(b, IR_RET, IRT_VOID, 0);
+        if (returnType != IRT_VOID) irAddArg(ret, zero);
+    }
+
+    free(b->escapes);
+    b->escapes = NULL;
+    for (int i = 0; i < b->removedCount; i++) irFreeInst(b->removedPhis[i]);
+    for (int i = 0; i < b->fn->nextBlockId; i++) {
+        free(b->blocks[i].defs);
+        free(b->blocks[i].incompletePhis);
+        b->blocks[i].defs = NULL;
+        b->blocks[i].incompletePhis = NULL;
+    }
+}
+
+IRModule* irBuildModule(ASTNode* program) {
+    if (!program) return NULL;
+    Builder b;
+    memset(&b, 0, sizeof(b));
+    b.module = irCreateModule();
+
+    for (int i = 0; i < program->program.count; i++) {
+        ASTNode* s = program->program.statements[i];
+        if (s && s->type == NODE_FUNCTION_DECL) lowerFunction(&b, s);
+    }
+
+    free(b.varTypes);
+    free(b.blocks);
+    free(b.removedPhis);
+    free(b.owned);
+    return b.module;
+}
@@ -0,0 +1,200 @@
+// src/ir/irverify.c - structural, type and SSA checks for the IR
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ir.h>
+
+static int verifyError(IRFunction* fn, IRBlock* block, IRInst* inst, const char* message) {
+    fprintf(stderr, "IR verify error in %s", fn->name);
+    if (block) fprintf(stderr, ", bb%d", block->id);
+    if (inst) fprintf(stderr, ", %%%d (%s)", inst->id, irOpName(inst->op));
+    fprintf(stderr, ": %s\n", message);
+    return 0;
+}
+
+static int isArithmetic(IROpcode op) {
+    return op == IR_ADD || op == IR_SUB || op == IR_MUL || op == IR_DIV || op == IR_REM;
+}
+
+static int isVector(IRType type) {
+    return type == IRT_V2I64 || type == IRT_V2F64;
+}
+
+static int hasPred(IRBlock* block, IRBlock* pred) {
+    for (int i = 0; i < block->predCount; i++) {
+        if (block->preds[i] == pred) return 1;
+    }
+    return 0;
+}
+
+// def must be available at the end of block (phi operands) or before use.
+// Blocks are checked in order, so within the use's block `seen` holds
+// exactly the instructions that come before it.
+static int dominatesUse(IRInst* def, IRInst* use, IRBlock* useBlock, const char* seen) {
+    if (def->block != useBlock) return irDominates(def->block, useBlock);
+    if (!use) return 1;   // end of block
+    return def != use && def->id >= 0 && def->id < useBlock->func->nextValueId && seen[def->id];
+}
+
+int irVerifyFunction(IRFunction* fn) {
+    int ok = 1;
+    int count = 0;
+    IRBlock** rpo = irComputeDominators(fn, &count);
+    free(rpo);
+
+    char* seen = calloc(fn->nextValueId > 0 ? fn->nextValueId : 1, 1);
+
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        if (block->func != fn) ok = verifyError(fn, block, NULL, "block belongs to another function");
+        if (!irTerminator(block)) ok = verifyError(fn, block, NULL, "block does not end in a terminator");
+
+        // every successor lists this block as a predecessor, and back
+        IRBlock* succs[2];
+        int succCount = irSuccessors(block, succs);
+        for (int i = 0; i < succCount; i++) {
+            if (!hasPred(succs[i], block)) ok = verifyError(fn, block, NULL, "successor is missing the predecessor edge");
+        }
+        for (int i = 0; i < block->predCount; i++) {
+            IRBlock* pred = block->preds[i];
+            IRBlock* predSuccs[2];
+            int n = irSuccessors(pred, predSuccs);
+            int found = 0;
+            for (int s = 0; s < n; s++) if (predSuccs[s] == block) found = 1;
+            if (!found) ok = verifyError(fn, block, NULL, "predecessor does not branch here");
+        }
+
+        int phisDone = 0;
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            if (inst->block != block) ok = verifyError(fn, block, inst, "instruction has a stale block pointer");
+            if (inst->id < 0 || inst->id >= fn->nextValueId || seen[inst->id]) {
+                ok = verifyError(fn, block, inst, "value number is out of range or reused");
+            } else {
+                seen[inst->id] = 1;
+            }
+            if (irIsTerminator(inst) && inst->next) ok = verifyError(fn, block, inst, "terminator in the middle of a block");
+
+            if (inst->op == IR_PHI) {
+                if (phisDone) ok = verifyError(fn, block, inst, "phi after a non-phi instruction");
+                if (inst->argCount != block->predCount) ok = verifyError(fn, block, inst, "phi operand count differs from predecessor count");
+            } else {
+                phisDone = 1;
+            }
+
+            for (int i = 0; i < inst->argCount; i++) {
+                IRInst* arg = inst->args[i];
+                if (!arg || !arg->block) {
+                    ok = verifyError(fn, block, inst, "operand refers to a removed instruction");
+                    continue;
+                }
+                if (arg->block->func != fn) {
+                    ok = verifyError(fn, block, inst, "operand defined in another function");
+                    continue;
+                }
+                if (arg->type == IRT_VOID) ok = verifyError(fn, block, inst, "operand has no value");
+                if (block->rpoIndex < 0) continue;   // unreachable code is not checked for dominance
+                if (inst->op == IR_PHI) {
+                    if (i < block->predCount && block->preds[i]->rpoIndex >= 0 &&
+                        !dominatesUse(arg, NULL, block->preds[i], seen)) {
+                        ok = verifyError(fn, block, inst, "phi operand does not dominate its predecessor");
+                    }
+                } else if (!dominatesUse(arg, inst, block, seen)) {
+                    ok = verifyError(fn, block, inst, "operand does not dominate its use");
+                }
+            }
+
+            // Types
+            if (isArithmetic(inst->op) && isVector(inst->type)) {
+                // lane-wise; SSE2 has no 64-bit integer multiply or divide
+                if (inst->argCount != 2) ok = verifyError(fn, block, inst, "arithmetic needs two operands");
+                if (inst->op == IR_REM || (inst->type == IRT_V2I64 && inst->op != IR_ADD && inst->op != IR_SUB)) {
+                    ok = verifyError(fn, block, inst, "vector operation is not supported");
+                }
+                for (int i = 0; i < inst->argCount; i++) {
+                    if (inst->args[i]->type != inst->type) ok = verifyError(fn, block, inst, "vector operand has the wrong type");
+                }
+            } else if (isArithmetic(inst->op)) {
+                if (inst->argCount != 2) ok = verifyError(fn, block, inst, "arithmetic needs two operands");
+                if (inst->type != IRT_I64 && inst->type != IRT_F64) ok = verifyError(fn, block, inst, "arithmetic on a non-numeric type");
+                for (int i = 0; i < inst->argCount; i++) {
+                    IRType t = inst->args[i]->type;
+                    if (t != IRT_I64 && t != IRT_F64) ok = verifyError(fn, block, inst, "arithmetic operand is not numeric");
+                }
+            }
+            if (inst->op == IR_LENGTH) {
+                if (inst->argCount != 1 || inst->args[0]->type != IRT_PTR) ok = verifyError(fn, block, inst, "length needs an array");
+                if (inst->type != IRT_I64) ok = verifyError(fn, block, inst, "length is not an integer");
+            }
+            if (inst->op == IR_LOAD || inst->op == IR_STORE) {
+                int count = inst->op == IR_LOAD ? 2 : 3;
+                if (inst->argCount != count || inst->args[0]->type != IRT_PTR || inst->args[1]->type != IRT_I64) {
+                    ok = verifyError(fn, block, inst, "element access needs an array and an integer index");
+                } else if (inst->op == IR_STORE && inst->type != IRT_VOID) {
+                    ok = verifyError(fn, block, inst, "store produces a value");
+                } else if (inst->op == IR_LOAD && inst->type == IRT_VOID) {
+                    ok = verifyError(fn, block, inst, "load without a type");
+                }
+            }
+            if (inst->op == IR_SPLAT) {
+                IRType lane = inst->type == IRT_V2I64 ? IRT_I64 : IRT_F64;
+                if (!isVector(inst->type)) ok = verifyError(fn, block, inst, "splat result is not a vector");
+                else if (inst->argCount != 1 || inst->args[0]->type != lane) ok = verifyError(fn, block, inst, "splat operand is not a lane");
+            }
+            if (inst->op == IR_HADD) {
+                if (inst->argCount != 1 || inst->args[0]->type != IRT_V2I64) ok = verifyError(fn, block, inst, "hadd needs an int vector");
+                if (inst->type != IRT_I64) ok = verifyError(fn, block, inst, "hadd result is not an integer");
+            }
+            if (inst->op == IR_COUNT && (inst->argCount != 0 || inst->type != IRT_VOID || inst->imm < 0)) {
+                ok = verifyError(fn, block, inst, "malformed profile counter");
+            }
+            if (irIsCompare(inst->op)) {
+                if (inst->argCount != 2) ok = verifyError(fn, block, inst, "comparison needs two operands");
+                if (inst->type != IRT_I64) ok = verifyError(fn, block, inst, "comparison result is not an integer");
+                if (inst->argCount == 2 && inst->args[0]->type != inst->args[1]->type) {
+                    ok = verifyError(fn, block, inst, "comparison operands differ in type");
+                }
+                for (int i = 0; i < inst->argCount; i++) {
+                    IRType t = inst->args[i]->type;
+                    if (t != IRT_I64 && t != IRT_F64) ok = verifyError(fn, block, inst, "comparison operand is not numeric");
+                }
+            }
+            if (inst->op == IR_ITOF || inst->op == IR_FTOI) {
+                IRType from = inst->op == IR_ITOF ? IRT_I64 : IRT_F64;
+                IRType to = inst->op == IR_ITOF ? IRT_F64 : IRT_I64;
+                if (inst->argCount != 1) ok = verifyError(fn, block, inst, "conversion needs one operand");
+                else if (inst->args[0]->type != from) ok = verifyError(fn, block, inst, "conversion operand has the wrong type");
+                if (inst->type != to) ok = verifyError(fn, block, inst, "conversion result has the wrong type");
+            }
+            if (inst->op == IR_PHI) {
+                for (int i = 0; i < inst->argCount; i++) {
+                    if (inst->args[i]->type != inst->type && inst->args[i]->type != IRT_VOID) {
+                        ok = verifyError(fn, block, inst, "phi operand type differs from the phi");
+                    }
+                }
+            }
+            if ((inst->op == IR_CONST || inst->op == IR_PARAM || inst->op == IR_STRING) && inst->type == IRT_VOID) {
+                ok = verifyError(fn, block, inst, "value without a type");
+            }
+            if (inst->op == IR_PARAM && (inst->imm < 0 || inst->imm >= fn->paramCount)) {
+                ok = verifyError(fn, block, inst, "parameter index out of range");
+            }
+            if (inst->op == IR_CALL && !inst->sym) ok = verifyError(fn, block, inst, "call without a target");
+            if (inst->op == IR_BR && inst->argCount != 1) ok = verifyError(fn, block, inst, "branch needs a condition");
+            if ((inst->op == IR_JMP || inst->op == IR_BR) && !inst->targets[0]) ok = verifyError(fn, block, inst, "branch without a target");
+            if (inst->op == IR_RET) {
+                if (inst->argCount > 1) ok = verifyError(fn, block, inst, "return with more than one value");
+                if (fn->returnType == IRT_VOID && inst->argCount > 0) ok = verifyError(fn, block, inst, "value returned from a void function");
+            }
+        }
+    }
+
+    free(seen);
+    return ok;
+}
+
+int irVerifyModule(IRModule* module) {
+    int ok = 1;
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) {
+        if (!irVerifyFunction(fn)) ok = 0;
+    }
+    return ok;
+}
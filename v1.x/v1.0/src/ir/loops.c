@@ -0,0 +1,321 @@
+// src/ir/loops.c - natural loops and the loop passes
+//
+// A loop is found from its back edges (edges whose target dominates their
+// source): the header is the target, and the body is every block that
+// reaches a back edge without passing through the header. Both passes
+// need a preheader, the single block outside the loop that enters the
+// header and has no other successor; irbuild creates one for every
+// while and for loop.
+//
+//   licm     move instructions whose operands are all defined outside
+//            the loop into the preheader
+//   indvars  for a basic induction variable i = phi(init, i +/- step),
+//            replace each i * k by a new variable j = phi(init*k, j +/- step*k),
+//            so the multiply becomes one add per iteration
+//
+// Loops are processed innermost first, so an expression hoisted out of an
+// inner loop can continue out of the loops around it.
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ir.h>
+
+typedef struct {
+    IRBlock* header;
+    IRBlock* preheader;         // NULL: nowhere to move code to
+    char* inBody;               // indexed by block id
+    int size;                   // blocks in the body
+} Loop;
+
+typedef struct {
+    IRBlock** rpo;              // reachable blocks, dominators first
+    int blockCount;
+    Loop* loops;                // innermost first
+    int loopCount;
+} LoopInfo;
+
+static void remark(IRModule* module, IRInst* inst, const char* format, ...) {
+    if (!module->remarks) return;
+    va_list args;
+    va_start(args, format);
+    fprintf(module->remarks, "[line %d] ", inst->line);
+    vfprintf(module->remarks, format, args);
+    fprintf(module->remarks, "\n");
+    va_end(args);
+}
+
+// ============ Loop discovery ============
+
+static int compareLoopSize(const void* a, const void* b) {
+    return ((const Loop*)a)->size - ((const Loop*)b)->size;
+}
+
+static void findLoops(IRFunction* fn, LoopInfo* info) {
+    info->rpo = irComputeDominators(fn, &info->blockCount);
+    info->loops = NULL;
+    info->loopCount = 0;
+    int total = fn->nextBlockId > 0 ? fn->nextBlockId : 1;
+    IRBlock** work = malloc(sizeof(IRBlock*) * total);
+
+    for (int b = 0; b < info->blockCount; b++) {
+        IRBlock* header = info->rpo[b];
+        Loop loop = {header, NULL, NULL, 0};
+        int top = 0;
+        for (int p = 0; p < header->predCount; p++) {
+            IRBlock* latch = header->preds[p];
+            if (!irDominates(header, latch)) continue;
+            if (!loop.inBody) {
+                loop.inBody = calloc(total, 1);
+                loop.inBody[header->id] = 1;
+                loop.size = 1;
+            }
+            if (!loop.inBody[latch->id]) {
+                loop.inBody[latch->id] = 1;
+                loop.size++;
+                work[top++] = latch;
+            }
+        }
+        if (!loop.inBody) continue;
+
+        // Walk backwards from the latches; the header stops the walk
+        while (top > 0) {
+            IRBlock* block = work[--top];
+            for (int p = 0; p < block->predCount; p++) {
+                IRBlock* pred = block->preds[p];
+                if (pred->rpoIndex < 0 || loop.inBody[pred->id]) continue;
+                loop.inBody[pred->id] = 1;
+                loop.size++;
+                work[top++] = pred;
+            }
+        }
+
+        IRBlock* outside = NULL;
+        int outsideCount = 0;
+        for (int p = 0; p < header->predCount; p++) {
+            if (!loop.inBody[header->preds[p]->id]) {
+                outside = header->preds[p];
+                outsideCount++;
+            }
+        }
+        IRBlock* succs[2];
+        if (outsideCount == 1 && irSuccessors(outside, succs) == 1) loop.preheader = outside;
+
+        info->loops = realloc(info->loops, sizeof(Loop) * (info->loopCount + 1));
+        info->loops[info->loopCount++] = loop;
+    }
+    free(work);
+
+    // A nested loop has fewer blocks than every loop around it
+    if (info->loopCount > 1) qsort(info->loops, info->loopCount, sizeof(Loop), compareLoopSize);
+}
+
+static void freeLoops(LoopInfo* info) {
+    for (int i = 0; i < info->loopCount; i++) free(info->loops[i].inBody);
+    free(info->loops);
+    free(info->rpo);
+}
+
+static int definedIn(Loop* loop, IRInst* value) {
+    return value->block && loop->inBody[value->block->id];
+}
+
+// ============ licm ============
+
+// Whether the block runs on every iteration that leaves the loop, i.e. it
+// dominates every block with an edge out of the body
+static int runsEveryIteration(LoopInfo* info, Loop* loop, IRBlock* block) {
+    for (int b = 0; b < info->blockCount; b++) {
+        IRBlock* exiting = info->rpo[b];
+        if (!loop->inBody[exiting->id]) continue;
+        IRBlock* succs[2];
+        int n = irSuccessors(exiting, succs);
+        for (int i = 0; i < n; i++) {
+            if (!loop->inBody[succs[i]->id] && !irDominates(block, exiting)) return 0;
+        }
+    }
+    return 1;
+}
+
+static int isHoistable(LoopInfo* info, Loop* loop, IRInst* inst) {
+    int speculative = 0;        // could trap or is expensive if the loop skips it
+    switch (inst->op) {
+        case IR_CONST:
+        case IR_STRING:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_ITOF:
+        case IR_FTOI:
+        case IR_LENGTH:         // every array value points at a live array
+        case IR_SPLAT:
+        case IR_HADD:
+            break;
+        case IR_DIV:
+        case IR_REM: {
+            // a constant divisor other than 0 and -1 cannot fault; float division never does
+            IRInst* divisor = inst->args[1];
+            speculative = inst->type == IRT_I64 &&
+                          (divisor->op != IR_CONST || divisor->imm == 0 || divisor->imm == -1);
+            break;
+        }
+        case IR_CALL:
+            if (irHasSideEffects(inst)) return 0;
+            speculative = 1;
+            break;
+        default:
+            return 0;
+    }
+    for (int i = 0; i < inst->argCount; i++) {
+        if (definedIn(loop, inst->args[i])) return 0;
+    }
+    return !speculative || runsEveryIteration(info, loop, inst->block);
+}
+
+static int hoistInvariants(IRModule* module, LoopInfo* info, Loop* loop) {
+    IRInst* anchor = irTerminator(loop->preheader);
+    int changed = 0;
+    // Dominators first, so an invariant's operands have already moved
+    for (int b = 0; b < info->blockCount; b++) {
+        IRBlock* block = info->rpo[b];
+        if (!loop->inBody[block->id]) continue;
+        IRInst* inst = block->first;
+        while (inst) {
+            IRInst* next = inst->next;
+            if (isHoistable(info, loop, inst)) {
+                if (inst->op != IR_CONST && inst->op != IR_STRING) {
+                    remark(module, inst, "hoisted %%%d (%s) out of the loop", inst->id, irOpName(inst->op));
+                }
+                irUnlink(inst);
+                irInsertBefore(anchor, inst);
+                changed = 1;
+            }
+            inst = next;
+        }
+    }
+    return changed;
+}
+
+int irPassLICM(IRModule* module, IRFunction* fn) {
+    LoopInfo info;
+    findLoops(fn, &info);
+    int changed = 0;
+    for (int i = 0; i < info.loopCount; i++) {
+        Loop* loop = &info.loops[i];
+        if (loop->preheader && irTerminator(loop->preheader)) changed |= hoistInvariants(module, &info, loop);
+    }
+    freeLoops(&info);
+    return changed;
+}
+
+// ============ indvars ============
+
+static int predIndex(IRBlock* block, IRBlock* pred) {
+    for (int i = 0; i < block->predCount; i++) {
+        if (block->preds[i] == pred) return i;
+    }
+    return -1;
+}
+
+static IRInst* insertBinary(IRFunction* fn, IRInst* pos, IROpcode op, IRInst* a, IRInst* b, int line) {
+    IRInst* inst = irNewInst(fn, op, IRT_I64);
+    inst->line = line;
+    irAddArg(inst, a);
+    irAddArg(inst, b);
+    irInsertBefore(pos, inst);
+    return inst;
+}
+
+// The invariant step of a basic induction variable, NULL if `phi` is not one
+static IRInst* inductionStep(Loop* loop, IRInst* phi, IRInst* next) {
+    if (next->op != IR_ADD && next->op != IR_SUB) return NULL;
+    IRInst* step = NULL;
+    if (next->args[0] == phi) step = next->args[1];
+    else if (next->op == IR_ADD && next->args[1] == phi) step = next->args[0];
+    if (!step || step == phi || definedIn(loop, step)) return NULL;
+    return step;
+}
+
+// Multiplies replaced so far, applied once every loop has been visited
+typedef struct {
+    IRInst** from;
+    IRInst** to;
+    int count;
+} Reductions;
+
+static void reduceInductionVariables(IRModule* module, IRFunction* fn, LoopInfo* info,
+                                     Loop* loop, Reductions* done) {
+    IRBlock* header = loop->header;
+    if (header->predCount != 2) return;
+    int entry = predIndex(header, loop->preheader);
+    int back = 1 - entry;
+    IRInst* anchor = irTerminator(loop->preheader);
+
+    for (IRInst* phi = header->first; phi && phi->op == IR_PHI; phi = phi->next) {
+        if (phi->type != IRT_I64 || phi->argCount != 2) continue;
+        IRInst* init = phi->args[entry];
+        IRInst* next = phi->args[back];
+        IRInst* step = inductionStep(loop, phi, next);
+        if (!step) continue;
+
+        for (int b = 0; b < info->blockCount; b++) {
+            IRBlock* block = info->rpo[b];
+            if (!loop->inBody[block->id]) continue;
+            for (IRInst* mul = block->first; mul; mul = mul->next) {
+                if (mul->op != IR_MUL || mul->type != IRT_I64) continue;
+                IRInst* scale = mul->args[0] == phi ? mul->args[1] : mul->args[1] == phi ? mul->args[0] : NULL;
+                if (!scale || definedIn(loop, scale)) continue;
+
+                // j = phi(init * k, j +/- step * k) tracks i * k
+                IRInst* start = insertBinary(fn, anchor, IR_MUL, init, scale, mul->line);
+                IRInst* stride = insertBinary(fn, anchor, IR_MUL, step, scale, mul->line);
+                IRInst* scaled = irNewInst(fn, IR_PHI, IRT_I64);
+                irPrepend(header, scaled);
+                IRInst* advance = irNewInst(fn, next->op, IRT_I64);
+                advance->line = next->line;
+                irAddArg(advance, scaled);
+                irAddArg(advance, stride);
+                if (next->next) irInsertBefore(next->next, advance);
+                else irAppend(next->block, advance);
+                irAddArg(scaled, entry == 0 ? start : advance);
+                irAddArg(scaled, entry == 0 ? advance : start);
+
+                remark(module, mul, "strength-reduced %%%d = %%%d * %%%d to an induction variable",
+                       mul->id, phi->id, scale->id);
+                done->from = realloc(done->from, sizeof(IRInst*) * (done->count + 1));
+                done->to = realloc(done->to, sizeof(IRInst*) * (done->count + 1));
+                done->from[done->count] = mul;
+                done->to[done->count++] = scaled;
+            }
+        }
+    }
+}
+
+int irPassIndVars(IRModule* module, IRFunction* fn) {
+    LoopInfo info;
+    findLoops(fn, &info);
+    Reductions done = {NULL, NULL, 0};
+    for (int i = 0; i < info.loopCount; i++) {
+        Loop* loop = &info.loops[i];
+        if (loop->preheader && irTerminator(loop->preheader)) {
+            reduceInductionVariables(module, fn, &info, loop, &done);
+        }
+    }
+
+    int changed = done.count > 0;
+    if (changed) {
+        IRInst** replacements = calloc(fn->nextValueId, sizeof(IRInst*));
+        for (int i = 0; i < done.count; i++) replacements[done.from[i]->id] = done.to[i];
+        irApplyReplacements(fn, replacements);
+        free(replacements);
+    }
+    free(done.from);
+    free(done.to);
+    freeLoops(&info);
+    return changed;
+}
@@ -0,0 +1,475 @@
+// src/ir/passes.c - pass manager and the scalar IR passes
+// (the inliner lives in inline.c, the loop passes in loops.c)
+//
+//   fold  constant arithmetic, comparisons and conversions, algebraic
+//         identities, trivial phis and branches on constants
+//   cse   dominator-scoped common-subexpression elimination
+//   dce   unreachable blocks and unused side-effect-free values
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ir.h>
+
+// ============ Pass manager ============
+
+void irInitPassManager(IRPassManager* pm) {
+    memset(pm, 0, sizeof(IRPassManager));
+    pm->verifyEach = 1;
+}
+
+void irAddPass(IRPassManager* pm, const char* name, IRPassFn run) {
+    if (pm->count >= IR_MAX_PASSES) {
+        fprintf(stderr, "Too many IR passes (max %d)\n", IR_MAX_PASSES);
+        return;
+    }
+    pm->passes[pm->count].name = name;
+    pm->passes[pm->count].run = run;
+    pm->count++;
+}
+
+void irAddDefaultPasses(IRPassManager* pm) {
+    irAddPass(pm, "inline", irPassInline);
+    irAddPass(pm, "fold", irPassFold);
+    irAddPass(pm, "cse", irPassCSE);
+    irAddPass(pm, "licm", irPassLICM);
+    irAddPass(pm, "indvars", irPassIndVars);
+    irAddPass(pm, "dce", irPassDCE);
+}
+
+#define MAX_PIPELINE_ROUNDS 4
+
+int irRunPasses(IRPassManager* pm, IRModule* module) {
+    // Only what main reaches is optimized and, once inlining has removed
+    // more calls, compiled
+    irRemoveUnreachableFunctions(module);
+
+    // Callees are optimized first, so the inliner copies finished bodies
+    int count = 0;
+    IRFunction** order = irCallGraphOrder(module, &count);
+    for (int f = 0; f < count; f++) {
+        IRFunction* fn = order[f];
+        // repeat the pipeline while it keeps finding work
+        for (int round = 0; round < MAX_PIPELINE_ROUNDS; round++) {
+            int changed = 0;
+            for (int i = 0; i < pm->count; i++) {
+                if (pm->passes[i].run(module, fn)) changed = 1;
+                if (pm->verifyEach && !irVerifyFunction(fn)) {
+                    fprintf(stderr, "IR verification failed after pass '%s'\n", pm->passes[i].name);
+                    free(order);
+                    return 0;
+                }
+            }
+            if (!changed) break;
+        }
+    }
+    free(order);
+    irRemoveUnreachableFunctions(module);
+    return 1;
+}
+
+// ============ fold ============
+
+static int isConst(IRInst* inst, long long value) {
+    return inst->op == IR_CONST && inst->type == IRT_I64 && inst->imm == value;
+}
+
+static void makeConst(IRInst* inst, long long value) {
+    inst->op = IR_CONST;
+    inst->argCount = 0;
+    inst->imm = value;
+}
+
+// Fold integer arithmetic and comparisons on constants (two's complement
+// wraparound); division by zero is left for run time
+static int foldArithmetic(IRInst* inst, IRInst** replacements) {
+    if (inst->type != IRT_I64) return 0;
+    IRInst* a = inst->args[0];
+    IRInst* b = inst->args[1];
+    int constA = a->op == IR_CONST && a->type == IRT_I64;
+    int constB = b->op == IR_CONST && b->type == IRT_I64;
+
+    if (constA && constB) {
+        unsigned long long x = (unsigned long long)a->imm;
+        unsigned long long y = (unsigned long long)b->imm;
+        switch (inst->op) {
+            case IR_ADD: makeConst(inst, (long long)(x + y)); return 1;
+            case IR_SUB: makeConst(inst, (long long)(x - y)); return 1;
+            case IR_MUL: makeConst(inst, (long long)(x * y)); return 1;
+            case IR_DIV:
+                if (b->imm == 0 || (a->imm == (long long)(1ULL << 63) && b->imm == -1)) return 0;
+                makeConst(inst, a->imm / b->imm);
+                return 1;
+            case IR_REM:
+                if (b->imm == 0 || (a->imm == (long long)(1ULL << 63) && b->imm == -1)) return 0;
+                makeConst(inst, a->imm % b->imm);
+                return 1;
+            case IR_EQ: makeConst(inst, a->imm == b->imm); return 1;
+            case IR_NE: makeConst(inst, a->imm != b->imm); return 1;
+            case IR_LT: makeConst(inst, a->imm < b->imm); return 1;
+            case IR_LE: makeConst(inst, a->imm <= b->imm); return 1;
+            case IR_GT: makeConst(inst, a->imm > b->imm); return 1;
+            case IR_GE: makeConst(inst, a->imm >= b->imm); return 1;
+            default:
+                return 0;
+        }
+    }
+
+    // x+0, 0+x, x-0, x*1, 1*x, x/1 => x; x*0, 0*x, x%1, x%-1 => 0
+    IRInst* same = NULL;
+    switch (inst->op) {
+        case IR_ADD:
+            if (isConst(b, 0)) same = a;
+            else if (isConst(a, 0)) same = b;
+            break;
+        case IR_SUB:
+            if (isConst(b, 0)) same = a;
+            break;
+        case IR_MUL:
+            if (isConst(b, 1)) same = a;
+            else if (isConst(a, 1)) same = b;
+            else if (isConst(a, 0) || isConst(b, 0)) { makeConst(inst, 0); return 1; }
+            break;
+        case IR_DIV:
+            if (isConst(b, 1)) same = a;
+            break;
+        case IR_REM:
+            if (isConst(b, 1) || isConst(b, -1)) { makeConst(inst, 0); return 1; }
+            break;
+        default:
+            break;
+    }
+    if (same && same->type == inst->type) {
+        replacements[inst->id] = same;
+        return 1;
+    }
+    return 0;
+}
+
+static double floatValue(IRInst* inst) {
+    double value;
+    memcpy(&value, &inst->imm, sizeof(double));
+    return value;
+}
+
+static void makeFloatConst(IRInst* inst, double value) {
+    long long bits;
+    memcpy(&bits, &value, sizeof(double));
+    makeConst(inst, bits);
+}
+
+// Float arithmetic and comparisons on constants, evaluated in double like
+// the generated code would. No identities: x+0.0 and x*1.0 are not x for
+// every x (-0.0, NaN).
+static int foldFloatArithmetic(IRInst* inst) {
+    IRInst* a = inst->args[0];
+    IRInst* b = inst->args[1];
+    if (a->op != IR_CONST || a->type != IRT_F64 || b->op != IR_CONST || b->type != IRT_F64) return 0;
+    double x = floatValue(a);
+    double y = floatValue(b);
+    switch (inst->op) {
+        case IR_ADD: makeFloatConst(inst, x + y); return 1;
+        case IR_SUB: makeFloatConst(inst, x - y); return 1;
+        case IR_MUL: makeFloatConst(inst, x * y); return 1;
+        case IR_DIV: makeFloatConst(inst, x / y); return 1;
+        case IR_EQ: makeConst(inst, x == y); return 1;
+        case IR_NE: makeConst(inst, x != y); return 1;
+        case IR_LT: makeConst(inst, x < y); return 1;
+        case IR_LE: makeConst(inst, x <= y); return 1;
+        case IR_GT: makeConst(inst, x > y); return 1;
+        case IR_GE: makeConst(inst, x >= y); return 1;
+        default:
+            return 0;
+    }
+}
+
+// A float -> int conversion is only folded when cvttsd2si would not
+// produce its out-of-range value
+static int foldConversion(IRInst* inst) {
+    IRInst* operand = inst->args[0];
+    if (operand->op != IR_CONST) return 0;
+    if (inst->op == IR_ITOF) {
+        makeFloatConst(inst, (double)operand->imm);
+        return 1;
+    }
+    double value = floatValue(operand);
+    if (isnan(value) || value < -9223372036854775808.0 || value >= 9223372036854775808.0) return 0;
+    makeConst(inst, (long long)value);
+    return 1;
+}
+
+// A phi whose operands are all the same value (or itself) is that value
+static int foldPhi(IRInst* phi, IRInst** replacements) {
+    IRInst* same = NULL;
+    for (int i = 0; i < phi->argCount; i++) {
+        IRInst* op = phi->args[i];
+        while (replacements[op->id] && replacements[op->id] != op) op = replacements[op->id];
+        if (op == same || op == phi) continue;
+        if (same) return 0;
+        same = op;
+    }
+    if (!same || replacements[phi->id]) return 0;
+    replacements[phi->id] = same;
+    return 1;
+}
+
+static int foldBranch(IRInst* br) {
+    IRInst* cond = br->args[0];
+    if (cond->op != IR_CONST) return 0;
+    IRBlock* taken = cond->imm != 0 ? br->targets[0] : br->targets[1];
+    IRBlock* dropped = cond->imm != 0 ? br->targets[1] : br->targets[0];
+    if (taken != dropped) irRemovePred(dropped, br->block);
+    br->op = IR_JMP;
+    br->argCount = 0;
+    br->targets[0] = taken;
+    br->targets[1] = NULL;
+    return 1;
+}
+
+int irPassFold(IRModule* module, IRFunction* fn) {
+    (void)module;
+    int changed = 0;
+    IRInst** replacements = calloc(fn->nextValueId > 0 ? fn->nextValueId : 1, sizeof(IRInst*));
+
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            // operands may already have been replaced earlier in this pass
+            for (int i = 0; i < inst->argCount; i++) {
+                IRInst* op = inst->args[i];
+                while (replacements[op->id] && replacements[op->id] != op) op = replacements[op->id];
+                inst->args[i] = op;
+            }
+            switch (inst->op) {
+                case IR_ADD:
+                case IR_SUB:
+                case IR_MUL:
+                case IR_DIV:
+                case IR_REM:
+                case IR_EQ:
+                case IR_NE:
+                case IR_LT:
+                case IR_LE:
+                case IR_GT:
+                case IR_GE:
+                    if (inst->type == IRT_F64 || inst->args[0]->type == IRT_F64) changed |= foldFloatArithmetic(inst);
+                    else changed |= foldArithmetic(inst, replacements);
+                    break;
+                case IR_ITOF:
+                case IR_FTOI:
+                    changed |= foldConversion(inst);
+                    break;
+                case IR_PHI:
+                    changed |= foldPhi(inst, replacements);
+                    break;
+                case IR_BR:
+                    changed |= foldBranch(inst);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (changed) irApplyReplacements(fn, replacements);
+    free(replacements);
+    return changed;
+}
+
+// ============ cse ============
+
+static int isCseCandidate(IRInst* inst) {
+    switch (inst->op) {
+        case IR_CONST:
+        case IR_STRING:
+        case IR_PARAM:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_REM:
+        case IR_EQ:
+        case IR_NE:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_ITOF:
+        case IR_FTOI:
+        case IR_LENGTH:         // an array never changes length
+        case IR_SPLAT:
+        case IR_HADD:
+            return 1;
+        case IR_CALL:
+            return !irHasSideEffects(inst);
+        default:
+            return 0;
+    }
+}
+
+static unsigned int hashInst(IRInst* inst) {
+    unsigned int h = 2166136261u;
+    h = (h ^ (unsigned int)inst->op) * 16777619;
+    h = (h ^ (unsigned int)inst->type) * 16777619;
+    h = (h ^ (unsigned int)inst->imm) * 16777619;
+    h = (h ^ (unsigned int)((unsigned long long)inst->imm >> 32)) * 16777619;
+    if (inst->sym) {
+        for (const char* p = inst->sym; *p; p++) h = (h ^ (unsigned char)*p) * 16777619;
+    }
+    // commutative operators hash their operands order-independently
+    if (inst->op == IR_ADD || inst->op == IR_MUL) {
+        h ^= (unsigned int)(inst->args[0]->id * 2654435761u + inst->args[1]->id * 2654435761u);
+    } else {
+        for (int i = 0; i < inst->argCount; i++) h = (h ^ (unsigned int)inst->args[i]->id) * 16777619;
+    }
+    return h;
+}
+
+static int sameInst(IRInst* a, IRInst* b) {
+    if (a->op != b->op || a->type != b->type || a->imm != b->imm || a->argCount != b->argCount) return 0;
+    if ((a->sym == NULL) != (b->sym == NULL)) return 0;
+    if (a->sym && strcmp(a->sym, b->sym) != 0) return 0;
+    if ((a->op == IR_ADD || a->op == IR_MUL) &&
+        a->args[0] == b->args[1] && a->args[1] == b->args[0]) return 1;
+    for (int i = 0; i < a->argCount; i++) {
+        if (a->args[i] != b->args[i]) return 0;
+    }
+    return 1;
+}
+
+int irPassCSE(IRModule* module, IRFunction* fn) {
+    (void)module;
+    int count = 0;
+    IRBlock** rpo = irComputeDominators(fn, &count);
+
+    int valueCount = 0;
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) valueCount++;
+    }
+    int capacity = 16;
+    while (capacity < valueCount * 2) capacity <<= 1;
+    IRInst** table = calloc(capacity, sizeof(IRInst*));
+    IRInst** replacements = calloc(fn->nextValueId > 0 ? fn->nextValueId : 1, sizeof(IRInst*));
+    int changed = 0;
+
+    // Reverse postorder visits a dominator before the blocks it dominates
+    for (int b = 0; b < count; b++) {
+        for (IRInst* inst = rpo[b]->first; inst; inst = inst->next) {
+            for (int i = 0; i < inst->argCount; i++) {
+                IRInst* op = inst->args[i];
+                if (replacements[op->id]) inst->args[i] = replacements[op->id];
+            }
+            if (!isCseCandidate(inst)) continue;
+
+            unsigned int index = hashInst(inst) & (capacity - 1);
+            while (table[index]) {
+                IRInst* existing = table[index];
+                if (sameInst(existing, inst)) {
+                    if (irDominates(existing->block, inst->block)) {
+                        replacements[inst->id] = existing;
+                        changed = 1;
+                    } else {
+                        table[index] = inst;    // a closer candidate for later blocks
+                    }
+                    break;
+                }
+                index = (index + 1) & (capacity - 1);
+            }
+            if (!table[index]) table[index] = inst;
+        }
+    }
+
+    if (changed) irApplyReplacements(fn, replacements);
+    free(replacements);
+    free(table);
+    free(rpo);
+    return changed;
+}
+
+// ============ dce ============
+
+static int removeUnreachableBlocks(IRFunction* fn) {
+    int count = 0;
+    IRBlock** rpo = irComputeDominators(fn, &count);
+    free(rpo);
+
+    int changed = 0;
+    IRBlock* prev = NULL;
+    IRBlock* block = fn->entry;
+    while (block) {
+        IRBlock* next = block->next;
+        if (block->rpoIndex >= 0) {
+            prev = block;
+            block = next;
+            continue;
+        }
+        IRBlock* succs[2];
+        int n = irSuccessors(block, succs);
+        for (int i = 0; i < n; i++) irRemovePred(succs[i], block);
+
+        IRInst* inst = block->first;
+        while (inst) {
+            IRInst* nextInst = inst->next;
+            irFreeInst(inst);
+            inst = nextInst;
+        }
+        if (prev) prev->next = next;
+        else fn->entry = next;
+        if (fn->lastBlock == block) fn->lastBlock = prev;
+        free(block->preds);
+        free(block);
+        changed = 1;
+        block = next;
+    }
+    return changed;
+}
+
+int irPassDCE(IRModule* module, IRFunction* fn) {
+    (void)module;
+    int changed = removeUnreachableBlocks(fn);
+
+    char* live = calloc(fn->nextValueId > 0 ? fn->nextValueId : 1, 1);
+    IRInst** worklist = NULL;
+    int workCount = 0, workCapacity = 0;
+
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            if (!irHasSideEffects(inst)) continue;
+            live[inst->id] = 1;
+            if (workCount == workCapacity) {
+                workCapacity = workCapacity ? workCapacity * 2 : 64;
+                worklist = realloc(worklist, sizeof(IRInst*) * workCapacity);
+            }
+            worklist[workCount++] = inst;
+        }
+    }
+    while (workCount > 0) {
+        IRInst* inst = worklist[--workCount];
+        for (int i = 0; i < inst->argCount; i++) {
+            IRInst* arg = inst->args[i];
+            if (live[arg->id]) continue;
+            live[arg->id] = 1;
+            if (workCount == workCapacity) {
+                workCapacity = workCapacity ? workCapacity * 2 : 64;
+                worklist = realloc(worklist, sizeof(IRInst*) * workCapacity);
+            }
+            worklist[workCount++] = arg;
+        }
+    }
+
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        IRInst* inst = block->first;
+        while (inst) {
+            IRInst* next = inst->next;
+            if (!live[inst->id]) {
+                irUnlink(inst);
+                irFreeInst(inst);
+                changed = 1;
+            }
+            inst = next;
+        }
+    }
+
+    free(worklist);
+    free(live);
+    return changed;
+}
@@ -0,0 +1,201 @@
+// src/ir/profile.c - profile instrumentation and profile-guided counts
+//
+// --profile-generate gives every block of the IR as built a counter,
+// bumped by an IR_COUNT at its top, and makes main start the runtime's
+// profile writer (sys_profile_start). At exit the runtime writes the
+// counts, added to those already in the file for the same code, one line
+// per function:
+//
+//   # mino profile v1
+//   <name> <checksum> <blocks> <count of block 0> <count of block 1> ...
+//
+// Counters are numbered in block layout order. A block entered only from
+// a block that always continues into it has no counter of its own, nor
+// has a block nothing enters. --profile-use builds the same IR again, and
+// where a function's checksum still matches, each block gets its count
+// back. Taken-edge counts follow from those of the targets: irbuild gives
+// every branch target its own block. The checksum covers
+// the instructions and the edges, so a profile of older code is ignored
+// rather than attached to the wrong blocks.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ir.h>
+#include <runtime_abi.h>
+
+#define PROFILE_HEADER "# mino profile v1"
+
+// FNV-1a over the block structure and the opcodes of the function
+static unsigned hashWord(unsigned hash, long long word) {
+    for (int i = 0; i < 8; i++) hash = (hash ^ (unsigned char)(word >> (8 * i))) * 16777619u;
+    return hash;
+}
+
+// A block runs as often as its only predecessor when that always
+// continues into it
+static int inheritsCount(IRBlock* block) {
+    IRBlock* succs[2];
+    return block->predCount == 1 && block->preds[0] != block && irSuccessors(block->preds[0], succs) == 1;
+}
+
+static int needsCounter(IRBlock* block) {
+    if (block == block->func->entry) return 1;
+    return block->predCount > 0 && !inheritsCount(block);
+}
+
+// The checksum of the function and, through outCounters, its counter count
+static unsigned functionChecksum(IRFunction* fn, int* outCounters) {
+    unsigned hash = 2166136261u;
+    int counters = 0;
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        if (needsCounter(block)) counters++;
+        hash = hashWord(hash, block->id);
+        for (IRInst* inst = block->first; inst; inst = inst->next) {
+            hash = hashWord(hash, inst->op);
+            hash = hashWord(hash, inst->argCount);
+            for (int t = 0; t < 2; t++) {
+                if (inst->targets[t]) hash = hashWord(hash, inst->targets[t]->id);
+            }
+        }
+    }
+    *outCounters = counters;
+    return hashWord(hash, counters);
+}
+
+// ============ Instrumentation ============
+
+// After the phis and parameters, which have to stay in front
+static IRInst* firstOrdinary(IRBlock* block) {
+    IRInst* inst = block->first;
+    while (inst && (inst->op == IR_PHI || inst->op == IR_PARAM)) inst = inst->next;
+    return inst;
+}
+
+void irInstrumentModule(IRModule* module) {
+    // The layout the runtime writes the counters by, one "name checksum
+    // counters" line per function, as literal text with \n escapes
+    size_t layoutLength = 0;
+    size_t layoutCapacity = 256;
+    char* layout = malloc(layoutCapacity);
+    layout[0] = '\0';
+
+    for (IRFunction* fn = module->functions; fn; fn = fn->next) {
+        int counters;
+        unsigned checksum = functionChecksum(fn, &counters);
+        size_t needed = strlen(fn->name) + 32;
+        while (layoutLength + needed >= layoutCapacity) {
+            layoutCapacity *= 2;
+            layout = realloc(layout, layoutCapacity);
+        }
+        layoutLength += (size_t)snprintf(layout + layoutLength, layoutCapacity - layoutLength,
+                                         "%s %u %d\\n", fn->name, checksum, counters);
+
+        for (IRBlock* block = fn->entry; block; block = block->next) {
+            if (!needsCounter(block)) continue;
+            IRInst* count = irNewInst(fn, IR_COUNT, IRT_VOID);
+            count->imm = module->counterCount++;
+            irInsertBefore(firstOrdinary(block), count);
+        }
+    }
+
+    IRFunction* mainFn = irFindFunction(module, "main");
+    if (mainFn) {
+        IRInst* pos = firstOrdinary(mainFn->entry);
+        IRInst* text = irNewInst(mainFn, IR_STRING, IRT_PTR);
+        text->imm = irModuleString(module, layout, (int)layoutLength);
+        irInsertBefore(pos, text);
+        IRInst* start = irNewInst(mainFn, IR_CALL, IRT_VOID);
+        start->sym = "sys_profile_start";
+        start->runtime = lookupRuntimeFunc(start->sym);
+        irAddArg(start, text);
+        irInsertBefore(pos, start);
+    }
+    free(layout);
+}
+
+// ============ Profile use ============
+
+static char* readProfile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    size_t length = 0;
+    size_t capacity = 4096;
+    char* text = malloc(capacity);
+    size_t n;
+    while ((n = fread(text + length, 1, capacity - length - 1, file)) > 0) {
+        length += n;
+        if (capacity - length - 1 == 0) {
+            capacity *= 2;
+            text = realloc(text, capacity);
+        }
+    }
+    fclose(file);
+    text[length] = '\0';
+    return text;
+}
+
+// Give the function's blocks the counts of one profile line (after its
+// name); returns 0 if the line describes different code
+static int applyRecord(IRModule* module, IRFunction* fn, const char* record) {
+    int counters;
+    unsigned checksum = functionChecksum(fn, &counters);
+    char* end;
+    unsigned long recordChecksum = strtoul(record, &end, 10);
+    long recordCounters = strtol(end, &end, 10);
+    if (recordChecksum != checksum || recordCounters != counters) return 0;
+
+    long long* counts = malloc(sizeof(long long) * (counters > 0 ? counters : 1));
+    for (int i = 0; i < counters; i++) {
+        const char* at = end;
+        counts[i] = strtoll(at, &end, 10);
+        if (end == at || counts[i] < 0) {
+            free(counts);
+            return 0;
+        }
+    }
+    int i = 0;
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        if (needsCounter(block)) block->count = counts[i++];
+        else if (block->predCount == 0) block->count = 0;
+    }
+    // Chains of inheriting blocks end at a counted one, unless they form
+    // a cycle nothing enters
+    for (IRBlock* block = fn->entry; block; block = block->next) {
+        IRBlock* from = block;
+        for (int steps = 0; inheritsCount(from) && steps < fn->nextBlockId; steps++) from = from->preds[0];
+        block->count = inheritsCount(from) ? 0 : from->count;
+        if (block->count > module->hottestCount) module->hottestCount = block->count;
+    }
+    fn->entryCount = fn->entry->count;
+    free(counts);
+    return 1;
+}
+
+int irApplyProfile(IRModule* module, const char* path) {
+    char* text = readProfile(path);
+    if (!text) {
+        fprintf(stderr, "Cannot read profile %s\n", path);
+        return 0;
+    }
+    if (strncmp(text, PROFILE_HEADER "\n", strlen(PROFILE_HEADER) + 1) != 0) {
+        fprintf(stderr, "%s is not a Mino profile\n", path);
+        free(text);
+        return 0;
+    }
+
+    module->hottestCount = 0;
+    char* line = text;
+    while ((line = strchr(line, '\n')) != NULL) {
+        line++;
+        char* nameEnd = line + strcspn(line, " \n");
+        if (*nameEnd != ' ') continue;
+        *nameEnd = '\0';
+        IRFunction* fn = irFindFunction(module, line);
+        *nameEnd = ' ';
+        if (fn && fn->entryCount < 0 && !applyRecord(module, fn, nameEnd + 1)) {
+            fprintf(stderr, "Warning: the profile of %s does not match its code, ignored\n", fn->name);
+        }
+    }
+    free(text);
+    return 1;
+}
@@ -306,6 +306,7 @@ Token scanToken(Lexer* lexer) {
         case '.': return makeToken(lexer, TOKEN_DOT);
         case ':': return makeToken(lexer, TOKEN_COLON);
         case '?': return makeToken(lexer, TOKEN_QUESTION);
+        case '@': return makeToken(lexer, TOKEN_AT);
         
         case '+': return makeToken(lexer, TOKEN_PLUS);
         case '/': return makeToken(lexer, TOKEN_SLASH);
@@ -315,6 +316,7 @@ Token scanToken(Lexer* lexer) {
         case '!':
             return makeToken(lexer, match(lexer, '=') ? TOKEN_BANG_EQUAL : TOKEN_BANG);
         case '=':
+            if (match(lexer, '>')) return makeToken(lexer, TOKEN_FAT_ARROW);
             return makeToken(lexer, match(lexer, '=') ? TOKEN_EQUAL_EQUAL : TOKEN_EQUAL);
         case '<':
             return makeToken(lexer, match(lexer, '=') ? TOKEN_LESS_EQUAL : TOKEN_LESS);
@@ -6,6 +6,10 @@
 #include <ast.h>
 #include <parser.h>
 #include <semantic.h>
+#include <fold.h>
+#include <ir.h>
+#include <namespace.h>
+#include "codegen/codegen.h"
 
 static char* readFile(const char* filename) {
     FILE* file = fopen(filename, "rb");
@@ -37,7 +41,28 @@ static char* readFile(const char* filename) {
 }
 
 // forward declaration for helper below
-static void getOutputPath(const char* filename, char* outPath, size_t outSize);
+static void getOutputPath(const char* filename, const char* extension, char* outPath, size_t outSize);
+
+// Options for compiling a source file
+typedef struct {
+    const char* output;     // -o <file>; NULL derives it from the input
+    int assemblyOnly;       // -S: stop after writing the assembly (or C)
+    int objectOnly;         // -c: stop after writing the ELF object
+    int viaAssembler;       // --via-asm: assemble printed text with gcc
+    int emitC;              // --emit-c: use the C backend
+    int profileGenerate;    // --profile-generate: count blocks, write a profile at exit
+    const char* profileUse; // --profile-use=<file>: optimize with a written profile
+    int debugInfo;          // -g: DWARF line tables and call frame information
+    int keepFramePointer;   // -fno-omit-frame-pointer: a frame in every function
+    int noPeephole;         // -fno-peephole: skip the cleanup after register allocation
+} CompileOptions;
+
+// The output path: -o if given, else the input with its extension replaced
+static void resolveOutputPath(const char* filename, const CompileOptions* options,
+                              const char* extension, char* outPath, size_t outSize) {
+    if (options->output) snprintf(outPath, outSize, "%s", options->output);
+    else getOutputPath(filename, extension, outPath, outSize);
+}
 
 static void testLexer(const char* source) {
     Lexer lexer;
@@ -63,6 +88,7 @@ static void testLexer(const char* source) {
             case TOKEN_DOT: printf("."); break;
             case TOKEN_COLON: printf(":"); break;
             case TOKEN_QUESTION: printf("?"); break;
+            case TOKEN_AT: printf("@"); break;
             
             // Operators
             case TOKEN_PLUS: printf("+"); break;
@@ -98,6 +124,7 @@ static void testLexer(const char* source) {
             case TOKEN_IF: printf("if"); break;
             case TOKEN_ELSE: printf("else"); break;
             case TOKEN_WHILE: printf("while"); break;
+            case TOKEN_FOR: printf("for"); break;
             case TOKEN_RETURN: printf("return"); break;
             case TOKEN_TRUE: printf("true"); break;
             case TOKEN_FALSE: printf("false"); break;
@@ -156,9 +183,131 @@ static void testParser(const char* source) {
     
     freeSymbolTable(symbols);
     freeAST(ast);
+    freeNamespaces();
+}
+
+// Lower a checked, folded program to IR and run the default pass
+// pipeline; returns NULL if the IR is malformed or the profile cannot be
+// read. Inlining decisions are reported to `remarks` when it is not NULL.
+// The profile options are applied to the IR as built, before any pass.
+static IRModule* buildOptimizedIR(ASTNode* ast, FILE* remarks, const CompileOptions* options) {
+    IRModule* module = irBuildModule(ast);
+    if (!module) return NULL;
+    module->remarks = remarks;
+    if (!irVerifyModule(module)) {
+        irFreeModule(module);
+        return NULL;
+    }
+    if (options && options->profileGenerate) irInstrumentModule(module);
+    if (options && options->profileUse && !irApplyProfile(module, options->profileUse)) {
+        irFreeModule(module);
+        return NULL;
+    }
+    IRPassManager pm;
+    irInitPassManager(&pm);
+    irAddDefaultPasses(&pm);
+    if (!irRunPasses(&pm, module)) {
+        irFreeModule(module);
+        return NULL;
+    }
+    return module;
+}
+
+// Print the optimized IR of a program: bin/minoc --emit-ir <file>
+static int emitIR(const char* filename) {
+    char* source = readFile(filename);
+    ASTNode* ast = parse(source);
+    if (!ast) {
+        fprintf(stderr, "Parse failed, aborting.\n");
+        free(source);
+        return 1;
+    }
+    SymbolTable* symbols = createSymbolTable();
+    int ok = typeCheck(ast, symbols) && foldConstants(ast);
+    IRModule* module = ok ? buildOptimizedIR(ast, stderr, NULL) : NULL;
+    if (module) irDumpModule(module, stdout);
+    else fprintf(stderr, "IR generation failed.\n");
+
+    irFreeModule(module);
+    freeSymbolTable(symbols);
+    freeAST(ast);
+    freeNamespaces();
+    free(source);
+    return module ? 0 : 1;
+}
+
+// Compile a program into memory and run it: bin/minoc --run <file>
+// Nothing but the program's own output is printed; the exit status is main's
+static int runFile(const char* filename) {
+    char* source = readFile(filename);
+    ASTNode* ast = parse(source);
+    if (!ast) {
+        fprintf(stderr, "Parse failed, aborting.\n");
+        free(source);
+        return 1;
+    }
+    SymbolTable* symbols = createSymbolTable();
+    int ok = typeCheck(ast, symbols) && foldConstants(ast);
+    IRModule* module = ok ? buildOptimizedIR(ast, NULL, NULL) : NULL;
+    int exitCode = 1;
+    if (!module || codegen_run(module, &exitCode) != 0) {
+        fprintf(stderr, "Run failed.\n");
+        exitCode = 1;
+    }
+
+    irFreeModule(module);
+    freeSymbolTable(symbols);
+    freeAST(ast);
+    freeNamespaces();
+    free(source);
+    return exitCode;
+}
+
+// Ensure runtime library/object exists; if not, build it via Makefile
+static void ensureRuntime(void) {
+    FILE* fa = fopen("lib/minolib/libminosys.a", "r");
+    if (!fa) {
+        FILE* fo = fopen("lib/minolib/System/System.o", "r");
+        if (!fo) {
+            printf("Runtime not found, building runtime...\n");
+            int rc = system("make runtime");
+            if (rc != 0) fprintf(stderr, "Warning: `make runtime` failed (rc=%d)\n", rc);
+        } else {
+            fclose(fo);
+        }
+    } else {
+        fclose(fa);
+    }
 }
 
-static void compileFile(const char* filename) {
+// Compile through the C backend: bin/minoc --emit-c <file>
+static int emitC(const char* filename, const CompileOptions* options) {
+    char* source = readFile(filename);
+    ASTNode* ast = parse(source);
+    if (!ast) {
+        fprintf(stderr, "Parse failed, aborting.\n");
+        free(source);
+        return 1;
+    }
+    SymbolTable* symbols = createSymbolTable();
+    int ok = typeCheck(ast, symbols) && foldConstants(ast);
+    if (ok) {
+        char outPath[512];
+        resolveOutputPath(filename, options, options->assemblyOnly ? ".c" : ".out", outPath, sizeof(outPath));
+        if (!options->assemblyOnly) ensureRuntime();
+        ok = codegen_generateC(ast, outPath, options->assemblyOnly) == 0;
+        if (ok) printf("Generated %s: %s\n", options->assemblyOnly ? "C" : "executable", outPath);
+    }
+    if (!ok) fprintf(stderr, "C generation failed.\n");
+
+    freeSymbolTable(symbols);
+    freeAST(ast);
+    freeNamespaces();
+    free(source);
+    return ok ? 0 : 1;
+}
+
+static int compileFile(const char* filename, const CompileOptions* options) {
     char* source = readFile(filename);
     
     printf("Compiling: %s\n", filename);
@@ -172,7 +321,7 @@ static void compileFile(const char* filename) {
     if (!ast) {
         fprintf(stderr, "Parse failed, aborting.\n");
         free(source);
-        return;
+        return 1;
     }
 
     printf("Parse successful!\n\n");
@@ -186,48 +335,74 @@ static void compileFile(const char* filename) {
         freeSymbolTable(symbols);
         freeAST(ast);
         free(source);
-        return;
+        return 1;
     }
     printf("Type checking passed!\n");
 
+    // Constant folding and propagation
+    if (!foldConstants(ast)) {
+        fprintf(stderr, "Constant folding failed, aborting.\n");
+        freeSymbolTable(symbols);
+        freeAST(ast);
+        free(source);
+        return 1;
+    }
+
+    // Lower to SSA and optimize
+    printf("\n=== Optimization ===\n");
+    IRModule* module = buildOptimizedIR(ast, stdout, options);
+    if (!module) {
+        fprintf(stderr, "IR generation failed, aborting.\n");
+        freeSymbolTable(symbols);
+        freeAST(ast);
+        free(source);
+        return 1;
+    }
+
     // Code generation: generate executable
     printf("\n=== Code Generation ===\n");
-    char outExe[256];
-    getOutputPath(filename, outExe, sizeof(outExe));
-
-    // Ensure runtime library/object exists; if not, build it via Makefile
-    FILE* fa = fopen("lib/minolib/libminosys.a", "r");
-    if (!fa) {
-        FILE* fo = fopen("lib/minolib/System/System.o", "r");
-        if (!fo) {
-            printf("Runtime not found, building runtime...\n");
-            int rc = system("make runtime");
-            if (rc != 0) fprintf(stderr, "Warning: `make runtime` failed (rc=%d)\n", rc);
-        } else {
-            fclose(fo);
-        }
-    } else {
-        fclose(fa);
+    CodegenOutput output = CODEGEN_EXECUTABLE;
+    const char* extension = ".out";
+    const char* kind = "executable";
+    if (options->assemblyOnly) {
+        output = CODEGEN_ASSEMBLY;
+        extension = ".s";
+        kind = "assembly";
+    } else if (options->objectOnly) {
+        output = CODEGEN_OBJECT;
+        extension = ".o";
+        kind = "object";
+    } else if (options->viaAssembler) {
+        output = CODEGEN_VIA_ASSEMBLER;
     }
+    char outPath[512];
+    resolveOutputPath(filename, options, extension, outPath, sizeof(outPath));
+
+    if (output == CODEGEN_EXECUTABLE || output == CODEGEN_VIA_ASSEMBLER) ensureRuntime();
 
-    extern int codegen_generateExecutable(ASTNode* ast, const char* outPath);
-    if (codegen_generateExecutable(ast, outExe) == 0) {
-        printf("Generated executable: %s\n", outExe);
+    CodegenOptions codegenOptions = {options->debugInfo ? filename : NULL, options->keepFramePointer,
+                                     options->noPeephole};
+    int rc = codegen_generateExecutable(module, outPath, output, &codegenOptions);
+    if (rc == 0) {
+        printf("Generated %s: %s\n", kind, outPath);
     } else {
         fprintf(stderr, "Code generation failed.\n");
     }
 
+    irFreeModule(module);
     freeSymbolTable(symbols);
     freeAST(ast);
+    freeNamespaces();
     
     free(source);
+    return rc;
 }
 
 int main(int argc, char** argv) {
     // Build runtime helper objects: bin/minoc --build-runtime
     if (argc == 2 && strcmp(argv[1], "--build-runtime") == 0) {
         printf("Building runtime object...\n");
-        int rc = system("gcc -c -I./include -o lib/minolib/System/System.o lib/minolib/System/System.c");
+        int rc = system("gcc -O2 -ffunction-sections -fdata-sections -c -I./include -o lib/minolib/System/System.o lib/minolib/System/System.c");
         if (rc == 0) printf("Built: lib/minolib/System/System.o\n");
         else fprintf(stderr, "Runtime build failed (rc=%d)\n", rc);
         return rc;
@@ -236,7 +411,7 @@ int main(int argc, char** argv) {
     // Build static runtime archive: bin/minoc --build-runtime-static
     if (argc == 2 && strcmp(argv[1], "--build-runtime-static") == 0) {
         printf("Building static runtime archive...\n");
-        int rc1 = system("gcc -c -I./include -o lib/minolib/System/System.o lib/minolib/System/System.c");
+        int rc1 = system("gcc -O2 -ffunction-sections -fdata-sections -c -I./include -o lib/minolib/System/System.o lib/minolib/System/System.c");
         if (rc1 != 0) { fprintf(stderr, "Compile runtime failed (rc=%d)\n", rc1); return rc1; }
         int rc2 = system("ar rcs lib/minolib/libminosys.a lib/minolib/System/System.o");
         if (rc2 == 0) printf("Built: lib/minolib/libminosys.a\n");
@@ -245,10 +420,15 @@ int main(int argc, char** argv) {
     }
     if (argc == 1) {
         printf("Mino Compiler v0.2.5\n");
-        printf("Usage: minoc <filename.mino|filename.mi>\n");
+        printf("Usage: minoc [-S | -c] [-g] [-fno-omit-frame-pointer] [-fno-peephole] [-o <output>]\n");
+        printf("             [--emit-c] [--via-asm]\n");
+        printf("             <filename.mino|filename.mi>\n");
+        printf("       minoc [--profile-generate | --profile-use=<profile>] [-o <output>] <filename>\n");
         printf("       minoc --test <test_string>\n");
         printf("       minoc --lex <filename>\n");
         printf("       minoc --parse <filename>\n");
+        printf("       minoc --emit-ir <filename>\n");
+        printf("       minoc --run <filename>\n");
         return 1;
     }
     
@@ -272,15 +452,76 @@ int main(int argc, char** argv) {
         return 0;
     }
     
-    // Compile file normally
-    compileFile(argv[1]);
-    
-    return 0;
+    if (argc == 3 && strcmp(argv[1], "--emit-ir") == 0) {
+        return emitIR(argv[2]);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--run") == 0) {
+        return runFile(argv[2]);
+    }
+
+    // Compile file normally: [-S | -c] [-g] [-fno-omit-frame-pointer] [-fno-peephole] [-o <output>]
+    // [--emit-c] [--via-asm]
+    // [--profile-generate | --profile-use=<profile>] <file>
+    CompileOptions options = {0};
+    const char* input = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-S") == 0) {
+            options.assemblyOnly = 1;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            options.objectOnly = 1;
+        } else if (strcmp(argv[i], "-g") == 0) {
+            options.debugInfo = 1;
+        } else if (strcmp(argv[i], "-fno-omit-frame-pointer") == 0) {
+            options.keepFramePointer = 1;
+        } else if (strcmp(argv[i], "-fno-peephole") == 0) {
+            options.noPeephole = 1;
+        } else if (strcmp(argv[i], "--via-asm") == 0) {
+            options.viaAssembler = 1;
+        } else if (strcmp(argv[i], "--emit-c") == 0) {
+            options.emitC = 1;
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            options.profileGenerate = 1;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0 && argv[i][14]) {
+            options.profileUse = argv[i] + 14;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (argv[i][0] == '-' || input) {
+            fprintf(stderr, "Unexpected argument: %s\n", argv[i]);
+            return 64;
+        } else {
+            input = argv[i];
+        }
+    }
+    if (!input) {
+        fprintf(stderr, "No input file.\n");
+        return 64;
+    }
+
+    if (options.emitC && options.objectOnly) {
+        fprintf(stderr, "-c is not supported with --emit-c\n");
+        return 64;
+    }
+    if (options.profileGenerate && options.profileUse) {
+        fprintf(stderr, "--profile-generate and --profile-use cannot be combined\n");
+        return 64;
+    }
+    if (options.emitC && (options.profileGenerate || options.profileUse)) {
+        fprintf(stderr, "Profiles are not supported with --emit-c\n");
+        return 64;
+    }
+    if (options.emitC && (options.debugInfo || options.keepFramePointer || options.noPeephole)) {
+        fprintf(stderr, "-g, -fno-omit-frame-pointer and -fno-peephole are not supported with --emit-c"
+                " (see MINO_CFLAGS)\n");
+        return 64;
+    }
+    if (options.emitC) return emitC(input, &options);
+    return compileFile(input, &options);
 }
 
-// Helper: generate output executable path by stripping known extensions
+// Helper: generate an output path by replacing known source extensions
 // Supported source extensions: .mino, .mi
-static void getOutputPath(const char* filename, char* outPath, size_t outSize) {
+static void getOutputPath(const char* filename, const char* extension, char* outPath, size_t outSize) {
     // copy filename so we can modify
     char tmp[512];
     strncpy(tmp, filename, sizeof(tmp)-1);
@@ -298,5 +539,5 @@ static void getOutputPath(const char* filename, char* outPath, size_t outSize) {
         }
     }
 
-    snprintf(outPath, outSize, "%s.out", tmp);
+    snprintf(outPath, outSize, "%s%s", tmp, extension);
 }
\ No newline at end of file
@@ -83,8 +83,20 @@ static char* copyString(const char* start, int length) {
     return result;
 }
 
+// A type keyword (already consumed), optionally followed by '[]' for an
+// array of that type
+static ASTNode* typeAnnotation(Parser* parser) {
+    ASTNode* type = createLiteralNode(parser->previous);
+    if (match(parser, TOKEN_LEFT_BRACKET)) {
+        consume(parser, TOKEN_RIGHT_BRACKET, "Expect ']' after '[' in array type.");
+        type->literal.isArray = 1;
+    }
+    return type;
+}
+
 // ============ Declarations ============
 static ASTNode* expression(Parser* parser);
+static ASTNode* statement(Parser* parser);
 static ASTNode* varDeclaration(Parser* parser);
 
 // ============ Expression parsing ============
@@ -111,48 +123,150 @@ static ASTNode* finishCall(Parser* parser, ASTNode* callee) {
 
     consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after arguments.");
 
-    return createCallNode(callee, args, argCount);
+    ASTNode* call = createCallNode(callee, args, argCount);
+    call->line = parser->previous.line;
+    return call;
+}
+
+// Member accesses and calls after a primary: sys.IO.print.PrintInt(x),
+// a.length, a.map((x) => x * 2).sum()
+static ASTNode* postfix(Parser* parser, ASTNode* node) {
+    while (node) {
+        if (match(parser, TOKEN_DOT)) {
+            consume(parser, TOKEN_IDENTIFIER, "Expect member name after '.'.");
+            char* member = copyString(parser->previous.start, parser->previous.length);
+            ASTNode* getNode = createGetNode(node, member);
+            free(member);
+            node = getNode;
+            continue;
+        }
+
+        // If a left parenthesis follows, this is a function call
+        if (check(parser, TOKEN_LEFT_PAREN)) {
+            node = finishCall(parser, node);
+            continue;
+        }
+
+        break;
+    }
+    return node;
+}
+
+// Whether '(' at the current token opens a lambda parameter list, i.e.
+// '(' [name {',' name}] ')' '=>' follows; scans ahead on a copy of the lexer
+static int lambdaAhead(Parser* parser) {
+    if (!check(parser, TOKEN_LEFT_PAREN)) return 0;
+
+    Lexer lexer = *parser->lexer;
+    Token token = scanToken(&lexer);
+    if (token.type != TOKEN_RIGHT_PAREN) {
+        while (1) {
+            if (token.type != TOKEN_IDENTIFIER) return 0;
+            token = scanToken(&lexer);
+            if (token.type == TOKEN_RIGHT_PAREN) break;
+            if (token.type != TOKEN_COMMA) return 0;
+            token = scanToken(&lexer);
+        }
+    }
+    return scanToken(&lexer).type == TOKEN_FAT_ARROW;
+}
+
+static ASTNode* lambdaParam(Parser* parser) {
+    char* name = copyString(parser->previous.start, parser->previous.length);
+    ASTNode* param = createVarNode(name, NULL, NULL);
+    param->line = parser->previous.line;
+    free(name);
+    return param;
+}
+
+// Parse 'x => body' or '(a, b) => body'; the parameter list has been
+// consumed up to the '=>'
+static ASTNode* lambdaBody(Parser* parser, ASTNode** params, int paramCount, int line) {
+    consume(parser, TOKEN_FAT_ARROW, "Expect '=>' after lambda parameters.");
+    ASTNode* lambda = createLambdaNode(params, paramCount, expression(parser));
+    lambda->line = line;
+    return lambda;
+}
+
+// '[a, b, c]' after the opening bracket
+static ASTNode* arrayLiteral(Parser* parser) {
+    int line = parser->previous.line;
+    ASTNode** elements = NULL;
+    int count = 0;
+
+    if (!check(parser, TOKEN_RIGHT_BRACKET)) {
+        do {
+            ASTNode* element = expression(parser);
+            if (element) {
+                elements = realloc(elements, sizeof(ASTNode*) * (count + 1));
+                elements[count++] = element;
+            }
+        } while (match(parser, TOKEN_COMMA));
+    }
+
+    consume(parser, TOKEN_RIGHT_BRACKET, "Expect ']' after array elements.");
+    ASTNode* array = createArrayNode(elements, count);
+    array->line = line;
+    return array;
 }
 
 // Parse primary expressions: literals, identifiers, function calls
 static ASTNode* primary(Parser* parser) {
     if (match(parser, TOKEN_TRUE) || match(parser, TOKEN_FALSE) || 
-        match(parser, TOKEN_NULL) || match(parser, TOKEN_NUMBER)) {
+        match(parser, TOKEN_NULL) || match(parser, TOKEN_NUMBER) ||
+        match(parser, TOKEN_STRING)) {
         return createLiteralNode(parser->previous);
     }
     
     if (match(parser, TOKEN_IDENTIFIER)) {
+        // 'x => body'
+        if (check(parser, TOKEN_FAT_ARROW)) {
+            ASTNode** params = malloc(sizeof(ASTNode*));
+            params[0] = lambdaParam(parser);
+            return lambdaBody(parser, params, 1, parser->previous.line);
+        }
+
         char* name = copyString(parser->previous.start, parser->previous.length);
         ASTNode* node = createVarRefNode(name);
         free(name);
 
         // Support dot access chains like sys.IO.print
-        while (1) {
-            if (match(parser, TOKEN_DOT)) {
-                consume(parser, TOKEN_IDENTIFIER, "Expect member name after '.'.");
-                char* member = copyString(parser->previous.start, parser->previous.length);
-                ASTNode* getNode = createGetNode(node, member);
-                free(member);
-                node = getNode;
-                continue;
-            }
+        return postfix(parser, node);
+    }
 
-            // If a left parenthesis follows, this is a function call
-            if (check(parser, TOKEN_LEFT_PAREN)) {
-                return finishCall(parser, node);
-            }
+    if (match(parser, TOKEN_LEFT_BRACKET)) {
+        return postfix(parser, arrayLiteral(parser));
+    }
 
-            break;
+    // '(a, b) => body'
+    if (lambdaAhead(parser)) {
+        int line = parser->current.line;
+        advance(parser);
+        ASTNode** params = NULL;
+        int paramCount = 0;
+        while (match(parser, TOKEN_IDENTIFIER)) {
+            params = realloc(params, sizeof(ASTNode*) * (paramCount + 1));
+            params[paramCount++] = lambdaParam(parser);
+            if (!match(parser, TOKEN_COMMA)) break;
         }
-
-        return node;
+        consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after lambda parameters.");
+        return lambdaBody(parser, params, paramCount, line);
     }
     
+    // Conversions: int(expr), float(expr)
+    if (match(parser, TOKEN_INT) || match(parser, TOKEN_FLOAT)) {
+        Token op = parser->previous;
+        consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after type in conversion.");
+        ASTNode* operand = expression(parser);
+        consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after conversion operand.");
+        return createUnaryNode(op, operand);
+    }
+
     // Handle parenthesized expression
     if (match(parser, TOKEN_LEFT_PAREN)) {
         ASTNode* expr = expression(parser);
         consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
-        return expr;
+        return postfix(parser, expr);
     }
     
     errorAtCurrent(parser, "Expect expression.");
@@ -165,7 +279,8 @@ static ASTNode* binary(Parser* parser) {
     
     while (1) {
         if (match(parser, TOKEN_PLUS) || match(parser, TOKEN_MINUS) ||
-            match(parser, TOKEN_STAR) || match(parser, TOKEN_SLASH)) {
+            match(parser, TOKEN_STAR) || match(parser, TOKEN_SLASH) ||
+            match(parser, TOKEN_PERCENT)) {
             Token op = parser->previous;
             ASTNode* right = primary(parser);
             left = createBinaryNode(op, left, right);
@@ -177,17 +292,126 @@ static ASTNode* binary(Parser* parser) {
     return left;
 }
 
+// Parse ordering comparisons: < <= > >= (bind looser than arithmetic)
+static ASTNode* comparison(Parser* parser) {
+    ASTNode* left = binary(parser);
+
+    while (match(parser, TOKEN_LESS) || match(parser, TOKEN_LESS_EQUAL) ||
+           match(parser, TOKEN_GREATER) || match(parser, TOKEN_GREATER_EQUAL)) {
+        Token op = parser->previous;
+        ASTNode* right = binary(parser);
+        left = createBinaryNode(op, left, right);
+    }
+
+    return left;
+}
+
+// Parse equality: == !=
+static ASTNode* equality(Parser* parser) {
+    ASTNode* left = comparison(parser);
+
+    while (match(parser, TOKEN_EQUAL_EQUAL) || match(parser, TOKEN_BANG_EQUAL)) {
+        Token op = parser->previous;
+        ASTNode* right = comparison(parser);
+        left = createBinaryNode(op, left, right);
+    }
+
+    return left;
+}
+
 static ASTNode* expression(Parser* parser) {
-    return binary(parser);
+    return equality(parser);
+}
+
+// Parse an expression or an assignment 'name = value' (no ';')
+static ASTNode* assignment(Parser* parser) {
+    ASTNode* expr = expression(parser);
+
+    if (match(parser, TOKEN_EQUAL)) {
+        int line = parser->previous.line;
+        ASTNode* value = expression(parser);
+        if (expr == NULL || expr->type != NODE_VARIABLE) {
+            error(parser, "Invalid assignment target.");
+            freeAST(expr);
+            freeAST(value);
+            return NULL;
+        }
+        expr->line = line;
+        return createAssignmentNode(expr, value);
+    }
+
+    return expr;
 }
 
 // ============ Statement parsing ============
 static ASTNode* expressionStatement(Parser* parser) {
-    ASTNode* expr = expression(parser);
+    ASTNode* expr = assignment(parser);
     consume(parser, TOKEN_SEMICOLON, "Expect ';' after expression.");
     return expr;
 }
 
+// Parse '{ statements }' after the opening brace
+static ASTNode* block(Parser* parser) {
+    ASTNode** statements = NULL;
+    int count = 0;
+
+    while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
+        ASTNode* stmt = statement(parser);
+        if (stmt) {
+            statements = realloc(statements, sizeof(ASTNode*) * (count + 1));
+            statements[count++] = stmt;
+        }
+    }
+
+    consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after block.");
+    return createBlockNode(statements, count);
+}
+
+static ASTNode* loopBody(Parser* parser) {
+    consume(parser, TOKEN_LEFT_BRACE, "Expect '{' before loop body.");
+    return block(parser);
+}
+
+static ASTNode* whileStatement(Parser* parser) {
+    int line = parser->previous.line;
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
+    ASTNode* condition = expression(parser);
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
+
+    ASTNode* loop = createLoopNode(NULL, condition, NULL, loopBody(parser));
+    loop->line = line;
+    return loop;
+}
+
+// for (init; condition; step) - every clause is optional
+static ASTNode* forStatement(Parser* parser) {
+    int line = parser->previous.line;
+    consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'for'.");
+
+    ASTNode* init = NULL;
+    if (match(parser, TOKEN_LET) || match(parser, TOKEN_VAR)) {
+        init = varDeclaration(parser);
+    } else if (!match(parser, TOKEN_SEMICOLON)) {
+        init = expressionStatement(parser);
+    }
+
+    ASTNode* condition = NULL;
+    if (!check(parser, TOKEN_SEMICOLON)) {
+        condition = expression(parser);
+    }
+    consume(parser, TOKEN_SEMICOLON, "Expect ';' after loop condition.");
+
+    ASTNode* step = NULL;
+    if (!check(parser, TOKEN_RIGHT_PAREN)) {
+        step = assignment(parser);
+    }
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
+
+    ASTNode* loop = createLoopNode(init, condition, step, loopBody(parser));
+    loop->line = line;
+    return loop;
+}
+
 static ASTNode* returnStatement(Parser* parser) {
     ASTNode* value = NULL;
     
@@ -201,6 +425,9 @@ static ASTNode* returnStatement(Parser* parser) {
 
 static ASTNode* statement(Parser* parser) {
     if (match(parser, TOKEN_RETURN)) return returnStatement(parser);
+    if (match(parser, TOKEN_WHILE)) return whileStatement(parser);
+    if (match(parser, TOKEN_FOR)) return forStatement(parser);
+    if (match(parser, TOKEN_LEFT_BRACE)) return block(parser);
     if (match(parser, TOKEN_LET) || match(parser, TOKEN_VAR)) return varDeclaration(parser);
     return expressionStatement(parser);
 }
@@ -208,6 +435,7 @@ static ASTNode* statement(Parser* parser) {
 // ============ Declaration parsing ============
 static ASTNode* varDeclaration(Parser* parser) {
     // 'let' or 'var' already matched
+    int isMutable = parser->previous.type == TOKEN_VAR;
     consume(parser, TOKEN_IDENTIFIER, "Expect variable name.");
     char* name = copyString(parser->previous.start, parser->previous.length);
     
@@ -219,7 +447,7 @@ static ASTNode* varDeclaration(Parser* parser) {
         // Format 1: with colon
         if (match(parser, TOKEN_INT) || match(parser, TOKEN_FLOAT) || 
             match(parser, TOKEN_BOOL) || match(parser, TOKEN_STRING_TYPE)) {
-            typeNode = createLiteralNode(parser->previous);
+            typeNode = typeAnnotation(parser);
         } else {
             errorAtCurrent(parser, "Expect type after :");
             free(name);
@@ -229,7 +457,7 @@ static ASTNode* varDeclaration(Parser* parser) {
                peekType(parser) == TOKEN_BOOL || peekType(parser) == TOKEN_STRING_TYPE) {
         // Format 2: without colon (type before name)
         advance(parser);
-        typeNode = createLiteralNode(parser->previous);
+        typeNode = typeAnnotation(parser);
     }
     
     // Check for initializer expression
@@ -238,11 +466,14 @@ static ASTNode* varDeclaration(Parser* parser) {
     }
     
     consume(parser, TOKEN_SEMICOLON, "Expect ';' after variable declaration.");
-    return createVarNode(name, typeNode, initializer);
+    ASTNode* node = createVarNode(name, typeNode, initializer);
+    node->variable.isMutable = isMutable;
+    return node;
 }
 
 static ASTNode* functionDeclaration(Parser* parser) {
     // TOKEN_FUNC already matched
+    int line = parser->previous.line;
     
     // Parse return type (optional)
     ASTNode* returnType = NULL;
@@ -251,7 +482,8 @@ static ASTNode* functionDeclaration(Parser* parser) {
         peekType(parser) == TOKEN_BOOL || peekType(parser) == TOKEN_STRING_TYPE ||
         peekType(parser) == TOKEN_VOID) {
         advance(parser);
-        returnType = createLiteralNode(parser->previous);
+        returnType = parser->previous.type == TOKEN_VOID ? createLiteralNode(parser->previous)
+                                                         : typeAnnotation(parser);
     }
     
     // Parse function name
@@ -272,7 +504,7 @@ static ASTNode* functionDeclaration(Parser* parser) {
                 errorAtCurrent(parser, "Expect parameter type.");
                 break;
             }
-            Token paramType = parser->previous;
+            ASTNode* paramTypeNode = typeAnnotation(parser);
             
             // Parse parameter name
             consume(parser, TOKEN_IDENTIFIER, "Expect parameter name.");
@@ -280,7 +512,6 @@ static ASTNode* functionDeclaration(Parser* parser) {
             
             // Add to parameter list
             params = realloc(params, sizeof(ASTNode*) * (paramCount + 1));
-            ASTNode* paramTypeNode = createLiteralNode(paramType);
             ASTNode* paramNode = createVarNode(paramName, paramTypeNode, NULL);
             params[paramCount++] = paramNode;
             
@@ -306,17 +537,43 @@ static ASTNode* functionDeclaration(Parser* parser) {
     consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after function body.");
     
     ASTNode* body = createProgramNode(bodyStatements, bodyCount);
-    return createFunctionNode(name, params, paramCount, returnType, body);
+    ASTNode* func = createFunctionNode(name, params, paramCount, returnType, body);
+    func->line = line;
+    return func;
 }
 
 static ASTNode* includeDeclaration(Parser* parser) {
     // For tests, skip include blocks
-    while (!check(parser, TOKEN_EOF) && parser->current.type != TOKEN_FUNC) {
+    while (!check(parser, TOKEN_EOF) && parser->current.type != TOKEN_FUNC && parser->current.type != TOKEN_AT) {
         advance(parser);
     }
     return NULL;
 }
 
+// Attributes in front of a function: @inline, @noinline
+static ASTNode* attributedFunction(Parser* parser) {
+    InlineHint hint = INLINE_DEFAULT;
+    do {
+        consume(parser, TOKEN_IDENTIFIER, "Expect attribute name after '@'.");
+        Token name = parser->previous;
+        if (name.length == 6 && memcmp(name.start, "inline", 6) == 0) {
+            hint = INLINE_ALWAYS;
+        } else if (name.length == 8 && memcmp(name.start, "noinline", 8) == 0) {
+            hint = INLINE_NEVER;
+        } else {
+            error(parser, "Unknown attribute.");
+        }
+    } while (match(parser, TOKEN_AT));
+
+    if (!match(parser, TOKEN_FUNC)) {
+        errorAtCurrent(parser, "Expect 'func' after attributes.");
+        return NULL;
+    }
+    ASTNode* func = functionDeclaration(parser);
+    if (func) func->function.inlineHint = hint;
+    return func;
+}
+
 static ASTNode* declaration(Parser* parser) {
     if (check(parser, TOKEN_INCLUDE)) {
         advance(parser);
@@ -326,6 +583,10 @@ static ASTNode* declaration(Parser* parser) {
     if (match(parser, TOKEN_FUNC)) {
         return functionDeclaration(parser);
     }
+
+    if (match(parser, TOKEN_AT)) {
+        return attributedFunction(parser);
+    }
     
     if (match(parser, TOKEN_LET) || match(parser, TOKEN_VAR)) {
         return varDeclaration(parser);
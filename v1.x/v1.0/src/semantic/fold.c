@@ -0,0 +1,565 @@
+// src/semantic/fold.c - constant folding and propagation
+//
+// Walks each function body in statement order. Binary expressions whose
+// operands are both integer constants are replaced by a folded literal,
+// and references to immutable (`let`) bindings with a constant value are
+// replaced by that value. `var` bindings and parameters are never
+// propagated. Comparisons fold to 0 or 1.
+//
+// A call whose arguments are all constants is evaluated at compile time
+// when everything it runs is integer arithmetic on its own locals: an
+// interpreter walks the callee's body, and pure runtime helpers with
+// integer signatures (MINO_PURE) are called directly, since the runtime
+// is linked into minoc. Anything else (output, floats, strings, arrays,
+// a trap such as division by zero, or running out of steps or depth)
+// abandons the evaluation and the call stays. `@noinline` functions are
+// always called. Results, including "cannot be evaluated", are remembered
+// per callee and arguments, so a call that runs out of steps costs them
+// once rather than at every site.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fold.h>
+#include <runtime_abi.h>
+
+// Limits of one compile-time call, counted in statements and expressions
+// evaluated and in nested calls
+#define EVAL_STEP_LIMIT 1000000
+#define EVAL_DEPTH_LIMIT 256
+
+typedef struct {
+    const char* name;
+    int isConstant;     // 0: the name shadows an outer constant
+    long long value;
+} ConstBinding;
+
+// The outcome of a compile-time call
+typedef struct {
+    ASTNode* func;              // NULL: an empty slot
+    long long* args;            // func's paramCount arguments
+    int evaluable;
+    long long value;
+} CallResult;
+
+typedef struct {
+    ConstBinding* bindings;     // globals, innermost last
+    int count;
+    int capacity;
+    ConstBinding* slots;        // params and locals of the current function, by frame slot
+    int slotCapacity;
+    int errors;
+    CallResult* results;        // open addressing by callee and arguments
+    int resultCount;
+    int resultCapacity;
+} FoldContext;
+
+static void bind(FoldContext* ctx, const char* name, int isConstant, long long value) {
+    if (ctx->count == ctx->capacity) {
+        ctx->capacity = ctx->capacity ? ctx->capacity * 2 : 16;
+        ctx->bindings = realloc(ctx->bindings, sizeof(ConstBinding) * ctx->capacity);
+    }
+    ctx->bindings[ctx->count].name = name;
+    ctx->bindings[ctx->count].isConstant = isConstant;
+    ctx->bindings[ctx->count].value = value;
+    ctx->count++;
+}
+
+// Innermost binding wins
+static ConstBinding* lookup(FoldContext* ctx, const char* name) {
+    for (int i = ctx->count - 1; i >= 0; i--) {
+        if (strcmp(ctx->bindings[i].name, name) == 0) return &ctx->bindings[i];
+    }
+    return NULL;
+}
+
+// Integer value of a literal node; floats, strings and booleans are not folded
+static int integerConstant(ASTNode* node, long long* out) {
+    if (!node || node->type != NODE_LITERAL) return 0;
+    if (node->literal.folded) {
+        *out = node->literal.value;
+        return 1;
+    }
+    Token t = node->literal.token;
+    if (t.type != TOKEN_NUMBER) return 0;
+    unsigned long long value = 0;
+    for (int i = 0; i < t.length; i++) {
+        if (t.start[i] < '0' || t.start[i] > '9') return 0;
+        value = value * 10 + (unsigned long long)(t.start[i] - '0');
+    }
+    *out = (long long)value;
+    return 1;
+}
+
+// Turn a node into a folded integer literal, releasing whatever it held
+static void replaceWithConstant(ASTNode* node, long long value) {
+    switch (node->type) {
+        case NODE_BINARY_EXPR:
+            freeAST(node->binary.left);
+            freeAST(node->binary.right);
+            break;
+        case NODE_CALL_EXPR:
+            freeAST(node->call.callee);
+            for (int i = 0; i < node->call.argCount; i++) freeAST(node->call.args[i]);
+            free(node->call.args);
+            break;
+        case NODE_VARIABLE:
+            free(node->varRef.name);
+            break;
+        default:
+            break;
+    }
+    node->type = NODE_LITERAL;
+    memset(&node->literal.token, 0, sizeof(Token));
+    node->literal.token.type = TOKEN_NUMBER;
+    node->literal.token.line = node->line;
+    node->literal.folded = 1;
+    node->literal.value = value;
+}
+
+// `left op right` with 64-bit wraparound, computed on unsigned values so
+// overflow is well defined; 0 where the machine would trap (division by
+// zero, INT64_MIN / -1) or the operator is not integer arithmetic
+static int applyOperator(TokenType op, long long left, long long right, long long* out) {
+    unsigned long long l = (unsigned long long)left;
+    unsigned long long r = (unsigned long long)right;
+    switch (op) {
+        case TOKEN_PLUS:  *out = (long long)(l + r); return 1;
+        case TOKEN_MINUS: *out = (long long)(l - r); return 1;
+        case TOKEN_STAR:  *out = (long long)(l * r); return 1;
+        case TOKEN_SLASH:
+        case TOKEN_PERCENT:
+            if (right == 0 || (left == (long long)(1ULL << 63) && right == -1)) return 0;
+            *out = op == TOKEN_SLASH ? left / right : left % right;
+            return 1;
+        case TOKEN_EQUAL_EQUAL:   *out = left == right; return 1;
+        case TOKEN_BANG_EQUAL:    *out = left != right; return 1;
+        case TOKEN_LESS:          *out = left < right; return 1;
+        case TOKEN_LESS_EQUAL:    *out = left <= right; return 1;
+        case TOKEN_GREATER:       *out = left > right; return 1;
+        case TOKEN_GREATER_EQUAL: *out = left >= right; return 1;
+        default:
+            return 0;
+    }
+}
+
+// Evaluate `left op right` written in the source; a division that would
+// trap is an error
+static int evaluate(FoldContext* ctx, ASTNode* node, long long left, long long right, long long* out) {
+    TokenType op = node->binary.op.type;
+    if (op == TOKEN_SLASH || op == TOKEN_PERCENT) {
+        if (right == 0) {
+            fprintf(stderr, "[line %d] Error: Division by zero in constant expression\n",
+                    node->binary.op.line);
+            ctx->errors++;
+            return 0;
+        }
+        if (left == (long long)(1ULL << 63) && right == -1) {
+            fprintf(stderr, "[line %d] Error: Integer overflow in constant division\n",
+                    node->binary.op.line);
+            ctx->errors++;
+            return 0;
+        }
+    }
+    return applyOperator(op, left, right, out);
+}
+
+// ============ Compile-time calls ============
+
+typedef struct {
+    FoldContext* ctx;
+    long steps;
+    int depth;
+} Evaluator;
+
+typedef enum {
+    EXEC_NEXT,      // carry on with the next statement
+    EXEC_RETURN,    // the function returned
+    EXEC_FAIL       // cannot be evaluated at compile time
+} ExecStatus;
+
+// int and bool values are what the interpreter computes with
+static int isIntegerType(ASTNode* type) {
+    if (!type) return 1;
+    if (type->type != NODE_LITERAL || type->literal.isArray) return 0;
+    return type->literal.token.type == TOKEN_INT || type->literal.token.type == TOKEN_BOOL;
+}
+
+static int isIntegerAbi(AbiType type) {
+    return type == ABI_INT || type == ABI_LONG;
+}
+
+// A literal argument: integers and booleans
+static int argumentConstant(ASTNode* node, long long* out) {
+    if (node && node->type == NODE_LITERAL && !node->literal.folded &&
+        (node->literal.token.type == TOKEN_TRUE || node->literal.token.type == TOKEN_FALSE)) {
+        *out = node->literal.token.type == TOKEN_TRUE;
+        return 1;
+    }
+    return integerConstant(node, out);
+}
+
+// @noinline asks for a real call at every site, and replacing a call by
+// its value removes it as surely as inlining it
+static int keepsCalls(ASTNode* func) {
+    return func->function.inlineHint == INLINE_NEVER;
+}
+
+static unsigned hashCall(ASTNode* func, const long long* args) {
+    unsigned long long hash = 14695981039346656037ULL ^ (unsigned long long)(uintptr_t)func;
+    for (int i = 0; i < func->function.paramCount; i++) {
+        hash = (hash ^ (unsigned long long)args[i]) * 1099511628211ULL;
+    }
+    return (unsigned)(hash ^ (hash >> 32));
+}
+
+static CallResult* findResult(FoldContext* ctx, ASTNode* func, const long long* args) {
+    if (ctx->resultCapacity == 0) return NULL;
+    unsigned mask = (unsigned)ctx->resultCapacity - 1;
+    for (unsigned slot = hashCall(func, args) & mask;; slot = (slot + 1) & mask) {
+        CallResult* r = &ctx->results[slot];
+        if (!r->func) return NULL;
+        if (r->func == func && memcmp(r->args, args, sizeof(long long) * func->function.paramCount) == 0) {
+            return r;
+        }
+    }
+}
+
+static void insertResult(FoldContext* ctx, CallResult result) {
+    unsigned mask = (unsigned)ctx->resultCapacity - 1;
+    unsigned slot = hashCall(result.func, result.args) & mask;
+    while (ctx->results[slot].func) slot = (slot + 1) & mask;
+    ctx->results[slot] = result;
+}
+
+static void rememberResult(FoldContext* ctx, ASTNode* func, const long long* args, int evaluable, long long value) {
+    // keep the table at most half full
+    if ((ctx->resultCount + 1) * 2 > ctx->resultCapacity) {
+        CallResult* old = ctx->results;
+        int oldCapacity = ctx->resultCapacity;
+        ctx->resultCapacity = oldCapacity ? oldCapacity * 2 : 64;
+        ctx->results = calloc(ctx->resultCapacity, sizeof(CallResult));
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i].func) insertResult(ctx, old[i]);
+        }
+        free(old);
+    }
+    int paramCount = func->function.paramCount;
+    long long* copy = malloc(sizeof(long long) * (paramCount > 0 ? paramCount : 1));
+    memcpy(copy, args, sizeof(long long) * paramCount);
+    insertResult(ctx, (CallResult){func, copy, evaluable, value});
+    ctx->resultCount++;
+}
+
+static void forgetResults(FoldContext* ctx) {
+    for (int i = 0; i < ctx->resultCapacity; i++) free(ctx->results[i].args);
+    free(ctx->results);
+    ctx->results = NULL;
+    ctx->resultCount = 0;
+    ctx->resultCapacity = 0;
+}
+
+static int evalExpression(Evaluator* ev, ASTNode* node, long long* frame, long long* out);
+static int callFunction(Evaluator* ev, ASTNode* func, long long* args, long long* out);
+
+// Pure helpers take and return integers in the same registers whether
+// they are declared int or long, so one pointer type calls them all
+typedef long long (*IntegerHelper)(long long, long long, long long, long long, long long, long long);
+
+static int callRuntime(const RuntimeFunc* runtime, long long* args, long long* out) {
+    if (!runtime->isPure || runtime->isVariadic || !isIntegerAbi(runtime->ret)) return 0;
+    for (int i = 0; i < runtime->paramCount; i++) {
+        if (!isIntegerAbi(runtime->params[i])) return 0;
+    }
+    IntegerHelper helper = (IntegerHelper)runtimeAbiAddresses[runtime - runtimeAbiFuncs];
+    long long value = helper(args[0], args[1], args[2], args[3], args[4], args[5]);
+    // an int result is sign-extended, as codegen does after the call
+    *out = runtime->ret == ABI_INT ? (long long)(int)value : value;
+    return 1;
+}
+
+static int evalCall(Evaluator* ev, ASTNode* node, long long* frame, long long* out) {
+    if (node->call.arrayMethod != ARRAY_METHOD_NONE) return 0;
+    ASTNode* callee = node->call.callee;
+    const RuntimeFunc* runtime = node->call.runtime;
+    if (!runtime && callee->type == NODE_GET_EXPR && callee->get.linkName) {
+        runtime = lookupRuntimeFunc(callee->get.linkName);
+    }
+    ASTNode* func = NULL;
+    if (!runtime) {
+        if (callee->type != NODE_VARIABLE) return 0;
+        func = node->call.function;
+        if (!func || func->function.paramCount != node->call.argCount) return 0;
+    }
+    int argCount = node->call.argCount;
+    if (argCount > RUNTIME_MAX_PARAMS && runtime) return 0;
+
+    long long inlineArgs[RUNTIME_MAX_PARAMS] = {0};
+    long long* args = argCount > RUNTIME_MAX_PARAMS ? calloc(argCount, sizeof(long long)) : inlineArgs;
+    int ok = 1;
+    for (int i = 0; i < argCount && ok; i++) ok = evalExpression(ev, node->call.args[i], frame, &args[i]);
+    if (ok) ok = runtime ? callRuntime(runtime, args, out) : callFunction(ev, func, args, out);
+    if (args != inlineArgs) free(args);
+    return ok;
+}
+
+static int evalExpression(Evaluator* ev, ASTNode* node, long long* frame, long long* out) {
+    if (!node || ++ev->steps > EVAL_STEP_LIMIT) return 0;
+    switch (node->type) {
+        case NODE_LITERAL:
+            return argumentConstant(node, out);
+        case NODE_VARIABLE: {
+            if (node->varRef.slot >= 0) {
+                *out = frame[node->varRef.slot];
+                return 1;
+            }
+            // globals only when they are constants
+            ConstBinding* binding = lookup(ev->ctx, node->varRef.name);
+            if (!binding || !binding->isConstant) return 0;
+            *out = binding->value;
+            return 1;
+        }
+        case NODE_BINARY_EXPR: {
+            long long left, right;
+            return evalExpression(ev, node->binary.left, frame, &left) &&
+                   evalExpression(ev, node->binary.right, frame, &right) &&
+                   applyOperator(node->binary.op.type, left, right, out);
+        }
+        case NODE_UNARY_EXPR:
+            // int(x) of an integer is x; float(x) leaves the integers
+            if (node->unary.op.type != TOKEN_INT) return 0;
+            return evalExpression(ev, node->unary.operand, frame, out);
+        case NODE_CALL_EXPR:
+            return evalCall(ev, node, frame, out);
+        default:
+            return 0;
+    }
+}
+
+static ExecStatus execStatement(Evaluator* ev, ASTNode* node, long long* frame, long long* result) {
+    if (!node) return EXEC_NEXT;
+    if (++ev->steps > EVAL_STEP_LIMIT) return EXEC_FAIL;
+    switch (node->type) {
+        case NODE_VAR_DECL: {
+            if (!isIntegerType(node->variable.type) || node->variable.slot < 0) return EXEC_FAIL;
+            long long value = 0;
+            if (node->variable.initializer && !evalExpression(ev, node->variable.initializer, frame, &value)) {
+                return EXEC_FAIL;
+            }
+            frame[node->variable.slot] = value;
+            return EXEC_NEXT;
+        }
+        case NODE_ASSIGN: {
+            int slot = node->assignment.target->varRef.slot;
+            if (slot < 0 || !evalExpression(ev, node->assignment.value, frame, &frame[slot])) return EXEC_FAIL;
+            return EXEC_NEXT;
+        }
+        case NODE_RETURN_STMT:
+            if (!node->returnStmt.value || !evalExpression(ev, node->returnStmt.value, frame, result)) {
+                return EXEC_FAIL;
+            }
+            return EXEC_RETURN;
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STMT: {
+            ASTNode** statements = node->type == NODE_PROGRAM ? node->program.statements : node->block.statements;
+            int count = node->type == NODE_PROGRAM ? node->program.count : node->block.count;
+            for (int i = 0; i < count; i++) {
+                ExecStatus status = execStatement(ev, statements[i], frame, result);
+                if (status != EXEC_NEXT) return status;
+            }
+            return EXEC_NEXT;
+        }
+        case NODE_WHILE_STMT: {
+            ExecStatus status = execStatement(ev, node->loop.init, frame, result);
+            while (status == EXEC_NEXT) {
+                long long condition = 1;
+                if (node->loop.condition && !evalExpression(ev, node->loop.condition, frame, &condition)) {
+                    return EXEC_FAIL;
+                }
+                if (!condition) break;
+                status = execStatement(ev, node->loop.body, frame, result);
+                if (status == EXEC_NEXT) status = execStatement(ev, node->loop.step, frame, result);
+            }
+            return status;
+        }
+        case NODE_CALL_EXPR:
+        case NODE_BINARY_EXPR:
+        case NODE_UNARY_EXPR:
+        case NODE_VARIABLE: {
+            long long ignored;
+            return evalExpression(ev, node, frame, &ignored) ? EXEC_NEXT : EXEC_FAIL;
+        }
+        default:
+            return EXEC_FAIL;
+    }
+}
+
+static int callFunction(Evaluator* ev, ASTNode* func, long long* args, long long* out) {
+    if (keepsCalls(func) || !isIntegerType(func->function.returnType)) return 0;
+    for (int i = 0; i < func->function.paramCount; i++) {
+        if (!isIntegerType(func->function.params[i]->variable.type)) return 0;
+    }
+    CallResult* known = findResult(ev->ctx, func, args);
+    if (known) {
+        *out = known->value;
+        return known->evaluable;
+    }
+    if (ev->depth >= EVAL_DEPTH_LIMIT) return 0;
+
+    int slotCount = func->function.slotCount;
+    long long* frame = calloc(slotCount > 0 ? slotCount : 1, sizeof(long long));
+    for (int i = 0; i < func->function.paramCount; i++) frame[func->function.params[i]->variable.slot] = args[i];
+    ev->depth++;
+    // falling off the end returns 0
+    *out = 0;
+    ExecStatus status = execStatement(ev, func->function.body, frame, out);
+    ev->depth--;
+    free(frame);
+    int evaluable = status != EXEC_FAIL;
+    // A nested call may fail only for the steps or depth its callers used
+    // up, so only an outermost call's failure is final
+    if (evaluable || ev->depth == 0) rememberResult(ev->ctx, func, args, evaluable, evaluable ? *out : 0);
+    return evaluable;
+}
+
+// The value of a call with constant arguments, if it can be computed here
+static int evaluateCall(FoldContext* ctx, ASTNode* node, long long* out) {
+    for (int i = 0; i < node->call.argCount; i++) {
+        long long value;
+        if (!argumentConstant(node->call.args[i], &value)) return 0;
+    }
+    Evaluator ev = {ctx, 0, 0};
+    return evalCall(&ev, node, NULL, out);
+}
+
+static void foldExpression(FoldContext* ctx, ASTNode* node) {
+    if (!node) return;
+    switch (node->type) {
+        case NODE_VARIABLE: {
+            int slot = node->varRef.slot;
+            ConstBinding* binding = slot >= 0 ? &ctx->slots[slot] : lookup(ctx, node->varRef.name);
+            if (binding && binding->isConstant) replaceWithConstant(node, binding->value);
+            break;
+        }
+        case NODE_BINARY_EXPR: {
+            foldExpression(ctx, node->binary.left);
+            foldExpression(ctx, node->binary.right);
+            long long left, right, value;
+            if (integerConstant(node->binary.left, &left) &&
+                integerConstant(node->binary.right, &right) &&
+                evaluate(ctx, node, left, right, &value)) {
+                replaceWithConstant(node, value);
+            }
+            break;
+        }
+        case NODE_UNARY_EXPR:
+            // conversions of constants are left to the IR folder
+            foldExpression(ctx, node->unary.operand);
+            break;
+        case NODE_CALL_EXPR: {
+            // the callee is a name, not a value, except for an array receiver
+            if (node->call.arrayMethod != ARRAY_METHOD_NONE) foldExpression(ctx, node->call.callee->get.object);
+            for (int i = 0; i < node->call.argCount; i++) foldExpression(ctx, node->call.args[i]);
+            long long value;
+            if (evaluateCall(ctx, node, &value)) replaceWithConstant(node, value);
+            break;
+        }
+        case NODE_GET_EXPR:
+            if (node->get.isLength) foldExpression(ctx, node->get.object);
+            break;
+        case NODE_ARRAY_LITERAL:
+            for (int i = 0; i < node->array.count; i++) foldExpression(ctx, node->array.elements[i]);
+            break;
+        case NODE_LAMBDA:
+            // params have slots of their own, which are never constants
+            foldExpression(ctx, node->lambda.body);
+            break;
+        default:
+            break;
+    }
+}
+
+static void foldStatement(FoldContext* ctx, ASTNode* node) {
+    if (!node) return;
+    switch (node->type) {
+        case NODE_VAR_DECL: {
+            foldExpression(ctx, node->variable.initializer);
+            long long value = 0;
+            ASTNode* type = node->variable.type;
+            int isInt = !type || (type->type == NODE_LITERAL && type->literal.token.type == TOKEN_INT);
+            int isConstant = !node->variable.isMutable && isInt &&
+                             integerConstant(node->variable.initializer, &value);
+            if (node->variable.slot >= 0) {
+                ctx->slots[node->variable.slot] = (ConstBinding){node->variable.name, isConstant, value};
+            } else {
+                bind(ctx, node->variable.name, isConstant, value);
+            }
+            break;
+        }
+        case NODE_RETURN_STMT:
+            foldExpression(ctx, node->returnStmt.value);
+            break;
+        case NODE_PROGRAM:
+            for (int i = 0; i < node->program.count; i++) foldStatement(ctx, node->program.statements[i]);
+            break;
+        case NODE_ASSIGN:
+            // the target is only ever a 'var', which is never a constant
+            foldExpression(ctx, node->assignment.value);
+            break;
+        case NODE_BLOCK_STMT: {
+            int mark = ctx->count;
+            for (int i = 0; i < node->block.count; i++) foldStatement(ctx, node->block.statements[i]);
+            ctx->count = mark;
+            break;
+        }
+        case NODE_WHILE_STMT: {
+            int mark = ctx->count;
+            foldStatement(ctx, node->loop.init);
+            foldExpression(ctx, node->loop.condition);
+            foldStatement(ctx, node->loop.step);
+            foldStatement(ctx, node->loop.body);
+            ctx->count = mark;
+            break;
+        }
+        default:
+            foldExpression(ctx, node);
+            break;
+    }
+}
+
+static void foldFunction(FoldContext* ctx, ASTNode* func) {
+    // Params and not yet declared locals are not constants
+    int slotCount = func->function.slotCount;
+    if (slotCount > ctx->slotCapacity) {
+        ctx->slotCapacity = slotCount;
+        ctx->slots = realloc(ctx->slots, sizeof(ConstBinding) * slotCount);
+    }
+    if (slotCount > 0) memset(ctx->slots, 0, sizeof(ConstBinding) * slotCount);
+    int mark = ctx->count;
+    foldStatement(ctx, func->function.body);
+    ctx->count = mark;
+}
+
+int foldConstants(ASTNode* program) {
+    if (!program) return 1;
+    FoldContext ctx = {NULL, 0, 0, NULL, 0, 0, NULL, 0, 0};
+
+    // Global bindings first, so functions can see constants declared anywhere
+    // at the top level
+    for (int i = 0; i < program->program.count; i++) {
+        ASTNode* s = program->program.statements[i];
+        if (s && s->type != NODE_FUNCTION_DECL) foldStatement(&ctx, s);
+    }
+    // Calls in global initializers saw only the constants declared before
+    // them; from here on every one is visible
+    forgetResults(&ctx);
+    for (int i = 0; i < program->program.count; i++) {
+        ASTNode* s = program->program.statements[i];
+        if (s && s->type == NODE_FUNCTION_DECL) foldFunction(&ctx, s);
+    }
+
+    free(ctx.bindings);
+    free(ctx.slots);
+    forgetResults(&ctx);
+    return ctx.errors == 0;
+}
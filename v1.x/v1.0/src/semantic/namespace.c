@@ -0,0 +1,177 @@
+// src/semantic/namespace.c - string interning and the qualified-name trie
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <namespace.h>
+
+// Semantic analysis checks functions concurrently; both tables below are
+// shared, so lookups that may insert take a lock.
+static pthread_mutex_t internLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t trieLock = PTHREAD_MUTEX_INITIALIZER;
+
+// ============ String interning ============
+
+typedef struct {
+    unsigned int hash;
+    int length;
+    char* chars;
+} InternEntry;
+
+static InternEntry* internTable = NULL;
+static int internCapacity = 0;
+static int internCount = 0;
+
+static unsigned int hashChars(const char* chars, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)chars[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+static InternEntry* findEntry(InternEntry* entries, int capacity,
+                              const char* chars, int length, unsigned int hash) {
+    unsigned int index = hash & (capacity - 1);
+    while (1) {
+        InternEntry* entry = &entries[index];
+        if (entry->chars == NULL) return entry;
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->chars, chars, length) == 0) {
+            return entry;
+        }
+        index = (index + 1) & (capacity - 1);
+    }
+}
+
+static void growInternTable(void) {
+    int capacity = internCapacity < 64 ? 64 : internCapacity * 2;
+    InternEntry* entries = calloc(capacity, sizeof(InternEntry));
+    for (int i = 0; i < internCapacity; i++) {
+        InternEntry* old = &internTable[i];
+        if (old->chars == NULL) continue;
+        *findEntry(entries, capacity, old->chars, old->length, old->hash) = *old;
+    }
+    free(internTable);
+    internTable = entries;
+    internCapacity = capacity;
+}
+
+const char* internString(const char* chars, int length) {
+    pthread_mutex_lock(&internLock);
+    if (internCount + 1 > internCapacity * 3 / 4) growInternTable();
+
+    unsigned int hash = hashChars(chars, length);
+    InternEntry* entry = findEntry(internTable, internCapacity, chars, length, hash);
+    if (entry->chars != NULL) {
+        pthread_mutex_unlock(&internLock);
+        return entry->chars;
+    }
+
+    char* copy = malloc(length + 1);
+    memcpy(copy, chars, length);
+    copy[length] = '\0';
+
+    entry->hash = hash;
+    entry->length = length;
+    entry->chars = copy;
+    internCount++;
+    pthread_mutex_unlock(&internLock);
+    return copy;
+}
+
+// ============ Namespace trie ============
+
+static NamespaceNode root = {"", "", "", NULL, NULL, NULL};
+
+NamespaceNode* namespaceRoot(void) {
+    return &root;
+}
+
+// Join parent and segment with a separator and intern the result
+static const char* joinName(const char* parent, char separator, const char* segment) {
+    size_t parentLen = strlen(parent);
+    size_t segmentLen = strlen(segment);
+    if (parentLen == 0) return internString(segment, (int)segmentLen);
+
+    char stackBuf[256];
+    size_t len = parentLen + 1 + segmentLen;
+    char* buf = len < sizeof(stackBuf) ? stackBuf : malloc(len + 1);
+    memcpy(buf, parent, parentLen);
+    buf[parentLen] = separator;
+    memcpy(buf + parentLen + 1, segment, segmentLen);
+
+    const char* result = internString(buf, (int)len);
+    if (buf != stackBuf) free(buf);
+    return result;
+}
+
+NamespaceNode* namespaceChild(NamespaceNode* parent, const char* segment) {
+    pthread_mutex_lock(&trieLock);
+    // Segments are interned, so a pointer compare is enough
+    for (NamespaceNode* child = parent->children; child; child = child->sibling) {
+        if (child->segment == segment) {
+            pthread_mutex_unlock(&trieLock);
+            return child;
+        }
+    }
+
+    NamespaceNode* child = malloc(sizeof(NamespaceNode));
+    child->segment = segment;
+    child->qualifiedName = joinName(parent->qualifiedName, '.', segment);
+    child->linkName = joinName(parent->linkName, '_', segment);
+    child->parent = parent;
+    child->children = NULL;
+    child->sibling = parent->children;
+    parent->children = child;
+    pthread_mutex_unlock(&trieLock);
+    return child;
+}
+
+NamespaceNode* resolveQualifiedName(ASTNode* node) {
+    if (!node) return NULL;
+
+    if (node->type == NODE_VARIABLE) {
+        const char* name = node->varRef.name;
+        return namespaceChild(&root, internString(name, (int)strlen(name)));
+    }
+
+    if (node->type == NODE_GET_EXPR) {
+        if (node->get.ns) return node->get.ns;
+
+        NamespaceNode* parent = resolveQualifiedName(node->get.object);
+        if (!parent) return NULL;
+        const char* member = node->get.name;
+        NamespaceNode* ns = namespaceChild(parent, internString(member, (int)strlen(member)));
+
+        node->get.ns = ns;
+        node->get.linkName = ns->linkName;
+        return ns;
+    }
+
+    return NULL;
+}
+
+static void freeNamespaceNode(NamespaceNode* node) {
+    NamespaceNode* child = node->children;
+    while (child) {
+        NamespaceNode* next = child->sibling;
+        freeNamespaceNode(child);
+        free(child);
+        child = next;
+    }
+    node->children = NULL;
+}
+
+void freeNamespaces(void) {
+    freeNamespaceNode(&root);
+
+    for (int i = 0; i < internCapacity; i++) {
+        free(internTable[i].chars);
+    }
+    free(internTable);
+    internTable = NULL;
+    internCapacity = 0;
+    internCount = 0;
+}
@@ -0,0 +1,29 @@
+// src/semantic/runtime_abi.c - lookup into the generated runtime registry
+#include <string.h>
+#include <runtime_abi.h>
+
+const RuntimeFunc* lookupRuntimeFunc(const char* name) {
+    if (!name) return NULL;
+    unsigned int slot = runtimeAbiHash(name, runtimeAbiSeed) & runtimeAbiMask;
+    int index = runtimeAbiSlots[slot];
+    if (index < 0) return NULL;
+    const RuntimeFunc* func = &runtimeAbiFuncs[index];
+    return strcmp(func->name, name) == 0 ? func : NULL;
+}
+
+int abiIsFloating(AbiType type) {
+    return type == ABI_FLOAT || type == ABI_DOUBLE;
+}
+
+const char* abiMinoTypeName(AbiType type) {
+    switch (type) {
+        case ABI_VOID: return "void";
+        case ABI_INT:
+        case ABI_LONG: return "int";
+        case ABI_FLOAT:
+        case ABI_DOUBLE: return "float";
+        case ABI_STRING: return "string";
+        case ABI_PTR: return "ptr";
+    }
+    return "void";
+}
@@ -1,7 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <semantic.h>
+#include <namespace.h>
+#include <runtime_abi.h>
 #include <System.h>
 
 // ============ Symbol table implementation ============
@@ -23,11 +28,54 @@ SymbolTable* createSymbolTable() {
     SymbolTable* table = malloc(sizeof(SymbolTable));
     table->capacity = TABLE_SIZE;
     table->count = 0;
+    table->lastDefined = NULL;
     table->scopeDepth = 0;
+    table->slotCount = 0;
     table->buckets = calloc(TABLE_SIZE, sizeof(Symbol*));
+    table->parent = NULL;
+    table->function = NULL;
+    table->diagnostics = NULL;
+    table->diagLength = 0;
+    table->diagCapacity = 0;
     return table;
 }
 
+SymbolTable* createLocalSymbolTable(SymbolTable* parent) {
+    SymbolTable* table = createSymbolTable();
+    table->parent = parent;
+    table->scopeDepth = parent ? parent->scopeDepth : 0;
+    // Buffer diagnostics so concurrent checks can be reported in source order
+    table->diagCapacity = 256;
+    table->diagnostics = malloc(table->diagCapacity);
+    table->diagnostics[0] = '\0';
+    return table;
+}
+
+// Report a diagnostic: buffered for local tables, printed directly otherwise
+static void reportError(SymbolTable* table, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (!table || !table->diagnostics) {
+        vfprintf(stderr, format, args);
+        va_end(args);
+        return;
+    }
+
+    va_list copy;
+    va_copy(copy, args);
+    int needed = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (needed > 0) {
+        if (table->diagLength + needed + 1 > table->diagCapacity) {
+            while (table->diagLength + needed + 1 > table->diagCapacity) table->diagCapacity *= 2;
+            table->diagnostics = realloc(table->diagnostics, table->diagCapacity);
+        }
+        vsnprintf(table->diagnostics + table->diagLength, needed + 1, format, args);
+        table->diagLength += needed;
+    }
+    va_end(args);
+}
+
 void freeSymbolTable(SymbolTable* table) {
     if (!table) return;
     
@@ -42,6 +90,7 @@ void freeSymbolTable(SymbolTable* table) {
     }
     
     free(table->buckets);
+    free(table->diagnostics);
     free(table);
 }
 
@@ -54,40 +103,46 @@ int enterScope(SymbolTable* table) {
 int exitScope(SymbolTable* table) {
     if (!table || table->scopeDepth <= 0) return 0;
     
-    // Remove all symbols in the current scope
-    for (int i = 0; i < table->capacity; i++) {
-        Symbol* prev = NULL;
-        Symbol* curr = table->buckets[i];
-        
-        while (curr) {
-            if (curr->scopeDepth == table->scopeDepth) {
-                // Remove the current symbol
-                if (prev) {
-                    prev->next = curr->next;
-                } else {
-                    table->buckets[i] = curr->next;
-                }
-                
-                Symbol* toFree = curr;
-                curr = curr->next;
-                
-                free(toFree->name);
-                free(toFree);
-                table->count--;
-            } else {
-                prev = curr;
-                curr = curr->next;
-            }
-        }
+    // Remove the symbols of the current scope, newest first
+    while (table->lastDefined && table->lastDefined->scopeDepth == table->scopeDepth) {
+        Symbol* symbol = table->lastDefined;
+        Symbol** link = &table->buckets[hash(symbol->name) % table->capacity];
+        while (*link != symbol) link = &(*link)->next;
+        *link = symbol->next;
+        table->lastDefined = symbol->defined;
+        free(symbol->name);
+        free(symbol);
+        table->count--;
     }
     
     table->scopeDepth--;
     return 1;
 }
 
+// Double the bucket count once there are as many symbols as buckets, so
+// chains stay short in functions with thousands of locals
+static void growTable(SymbolTable* table) {
+    int capacity = table->capacity * 2;
+    Symbol** buckets = calloc(capacity, sizeof(Symbol*));
+    for (int i = 0; i < table->capacity; i++) {
+        Symbol* symbol = table->buckets[i];
+        while (symbol) {
+            Symbol* next = symbol->next;
+            unsigned int index = hash(symbol->name) % capacity;
+            symbol->next = buckets[index];
+            buckets[index] = symbol;
+            symbol = next;
+        }
+    }
+    free(table->buckets);
+    table->buckets = buckets;
+    table->capacity = capacity;
+}
+
 int defineSymbol(SymbolTable* table, const char* name, SymbolType type, 
                  ASTNode* typeNode, int line) {
     if (!table || !name) return 0;
+    if (table->count >= table->capacity) growTable(table);
     
     unsigned int index = hash(name) % table->capacity;
     
@@ -96,7 +151,7 @@ int defineSymbol(SymbolTable* table, const char* name, SymbolType type,
     while (existing) {
         if (strcmp(existing->name, name) == 0 && 
             existing->scopeDepth == table->scopeDepth) {
-            fprintf(stderr, "[line %d] Error: Symbol '%s' already defined in this scope\n", 
+            reportError(table, "[line %d] Error: Symbol '%s' already defined in this scope\n", 
                     line, name);
             return 0;
         }
@@ -110,10 +165,16 @@ int defineSymbol(SymbolTable* table, const char* name, SymbolType type,
     symbol->typeNode = typeNode;
     symbol->scopeDepth = table->scopeDepth;
     symbol->definedLine = line;
+    symbol->isMutable = 0;
+    // Params and locals of the function being checked get the next frame slot
+    symbol->slot = table->parent && (type == SYM_VARIABLE || type == SYM_PARAMETER)
+                   ? table->slotCount++ : -1;
     
     // Insert at the head of the bucket list
     symbol->next = table->buckets[index];
     table->buckets[index] = symbol;
+    symbol->defined = table->lastDefined;
+    table->lastDefined = symbol;
     table->count++;
     
     return 1;
@@ -139,6 +200,8 @@ Symbol* resolveSymbol(SymbolTable* table, const char* name) {
         symbol = symbol->next;
     }
     
+    // Fall back to the enclosing (read-only) layer
+    if (!found && table->parent) return resolveSymbol(table->parent, name);
     return found;
 }
 
@@ -157,46 +220,382 @@ static TypeInfo* createTypeInfo(const char* name, int size, int isPrimitive) {
 static void freeTypeInfo(TypeInfo* info) {
     if (!info) return;
     free(info->name);
+    freeTypeInfo(info->base);
     free(info);
 }
 
+// 'T[]', taking ownership of the element type
+static TypeInfo* createArrayTypeInfo(TypeInfo* element) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s[]", element->name);
+    TypeInfo* info = createTypeInfo(name, sizeof(void*), 0);
+    info->isArray = 1;
+    info->base = element;
+    return info;
+}
+
+static TypeInfo* copyTypeInfo(TypeInfo* info) {
+    TypeInfo* copy = createTypeInfo(info->name, info->size, info->isPrimitive);
+    copy->isArray = info->isArray;
+    copy->base = info->base ? copyTypeInfo(info->base) : NULL;
+    return copy;
+}
+
+// Primitive type names and the keywords that declare them
+static const struct {
+    const char* name;
+    TokenType keyword;
+} primitiveTypes[] = {
+    {"int", TOKEN_INT},
+    {"float", TOKEN_FLOAT},
+    {"bool", TOKEN_BOOL},
+    {"string", TOKEN_STRING_TYPE},
+};
+
+#define PRIMITIVE_TYPE_COUNT ((int)(sizeof(primitiveTypes) / sizeof(primitiveTypes[0])))
+
+static int primitiveIndex(const char* name) {
+    for (int i = 0; i < PRIMITIVE_TYPE_COUNT; i++) {
+        if (strcmp(primitiveTypes[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// Whether values of this type can be array elements
+static int isElementType(TypeInfo* info) {
+    return !info->isArray && primitiveIndex(info->name) >= 0;
+}
+
+// A type literal node naming `type`, for a declaration whose type is
+// inferred; types without a keyword get a TOKEN_IDENTIFIER that resolves
+// to no type
+static ASTNode* createTypeNode(TypeInfo* type, int line) {
+    int index = primitiveIndex(type->isArray ? type->base->name : type->name);
+    Token tkn;
+    tkn.type = index >= 0 ? primitiveTypes[index].keyword : TOKEN_IDENTIFIER;
+    tkn.start = index >= 0 ? primitiveTypes[index].name : "?";
+    tkn.length = (int)strlen(tkn.start);
+    tkn.line = line;
+    ASTNode* lit = createLiteralNode(tkn);
+    lit->literal.isArray = type->isArray;
+    return lit;
+}
+
+// Type of a value literal or of the type keyword naming it
+static TypeInfo* literalTypeInfo(Token token) {
+    switch (token.type) {
+        case TOKEN_NUMBER:
+            // Check for decimal point
+            for (int i = 0; i < token.length; i++) {
+                if (token.start[i] == '.') {
+                    return createTypeInfo("float", sizeof(float), 1);
+                }
+            }
+            return createTypeInfo("int", sizeof(int), 1);
+        case TOKEN_STRING:
+            return createTypeInfo("string", sizeof(char*), 1);
+        case TOKEN_TRUE:
+        case TOKEN_FALSE:
+            return createTypeInfo("bool", sizeof(int), 1);
+        case TOKEN_INT:
+            return createTypeInfo("int", sizeof(int), 1);
+        case TOKEN_FLOAT:
+            return createTypeInfo("float", sizeof(float), 1);
+        case TOKEN_BOOL:
+            return createTypeInfo("bool", sizeof(int), 1);
+        case TOKEN_STRING_TYPE:
+            return createTypeInfo("string", sizeof(char*), 1);
+        case TOKEN_VOID:
+            return createTypeInfo("void", 0, 1);
+        default:
+            return NULL;
+    }
+}
+
+// Resolve a variable reference and record the frame slot of the local it
+// names on the node, so later passes index locals instead of searching names
+static Symbol* resolveVariable(ASTNode* node, SymbolTable* symbols) {
+    Symbol* symbol = resolveSymbol(symbols, node->varRef.name);
+    node->varRef.slot = symbol ? symbol->slot : -1;
+    return symbol;
+}
+
+// Resolve a GET_EXPR chain once through the namespace trie. The trie entry,
+// its linker name and (once found) the symbol are cached on the node, so
+// repeated lookups do not rebuild the dotted name.
+static Symbol* resolveMemberSymbol(ASTNode* node, SymbolTable* symbols) {
+    if (node->get.symbol) return node->get.symbol;
+    NamespaceNode* ns = resolveQualifiedName(node);
+    if (!ns) return NULL;
+    node->get.symbol = resolveSymbol(symbols, ns->qualifiedName);
+    return node->get.symbol;
+}
+
+// Check a call against a runtime registry entry (argument count and types)
+static int checkRuntimeCall(ASTNode* node, const RuntimeFunc* runtime,
+                            SymbolTable* symbols, TypeInfo** outType) {
+    int argCount = node->call.argCount;
+    if (argCount < runtime->paramCount ||
+        (!runtime->isVariadic && argCount != runtime->paramCount)) {
+        reportError(symbols, "[line %d] Error: Argument count mismatch in call to '%s'\n",
+                node->line, runtime->name);
+        return 0;
+    }
+
+    for (int i = 0; i < argCount; i++) {
+        TypeInfo* argType = getTypeInfo(node->call.args[i], symbols);
+        if (!argType) {
+            reportError(symbols, "[line %d] Error: Cannot determine argument type\n", node->line);
+            return 0;
+        }
+        // Variadic tail arguments take any type (floats are passed as doubles)
+        const char* expected = i < runtime->paramCount ? abiMinoTypeName(runtime->params[i]) : argType->name;
+        if (strcmp(argType->name, expected) != 0) {
+            reportError(symbols, "[line %d] Error: Argument type mismatch in call to '%s' (expected %s, got %s)\n",
+                    node->line, runtime->name, expected, argType->name);
+            freeTypeInfo(argType);
+            return 0;
+        }
+        freeTypeInfo(argType);
+    }
+
+    const char* ret = abiMinoTypeName(runtime->ret);
+    *outType = createTypeInfo(ret, runtime->ret == ABI_VOID ? 0 : 8, 1);
+    return 1;
+}
+
+static int checkCall(ASTNode* node, SymbolTable* symbols, TypeInfo** outType);
+
+// Type of `object` when it is an array, NULL otherwise. Namespace chains
+// (sys.IO.print) are left alone: they are resolved as qualified names.
+static TypeInfo* arrayReceiverType(ASTNode* object, SymbolTable* symbols) {
+    if (!object || object->type == NODE_GET_EXPR) return NULL;
+    if (object->type == NODE_VARIABLE) {
+        Symbol* symbol = resolveSymbol(symbols, object->varRef.name);
+        if (!symbol || symbol->type == SYM_FUNCTION || !symbol->typeNode ||
+            symbol->typeNode->type != NODE_LITERAL || !symbol->typeNode->literal.isArray) {
+            return NULL;
+        }
+    }
+    TypeInfo* type = getTypeInfo(object, symbols);
+    if (type && !type->isArray) {
+        freeTypeInfo(type);
+        return NULL;
+    }
+    return type;
+}
+
+// Check a lambda passed to an array method. Its params take `paramTypes`
+// and get frame slots in a scope of their own; *bodyType receives the type
+// of the body (NULL for a call without a result).
+static int checkLambda(ASTNode* lambda, TypeInfo** paramTypes, SymbolTable* symbols,
+                       TypeInfo** bodyType) {
+    *bodyType = NULL;
+    if (!enterScope(symbols)) return 0;
+
+    int ok = 1;
+    for (int i = 0; ok && i < lambda->lambda.paramCount; i++) {
+        ASTNode* p = lambda->lambda.params[i];
+        if (!p->variable.type) p->variable.type = createTypeNode(paramTypes[i], p->line);
+        ok = defineSymbol(symbols, p->variable.name, SYM_PARAMETER, p->variable.type, p->line);
+        if (ok) p->variable.slot = resolveSymbol(symbols, p->variable.name)->slot;
+    }
+
+    ASTNode* body = lambda->lambda.body;
+    if (ok && body && body->type == NODE_CALL_EXPR) {
+        ok = checkCall(body, symbols, bodyType);
+    } else if (ok) {
+        *bodyType = getTypeInfo(body, symbols);
+        ok = *bodyType != NULL;
+    }
+
+    exitScope(symbols);
+    return ok;
+}
+
+// Check a built-in method call on an array of type `array` (owned):
+//   each((x) => ...)               void
+//   map((x) => e)                  array of e's type
+//   reduce(init, (acc, x) => e)    init's type, which e must have
+//   sum()                          element type, int or float arrays
+// The method, element type and hidden loop slots are recorded on the node.
+static int checkArrayMethod(ASTNode* node, TypeInfo* array, SymbolTable* symbols, TypeInfo** outType) {
+    const char* name = node->call.callee->get.name;
+    TypeInfo* element = array->base;
+    ArrayMethod method = ARRAY_METHOD_NONE;
+    int argCount = 0;
+    if (strcmp(name, "each") == 0) { method = ARRAY_METHOD_EACH; argCount = 1; }
+    else if (strcmp(name, "map") == 0) { method = ARRAY_METHOD_MAP; argCount = 1; }
+    else if (strcmp(name, "reduce") == 0) { method = ARRAY_METHOD_REDUCE; argCount = 2; }
+    else if (strcmp(name, "sum") == 0) { method = ARRAY_METHOD_SUM; argCount = 0; }
+
+    int ok = 1;
+    if (method == ARRAY_METHOD_NONE) {
+        reportError(symbols, "[line %d] Error: Unknown array method '%s'\n", node->line, name);
+        ok = 0;
+    } else if (!symbols->parent) {
+        reportError(symbols, "[line %d] Error: Arrays are only supported inside functions\n", node->line);
+        ok = 0;
+    } else if (node->call.argCount != argCount) {
+        reportError(symbols, "[line %d] Error: Argument count mismatch in call to '%s'\n", node->line, name);
+        ok = 0;
+    } else if (method == ARRAY_METHOD_SUM && strcmp(element->name, "int") != 0 &&
+               strcmp(element->name, "float") != 0) {
+        reportError(symbols, "[line %d] Error: sum() needs an int or float array\n", node->line);
+        ok = 0;
+    }
+
+    // reduce's accumulator starts as its first argument
+    TypeInfo* accType = NULL;
+    if (ok && method == ARRAY_METHOD_REDUCE) {
+        accType = getTypeInfo(node->call.args[0], symbols);
+        if (!accType || !isElementType(accType)) {
+            reportError(symbols, "[line %d] Error: reduce() needs an int, float, bool or string initial value\n",
+                    node->line);
+            ok = 0;
+        }
+    }
+
+    TypeInfo* bodyType = NULL;
+    if (ok && argCount > 0) {
+        ASTNode* lambda = node->call.args[argCount - 1];
+        int paramCount = method == ARRAY_METHOD_REDUCE ? 2 : 1;
+        TypeInfo* paramTypes[2] = {accType ? accType : element, element};
+        if (lambda->type != NODE_LAMBDA || lambda->lambda.paramCount != paramCount) {
+            reportError(symbols, "[line %d] Error: %s() takes a lambda of %d parameter%s\n",
+                    node->line, name, paramCount, paramCount == 1 ? "" : "s");
+            ok = 0;
+        } else {
+            ok = checkLambda(lambda, paramTypes, symbols, &bodyType);
+        }
+    }
+
+    if (ok && method == ARRAY_METHOD_MAP && (!bodyType || !isElementType(bodyType))) {
+        reportError(symbols, "[line %d] Error: map() must produce int, float, bool or string values\n", node->line);
+        ok = 0;
+    }
+    if (ok && method == ARRAY_METHOD_REDUCE && !areTypesCompatible(bodyType, accType)) {
+        reportError(symbols, "[line %d] Error: reduce() lambda must return %s\n", node->line, accType->name);
+        ok = 0;
+    }
+
+    if (ok) {
+        switch (method) {
+            case ARRAY_METHOD_EACH: *outType = createTypeInfo("void", 0, 1); break;
+            case ARRAY_METHOD_MAP: *outType = createArrayTypeInfo(bodyType); bodyType = NULL; break;
+            case ARRAY_METHOD_REDUCE: *outType = accType; accType = NULL; break;
+            default: *outType = copyTypeInfo(element); break;
+        }
+        node->call.arrayMethod = method;
+        node->call.elementType = primitiveTypes[primitiveIndex(element->name)].keyword;
+        // index and accumulators of the loop it lowers to; a re-check of the
+        // same call keeps them
+        if (node->call.slot < 0) {
+            node->call.slot = symbols->slotCount;
+            symbols->slotCount += 3;
+        }
+    }
+
+    freeTypeInfo(bodyType);
+    freeTypeInfo(accType);
+    freeTypeInfo(array);
+    return ok;
+}
+
+// Check a call expression; returns 0 on error. *outType receives the call's
+// result type (NULL for functions without a declared return type).
+static int checkCall(ASTNode* node, SymbolTable* symbols, TypeInfo** outType) {
+    *outType = NULL;
+
+    // callee should be VARIABLE or a GET_EXPR chain; resolve its symbol
+    ASTNode* callee = node->call.callee;
+    if (callee && callee->type == NODE_GET_EXPR) {
+        TypeInfo* array = arrayReceiverType(callee->get.object, symbols);
+        if (array) return checkArrayMethod(node, array, symbols, outType);
+    }
+    const char* calleeName = NULL;
+    Symbol* symbol = NULL;
+    if (callee && callee->type == NODE_VARIABLE) {
+        calleeName = callee->varRef.name;
+        symbol = resolveSymbol(symbols, calleeName);
+    } else if (callee && callee->type == NODE_GET_EXPR) {
+        symbol = resolveMemberSymbol(callee, symbols);
+        if (callee->get.ns) calleeName = callee->get.ns->qualifiedName;
+    }
+    if (!calleeName) {
+        reportError(symbols, "[line %d] Error: Unsupported callee in call\n", node->line);
+        return 0;
+    }
+
+    // Not a Mino function: look the callee up in the typed runtime registry
+    if (!symbol) {
+        const char* linkName = callee->type == NODE_GET_EXPR ? callee->get.linkName : calleeName;
+        const RuntimeFunc* runtime = lookupRuntimeFunc(linkName);
+        if (!runtime) {
+            if (strncmp(calleeName, "sys", 3) == 0) {
+                reportError(symbols, "[line %d] Error: Unknown runtime function '%s'\n", node->line, calleeName);
+            } else {
+                reportError(symbols, "[line %d] Error: Undefined function in call\n", node->line);
+            }
+            return 0;
+        }
+        node->call.runtime = runtime;
+        return checkRuntimeCall(node, runtime, symbols, outType);
+    }
+
+    if (symbol->type != SYM_FUNCTION || !symbol->typeNode ||
+        symbol->typeNode->type != NODE_FUNCTION_DECL) {
+        reportError(symbols, "[line %d] Error: Called symbol is not a function\n", node->line);
+        return 0;
+    }
+
+    ASTNode* func = symbol->typeNode;
+    node->call.function = func;
+    int expected = func->function.paramCount;
+    if (expected != node->call.argCount) {
+        reportError(symbols, "[line %d] Error: Argument count mismatch in call\n", node->line);
+        return 0;
+    }
+
+    // Check parameter types
+    for (int i = 0; i < node->call.argCount; i++) {
+        TypeInfo* argType = getTypeInfo(node->call.args[i], symbols);
+        TypeInfo* paramType = getTypeInfo(func->function.params[i]->variable.type, symbols);
+        if (!argType || !paramType) {
+            if (argType) freeTypeInfo(argType);
+            if (paramType) freeTypeInfo(paramType);
+            reportError(symbols, "[line %d] Error: Cannot determine argument type\n", node->line);
+            return 0;
+        }
+
+        if (!areTypesCompatible(argType, paramType)) {
+            reportError(symbols, "[line %d] Error: Argument type mismatch\n", node->line);
+            freeTypeInfo(argType);
+            freeTypeInfo(paramType);
+            return 0;
+        }
+
+        freeTypeInfo(argType);
+        freeTypeInfo(paramType);
+    }
+
+    // Return the function's return type
+    *outType = getTypeInfo(func->function.returnType, symbols);
+    return 1;
+}
+
 TypeInfo* getTypeInfo(ASTNode* node, SymbolTable* symbols) {
     if (!node) return NULL;
     
     switch (node->type) {
         case NODE_LITERAL: {
-            Token token = node->literal.token;
-            switch (token.type) {
-                case TOKEN_NUMBER:
-                    // Check for decimal point
-                    for (int i = 0; i < token.length; i++) {
-                        if (token.start[i] == '.') {
-                            return createTypeInfo("float", sizeof(float), 1);
-                        }
-                    }
-                    return createTypeInfo("int", sizeof(int), 1);
-                case TOKEN_STRING:
-                    return createTypeInfo("string", sizeof(char*), 1);
-                case TOKEN_TRUE:
-                case TOKEN_FALSE:
-                    return createTypeInfo("bool", sizeof(int), 1);
-                case TOKEN_INT:
-                    return createTypeInfo("int", sizeof(int), 1);
-                case TOKEN_FLOAT:
-                    return createTypeInfo("float", sizeof(float), 1);
-                case TOKEN_BOOL:
-                    return createTypeInfo("bool", sizeof(int), 1);
-                case TOKEN_STRING_TYPE:
-                    return createTypeInfo("string", sizeof(char*), 1);
-                case TOKEN_VOID:
-                    return createTypeInfo("void", 0, 1);
-                default:
-                    return NULL;
-            }
+            TypeInfo* type = literalTypeInfo(node->literal.token);
+            if (type && node->literal.isArray) return createArrayTypeInfo(type);
+            return type;
         }
             
         case NODE_VARIABLE: {
-            Symbol* symbol = resolveSymbol(symbols, node->varRef.name);
+            Symbol* symbol = resolveVariable(node, symbols);
             if (!symbol) return NULL;
 
             // If this is a function symbol, return the function's return type
@@ -207,15 +606,7 @@ TypeInfo* getTypeInfo(ASTNode* node, SymbolTable* symbols) {
             }
 
             if (symbol->typeNode && symbol->typeNode->type == NODE_LITERAL) {
-                Token typeToken = symbol->typeNode->literal.token;
-                switch (typeToken.type) {
-                    case TOKEN_INT: return createTypeInfo("int", sizeof(int), 1);
-                    case TOKEN_FLOAT: return createTypeInfo("float", sizeof(float), 1);
-                    case TOKEN_BOOL: return createTypeInfo("bool", sizeof(int), 1);
-                    case TOKEN_STRING_TYPE: return createTypeInfo("string", sizeof(char*), 1);
-                    case TOKEN_VOID: return createTypeInfo("void", 0, 1);
-                    default: return NULL;
-                }
+                return getTypeInfo(symbol->typeNode, symbols);
             }
             return NULL;
         }
@@ -232,53 +623,77 @@ TypeInfo* getTypeInfo(ASTNode* node, SymbolTable* symbols) {
             
             // Check type compatibility
             if (strcmp(leftType->name, rightType->name) != 0) {
-                fprintf(stderr, "[line %d] Error: Type mismatch in binary expression\n", 
+                reportError(symbols, "[line %d] Error: Type mismatch in binary expression\n", 
                         node->line);
                 freeTypeInfo(leftType);
                 freeTypeInfo(rightType);
                 return NULL;
             }
+
+            // Comparisons yield bool; ordering needs int or float, == and != also take bool
+            TokenType op = node->binary.op.type;
+            if (op == TOKEN_LESS || op == TOKEN_LESS_EQUAL || op == TOKEN_GREATER ||
+                op == TOKEN_GREATER_EQUAL || op == TOKEN_EQUAL_EQUAL || op == TOKEN_BANG_EQUAL) {
+                int isEquality = op == TOKEN_EQUAL_EQUAL || op == TOKEN_BANG_EQUAL;
+                int ok = strcmp(leftType->name, "int") == 0 || strcmp(leftType->name, "float") == 0 ||
+                         (isEquality && strcmp(leftType->name, "bool") == 0);
+                if (!ok) {
+                    reportError(symbols, "[line %d] Error: Cannot compare values of type %s\n",
+                            node->line, leftType->name);
+                }
+                freeTypeInfo(leftType);
+                freeTypeInfo(rightType);
+                return ok ? createTypeInfo("bool", sizeof(int), 1) : NULL;
+            }
+
+            if (leftType->isArray) {
+                reportError(symbols, "[line %d] Error: Arithmetic on arrays is not supported\n", node->line);
+                freeTypeInfo(leftType);
+                freeTypeInfo(rightType);
+                return NULL;
+            }
+
+            if (op == TOKEN_PERCENT && strcmp(leftType->name, "int") != 0) {
+                reportError(symbols, "[line %d] Error: Operator '%%' needs int operands\n", node->line);
+                freeTypeInfo(leftType);
+                freeTypeInfo(rightType);
+                return NULL;
+            }
             
             freeTypeInfo(rightType);
             return leftType; // Return left operand type
         }
 
+        case NODE_UNARY_EXPR: {
+            // int(x) truncates a float toward zero, float(x) widens an int
+            TypeInfo* operandType = getTypeInfo(node->unary.operand, symbols);
+            if (!operandType) return NULL;
+            int ok = strcmp(operandType->name, "int") == 0 || strcmp(operandType->name, "float") == 0;
+            if (!ok) {
+                reportError(symbols, "[line %d] Error: Cannot convert a %s\n", node->line, operandType->name);
+            }
+            freeTypeInfo(operandType);
+            if (!ok) return NULL;
+            if (node->unary.op.type == TOKEN_FLOAT) return createTypeInfo("float", sizeof(float), 1);
+            return createTypeInfo("int", sizeof(int), 1);
+        }
+
         case NODE_GET_EXPR: {
-            // Resolve symbol by full chained name, e.g. sys.IO.print -> "sys.IO.print"
-            // Build the chained name
-            char* fullname = NULL;
-            // Helper: recursive name construction
-            ASTNode* cur = node;
-            // Use a small recursive helper to generate fullname
-            function_char_concat:;
-            ;
-            // Recursively obtain object name
-            char* getNameRecursive(ASTNode* n) {
-                if (!n) return NULL;
-                if (n->type == NODE_VARIABLE) {
-                    return strdup(n->varRef.name);
-                }
-                if (n->type == NODE_GET_EXPR) {
-                    char* left = getNameRecursive(n->get.object);
-                    if (!left) return NULL;
-                    int len = strlen(left) + 1 + strlen(n->get.name) + 1;
-                    char* res = malloc(len);
-                    snprintf(res, len, "%s.%s", left, n->get.name);
-                    free(left);
-                    return res;
+            // 'a.length' is the only property of an array
+            TypeInfo* array = arrayReceiverType(node->get.object, symbols);
+            if (array) {
+                freeTypeInfo(array);
+                if (strcmp(node->get.name, "length") != 0) {
+                    reportError(symbols, "[line %d] Error: Unknown array property '%s'\n",
+                            node->line, node->get.name);
+                    return NULL;
                 }
-                return NULL;
+                node->get.isLength = 1;
+                return createTypeInfo("int", sizeof(int), 1);
             }
 
-            fullname = getNameRecursive(node->get.object);
-            if (!fullname) return NULL;
-            int needed = strlen(fullname) + 1 + strlen(node->get.name) + 1;
-            char* total = malloc(needed);
-            snprintf(total, needed, "%s.%s", fullname, node->get.name);
-            free(fullname);
-
-            Symbol* symbol = resolveSymbol(symbols, total);
-            free(total);
+            // Resolve the chain through the namespace trie (cached on the node)
+            Symbol* symbol = resolveMemberSymbol(node, symbols);
             if (!symbol) return NULL;
 
             // If the symbol is a function, return its return type
@@ -295,95 +710,43 @@ TypeInfo* getTypeInfo(ASTNode* node, SymbolTable* symbols) {
         }
 
         case NODE_CALL_EXPR: {
-            // callee should be VARIABLE or a GET_EXPR chain; resolve its symbol
-            // First try resolving by callee name
-            char* calleeName = NULL;
-            char* getNameRecursive2(ASTNode* n) {
-                if (!n) return NULL;
-                if (n->type == NODE_VARIABLE) return strdup(n->varRef.name);
-                if (n->type == NODE_GET_EXPR) {
-                    char* left = getNameRecursive2(n->get.object);
-                    if (!left) return NULL;
-                    int len = strlen(left) + 1 + strlen(n->get.name) + 1;
-                    char* res = malloc(len);
-                    snprintf(res, len, "%s.%s", left, n->get.name);
-                    free(left);
-                    return res;
-                }
-                return NULL;
-            }
-
-            calleeName = getNameRecursive2(node->call.callee);
-            if (!calleeName) return NULL;
-
-            Symbol* symbol = resolveSymbol(symbols, calleeName);
-            // If symbol not found, allow calls to runtime 'sys' namespace as external functions
-            if (!symbol) {
-                // check if calleeName starts with "sys" (e.g., sys.Math.powInt or sys_IO_print_PrintInt)
-                if (strncmp(calleeName, "sys", 3) == 0) {
-                    // naive external function: ensure argument types are inferable (prefer int)
-                    for (int i = 0; i < node->call.argCount; i++) {
-                        TypeInfo* at = getTypeInfo(node->call.args[i], symbols);
-                        if (!at) {
-                            // cannot determine arg type -> fail
-                            free(calleeName);
-                            return NULL;
-                        }
-                        // accept ints and floats for now
-                        if (strcmp(at->name, "int") != 0 && strcmp(at->name, "float") != 0) {
-                            freeTypeInfo(at);
-                            free(calleeName);
-                            return NULL;
-                        }
-                        freeTypeInfo(at);
-                    }
-                    // Default to int return type for integer-friendly runtime helpers
-                    free(calleeName);
-                    return createTypeInfo("int", sizeof(int), 1);
-                }
-                free(calleeName);
-                fprintf(stderr, "[line %d] Error: Undefined function in call\n", node->line);
-                return NULL;
-            }
+            TypeInfo* result = NULL;
+            checkCall(node, symbols, &result);
+            return result;
+        }
 
-            if (symbol->type != SYM_FUNCTION || !symbol->typeNode ||
-                symbol->typeNode->type != NODE_FUNCTION_DECL) {
-                fprintf(stderr, "[line %d] Error: Called symbol is not a function\n", node->line);
+        case NODE_ARRAY_LITERAL: {
+            // globals are not lowered, so an array there would read as null
+            if (!symbols || !symbols->parent) {
+                reportError(symbols, "[line %d] Error: Arrays are only supported inside functions\n", node->line);
                 return NULL;
             }
-
-            ASTNode* func = symbol->typeNode;
-            int expected = func->function.paramCount;
-            if (expected != node->call.argCount) {
-                fprintf(stderr, "[line %d] Error: Argument count mismatch in call\n", node->line);
+            if (node->array.count == 0) {
+                reportError(symbols, "[line %d] Error: Cannot infer the type of an empty array\n", node->line);
                 return NULL;
             }
 
-            // Check parameter types
-            for (int i = 0; i < node->call.argCount; i++) {
-                TypeInfo* argType = getTypeInfo(node->call.args[i], symbols);
-                TypeInfo* paramType = getTypeInfo(func->function.params[i]->variable.type, symbols);
-                if (!argType || !paramType) {
-                    if (argType) freeTypeInfo(argType);
-                    if (paramType) freeTypeInfo(paramType);
-                    fprintf(stderr, "[line %d] Error: Cannot determine argument type\n", node->line);
-                    return NULL;
-                }
-
-                if (!areTypesCompatible(argType, paramType)) {
-                    fprintf(stderr, "[line %d] Error: Argument type mismatch\n", node->line);
-                    freeTypeInfo(argType);
-                    freeTypeInfo(paramType);
+            TypeInfo* element = NULL;
+            for (int i = 0; i < node->array.count; i++) {
+                TypeInfo* type = getTypeInfo(node->array.elements[i], symbols);
+                const char* problem = !type ? NULL :
+                    !isElementType(type) ? "Array elements must be int, float, bool or string" :
+                    element && !areTypesCompatible(element, type) ? "Array elements must all have the same type" : NULL;
+                if (!type || problem) {
+                    if (problem) reportError(symbols, "[line %d] Error: %s\n", node->line, problem);
+                    freeTypeInfo(type);
+                    freeTypeInfo(element);
                     return NULL;
                 }
-
-                freeTypeInfo(argType);
-                freeTypeInfo(paramType);
+                if (element) freeTypeInfo(type);
+                else element = type;
             }
-
-            // Return the function's return type
-            return getTypeInfo(func->function.returnType, symbols);
+            return createArrayTypeInfo(element);
         }
+
+        case NODE_LAMBDA:
+            reportError(symbols, "[line %d] Error: A lambda can only be passed to an array method\n", node->line);
+            return NULL;
             
         default:
             return NULL;
@@ -395,6 +758,80 @@ int areTypesCompatible(TypeInfo* t1, TypeInfo* t2) {
     return strcmp(t1->name, t2->name) == 0;
 }
 
+// ============ Parallel function checking ============
+
+#define MAX_CHECK_WORKERS 64
+
+// Function bodies only read the global layer and their own locals, so each
+// one is checked on its own local table by a pool of workers.
+typedef struct {
+    ASTNode** functions;
+    int count;
+    int next;                 // next function to claim (atomic)
+    SymbolTable* globals;     // read-only while the workers run
+    int* results;
+    char** diagnostics;       // buffered per function, printed in source order
+} FunctionCheckPool;
+
+static void checkFunctionBody(FunctionCheckPool* pool, int index) {
+    SymbolTable* locals = createLocalSymbolTable(pool->globals);
+    pool->results[index] = typeCheck(pool->functions[index], locals);
+    pool->diagnostics[index] = locals->diagnostics;
+    locals->diagnostics = NULL;
+    freeSymbolTable(locals);
+}
+
+static void* functionCheckWorker(void* arg) {
+    FunctionCheckPool* pool = arg;
+    while (1) {
+        int index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        if (index >= pool->count) break;
+        checkFunctionBody(pool, index);
+    }
+    return NULL;
+}
+
+static int checkFunctions(ASTNode** functions, int count, SymbolTable* globals) {
+    if (count == 0) return 1;
+
+    FunctionCheckPool pool;
+    pool.functions = functions;
+    pool.count = count;
+    pool.next = 0;
+    pool.globals = globals;
+    pool.results = calloc(count, sizeof(int));
+    pool.diagnostics = calloc(count, sizeof(char*));
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 1 ? (int)cpus : 1;
+    if (workers > count) workers = count;
+    if (workers > MAX_CHECK_WORKERS) workers = MAX_CHECK_WORKERS;
+
+    // The calling thread is one of the workers
+    pthread_t threads[MAX_CHECK_WORKERS];
+    int started = 0;
+    for (int i = 1; i < workers; i++) {
+        if (pthread_create(&threads[started], NULL, functionCheckWorker, &pool) != 0) break;
+        started++;
+    }
+    functionCheckWorker(&pool);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+
+    // Report diagnostics in source order
+    int ok = 1;
+    for (int i = 0; i < count; i++) {
+        if (pool.diagnostics[i]) {
+            fputs(pool.diagnostics[i], stderr);
+            free(pool.diagnostics[i]);
+        }
+        if (!pool.results[i]) ok = 0;
+    }
+
+    free(pool.results);
+    free(pool.diagnostics);
+    return ok;
+}
+
 int typeCheck(ASTNode* node, SymbolTable* symbols) {
     if (!node) return 1;
     
@@ -410,13 +847,37 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
                 }
             }
 
-            // Then perform type checking
+            // Function bodies (a nested PROGRAM inside a scope) are checked in order
+            if (symbols->scopeDepth > 0 || symbols->parent) {
+                for (int i = 0; i < node->program.count; i++) {
+                    if (!typeCheck(node->program.statements[i], symbols)) {
+                        return 0;
+                    }
+                }
+                return 1;
+            }
+
+            // Top level: global statements first, building the global layer
+            int functionCount = 0;
             for (int i = 0; i < node->program.count; i++) {
-                if (!typeCheck(node->program.statements[i], symbols)) {
+                ASTNode* s = node->program.statements[i];
+                if (s && s->type == NODE_FUNCTION_DECL) {
+                    functionCount++;
+                } else if (!typeCheck(s, symbols)) {
                     return 0;
                 }
             }
-            return 1;
+
+            // Then check function bodies concurrently against the frozen globals
+            ASTNode** functions = malloc(sizeof(ASTNode*) * (functionCount > 0 ? functionCount : 1));
+            int n = 0;
+            for (int i = 0; i < node->program.count; i++) {
+                ASTNode* s = node->program.statements[i];
+                if (s && s->type == NODE_FUNCTION_DECL) functions[n++] = s;
+            }
+            int ok = checkFunctions(functions, functionCount, symbols);
+            free(functions);
+            return ok;
         }
             
         case NODE_VAR_DECL: {
@@ -426,35 +887,22 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
                 TypeInfo* declType = getTypeInfo(node->variable.type, symbols);
 
                 if (!initType && !declType) {
-                    fprintf(stderr, "[line %d] Error: Cannot determine type (var '%s')\n", node->line, node->variable.name);
+                    reportError(symbols, "[line %d] Error: Cannot determine type (var '%s')\n", node->line, node->variable.name);
                     if (node->variable.type && node->variable.type->type == NODE_LITERAL) {
                         Token t = node->variable.type->literal.token;
-                        fprintf(stderr, "  Decl type token: %d '%.*s'\n", t.type, t.length, t.start);
+                        reportError(symbols, "  Decl type token: %d '%.*s'\n", t.type, t.length, t.start);
                     } else {
-                        fprintf(stderr, "  Decl type node missing or not literal\n");
+                        reportError(symbols, "  Decl type node missing or not literal\n");
                     }
                     if (node->variable.initializer) {
-                        fprintf(stderr, "  Initializer node type: %d\n", node->variable.initializer->type);
+                        reportError(symbols, "  Initializer node type: %d\n", node->variable.initializer->type);
                     }
                     return 0;
                 }
 
                 // If no explicit decl type, but can infer from initializer, create a literal type node
                 if (!declType && initType) {
-                    Token tkn;
-                    if (strcmp(initType->name, "int") == 0) tkn.type = TOKEN_INT;
-                    else if (strcmp(initType->name, "float") == 0) tkn.type = TOKEN_FLOAT;
-                    else if (strcmp(initType->name, "bool") == 0) tkn.type = TOKEN_BOOL;
-                    else if (strcmp(initType->name, "string") == 0) tkn.type = TOKEN_STRING_TYPE;
-                    else tkn.type = TOKEN_IDENTIFIER;
-                    char* s = strdup(initType->name);
-                    tkn.start = s;
-                    tkn.length = (int)strlen(s);
-                    tkn.line = node->line;
-                    ASTNode* lit = createLiteralNode(tkn);
-                    // createLiteralNode copies token but we need to free allocated start
-                    free(s);
-                    node->variable.type = lit;
+                    node->variable.type = createTypeNode(initType, node->line);
                     // refresh declType
                     freeTypeInfo(initType);
                     initType = NULL;
@@ -467,11 +915,11 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
                     if (!finalInit || !finalDecl) {
                         if (finalInit) freeTypeInfo(finalInit);
                         if (finalDecl) freeTypeInfo(finalDecl);
-                        fprintf(stderr, "[line %d] Error: Cannot determine type\n", node->line);
+                        reportError(symbols, "[line %d] Error: Cannot determine type\n", node->line);
                         return 0;
                     }
                     if (!areTypesCompatible(finalInit, finalDecl)) {
-                        fprintf(stderr, "[line %d] Error: Type mismatch in variable initialization\n", node->line);
+                        reportError(symbols, "[line %d] Error: Type mismatch in variable initialization\n", node->line);
                         freeTypeInfo(finalInit);
                         freeTypeInfo(finalDecl);
                         return 0;
@@ -486,10 +934,42 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
                              node->variable.type, node->line)) {
                 return 0;
             }
+            Symbol* symbol = resolveSymbol(symbols, node->variable.name);
+            symbol->isMutable = node->variable.isMutable;
+            node->variable.slot = symbol->slot;
 
             return 1;
         }
 
+        case NODE_BLOCK_STMT: {
+            if (!enterScope(symbols)) return 0;
+            for (int i = 0; i < node->block.count; i++) {
+                if (!typeCheck(node->block.statements[i], symbols)) {
+                    exitScope(symbols);
+                    return 0;
+                }
+            }
+            exitScope(symbols);
+            return 1;
+        }
+
+        case NODE_WHILE_STMT: {
+            // The for-initializer is scoped to the loop
+            if (!enterScope(symbols)) return 0;
+            int ok = typeCheck(node->loop.init, symbols);
+            if (ok && node->loop.condition) {
+                TypeInfo* condType = getTypeInfo(node->loop.condition, symbols);
+                if (!condType || strcmp(condType->name, "bool") != 0) {
+                    reportError(symbols, "[line %d] Error: Loop condition must be bool\n", node->line);
+                    ok = 0;
+                }
+                if (condType) freeTypeInfo(condType);
+            }
+            ok = ok && typeCheck(node->loop.step, symbols) && typeCheck(node->loop.body, symbols);
+            exitScope(symbols);
+            return ok;
+        }
+
         case NODE_FUNCTION_DECL: {
             // Symbol should have been created during program pre-declaration; enter a new scope and register params
             if (!enterScope(symbols)) return 0;
@@ -501,14 +981,19 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
                     exitScope(symbols);
                     return 0;
                 }
+                p->variable.slot = resolveSymbol(symbols, p->variable.name)->slot;
             }
 
             // Type check function body
-            if (!typeCheck(node->function.body, symbols)) {
+            symbols->function = node;
+            int ok = typeCheck(node->function.body, symbols);
+            symbols->function = NULL;
+            if (!ok) {
                 exitScope(symbols);
                 return 0;
             }
 
+            node->function.slotCount = symbols->slotCount;
             exitScope(symbols);
             return 1;
         }
@@ -516,17 +1001,24 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
         case NODE_ASSIGN: {
             // Check if assignment target variable exists
             if (node->assignment.target->type != NODE_VARIABLE) {
-                fprintf(stderr, "[line %d] Error: Invalid assignment target\n", node->line);
+                reportError(symbols, "[line %d] Error: Invalid assignment target\n", node->line);
                 return 0;
             }
             
             char* varName = node->assignment.target->varRef.name;
-            Symbol* symbol = resolveSymbol(symbols, varName);
+            Symbol* symbol = resolveVariable(node->assignment.target, symbols);
             if (!symbol) {
-                fprintf(stderr, "[line %d] Error: Undefined variable '%s'\n", 
+                reportError(symbols, "[line %d] Error: Undefined variable '%s'\n", 
                         node->line, varName);
                 return 0;
             }
+
+            // Only 'var' locals can change; globals are read-only inside functions
+            if (symbol->type != SYM_VARIABLE || !symbol->isMutable ||
+                (symbols->parent && symbol->scopeDepth == 0)) {
+                reportError(symbols, "[line %d] Error: Cannot assign to '%s'\n", node->line, varName);
+                return 0;
+            }
             
             // Check type compatibility
             TypeInfo* targetType = getTypeInfo(symbol->typeNode, symbols);
@@ -535,12 +1027,12 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
             if (!targetType || !valueType) {
                 if (targetType) freeTypeInfo(targetType);
                 if (valueType) freeTypeInfo(valueType);
-                fprintf(stderr, "[line %d] Error: Cannot determine type\n", node->line);
+                reportError(symbols, "[line %d] Error: Cannot determine type\n", node->line);
                 return 0;
             }
             
             if (!areTypesCompatible(targetType, valueType)) {
-                fprintf(stderr, "[line %d] Error: Type mismatch in assignment\n", node->line);
+                reportError(symbols, "[line %d] Error: Type mismatch in assignment\n", node->line);
                 freeTypeInfo(targetType);
                 freeTypeInfo(valueType);
                 return 0;
@@ -552,16 +1044,58 @@ int typeCheck(ASTNode* node, SymbolTable* symbols) {
         }
             
         case NODE_RETURN_STMT: {
-            // TODO: Check return type matches function declaration
-            if (node->returnStmt.value) {
-                return typeCheck(node->returnStmt.value, symbols);
+            if (!node->returnStmt.value) return 1;
+            if (!typeCheck(node->returnStmt.value, symbols)) return 0;
+            // floats travel in different registers, so they must match the
+            // declared type exactly (other mismatches are still let through)
+            ASTNode* declared = symbols->function ? symbols->function->function.returnType : NULL;
+            TypeInfo* returnType = declared ? getTypeInfo(declared, symbols) : NULL;
+            TypeInfo* valueType = returnType ? getTypeInfo(node->returnStmt.value, symbols) : NULL;
+            int ok = 1;
+            if (returnType && valueType && !areTypesCompatible(returnType, valueType) &&
+                (strcmp(returnType->name, "float") == 0 || strcmp(valueType->name, "float") == 0)) {
+                reportError(symbols, "[line %d] Error: Return type mismatch (expected %s, got %s)\n",
+                        node->line, returnType->name, valueType->name);
+                ok = 0;
             }
-            return 1;
+            if (returnType) freeTypeInfo(returnType);
+            if (valueType) freeTypeInfo(valueType);
+            return ok;
         }
             
         case NODE_BINARY_EXPR:
+        case NODE_UNARY_EXPR:
+        case NODE_ARRAY_LITERAL:
+        case NODE_LAMBDA: {
             // Type checking is already performed in getTypeInfo
-            return getTypeInfo(node, symbols) != NULL;
+            TypeInfo* type = getTypeInfo(node, symbols);
+            freeTypeInfo(type);
+            return type != NULL;
+        }
+
+        case NODE_GET_EXPR: {
+            // 'a.length' is checked like any expression; other member reads
+            // (namespaced globals) are resolved when they are lowered
+            TypeInfo* array = arrayReceiverType(node->get.object, symbols);
+            if (!array) return 1;
+            freeTypeInfo(array);
+            TypeInfo* type = getTypeInfo(node, symbols);
+            freeTypeInfo(type);
+            return type != NULL;
+        }
+
+        case NODE_VARIABLE:
+            // e.g. 'return x': nothing to check, but the slot is needed
+            resolveVariable(node, symbols);
+            return 1;
+
+        case NODE_CALL_EXPR: {
+            // Call statements: check arguments and resolve the callee
+            TypeInfo* result = NULL;
+            int ok = checkCall(node, symbols, &result);
+            if (result) freeTypeInfo(result);
+            return ok;
+        }
             
         default:
             // Other node types skipped for now
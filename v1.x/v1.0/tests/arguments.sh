@@ -0,0 +1,60 @@
+#!/bin/sh
+# Arguments go in registers only: 6 integers and 8 floats still work,
+# one more of either is a compile error instead of a wrong program, and
+# the C backend has no limit
+dir=$1
+cat > "$dir/fits.mino" <<'MINO'
+@noinline
+func float mix(int a, float p, int b, float q, int c, float r, int d, float s,
+               int e, float t, int f, float u, float v, float w) {
+    return float((a * 100000) + (b * 10000) + (c * 1000) + (d * 100) + (e * 10) + f) + p + q + r + s + t + u + v + w;
+}
+
+func int main() {
+    var one: int = 1;
+    return int(mix(one, 0.5, 2, 0.5, 3, 0.5, 4, 0.5, 5, 0.5, 6, 0.5, 0.5, 0.5) - 123400.0);
+}
+MINO
+"$MINOC" -o "$dir/fits.out" "$dir/fits.mino" > /dev/null || exit 1
+"$dir/fits.out"
+[ $? = 60 ] || { echo "fits.mino returned $?"; exit 1; }
+
+cat > "$dir/ints.mino" <<'MINO'
+@noinline
+func int seventh(int a, int b, int c, int d, int e, int f, int g) {
+    return g;
+}
+
+func int main() {
+    var g: int = 7;
+    return seventh(1, 2, 3, 4, 5, 6, g);
+}
+MINO
+cat > "$dir/floats.mino" <<'MINO'
+@noinline
+func float ninth(float a, float b, float c, float d, float e, float f, float g, float h, float i) {
+    return i;
+}
+
+func int main() {
+    var i: float = 9.0;
+    return int(ninth(1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, i));
+}
+MINO
+for name in ints:7 floats:9; do
+    expect=${name#*:}
+    name=${name%:*}
+    for flag in "" -S -c; do
+        if "$MINOC" $flag -o "$dir/$name.out" "$dir/$name.mino" > /dev/null 2> "$dir/$name.err"; then
+            echo "$name.mino $flag compiled"
+            exit 1
+        fi
+        grep -q "too many parameters in function" "$dir/$name.err" || { cat "$dir/$name.err"; exit 1; }
+        grep -q "too many arguments in call to" "$dir/$name.err" || { cat "$dir/$name.err"; exit 1; }
+        [ ! -e "$dir/$name.out" ] || { echo "$name.mino $flag left an output"; exit 1; }
+    done
+    "$MINOC" --emit-c -o "$dir/$name.out" "$dir/$name.mino" > /dev/null || exit 1
+    "$dir/$name.out"
+    status=$?
+    [ $status = "$expect" ] || { echo "$name.mino --emit-c returned $status"; exit 1; }
+done
@@ -0,0 +1,13 @@
+#!/bin/sh
+# The calls tests/comptime.mino makes with constant arguments are folded
+# to their values, except the ones to @noinline functions; fib, pick and
+# even are then not called at all and dropped
+dir=$1
+"$MINOC" -S -o "$dir/comptime.s" tests/comptime.mino > /dev/null || exit 1
+for value in 75025 42 2001; do
+    grep -q "mov \$$value, %rdi" "$dir/comptime.s" || { echo "$value not folded"; exit 1; }
+done
+grep -q "call twice" "$dir/comptime.s" || { echo "@noinline call folded"; exit 1; }
+if grep -E "^(fib|pick|even):|call (fib|pick|even)$" "$dir/comptime.s"; then
+    exit 1
+fi
@@ -0,0 +1,44 @@
+#!/bin/sh
+# -g adds line tables and call frame information to both the built-in
+# encoder's objects and the printed assembly, without changing the code
+dir=$1
+cat > "$dir/dbg.mino" <<'MINO'
+@noinline
+func int square(int n) {
+    let s = n * n;
+    return s;
+}
+
+func int main() {
+    var n: int = 7;
+    sys.IO.print.PrintIntLn(square(n));
+    return 0;
+}
+MINO
+"$MINOC" -g -c -o "$dir/dbg.o" "$dir/dbg.mino" > /dev/null || exit 1
+for section in .eh_frame .debug_info .debug_abbrev .debug_line .debug_ranges; do
+    readelf -SW "$dir/dbg.o" | grep -q " $section " || { echo "no $section"; exit 1; }
+done
+fdes=$(readelf --debug-dump=frames "$dir/dbg.o" | grep -c " FDE ")
+[ "$fdes" = 2 ] || { echo "$fdes FDEs instead of 2"; exit 1; }
+
+# The code is the same as without -g
+"$MINOC" -c -o "$dir/plain.o" "$dir/dbg.mino" > /dev/null || exit 1
+objdump -d "$dir/dbg.o" | tail -n +3 > "$dir/dbg.dis"
+objdump -d "$dir/plain.o" | tail -n +3 > "$dir/plain.dis"
+cmp -s "$dir/dbg.dis" "$dir/plain.dis" || { diff "$dir/plain.dis" "$dir/dbg.dis" | head; exit 1; }
+
+# Each function's address maps to its first line: the declaration when
+# there is a prologue, else the first statement
+for flag in "" --via-asm; do
+    "$MINOC" -g $flag -o "$dir/dbg.out" "$dir/dbg.mino" > /dev/null || exit 1
+    [ "$("$dir/dbg.out")" = 49 ] || { echo "$flag: wrong output"; exit 1; }
+    for entry in square:3 main:7; do
+        address=$(nm "$dir/dbg.out" | awk -v name="${entry%:*}" '$3 == name { print $1 }')
+        line=$(addr2line -e "$dir/dbg.out" "$address")
+        [ "$line" = "$dir/dbg.mino:${entry#*:}" ] || { echo "$flag: ${entry%:*} is at $line"; exit 1; }
+    done
+done
+"$MINOC" -g -S -o "$dir/dbg.s" "$dir/dbg.mino" > /dev/null || exit 1
+grep -q "^	\.cfi_startproc" "$dir/dbg.s" || { echo "no .cfi_startproc in the assembly"; exit 1; }
+grep -q "^	\.loc 1 3$" "$dir/dbg.s" || { echo "no .loc for line 3 in the assembly"; exit 1; }
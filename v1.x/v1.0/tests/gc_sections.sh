@@ -0,0 +1,37 @@
+#!/bin/sh
+# Programs are linked with --gc-sections: every function is a section of
+# its own, only the runtime functions the program calls are kept, and
+# functions main cannot reach are dropped
+dir=$1
+cat > "$dir/gc.mino" <<'MINO'
+@noinline
+func int unused(int n) {
+    sys.IO.print.PrintString("never");
+    return n;
+}
+
+@noinline
+func int answer(int n) {
+    return n + 2;
+}
+
+func int main() {
+    var n: int = 40;
+    sys.IO.print.PrintIntLn(answer(n));
+    return 0;
+}
+MINO
+"$MINOC" -c -o "$dir/gc.o" "$dir/gc.mino" > /dev/null || exit 1
+sections=$(readelf -SW "$dir/gc.o" | grep -o "] \.text\.[a-z]*" | cut -c3- | sort | tr '\n' ' ')
+[ "$sections" = ".text.answer .text.main " ] || { echo "object sections: $sections"; exit 1; }
+"$MINOC" -S -o "$dir/gc.s" "$dir/gc.mino" > /dev/null || exit 1
+grep -q '^	.section .text.answer,"ax",@progbits$' "$dir/gc.s" || { echo "no .text.answer in the assembly"; exit 1; }
+for flag in "" --via-asm --emit-c; do
+    "$MINOC" $flag -o "$dir/gc.out" "$dir/gc.mino" > /dev/null || exit 1
+    [ "$("$dir/gc.out")" = 42 ] || { echo "$flag: wrong output"; exit 1; }
+    symbols=$(nm "$dir/gc.out" | grep -E " (sys_|initSystem$|sys$|mathModule$|unused$)" | awk '{ print $3 }')
+    [ "$symbols" = sys_IO_print_PrintIntLn ] || {
+        echo "$flag: kept:" $symbols
+        exit 1
+    }
+done
@@ -0,0 +1,60 @@
+#!/bin/sh
+# The inliner leaves functions on call-graph cycles alone and inlines
+# small leaves; functions main cannot reach are dropped. The call graph
+# is built once, so a long chain of calls compiles in linear time.
+dir=$1
+cat > "$dir/inline.mino" <<'MINO'
+func int even(int n) {
+    var r: int = 1;
+    var more: bool = n > 0;
+    while (more) { r = odd(n - 1); more = false; }
+    return r;
+}
+func int odd(int n) {
+    var r: int = 0;
+    var more: bool = n > 0;
+    while (more) { r = even(n - 1); more = false; }
+    return r;
+}
+func int self(int n) {
+    var r: int = 0;
+    var more: bool = n > 0;
+    while (more) { r = self(n - 1) + 1; more = false; }
+    return r;
+}
+func int leaf(int n) {
+    return n + 1;
+}
+func int dead(int n) {
+    return leaf(n);
+}
+func int main() {
+    var n: int = 7;
+    sys.IO.print.PrintIntLn(even(n) + self(n) + leaf(n));
+    return 0;
+}
+MINO
+"$MINOC" --emit-ir "$dir/inline.mino" > /dev/null 2> "$dir/remarks" || exit 1
+for remark in "removed: dead (not reachable from main)" \
+              "not inlined: even into odd (recursive)" \
+              "not inlined: odd into even (recursive)" \
+              "not inlined: self into self (recursive)" \
+              "not inlined: even into main (recursive)" \
+              "inlined leaf into main"; do
+    grep -q "$remark" "$dir/remarks" || { echo "missing: $remark"; cat "$dir/remarks"; exit 1; }
+done
+"$MINOC" -o "$dir/inline.out" "$dir/inline.mino" > /dev/null || exit 1
+[ "$("$dir/inline.out")" = 15 ] || { echo "wrong result: $("$dir/inline.out")"; exit 1; }
+
+# 3000 @noinline functions, each calling the next; this took minutes
+# when every call site searched the call graph
+awk 'BEGIN {
+    for (i = 0; i < 3000; i++) {
+        printf "@noinline\nfunc int f%d(int x) {\n", i
+        if (i < 2999) printf "    return f%d(x + 1);\n}\n", i + 1
+        else print "    return x;\n}"
+    }
+    print "func int main() {\n    var x: int = 1;\n    sys.IO.print.PrintIntLn(f0(x));\n    return 0;\n}"
+}' > "$dir/chain.mino"
+timeout 20 "$MINOC" -o "$dir/chain.out" "$dir/chain.mino" > /dev/null || { echo "chain: failed or too slow"; exit 1; }
+[ "$("$dir/chain.out")" = 3000 ] || { echo "chain: wrong result"; exit 1; }
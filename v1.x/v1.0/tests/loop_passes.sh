@@ -0,0 +1,33 @@
+#!/bin/sh
+# LICM and induction-variable reduction report what they change; the
+# loop below has an invariant product and a multiply by the counter
+dir=$1
+cat > "$dir/passes.mino" <<'MINO'
+@noinline
+func int walk(int n, int k) {
+    var total: int = 0;
+    for (var i: int = 0; i < n; i = i + 1) {
+        total = total + (i * k) + (n * k);
+    }
+    return total;
+}
+
+func int main() {
+    var n: int = 6;
+    sys.IO.print.PrintIntLn(walk(n, 7));
+    return 0;
+}
+MINO
+"$MINOC" --emit-ir "$dir/passes.mino" > "$dir/passes.ir" 2> "$dir/passes.remarks" || exit 1
+grep -q "hoisted %[0-9]* (mul) out of the loop" "$dir/passes.remarks" || { echo "no LICM remark"; exit 1; }
+grep -q "strength-reduced %[0-9]* = %[0-9]* \* %[0-9]* to an induction variable" "$dir/passes.remarks" || {
+    echo "no indvars remark"
+    exit 1
+}
+# no multiply is left in the loop, which starts at the first phi
+if sed -n '/^func walk/,/^}/p' "$dir/passes.ir" | sed -n '/ phi /,$p' | grep -q " mul "; then
+    sed -n '/^func walk/,/^}/p' "$dir/passes.ir"
+    exit 1
+fi
+"$MINOC" -o "$dir/passes.out" "$dir/passes.mino" > /dev/null || exit 1
+[ "$("$dir/passes.out")" = 357 ] || { echo "wrong result: $("$dir/passes.out")"; exit 1; }
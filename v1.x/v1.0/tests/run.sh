@@ -0,0 +1,72 @@
+#!/bin/sh
+# tests/run.sh - compile and run the programs in tests/
+#
+# Each tests/*.mino is built with bin/minoc, run, and its output plus its
+# exit status ("exit N" as the last line) compared with the .expect file
+# next to it. A line `// minoc: <flags>` in the source builds and checks
+# the program again with those flags, e.g. --emit-c or -g.
+#
+# Each tests/*.sh is run with MINOC set to the compiler and the scratch
+# directory as its first argument; it passes when it exits 0.
+#
+# Run from the directory with the Makefile: make test, or tests/run.sh
+MINOC=${MINOC:-./bin/minoc}
+export MINOC
+work=$(mktemp -d "${TMPDIR:-/tmp}/minotest.XXXXXX") || exit 1
+trap 'rm -rf "$work"' EXIT
+passed=0
+failed=0
+
+pass() {
+    passed=$((passed + 1))
+}
+
+fail() {
+    echo "FAIL: $1"
+    failed=$((failed + 1))
+}
+
+# check <source> <flags...>: build, run and compare with the .expect file
+check() {
+    source=$1
+    shift
+    name=$(basename "$source" .mino)
+    label="$name${1:+ ($*)}"
+    if ! "$MINOC" "$@" -o "$work/$name.out" "$source" > "$work/$name.log" 2>&1; then
+        fail "$label: compile error"
+        sed 's/^/    /' "$work/$name.log" | grep -i "error" | head -5
+        return
+    fi
+    { "$work/$name.out" < /dev/null; echo "exit $?"; } > "$work/$name.actual" 2>&1
+    if cmp -s "$work/$name.actual" "${source%.mino}.expect"; then
+        pass
+    else
+        fail "$label: output differs"
+        diff "${source%.mino}.expect" "$work/$name.actual" | head -10 | sed 's/^/    /'
+    fi
+}
+
+for source in tests/*.mino; do
+    [ -e "$source" ] || continue
+    check "$source"
+    sed -n 's|^// minoc: ||p' "$source" > "$work/flags"
+    while read -r flags; do
+        # one build per line, with the flags word-split
+        check "$source" $flags
+    done < "$work/flags"
+done
+
+for script in tests/*.sh; do
+    [ "$script" = tests/run.sh ] && continue
+    mkdir -p "$work/sh"
+    if sh "$script" "$work/sh" > "$work/script.log" 2>&1; then
+        pass
+    else
+        fail "$(basename "$script")"
+        sed 's/^/    /' "$work/script.log" | head -10
+    fi
+    rm -rf "$work/sh"
+done
+
+echo "tests: $passed passed, $failed failed"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,17 @@
+#!/bin/sh
+# C code calling println through the `sys` table gets the same output as
+# the flattened sys_IO_print_println the compiler calls: the text verbatim
+dir=$1
+cat > "$dir/table.c" <<'C'
+#include <System.h>
+
+int main(void) {
+    initSystem();
+    sys.IO.print.println("100%d %s");
+    sys_IO_print_println("100%d %s");
+    return 0;
+}
+C
+${CC:-gcc} -I./include -o "$dir/table" "$dir/table.c" lib/minolib/libminosys.a -lm || exit 1
+expected=$(printf '100%%d %%s\n100%%d %%s')
+[ "$("$dir/table")" = "$expected" ] || { echo "output:"; "$dir/table"; exit 1; }
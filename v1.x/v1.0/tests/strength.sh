@@ -0,0 +1,45 @@
+#!/bin/sh
+# Constant multipliers of the form 2^k, 3/5/9 x 2^k or a product of two
+# of those become shl, lea and neg; constant divisors and remainders never
+# use idiv
+dir=$1
+cat > "$dir/strength.mino" <<'MINO'
+@noinline
+func int muls(int x) {
+    return (x * 8) + (x * 40) + (x * 45) + (x * 24) + (x * (0 - 1)) + (x * (0 - 8));
+}
+
+@noinline
+func int divs(int x) {
+    return (x / 8) + (x / 7) + (x / (0 - 3)) + (x % 16) + (x % 10) + (x % (0 - 641));
+}
+
+@noinline
+func int other(int x, int y) {
+    return (x * 1000003) + (x / y);
+}
+
+func int main() {
+    var x: int = 0 - 1234;
+    sys.IO.print.PrintIntLn(muls(x) + divs(x) + other(x, 7));
+    return 0;
+}
+MINO
+"$MINOC" -S -o "$dir/strength.s" "$dir/strength.mino" > /dev/null || exit 1
+# body <function>: the assembly of one function
+body() {
+    sed -n "/^$1:/,/^	\.section/p" "$dir/strength.s"
+}
+if body muls | grep -q "imul"; then
+    body muls
+    exit 1
+fi
+if body divs | grep -q "idiv"; then
+    body divs
+    exit 1
+fi
+# a multiplier without a short sequence and a variable divisor stay
+body other | grep -q "imul" || { echo "other: no imul"; exit 1; }
+body other | grep -q "idiv" || { echo "other: no idiv"; exit 1; }
+"$MINOC" -o "$dir/strength.out" "$dir/strength.mino" > /dev/null || exit 1
+[ "$("$dir/strength.out")" = -1234137668 ] || { echo "wrong result: $("$dir/strength.out")"; exit 1; }
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Array loops run two elements per iteration in SSE2 registers where the
+# lambda allows it, and stay scalar where it does not; the C backend
+# rejects arrays instead of miscompiling them
+dir=$1
+cat > "$dir/vec.mino" <<'MINO'
+@noinline
+func int total(int[] xs) {
+    return xs.sum();
+}
+
+@noinline
+func float[] scale(float[] xs, float k) {
+    return xs.map(x => x * k + 0.5);
+}
+
+@noinline
+func int weird(int[] xs) {
+    return xs.reduce(1, (acc, x) => acc * 2 + x);
+}
+
+func int main() {
+    let a = [1, 2, 3, 4, 5];
+    let f = scale([1.5, 2.25, 3.0], 2.0);
+    sys.IO.print.PrintIntLn(total(a) + weird(a) + int(f.sum()));
+    return 0;
+}
+MINO
+"$MINOC" -S -o "$dir/vec.s" "$dir/vec.mino" > /dev/null || exit 1
+# body <function>: the assembly of one function
+body() {
+    sed -n "/^$1:/,/^	\.section/p" "$dir/vec.s"
+}
+body total | grep -q "paddq" || { echo "total: no paddq"; exit 1; }
+body scale | grep -q "mulpd" || { echo "scale: no mulpd"; exit 1; }
+body scale | grep -q "addpd" || { echo "scale: no addpd"; exit 1; }
+if body weird | grep -Eq "p(add|sub)q|movdqu"; then
+    echo "weird: vectorized a reduction that is not acc + e"
+    exit 1
+fi
+"$MINOC" -o "$dir/vec.out" "$dir/vec.mino" > /dev/null || exit 1
+[ "$("$dir/vec.out")" = 119 ] || { echo "wrong result: $("$dir/vec.out")"; exit 1; }
+if "$MINOC" --emit-c -o "$dir/vec.c.out" "$dir/vec.mino" > "$dir/vec.log" 2>&1; then
+    echo "--emit-c accepted arrays"
+    exit 1
+fi
+grep -q "arrays are not supported by the C backend" "$dir/vec.log" || { echo "no C backend error"; exit 1; }
+[ ! -e "$dir/vec.c.out" ] || { echo "--emit-c wrote an executable"; exit 1; }
@@ -0,0 +1,297 @@
+// tools/genabi.c - generate the typed runtime registry from include/System.h
+//
+// Usage: genabi <System.h> <out.c> [<addresses.c>]
+//
+// Reads every top-level `sys_*` prototype in the header, records parameter
+// and return types plus the MINO_PURE flag, and writes a C table indexed by
+// a perfect hash of the linker name (see include/runtime_abi.h). The
+// optional second output lists each function's address in the same order,
+// for programs that link the runtime in (minoc --run).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <runtime_abi.h>
+
+#define MAX_FUNCS 256
+
+static RuntimeFunc funcs[MAX_FUNCS];
+static char* names[MAX_FUNCS];
+static int funcCount = 0;
+
+static char* readFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "genabi: could not open \"%s\"\n", path);
+        exit(1);
+    }
+    fseek(file, 0L, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    char* buffer = malloc(size + 1);
+    size_t n = fread(buffer, 1, size, file);
+    buffer[n] = '\0';
+    fclose(file);
+    return buffer;
+}
+
+// Blank out comments and preprocessor lines so only declarations remain
+static void stripNoise(char* s) {
+    int lineStart = 1;
+    while (*s) {
+        if (s[0] == '/' && s[1] == '/') {
+            while (*s && *s != '\n') *s++ = ' ';
+            continue;
+        }
+        if (s[0] == '/' && s[1] == '*') {
+            while (*s && !(s[0] == '*' && s[1] == '/')) { if (*s != '\n') *s = ' '; s++; }
+            if (*s) { s[0] = ' '; s[1] = ' '; s += 2; }
+            continue;
+        }
+        if (lineStart && *s == '#') {
+            while (*s && *s != '\n') *s++ = ' ';
+            continue;
+        }
+        if (*s == '\n') lineStart = 1;
+        else if (!isspace((unsigned char)*s)) lineStart = 0;
+        s++;
+    }
+}
+
+static char* trim(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+// Map a C type spelling (without the parameter name) to an ABI type
+static int parseType(const char* text, AbiType* out) {
+    char buf[128];
+    int n = 0;
+    // normalize: drop qualifiers, collapse spaces, keep '*'
+    for (const char* p = text; *p && n < (int)sizeof(buf) - 1; p++) {
+        if (isspace((unsigned char)*p)) {
+            if (n > 0 && buf[n - 1] != ' ') buf[n++] = ' ';
+        } else {
+            buf[n++] = *p;
+        }
+    }
+    buf[n] = '\0';
+
+    int pointers = 0;
+    char base[128] = {0};
+    int b = 0;
+    for (char* p = buf; *p; p++) {
+        if (*p == '*') { pointers++; continue; }
+        base[b++] = *p;
+    }
+    char* t = trim(base);
+    if (strncmp(t, "const ", 6) == 0) t += 6;
+    if (strncmp(t, "unsigned ", 9) == 0) t += 9;
+
+    if (pointers > 0) {
+        *out = (strcmp(t, "char") == 0 && pointers == 1) ? ABI_STRING : ABI_PTR;
+        return 1;
+    }
+    if (strcmp(t, "void") == 0) { *out = ABI_VOID; return 1; }
+    if (strcmp(t, "int") == 0 || strcmp(t, "unsigned") == 0) { *out = ABI_INT; return 1; }
+    if (strcmp(t, "size_t") == 0) { *out = ABI_LONG; return 1; }
+    if (strcmp(t, "float") == 0) { *out = ABI_FLOAT; return 1; }
+    if (strcmp(t, "double") == 0) { *out = ABI_DOUBLE; return 1; }
+    return 0;
+}
+
+// Split "type name" into its type part (the name is the trailing identifier)
+static void dropParamName(char* param) {
+    char* end = param + strlen(param);
+    char* p = end;
+    while (p > param && (isalnum((unsigned char)p[-1]) || p[-1] == '_')) p--;
+    // only a name if something (type or '*') precedes it
+    char* before = p;
+    while (before > param && isspace((unsigned char)before[-1])) before--;
+    if (p < end && before > param) *p = '\0';
+}
+
+static void parseDeclaration(char* decl) {
+    char* open = strchr(decl, '(');
+    char* close = strrchr(decl, ')');
+    if (!open || !close || close < open) return;
+    if (strstr(decl, "(*")) return;  // function pointer, not an export
+
+    *open = '\0';
+    *close = '\0';
+    char* head = trim(decl);
+    char* params = trim(open + 1);
+
+    // head = [MINO_PURE] [extern] <type> <name>
+    int isPure = 0;
+    if (strncmp(head, "MINO_PURE", 9) == 0) { isPure = 1; head = trim(head + 9); }
+    if (strncmp(head, "extern ", 7) == 0) head = trim(head + 7);
+
+    char* name = head + strlen(head);
+    while (name > head && (isalnum((unsigned char)name[-1]) || name[-1] == '_')) name--;
+    if (strncmp(name, "sys_", 4) != 0) return;
+
+    RuntimeFunc f;
+    memset(&f, 0, sizeof(f));
+    f.isPure = isPure;
+
+    char nameCopy[128];
+    snprintf(nameCopy, sizeof(nameCopy), "%s", name);
+    *name = '\0';
+    if (!parseType(head, &f.ret)) {
+        fprintf(stderr, "genabi: unsupported return type in %s\n", nameCopy);
+        exit(1);
+    }
+
+    if (*params && strcmp(params, "void") != 0) {
+        char* save = NULL;
+        for (char* param = strtok_r(params, ",", &save); param; param = strtok_r(NULL, ",", &save)) {
+            param = trim(param);
+            if (strcmp(param, "...") == 0) { f.isVariadic = 1; continue; }
+            if (f.paramCount >= RUNTIME_MAX_PARAMS) {
+                fprintf(stderr, "genabi: too many parameters in %s\n", nameCopy);
+                exit(1);
+            }
+            dropParamName(param);
+            if (!parseType(param, &f.params[f.paramCount])) {
+                fprintf(stderr, "genabi: unsupported parameter type '%s' in %s\n", param, nameCopy);
+                exit(1);
+            }
+            f.paramCount++;
+        }
+    }
+
+    if (funcCount >= MAX_FUNCS) {
+        fprintf(stderr, "genabi: too many runtime functions\n");
+        exit(1);
+    }
+    names[funcCount] = strdup(nameCopy);
+    funcs[funcCount++] = f;
+}
+
+// Collect top-level declarations (statements at brace depth 0)
+static void scanHeader(char* text) {
+    int depth = 0;
+    char* start = text;
+    for (char* p = text; *p; p++) {
+        if (*p == '{') depth++;
+        else if (*p == '}') { depth--; if (depth == 0) start = p + 1; }
+        else if (*p == ';') {
+            if (depth == 0) {
+                *p = '\0';
+                parseDeclaration(start);
+            }
+            start = p + 1;
+        }
+    }
+}
+
+// Find a seed that maps every name to a distinct slot
+static int buildPerfectHash(unsigned int* outSeed, unsigned int* outSize, short** outSlots) {
+    unsigned int size = 1;
+    while (size < (unsigned int)funcCount) size <<= 1;
+
+    for (; size <= 4096; size <<= 1) {
+        short* slots = malloc(sizeof(short) * size);
+        for (unsigned int seed = 0; seed < 200000; seed++) {
+            for (unsigned int i = 0; i < size; i++) slots[i] = -1;
+            int ok = 1;
+            for (int i = 0; i < funcCount && ok; i++) {
+                unsigned int slot = runtimeAbiHash(names[i], seed) & (size - 1);
+                if (slots[slot] != -1) ok = 0;
+                else slots[slot] = (short)i;
+            }
+            if (ok) {
+                *outSeed = seed;
+                *outSize = size;
+                *outSlots = slots;
+                return 1;
+            }
+        }
+        free(slots);
+    }
+    return 0;
+}
+
+static const char* abiName(AbiType type) {
+    switch (type) {
+        case ABI_VOID: return "ABI_VOID";
+        case ABI_INT: return "ABI_INT";
+        case ABI_LONG: return "ABI_LONG";
+        case ABI_FLOAT: return "ABI_FLOAT";
+        case ABI_DOUBLE: return "ABI_DOUBLE";
+        case ABI_STRING: return "ABI_STRING";
+        case ABI_PTR: return "ABI_PTR";
+    }
+    return "ABI_VOID";
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage: genabi <System.h> <out.c> [<addresses.c>]\n");
+        return 1;
+    }
+
+    char* text = readFile(argv[1]);
+    stripNoise(text);
+    scanHeader(text);
+
+    unsigned int seed = 0, size = 0;
+    short* slots = NULL;
+    if (!buildPerfectHash(&seed, &size, &slots)) {
+        fprintf(stderr, "genabi: could not build a perfect hash\n");
+        return 1;
+    }
+
+    FILE* out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "genabi: could not write \"%s\"\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by tools/genabi.c from %s - do not edit\n", argv[1]);
+    fprintf(out, "#include <runtime_abi.h>\n\n");
+    fprintf(out, "const RuntimeFunc runtimeAbiFuncs[] = {\n");
+    for (int i = 0; i < funcCount; i++) {
+        RuntimeFunc* f = &funcs[i];
+        fprintf(out, "    {\"%s\", %s, %d, {", names[i], abiName(f->ret), f->paramCount);
+        for (int j = 0; j < f->paramCount; j++) {
+            fprintf(out, "%s%s", j ? ", " : "", abiName(f->params[j]));
+        }
+        if (f->paramCount == 0) fprintf(out, "ABI_VOID");
+        fprintf(out, "}, %d, %d},\n", f->isVariadic, f->isPure);
+    }
+    fprintf(out, "};\n\n");
+    fprintf(out, "const int runtimeAbiCount = %d;\n", funcCount);
+    fprintf(out, "const unsigned int runtimeAbiSeed = %uu;\n", seed);
+    fprintf(out, "const unsigned int runtimeAbiMask = %uu;\n\n", size - 1);
+    fprintf(out, "const short runtimeAbiSlots[] = {");
+    for (unsigned int i = 0; i < size; i++) {
+        fprintf(out, "%s%d", (i % 16 == 0) ? "\n    " : " ", slots[i]);
+        if (i + 1 < size) fprintf(out, ",");
+    }
+    fprintf(out, "\n};\n");
+    fclose(out);
+
+    if (argc == 4) {
+        out = fopen(argv[3], "w");
+        if (!out) {
+            fprintf(stderr, "genabi: could not write \"%s\"\n", argv[3]);
+            return 1;
+        }
+        fprintf(out, "// Generated by tools/genabi.c from %s - do not edit\n", argv[1]);
+        fprintf(out, "#include <System.h>\n#include <runtime_abi.h>\n\n");
+        fprintf(out, "void (*const runtimeAbiAddresses[])(void) = {\n");
+        for (int i = 0; i < funcCount; i++) fprintf(out, "    (void (*)(void))%s,\n", names[i]);
+        fprintf(out, "};\n");
+        fclose(out);
+    }
+
+    printf("genabi: %d runtime functions, %u slots (seed %u)\n", funcCount, size, seed);
+    free(slots);
+    for (int i = 0; i < funcCount; i++) free(names[i]);
+    free(text);
+    return 0;
+}